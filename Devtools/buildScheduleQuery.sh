@@ -0,0 +1,20 @@
+sources="./../Sources/Windows/" # the schedule engine and the ScheduleQuery tool
+output="${1:-./ScheduleQuery}" # where to write the executable
+compiler="${CXX:-g++}" # needs std::ranges::to from C++23, so GCC 14, or Clang with libc++ 17, and newer
+libraries="${LDLIBS--ltbb}" # libstdc++ runs std::execution::par on TBB, pass LDLIBS= to build without it
+
+# builds ScheduleQuery on Linux, where the Visual Studio project cannot be used. Run it from the plugin folder,
+# or pass the route databases with --data
+"$compiler" -std=c++23 -O2 -pthread \
+	-o "$output" \
+	"$sources"ScheduleQuery/main.cpp \
+	"$sources"ScheduleQueryRunner.cpp \
+	"$sources"ScheduleTable.cpp \
+	"$sources"FFXIVOceanFishingHelper.cpp \
+	"$sources"FFXIVOceanFishingProcessor.cpp \
+	"$sources"FFXIVOceanFishingJsonLoadUtils.cpp \
+	"$sources"FFXIVOceanFishingCreateTargetUtils.cpp \
+	$libraries \
+	|| exit 1
+
+echo "Built $output"
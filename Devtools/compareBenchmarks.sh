@@ -0,0 +1,61 @@
+baseline="$1" # json written by PluginBenchmarks.exe --json=<file> on the build to compare against
+contender="$2" # json written the same way on the new build
+threshold="${3:-10}" # percent slower per iteration before a benchmark counts as a regression
+
+if [ ! -f "$baseline" ] || [ ! -f "$contender" ]
+then
+	echo "usage: compareBenchmarks.sh <baseline.json> <contender.json> [threshold percent]"
+	exit 2
+fi
+
+# the harness writes one benchmark object per line, so each line holds a name and its real_time in ns
+export LC_ALL=C
+awk -v threshold="$threshold" '
+	function field(line, key,    match_) {
+		if (!match(line, "\"" key "\":(\"[^\"]*\"|[-0-9.eE+]+)"))
+			return ""
+		match_ = substr(line, RSTART + length(key) + 3, RLENGTH - length(key) - 3)
+		gsub(/"/, "", match_)
+		return match_
+	}
+	/"name":/ {
+		name = field($0, "name")
+		time = field($0, "real_time")
+		if (FILENAME == ARGV[1])
+			baseline[name] = time
+		else
+		{
+			contender[name] = time
+			order[++count] = name
+		}
+	}
+	END {
+		printf "%-48s %14s %14s %9s\n", "Benchmark", "baseline ns", "contender ns", "change"
+		regressions = 0
+		for (i = 1; i <= count; i++)
+		{
+			name = order[i]
+			if (!(name in baseline))
+			{
+				printf "%-48s %14s %14.1f %9s\n", name, "-", contender[name], "new"
+				continue
+			}
+			change = baseline[name] > 0 ? (contender[name] - baseline[name]) * 100 / baseline[name] : 0
+			flag = ""
+			if (change > threshold)
+			{
+				flag = "  REGRESSION"
+				regressions++
+			}
+			else if (change < -threshold)
+				flag = "  faster"
+			printf "%-48s %14.1f %14.1f %+8.1f%%%s\n", name, baseline[name], contender[name], change, flag
+		}
+		for (name in baseline)
+			if (!(name in contender))
+				printf "%-48s %14.1f %14s %9s\n", name, baseline[name], "-", "removed"
+
+		printf "\n%d regression(s) over %s%%\n", regressions, threshold
+		exit regressions > 0 ? 1 : 0
+	}
+' "$baseline" "$contender"
@@ -0,0 +1,33 @@
+iconsFolder="./../Sources/com.elgato.ffxivoceanfishing.sdPlugin/Icons/" # finished streamdeck icons
+output="./../Sources/com.elgato.ffxivoceanfishing.sdPlugin/Icons.pack" # pack the plugin maps at startup, see IconPack.h
+
+# byte lengths and sort order must not depend on the locale
+export LC_ALL=C
+
+index=""
+dataFile="$(mktemp)"
+offset=0
+count=0
+
+# each icon becomes a ready to send data URI, and an index line of "<offset> <length> <name>"
+for image in "$iconsFolder"*.png
+do
+	name="$(basename "$image" .png)"
+	uri="data:image/png;base64,$(base64 -w0 "$image")"
+	length=${#uri}
+
+	printf '%s\n' "$uri" >> "$dataFile"
+	index+="$offset $length $name"$'\n'
+
+	offset=$((offset + length + 1))
+	count=$((count + 1))
+done
+
+{
+	printf 'FFXIVICONPACK 1\n%d\n' "$count"
+	printf '%s' "$index"
+	cat "$dataFile"
+} > "$output"
+rm -f "$dataFile"
+
+echo "Packed $count icons into $output"
@@ -12,7 +12,7 @@
 
 #pragma once
 
-class ESDConnectionManager;
+class ESDTransport;
 
 class ESDBasePlugin
 {
@@ -20,7 +20,7 @@ public:
 	ESDBasePlugin() { }
 	virtual ~ESDBasePlugin() { }
 	
-	void SetConnectionManager(ESDConnectionManager * inConnectionManager) { mConnectionManager = inConnectionManager; }
+	void SetConnectionManager(ESDTransport * inConnectionManager) { mConnectionManager = inConnectionManager; }
 	
 	virtual void KeyDownForAction(const std::string& inAction, const std::string& inContext, const json &inPayload, const std::string& inDeviceID) = 0;
 	virtual void KeyUpForAction(const std::string& inAction, const std::string& inContext, const json &inPayload, const std::string& inDeviceID) = 0;
@@ -36,6 +36,6 @@ public:
 	virtual void DidReceiveGlobalSettings(const json& inPayload) = 0;
 	
 protected:
-	ESDConnectionManager *mConnectionManager = nullptr;
+	ESDTransport *mConnectionManager = nullptr;
 
 };
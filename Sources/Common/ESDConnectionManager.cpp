@@ -11,20 +11,48 @@
 //==============================================================================
 
 #include "ESDConnectionManager.h"
-#include "EPLJSONUtils.h"
+#include "../Windows/MessageWriter.h"
+#include "../Windows/PluginTracer.h"
 
+/**
+	@brief queues a serialized message for the websocket thread to send to the Stream Deck application
+
+	@param[in] inMessage the json message
+	@param[in] inCoalesce which pending message of the same context this replaces, NONE to always send it
+	@param[in] inContext the context the message is for, only used when coalescing
+**/
+void ESDConnectionManager::Send(std::string_view inMessage, const MessageQueue::COALESCE inCoalesce, std::string_view inContext)
+{
+	if (mOutbound.push(inMessage, inCoalesce, inContext) && mIsOpen)
+		mWebsocket.get_io_service().post(websocketpp::lib::bind(&ESDConnectionManager::Flush, this));
+}
+
+/**
+	@brief sends every queued message, only called on the websocket thread since websocketpp sends are not thread safe
+**/
+void ESDConnectionManager::Flush()
+{
+	const ScopedTraceSpan span("flush", "websocket");
+	mOutbound.drain(mOutboundBatch);
+	for (const MessageQueue::message_t& message : mOutboundBatch)
+	{
+		websocketpp::lib::error_code ec;
+		mWebsocket.send(mConnectionHandle, message.text, websocketpp::frame::opcode::text, ec);
+	}
+}
 
 void ESDConnectionManager::OnOpen(WebsocketClient* inClient, websocketpp::connection_hdl inConnectionHandler)
 {
 	DebugPrint("OnOpen");
 	
-	// Register plugin with StreamDeck
-	json jsonObject;
-	jsonObject["event"] = mRegisterEvent;
-	jsonObject["uuid"] = mPluginUUID;
-
+	// Register plugin with StreamDeck, before anything queued while connecting
+	MessageWriter writer;
+	const std::string_view registration = writer.registerPlugin(mRegisterEvent, mPluginUUID);
 	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
+	mWebsocket.send(mConnectionHandle, registration.data(), registration.size(), websocketpp::frame::opcode::text, ec);
+
+	mIsOpen = true;
+	Flush();
 }
 
 void ESDConnectionManager::OnFail(WebsocketClient* inClient, websocketpp::connection_hdl inConnectionHandler)
@@ -57,64 +85,17 @@ void ESDConnectionManager::OnClose(WebsocketClient* inClient, websocketpp::conne
 	}
 	
 	DebugPrint("Close with reason: %s\n", reason.c_str());
+	mIsOpen = false;
 }
 
 void ESDConnectionManager::OnMessage(websocketpp::connection_hdl, WebsocketClient::message_ptr inMsg)
 {
 	if (inMsg != NULL && inMsg->get_opcode() == websocketpp::frame::opcode::text)
 	{
-		std::string message = inMsg->get_payload();
+		const std::string& message = inMsg->get_payload();
 		DebugPrint("OnMessage: %s\n", message.c_str());
 		
-		try
-		{
-			json receivedJson = json::parse(message);
-			
-			std::string event = EPLJSONUtils::GetStringByName(receivedJson, kESDSDKCommonEvent);
-			std::string context = EPLJSONUtils::GetStringByName(receivedJson, kESDSDKCommonContext);
-			std::string action = EPLJSONUtils::GetStringByName(receivedJson, kESDSDKCommonAction);
-			std::string deviceID = EPLJSONUtils::GetStringByName(receivedJson, kESDSDKCommonDevice);
-			json payload;
-			EPLJSONUtils::GetObjectByName(receivedJson, kESDSDKCommonPayload, payload);
-
-			if(event == kESDSDKEventKeyDown)
-			{
-				mPlugin->KeyDownForAction(action, context, payload, deviceID);
-			}
-			else if(event == kESDSDKEventKeyUp)
-			{
-				mPlugin->KeyUpForAction(action, context, payload, deviceID);
-			}
-			else if(event == kESDSDKEventWillAppear)
-			{
-				mPlugin->WillAppearForAction(action, context, payload, deviceID);
-			}
-			else if(event == kESDSDKEventWillDisappear)
-			{
-				mPlugin->WillDisappearForAction(action, context, payload, deviceID);
-			}
-			else if(event == kESDSDKEventDeviceDidConnect)
-			{
-				json deviceInfo;
-				EPLJSONUtils::GetObjectByName(receivedJson, kESDSDKCommonDeviceInfo, deviceInfo);
-				mPlugin->DeviceDidConnect(deviceID, deviceInfo);
-			}
-			else if(event == kESDSDKEventDeviceDidDisconnect)
-			{
-				mPlugin->DeviceDidDisconnect(deviceID);
-			}
-			else if (event == kESDSDKEventSendToPlugin)
-			{
-				mPlugin->SendToPlugin(action, context, payload, deviceID);
-			}
-			else if (event == kESDSDKEventDidReceiveGlobalSettings)
-			{
-				mPlugin->DidReceiveGlobalSettings(payload);
-			}
-		}
-		catch (...)
-		{
-		}
+		Dispatch(message);
 	}
 }
 
@@ -125,17 +106,15 @@ ESDConnectionManager::ESDConnectionManager(
 		const std::string &inInfo,
 		ESDBasePlugin *inPlugin) :
 
+	ESDTransport(inPluginUUID, inPlugin),
 	mPort(inPort),
-	mPluginUUID(inPluginUUID),
-	mRegisterEvent(inRegisterEvent),
-	mPlugin(inPlugin)
+	mRegisterEvent(inRegisterEvent)
 {
-	if (inPlugin != nullptr)
-		inPlugin->SetConnectionManager(this);
 }
 
 void ESDConnectionManager::Run()
 {
+	PluginTracer::get().nameThread("websocket");
 	try
 	{
 		// Create the endpoint
@@ -178,180 +157,3 @@ void ESDConnectionManager::Run()
 		DebugPrint("Websocket threw an exception: %s\n", e.what());
     }
 }
-
-void ESDConnectionManager::SetTitle(const std::string &inTitle, const std::string& inContext, ESDSDKTarget inTarget)
-{
-	json jsonObject;
-
-	jsonObject[kESDSDKCommonEvent] = kESDSDKEventSetTitle;
-	jsonObject[kESDSDKCommonContext] = inContext;
-
-	json payload;
-	payload[kESDSDKPayloadTarget] = inTarget;
-	payload[kESDSDKPayloadTitle] = inTitle;
-	jsonObject[kESDSDKCommonPayload] = payload;
-	
-	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-}
-
-void ESDConnectionManager::SetImage(const std::string &inBase64ImageString, const std::string& inContext, ESDSDKTarget inTarget)
-{
-	json jsonObject;
-
-	jsonObject[kESDSDKCommonEvent] = kESDSDKEventSetImage;
-	jsonObject[kESDSDKCommonContext] = inContext;
-
-	json payload;
-	payload[kESDSDKPayloadTarget] = inTarget;
-	const std::string prefix = "data:image/png;base64,";
-	if (inBase64ImageString.empty() || inBase64ImageString.substr(0, prefix.length()).find(prefix) == 0)
-		payload[kESDSDKPayloadImage] = inBase64ImageString;
-	else
-		payload[kESDSDKPayloadImage] = "data:image/png;base64," + inBase64ImageString;
-	jsonObject[kESDSDKCommonPayload] = payload;
-	
-	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-}
-
-void ESDConnectionManager::ShowAlertForContext(const std::string& inContext)
-{
-	json jsonObject;
-
-	jsonObject[kESDSDKCommonEvent] = kESDSDKEventShowAlert;
-	jsonObject[kESDSDKCommonContext] = inContext;
-	
-	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-}
-
-void ESDConnectionManager::ShowOKForContext(const std::string& inContext)
-{
-	json jsonObject;
-
-	jsonObject[kESDSDKCommonEvent] = kESDSDKEventShowOK;
-	jsonObject[kESDSDKCommonContext] = inContext;
-	
-	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-}
-
-void ESDConnectionManager::GetGlobalSettings()
-{
-	json jsonObject;
-
-	jsonObject[kESDSDKCommonEvent] = kESDSDKEventGetGlobalSettings;
-	jsonObject[kESDSDKCommonContext] = mPluginUUID;
-
-	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-}
-
-void ESDConnectionManager::SetGlobalSettings(const json &inSettings)
-{
-	json jsonObject;
-
-	jsonObject[kESDSDKCommonEvent] = kESDSDKEventSetGlobalSettings;
-	jsonObject[kESDSDKCommonContext] = mPluginUUID;
-	jsonObject[kESDSDKCommonPayload] = inSettings;
-	
-	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-}
-
-void ESDConnectionManager::SetSettings(const json& inSettings, const std::string& inContext)
-{
-	json jsonObject;
-
-	jsonObject[kESDSDKCommonEvent] = kESDSDKEventSetSettings;
-	jsonObject[kESDSDKCommonContext] = inContext;
-	jsonObject[kESDSDKCommonPayload] = inSettings;
-
-	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-}
-
-void ESDConnectionManager::SetState(int inState, const std::string& inContext)
-{
-	json jsonObject;
-	
-	json payload;
-	payload[kESDSDKPayloadState] = inState;
-
-	jsonObject[kESDSDKCommonEvent] = kESDSDKEventSetState;
-	jsonObject[kESDSDKCommonContext] = inContext;
-	jsonObject[kESDSDKCommonPayload] = payload;
-	
-	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-}
-
-void ESDConnectionManager::SendToPropertyInspector(const std::string & inAction, const std::string & inContext, const json & inPayload)
-{
-	json jsonObject;
-
-	jsonObject[kESDSDKCommonEvent] = kESDSDKEventSendToPropertyInspector;
-	jsonObject[kESDSDKCommonContext] = inContext;
-	jsonObject[kESDSDKCommonAction] = inAction;
-	jsonObject[kESDSDKCommonPayload] = inPayload;
-
-	websocketpp::lib::error_code ec;
-	mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-}
-
-void ESDConnectionManager::SwitchToProfile(const std::string& inDeviceID, const std::string& inProfileName)
-{
-	if(!inDeviceID.empty())
-	{
-		json jsonObject;
-
-		jsonObject[kESDSDKCommonEvent] = kESDSDKEventSwitchToProfile;
-		jsonObject[kESDSDKCommonContext] = mPluginUUID;
-		jsonObject[kESDSDKCommonDevice] = inDeviceID;
-		
-		if(!inProfileName.empty())
-		{
-			json payload;
-			payload[kESDSDKPayloadProfile] = inProfileName;
-			jsonObject[kESDSDKCommonPayload] = payload;
-		}
-
-		websocketpp::lib::error_code ec;
-		mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-	}
-}
-
-void ESDConnectionManager::LogMessage(const std::string& inMessage)
-{
-	if(!inMessage.empty())
-	{
-		json jsonObject;
-
-		jsonObject[kESDSDKCommonEvent] = kESDSDKEventLogMessage;
-		
-		json payload;
-		payload[kESDSDKPayloadMessage] = inMessage;
-		jsonObject[kESDSDKCommonPayload] = payload;
-
-		websocketpp::lib::error_code ec;
-		mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-	}
-}
-
-void ESDConnectionManager::OpenUrl(const std::string& inMessage)
-{
-	if (!inMessage.empty())
-	{
-		json jsonObject;
-
-		jsonObject[kESDSDKCommonEvent] = kESDSDKEventOpenURL;
-
-		json payload;
-		payload[kESDSDKPayloadURL] = inMessage;
-		jsonObject[kESDSDKCommonPayload] = payload;
-
-		websocketpp::lib::error_code ec;
-		mWebsocket.send(mConnectionHandle, jsonObject.dump(), websocketpp::frame::opcode::text, ec);
-	}
-}
@@ -12,8 +12,11 @@
 
 #pragma once
 
-#include "ESDBasePlugin.h"
-#include "ESDSDKDefines.h"
+#include "ESDTransport.h"
+#include "../Windows/MessageQueue.h"
+
+#include <atomic>
+#include <vector>
 
 #include <websocketpp/config/asio_no_tls_client.hpp>
 #include <websocketpp/client.hpp>
@@ -23,7 +26,7 @@
 typedef websocketpp::config::asio_client::message_type::ptr message_ptr;
 typedef websocketpp::client<websocketpp::config::asio_client> WebsocketClient;
 
-class ESDConnectionManager
+class ESDConnectionManager : public ESDTransport
 {
 public:
 	
@@ -36,20 +39,6 @@ public:
 	
 	// Start the event loop
 	void Run();
-	
-	// API to communicate with the Stream Deck application
-	void SetTitle(const std::string &inTitle, const std::string& inContext, ESDSDKTarget inTarget);
-	void SetImage(const std::string &inBase64ImageString, const std::string& inContext, ESDSDKTarget inTarget);
-	void ShowAlertForContext(const std::string& inContext);
-	void ShowOKForContext(const std::string& inContext);
-	void GetGlobalSettings();
-	void SetSettings(const json &inSettings, const std::string& inContext);
-	void SetGlobalSettings(const json& inSettings);
-	void SetState(int inState, const std::string& inContext);
-	void SendToPropertyInspector(const std::string& inAction, const std::string& inContext, const json &inPayload);
-	void SwitchToProfile(const std::string& inDeviceID, const std::string& inProfileName);
-	void LogMessage(const std::string& inMessage);
-	void OpenUrl(const std::string& inMessage);
 
 private:
 	
@@ -58,13 +47,20 @@ private:
 	void OnFail(WebsocketClient * inClient, websocketpp::connection_hdl inConnectionHandler);
 	void OnClose(WebsocketClient * inClient, websocketpp::connection_hdl inConnectionHandler);
 	void OnMessage(websocketpp::connection_hdl, WebsocketClient::message_ptr inMsg);
+
+	void Send(std::string_view inMessage, const MessageQueue::COALESCE inCoalesce, std::string_view inContext) override;
+	void Flush();
 	
 	// Member variables
 	int mPort = 0;
-	std::string mPluginUUID;
 	std::string mRegisterEvent;
 	websocketpp::connection_hdl mConnectionHandle;
 	WebsocketClient mWebsocket;
-	ESDBasePlugin * mPlugin = nullptr;
+
+	// outbound messages wait here until the websocket thread sends them, they are held until the connection opens
+	MessageQueue mOutbound;
+	std::atomic<bool> mIsOpen = false;
+	// only used on the websocket thread
+	std::vector<MessageQueue::message_t> mOutboundBatch;
 };
 
@@ -168,6 +168,12 @@ enum
 	kESDSDKDeviceType_StreamDeck = 0,
 	kESDSDKDeviceType_StreamDeckMini = 1,
 	kESDSDKDeviceType_StreamDeckXL = 2,
-	kESDSDKDeviceType_StreamDeckMobile = 3
+	kESDSDKDeviceType_StreamDeckMobile = 3,
+	kESDSDKDeviceType_CorsairGKeys = 4,
+	kESDSDKDeviceType_StreamDeckPedal = 5,
+	kESDSDKDeviceType_CorsairVoyager = 6,
+	kESDSDKDeviceType_StreamDeckPlus = 7,
+	kESDSDKDeviceType_SCUFController = 8,
+	kESDSDKDeviceType_StreamDeckNeo = 9
 };
 
@@ -0,0 +1,149 @@
+//==============================================================================
+/**
+@file       ESDTransport.cpp
+
+@brief      Carries messages between a plugin and the Stream Deck application
+
+@copyright  (c) 2023, Momoko Tomoko
+
+**/
+//==============================================================================
+
+#include "ESDTransport.h"
+#include "../Windows/MessageWriter.h"
+
+namespace
+{
+	// outbound messages are written into a buffer reused across calls, one per thread since the plugin sends from several
+	thread_local MessageWriter tMessageWriter;
+}
+
+ESDTransport::ESDTransport(const std::string& inPluginUUID, ESDBasePlugin* inPlugin) :
+	mPluginUUID(inPluginUUID),
+	mPlugin(inPlugin)
+{
+	if (inPlugin != nullptr)
+		inPlugin->SetConnectionManager(this);
+}
+
+void ESDTransport::Dispatch(std::string_view inMessage)
+{
+	// scanned in place, the payload is only parsed for events that are handled
+	if (mPlugin == nullptr || !mInbound.parse(inMessage))
+		return;
+	const ScopedTraceSpan span("dispatch", "websocket");
+	PluginMetrics::get().countReceived(mInbound.getEvent(), inMessage.size());
+
+	try
+	{
+		switch (mInbound.getEvent())
+		{
+		case InboundMessage::EVENT::KEY_DOWN:
+			mPlugin->KeyDownForAction(mInbound.getAction(), mInbound.getContext(), mInbound.getPayload(), mInbound.getDevice());
+			break;
+		case InboundMessage::EVENT::KEY_UP:
+			mPlugin->KeyUpForAction(mInbound.getAction(), mInbound.getContext(), mInbound.getPayload(), mInbound.getDevice());
+			break;
+		case InboundMessage::EVENT::WILL_APPEAR:
+			mPlugin->WillAppearForAction(mInbound.getAction(), mInbound.getContext(), mInbound.getPayload(), mInbound.getDevice());
+			break;
+		case InboundMessage::EVENT::WILL_DISAPPEAR:
+			mPlugin->WillDisappearForAction(mInbound.getAction(), mInbound.getContext(), mInbound.getPayload(), mInbound.getDevice());
+			break;
+		case InboundMessage::EVENT::DEVICE_DID_CONNECT:
+			mPlugin->DeviceDidConnect(mInbound.getDevice(), mInbound.getDeviceInfo());
+			break;
+		case InboundMessage::EVENT::DEVICE_DID_DISCONNECT:
+			mPlugin->DeviceDidDisconnect(mInbound.getDevice());
+			break;
+		case InboundMessage::EVENT::SEND_TO_PLUGIN:
+			mPlugin->SendToPlugin(mInbound.getAction(), mInbound.getContext(), mInbound.getPayload(), mInbound.getDevice());
+			break;
+		case InboundMessage::EVENT::DID_RECEIVE_GLOBAL_SETTINGS:
+			mPlugin->DidReceiveGlobalSettings(mInbound.getPayload());
+			break;
+		default:
+			break;
+		}
+	}
+	catch (...)
+	{
+	}
+}
+
+void ESDTransport::SendCounted(const PluginMetrics::SENT inType, std::string_view inMessage, const MessageQueue::COALESCE inCoalesce, std::string_view inContext)
+{
+	PluginMetrics::get().countSent(inType, inMessage.size());
+	Send(inMessage, inCoalesce, inContext);
+}
+
+void ESDTransport::SetTitle(std::string_view inTitle, const std::string& inContext, ESDSDKTarget inTarget)
+{
+	const ScopedTraceSpan span("setTitle", "send");
+	SendCounted(PluginMetrics::SENT::SET_TITLE, tMessageWriter.setTitle(inContext, inTitle, inTarget), MessageQueue::COALESCE::TITLE, inContext);
+}
+
+void ESDTransport::SetImage(std::string_view inBase64ImageString, const std::string& inContext, ESDSDKTarget inTarget)
+{
+	const ScopedTraceSpan span("setImage", "send");
+	SendCounted(PluginMetrics::SENT::SET_IMAGE, tMessageWriter.setImage(inContext, inBase64ImageString, inTarget), MessageQueue::COALESCE::IMAGE, inContext);
+}
+
+void ESDTransport::ShowAlertForContext(const std::string& inContext)
+{
+	SendCounted(PluginMetrics::SENT::SHOW_ALERT, tMessageWriter.contextEvent(kESDSDKEventShowAlert, inContext), MessageQueue::COALESCE::NONE, {});
+}
+
+void ESDTransport::ShowOKForContext(const std::string& inContext)
+{
+	SendCounted(PluginMetrics::SENT::SHOW_OK, tMessageWriter.contextEvent(kESDSDKEventShowOK, inContext), MessageQueue::COALESCE::NONE, {});
+}
+
+void ESDTransport::GetGlobalSettings()
+{
+	SendCounted(PluginMetrics::SENT::GET_GLOBAL_SETTINGS, tMessageWriter.contextEvent(kESDSDKEventGetGlobalSettings, mPluginUUID), MessageQueue::COALESCE::NONE, {});
+}
+
+void ESDTransport::SetGlobalSettings(const json &inSettings)
+{
+	SendCounted(PluginMetrics::SENT::SET_GLOBAL_SETTINGS, tMessageWriter.contextPayloadEvent(kESDSDKEventSetGlobalSettings, mPluginUUID, inSettings.dump()), MessageQueue::COALESCE::NONE, {});
+}
+
+void ESDTransport::SetSettings(const json& inSettings, const std::string& inContext)
+{
+	SendCounted(PluginMetrics::SENT::SET_SETTINGS, tMessageWriter.contextPayloadEvent(kESDSDKEventSetSettings, inContext, inSettings.dump()), MessageQueue::COALESCE::NONE, {});
+}
+
+void ESDTransport::SetState(int inState, const std::string& inContext)
+{
+	SendCounted(PluginMetrics::SENT::SET_STATE, tMessageWriter.setState(inContext, inState), MessageQueue::COALESCE::NONE, {});
+}
+
+void ESDTransport::SendToPropertyInspector(const std::string & inAction, const std::string & inContext, const json & inPayload)
+{
+	SendCounted(PluginMetrics::SENT::SEND_TO_PROPERTY_INSPECTOR, tMessageWriter.sendToPropertyInspector(inAction, inContext, inPayload.dump()), MessageQueue::COALESCE::NONE, {});
+}
+
+void ESDTransport::SwitchToProfile(const std::string& inDeviceID, const std::string& inProfileName)
+{
+	if(!inDeviceID.empty())
+	{
+		SendCounted(PluginMetrics::SENT::SWITCH_TO_PROFILE, tMessageWriter.switchToProfile(mPluginUUID, inDeviceID, inProfileName), MessageQueue::COALESCE::NONE, {});
+	}
+}
+
+void ESDTransport::LogMessage(const std::string& inMessage)
+{
+	if(!inMessage.empty())
+	{
+		SendCounted(PluginMetrics::SENT::LOG_MESSAGE, tMessageWriter.logMessage(inMessage), MessageQueue::COALESCE::NONE, {});
+	}
+}
+
+void ESDTransport::OpenUrl(const std::string& inMessage)
+{
+	if (!inMessage.empty())
+	{
+		SendCounted(PluginMetrics::SENT::OPEN_URL, tMessageWriter.openUrl(inMessage), MessageQueue::COALESCE::NONE, {});
+	}
+}
@@ -0,0 +1,63 @@
+//==============================================================================
+/**
+@file       ESDTransport.h
+
+@brief      Carries messages between a plugin and the Stream Deck application
+
+@copyright  (c) 2023, Momoko Tomoko
+
+**/
+//==============================================================================
+
+#pragma once
+
+#include "ESDBasePlugin.h"
+#include "ESDSDKDefines.h"
+#include "../Windows/InboundMessage.h"
+#include "../Windows/MessageQueue.h"
+#include "../Windows/PluginMetrics.h"
+
+#include <string>
+#include <string_view>
+
+/**
+	@brief Turns the Stream Deck API into messages for a transport to send, and hands the events a transport
+	       receives to its plugin. ESDConnectionManager carries them over the Stream Deck's websocket,
+	       InMemoryTransport keeps them in memory so the plugin can run without the Stream Deck application.
+**/
+class ESDTransport
+{
+public:
+	ESDTransport(const std::string& inPluginUUID, ESDBasePlugin* inPlugin);
+	virtual ~ESDTransport() {}
+
+	// API to communicate with the Stream Deck application
+	void SetTitle(std::string_view inTitle, const std::string& inContext, ESDSDKTarget inTarget);
+	void SetImage(std::string_view inBase64ImageString, const std::string& inContext, ESDSDKTarget inTarget);
+	void ShowAlertForContext(const std::string& inContext);
+	void ShowOKForContext(const std::string& inContext);
+	void GetGlobalSettings();
+	void SetSettings(const json &inSettings, const std::string& inContext);
+	void SetGlobalSettings(const json& inSettings);
+	void SetState(int inState, const std::string& inContext);
+	void SendToPropertyInspector(const std::string& inAction, const std::string& inContext, const json &inPayload);
+	void SwitchToProfile(const std::string& inDeviceID, const std::string& inProfileName);
+	void LogMessage(const std::string& inMessage);
+	void OpenUrl(const std::string& inMessage);
+
+protected:
+	// sends a serialized message, called from any thread, titles and images may be coalesced per context
+	virtual void Send(std::string_view inMessage, const MessageQueue::COALESCE inCoalesce, std::string_view inContext) = 0;
+
+	// hands a message from the Stream Deck application to the plugin, only call from one thread
+	void Dispatch(std::string_view inMessage);
+
+	std::string mPluginUUID;
+	ESDBasePlugin * mPlugin = nullptr;
+
+private:
+	InboundMessage mInbound;
+
+	// counts a message in the plugin's metrics before sending it
+	void SendCounted(const PluginMetrics::SENT inType, std::string_view inMessage, const MessageQueue::COALESCE inCoalesce, std::string_view inContext);
+};
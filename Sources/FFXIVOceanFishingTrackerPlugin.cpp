@@ -8,17 +8,25 @@
 
 #include "FFXIVOceanFishingTrackerPlugin.h"
 
-#include "Windows/TimeUtils.hpp"
+#include "Common/ESDTransport.h"
 #include "Windows/ImageUtils.h"
-#include "lodepng.h"
-#include "lodepng.cpp"
+#include <filesystem>
+#include <fstream>
 
-#include "Common/ESDConnectionManager.h"
 
-//#define LOGGING
-
-
-FFXIVOceanFishingTrackerPlugin::FFXIVOceanFishingTrackerPlugin()
+/**
+	@param[in] clock where the plugin and its timers read the time from, the system clock unless simulating
+**/
+FFXIVOceanFishingTrackerPlugin::FFXIVOceanFishingTrackerPlugin(Clock& clock) :
+	mClock(clock),
+	mLogger(
+		[this](std::string_view lines)
+		{
+			if (mConnectionManager != nullptr)
+				mConnectionManager->LogMessage(std::string(lines));
+		},
+		clock
+	)
 {
 	mFFXIVOceanFishingHelper = std::make_unique<FFXIVOceanFishingHelper>(
 		std::vector <std::string>({
@@ -27,36 +35,78 @@ FFXIVOceanFishingTrackerPlugin::FFXIVOceanFishingTrackerPlugin()
 		})
 	);
 
-	// timer that is called on certain minutes of the hour
-	mTimer = std::make_unique <CallBackTimer>();
+	// icons are sent straight out of the pack, with no file reads or encoding
+	mIconPack = std::make_unique<IconPack>("Icons.pack");
+
+	// loads icons in the background and pushes them to any contexts waiting on them, composing blue fish patterns as needed
+	mImageLoader = std::make_unique<ImageLoader>(
+		"Icons/",
+		[this](const std::string& imageName, const uint32_t size, const ImageLoader::image_t& dataUri)
+		{
+			onImageLoaded(imageName, size, dataUri);
+		},
+		ImageLoader::DEFAULT_BYTE_BUDGET,
+		mFFXIVOceanFishingHelper->getImageAliases()
+	);
+
+	// publishes what each button shows for overlays and other tools to read, see ScheduleReader
+	mSchedulePublisher = std::make_unique<SchedulePublisher>();
+
+	// timer that recomputes the schedule when the earliest context goes stale
+	mTimer = std::make_unique <CallBackTimer>(mClock);
 	//timer that is called every half a second to update UI
-	mSecondsTimer = std::make_unique <CallBackTimer>();
+	mSecondsTimer = std::make_unique <CallBackTimer>(mClock);
 
 	startTimers();
 }
 
 /**
-	@brief Starts the callback timers for this plugin
+	@brief Starts any callback timers for this plugin that are not already running
 **/
 void FFXIVOceanFishingTrackerPlugin::startTimers()
 {
-	stopTimers();
-
-	const std::set <int> triggerMinutesOfTheHour = { 0, 15 };
-	mTimer->start(triggerMinutesOfTheHour, [this]()
+	mTimer->start([this]() -> std::optional<time_t>
 		{
-			// warning: this is called in the callbacktimer on a loop at certain time intervals
+			// warning: this is called in the callbacktimer on a loop, next called when the earliest context goes stale
+			const ScopedMetricsTimer metricsTimer(PluginMetrics::HISTOGRAM::TIMER_CALLBACK);
+			PluginTracer::get().nameThread("recompute timer");
+			const ScopedTraceSpan span("recompute", "timer");
+			PLUGIN_LOG_DEBUG(mLogger, "Callback function triggered");
 
-#ifdef LOGGING
-			mConnectionManager->LogMessage("Callback function triggered");
-#endif
-			// For each context, load what the context is trying to track.
-			// Then compute the seconds until the next window
+			// if no buttons are left once a burst of appear/disappear events has settled, stop the UI timer to save cpu cycles
+			{
+				std::unique_lock<std::mutex> timersLock(this->mTimersMutex);
+				bool isEmpty = false;
+				{
+					std::unique_lock<MeteredMutex> lock(this->mVisibleContextsMutex);
+					isEmpty = mContextServerMap.empty();
+				}
+				if (isEmpty)
+				{
+					mSecondsTimer->stop();
+					return NO_STATE_CHANGE; // nothing to track until a context appears and wakes us
+				}
+			}
+
+			// For each context whose results went stale or whose settings changed, load what the context is trying to track.
+			// Then compute the seconds until the next window, and until that answer changes again
 			bool status = true;
+			time_t nextStateChange = NO_STATE_CHANGE;
 			{
-				std::unique_lock<std::mutex> lock(this->mVisibleContextsMutex);
+				std::unique_lock<MeteredMutex> lock(this->mVisibleContextsMutex);
+				const time_t startTime = mClock.now();
 				for (auto& [context, metadata] : mContextServerMap)
 				{
+					// nothing about this context has changed since it was last computed, so skip it
+					if (!metadata.needUpdate && startTime < metadata.validUntil)
+					{
+						mSkippedContexts++;
+						nextStateChange = (std::min)(nextStateChange, metadata.validUntil);
+						continue;
+					}
+					mRecomputedContexts++;
+					const ScopedTraceSpan querySpan("query", "schedule");
+
 					// First find what voyages we are actually looking for.
 					// So convert what is requested to be tracked into voyage IDs
 					std::unordered_set<uint32_t> voyageIds =
@@ -69,19 +119,40 @@ void FFXIVOceanFishingTrackerPlugin::startTimers()
 					// now call the helper to compute the relative time until the next window
 					uint32_t relativeSecondsTillNextVoyage = 0;
 					uint32_t relativeWindowTime = 0;
-					time_t startTime = time(0);
-					status = mFFXIVOceanFishingHelper->getSecondsUntilNextVoyage(
+					const bool voyageFound = mFFXIVOceanFishingHelper->getSecondsUntilNextVoyage(
 						relativeSecondsTillNextVoyage,
 						relativeWindowTime,
+						metadata.nextVoyageId,
 						startTime,
 						voyageIds,
 						metadata.routeName,
 						metadata.skips
 					);
 					// store the absolute times
+					if (!voyageFound)
+						metadata.nextVoyageId = 0;
 					metadata.voyageTime = startTime + relativeSecondsTillNextVoyage;
 					metadata.windowTime = startTime + relativeWindowTime;
 
+					// find when these results go stale. Contexts tracking nothing only change with their settings,
+					// but a failed lookup of a real target is retried on the next tick.
+					uint32_t relativeStateChangeTime = UINT32_MAX;
+					if (voyageFound)
+						mFFXIVOceanFishingHelper->getSecondsUntilNextStateChange(
+							relativeStateChangeTime,
+							startTime,
+							voyageIds,
+							metadata.routeName,
+							metadata.skips
+						);
+					else if (!voyageIds.empty())
+					{
+						relativeStateChangeTime = 0;
+						status = false;
+					}
+					metadata.validUntil = startTime + relativeStateChangeTime;
+					nextStateChange = (std::min)(nextStateChange, metadata.validUntil);
+
 					std::string imageName;
 					std::string buttonLabel;
 					mFFXIVOceanFishingHelper->getImageNameAndLabel(
@@ -95,6 +166,9 @@ void FFXIVOceanFishingTrackerPlugin::startTimers()
 						metadata.skips
 					);
 
+					// overlays see the same schedule as the button, the publisher only writes it if it changed
+					publishSchedule(lock, metadata, context, voyageFound ? metadata.voyageTime : 0, relativeWindowTime > 0 ? metadata.windowTime : 0, imageName, buttonLabel);
+
 					// update the image if needUpdate flag was set, or if name/label changed
 					if (metadata.needUpdate ||
 						metadata.imageName != imageName ||
@@ -102,14 +176,68 @@ void FFXIVOceanFishingTrackerPlugin::startTimers()
 					{
 						metadata.imageName = imageName;
 						metadata.buttonLabel = buttonLabel;
-						updateImage(lock, metadata.imageName, context);
+						updateImage(lock, metadata, context);
 						metadata.needUpdate = false;
 					}
+
+					// load the icon this context will switch to at its next state change now, so the swap needs no I/O
+					if (voyageFound)
+					{
+						std::string nextImageName;
+						std::string nextButtonLabel;
+						mFFXIVOceanFishingHelper->getImageNameAndLabel(
+							nextImageName,
+							nextButtonLabel,
+							metadata.routeName,
+							metadata.tracker,
+							metadata.targetName,
+							metadata.validUntil,
+							metadata.priority,
+							metadata.skips
+						);
+						if (!nextImageName.empty() &&
+							(metadata.keySize != ImageLoader::ORIGINAL_SIZE || !mIconPack->find(nextImageName)))
+							mImageLoader->prefetch(nextImageName, metadata.keySize);
+					}
 				}
+
+				PLUGIN_LOG_DEBUG(mLogger, "Contexts recomputed: ", mRecomputedContexts, ", skipped: ", mSkippedContexts);
+				PLUGIN_LOG_DEBUG(mLogger, "Image cache: ", [this]()
+					{
+						const ImageLoader::cacheStats_t imageStats = mImageLoader->getStats();
+						return json({
+							{ "hits", imageStats.hits },
+							{ "misses", imageStats.misses },
+							{ "evictions", imageStats.evictions },
+							{ "entries", imageStats.entries },
+							{ "bytes", imageStats.bytes }
+						});
+					}());
+				PLUGIN_LOG_DEBUG(mLogger,
+					"Images sent: ", mImagesSent,
+					", bytes sent: ", mImageBytesSent,
+					", average bytes per setImage: ", mImagesSent ? mImageBytesSent / mImagesSent : 0,
+					", skipped as already shown: ", mImageBytesSkipped
+				);
 			}
 
 			this->UpdateUI();
-			return status;
+
+			// any contexts that appeared since the last call now have their titles shown
+			{
+				std::unique_lock<MeteredMutex> lock(this->mVisibleContextsMutex);
+				if (mAppearBurstCount > 0)
+					PLUGIN_LOG_DEBUG(mLogger,
+						"Showed ", mAppearBurstCount, " appearing contexts in ",
+						std::chrono::duration_cast<std::chrono::milliseconds>(mClock.steadyNow() - mAppearBurstStart).count(), "ms"
+					);
+				mAppearBurstCount = 0;
+			}
+
+			// sleep until the earliest context goes stale
+			if (!status)
+				return std::nullopt;
+			return nextStateChange;
 		});
 
 	const std::uint32_t UPDATE_INTERVAL_MS = 500;
@@ -117,7 +245,9 @@ void FFXIVOceanFishingTrackerPlugin::startTimers()
 		{
 			// warning: this is called in the callbacktimer on a loop at certain time intervals
 
+			PluginTracer::get().nameThread("ui timer");
 			this->UpdateUI();
+			this->reportMetrics(false);
 		});
 }
 
@@ -130,53 +260,136 @@ void FFXIVOceanFishingTrackerPlugin::stopTimers()
 }
 
 /**
-	@brief creates the title string displayed on a steamdeck button
+	@brief Turns metrics on or off and picks where snapshots of them go.
+	       Takes any of {"enabled": bool, "reset": bool, "output": "log" or a file path, "intervalSeconds": n, "snapshot": bool},
+	       a snapshot is written straight away if asked for, and then every interval while the UI timer runs.
 
-	@param[in] metadata the metadata to generate the string for
-	@param[in] currentTime the current time
+	@param[in] command the metrics command sent by the property inspector
+**/
+void FFXIVOceanFishingTrackerPlugin::handleMetricsCommand(const json& command)
+{
+	if (!command.is_object())
+		return;
+
+	PluginMetrics& metrics = PluginMetrics::get();
+	if (command.contains("enabled") && command["enabled"].is_boolean())
+		metrics.setEnabled(command["enabled"].get<bool>());
+	if (command.value("reset", false))
+		metrics.reset();
+
+	{
+		std::unique_lock<std::mutex> lock(mMetricsMutex);
+		if (command.contains("output") && command["output"].is_string())
+		{
+			const std::string output = command["output"].get<std::string>();
+			mMetricsFile = (output == "log") ? "" : output;
+		}
+		if (command.contains("intervalSeconds") && command["intervalSeconds"].is_number_unsigned())
+		{
+			mMetricsInterval = std::chrono::seconds(command["intervalSeconds"].get<uint32_t>());
+			mLastMetricsReport = mClock.steadyNow();
+		}
+	}
 
-	@return the title string
+	if (command.value("snapshot", false))
+		reportMetrics(true);
+}
+
+/**
+	@brief reads the metrics registry along with the plugin's own counters of the image cache, recomputes and images sent
+
+	@return the snapshot
 **/
-std::string FFXIVOceanFishingTrackerPlugin::createTitleString(
-	const contextMetaData_t& metadata,
-	const std::time_t& currentTime
-)
+json FFXIVOceanFishingTrackerPlugin::getMetricsSnapshot()
 {
-	if (metadata.targetName.empty()) return "";
+	json snapshot = PluginMetrics::get().snapshot();
+
+	const ImageLoader::cacheStats_t imageStats = mImageLoader->getStats();
+	snapshot["imageCache"] = {
+		{ "hits", imageStats.hits },
+		{ "misses", imageStats.misses },
+		{ "evictions", imageStats.evictions },
+		{ "entries", imageStats.entries },
+		{ "bytes", imageStats.bytes }
+	};
+
+	std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
+	snapshot["contexts"] = {
+		{ "visible", mContextServerMap.size() },
+		{ "recomputed", mRecomputedContexts },
+		{ "skipped", mSkippedContexts }
+	};
+	snapshot["images"] = {
+		{ "sent", mImagesSent },
+		{ "bytesSent", mImageBytesSent },
+		{ "bytesSkipped", mImageBytesSkipped }
+	};
+	return snapshot;
+}
 
-	std::string titleString  = metadata.buttonLabel + "\n";
-	// if we have skips, add a number to the top right
-	if (metadata.skips != 0)
-		titleString += "               " + std::to_string(metadata.skips);
-	titleString += "\n";
+/**
+	@brief writes a metrics snapshot as one line of json, to the Stream Deck log or appended to the metrics file
 
-	// check to see if we are in a window, and display a timer for that
-	int windowTimeLeft = static_cast<int>(difftime(metadata.windowTime, currentTime));
-	if (windowTimeLeft <= 15 * 60 && windowTimeLeft > 0)
+	@param[in] isForced true to write it now, false to only write it if metrics are on and the interval has passed
+**/
+void FFXIVOceanFishingTrackerPlugin::reportMetrics(const bool isForced)
+{
+	if (mConnectionManager == nullptr)
+		return;
+
+	std::string file;
 	{
-		titleString += "Window ends:\n";
-		titleString += timeutils::convertSecondsToHMSString(windowTimeLeft) + "\n";
+		std::unique_lock<std::mutex> lock(mMetricsMutex);
+		const std::chrono::steady_clock::time_point now = mClock.steadyNow();
+		if (!isForced &&
+			(!PluginMetrics::get().isEnabled() ||
+			mMetricsInterval.count() == 0 ||
+			now - mLastMetricsReport < mMetricsInterval))
+			return;
+		mLastMetricsReport = now;
+		file = mMetricsFile;
 	}
-	else
-		titleString += "\n\n";
 
-	// display either the date or time
-	if (metadata.dateOrTime)
+	const std::string line = getMetricsSnapshot().dump();
+	if (file.empty())
 	{
-		timeutils::date_t date{};
-		if (timeutils::convertTimeToDate(date, metadata.voyageTime))
-			if (mTimekeepingMode == TIMEKEEPING_MODE::MODE_24H)
-				titleString += date.weekday + " " + date.month + " " + std::to_string(date.day) + "\n" + date.time24H;
-			else
-				titleString += date.weekday + " " + date.month + " " + std::to_string(date.day) + "\n" + date.time12H;
-		else
-			titleString += "Error";
+		mConnectionManager->LogMessage(line);
+		return;
 	}
-	else
-		titleString += "\n" + timeutils::convertSecondsToHMSString(
-			static_cast<int>(difftime(metadata.voyageTime, currentTime)));
 
-	return titleString;
+	std::ofstream output(file, std::ios::app);
+	if (!output)
+	{
+		PLUGIN_LOG_ERROR(mLogger, "could not open metrics file: ", file);
+		return;
+	}
+	output << line << '\n';
+}
+
+/**
+	@brief creates the title string displayed on a steamdeck button
+
+	@param[in] metadata the metadata to generate the string for
+	@param[in] currentTime the current time
+
+	@return view of the title string, held in the context's title buffer until its next render
+**/
+std::string_view FFXIVOceanFishingTrackerPlugin::createTitleString(
+	contextMetaData_t& metadata,
+	const std::time_t& currentTime
+)
+{
+	if (metadata.targetName.empty()) return "";
+
+	return metadata.titleFormatter.format(
+		metadata.buttonLabel,
+		metadata.skips,
+		metadata.windowTime,
+		metadata.voyageTime,
+		metadata.dateOrTime,
+		mTimekeepingMode == TIMEKEEPING_MODE::MODE_24H,
+		currentTime
+	);
 }
 
 
@@ -186,12 +399,43 @@ std::string FFXIVOceanFishingTrackerPlugin::createTitleString(
 void FFXIVOceanFishingTrackerPlugin::UpdateUI()
 {
 	if (mConnectionManager == nullptr) return;
+	const ScopedMetricsTimer metricsTimer(PluginMetrics::HISTOGRAM::UPDATE_UI);
+	const ScopedTraceSpan span("updateUI", "timer");
+
+	std::unique_lock<std::mutex> liveImagesLock(mLiveImagesMutex);
+	mChangedLiveImages.clear();
+	{
+		std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
+		// go through all our visible contexts and set the title to show what we are tracking and the window times
+		time_t now = mClock.now();
+		for (auto& [context, metadata] : mContextServerMap)
+		{
+			mConnectionManager->SetTitle(createTitleString(metadata, now), context, kESDSDKTarget_HardwareAndSoftware);
+			if (metadata.showProgressRing && drawLiveImage(lock, metadata, now))
+				mChangedLiveImages.emplace_back(context, metadata.liveImage);
+		}
+	}
+	if (mChangedLiveImages.empty()) return;
+
+	// encode without blocking the other contexts, mLiveImagesMutex keeps the images from being drawn meanwhile.
+	// The ring only moves every few seconds, so favour encode speed over size
+	for (auto& [context, liveImage] : mChangedLiveImages)
+	{
+		const std::vector<uint8_t>& png = liveImage->canvas.encodePng(ButtonCanvas::ENCODE_MODE::FAST);
+		liveImage->dataUri.clear();
+		if (png.empty()) continue;
+		liveImage->dataUri.assign("data:image/png;base64,");
+		imageutils::pngToBase64(liveImage->dataUri, png);
+	}
 
-	std::unique_lock<std::mutex> lock(mVisibleContextsMutex);
-	// go through all our visible contexts and set the title to show what we are tracking and the window times
-	time_t now = time(0);
-	for (const auto& [context, metadata] : mContextServerMap)
-		mConnectionManager->SetTitle(createTitleString(metadata, now), context, kESDSDKTarget_HardwareAndSoftware);
+	// send the images of contexts still showing them
+	std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
+	for (const auto& [context, liveImage] : mChangedLiveImages)
+	{
+		const auto it = mContextServerMap.find(context);
+		if (it != mContextServerMap.end() && it->second.liveImage == liveImage && !liveImage->dataUri.empty())
+			sendImage(lock, it->second, context, liveImage->dataUri);
+	}
 }
 
 
@@ -199,7 +443,7 @@ void FFXIVOceanFishingTrackerPlugin::KeyDownForAction(const std::string& /*inAct
 {
 	std::string url;
 	{
-		std::unique_lock<std::mutex> lock(mVisibleContextsMutex);
+		std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
 		url = mContextServerMap.at(inContext).url;
 	}
 
@@ -222,9 +466,7 @@ void FFXIVOceanFishingTrackerPlugin::KeyUpForAction(const std::string& /*inActio
 **/
 FFXIVOceanFishingTrackerPlugin::contextMetaData_t FFXIVOceanFishingTrackerPlugin::readJsonIntoMetaData(const json& payload)
 {
-	#ifdef LOGGING
-	mConnectionManager->LogMessage(payload.dump(4));
-	#endif
+	PLUGIN_LOG_DEBUG(mLogger, "Settings: ", payload);
 	contextMetaData_t data{};
 
 	if (payload.contains("Route"))
@@ -259,6 +501,9 @@ FFXIVOceanFishingTrackerPlugin::contextMetaData_t FFXIVOceanFishingTrackerPlugin
 	if (payload.contains("url"))
 		data.url = payload["url"].get<std::string>();
 
+	if (payload.contains("ProgressRing"))
+		data.showProgressRing = payload["ProgressRing"].get<bool>();
+
 	data.voyageTime = 0;
 	data.windowTime = 0;
 	data.needUpdate = false;
@@ -269,53 +514,196 @@ FFXIVOceanFishingTrackerPlugin::contextMetaData_t FFXIVOceanFishingTrackerPlugin
 	return data;
 }
 
-std::optional<std::string> FFXIVOceanFishingTrackerPlugin::loadBase64Image(const std::unique_lock<std::mutex>& lock, const std::string& imageName)
+/**
+	@brief Updates the selected context's image icon. On keys of a known size the icon is shrunk and recompressed to fit,
+	       otherwise it is sent as shipped from the icon pack.
+	       If the icon is not ready yet, it is pushed once the loader finishes.
+
+	@param[in] lock proof that mVisibleContextsMutex is held
+	@param[in] metadata the context's metadata, imageName is the tracker name. The image file is Icons/<imageName>.png
+	@param[in] inContext the context to update
+**/
+void FFXIVOceanFishingTrackerPlugin::updateImage(const std::unique_lock<MeteredMutex>& lock, contextMetaData_t& metadata, const std::string& inContext)
 {
-	if (!lock.owns_lock()) return std::nullopt;
+	if (!lock.owns_lock()) return;
+	const ScopedTraceSpan span("updateImage", "image");
 
-	// if image was cached, just retrieve from cache
-	if (mImageNameToBase64Map.contains(imageName)) return mImageNameToBase64Map.at(imageName);
+	const std::string defaultImageName = "default";
+	if (metadata.imageName.empty())
+		metadata.imageName = defaultImageName;
+
+	// live images are redrawn over the new icon on the next UI update instead
+	if (metadata.showProgressRing)
+	{
+		metadata.isImagePending = false;
+		return;
+	}
 
-	// image was not cached, try to load the image from file
-	std::vector<uint8_t> buffer;
-	const std::string filename = "Icons/" + imageName + ".png";
-	if (lodepng::load_file(buffer, filename) != 0) return std::nullopt; // load failed
+	if (metadata.keySize != ImageLoader::ORIGINAL_SIZE)
+	{
+		const ImageLoader::image_t fitted = mImageLoader->getOrLoad(metadata.imageName, metadata.keySize);
+		metadata.isImagePending = !fitted;
+		if (fitted)
+			sendImage(lock, metadata, inContext, *fitted);
+		// show the icon as shipped until the fitted one is ready
+		else if (const std::optional<std::string_view> dataUri = mIconPack->find(metadata.imageName))
+			sendImage(lock, metadata, inContext, *dataUri);
+		return;
+	}
 
-	std::string base64Image;
-	imageutils::pngToBase64(base64Image, buffer);
-	mImageNameToBase64Map.emplace( imageName, base64Image ); // store to cache for next time
-	return base64Image;
+	if (const std::optional<std::string_view> dataUri = mIconPack->find(metadata.imageName))
+	{
+		metadata.isImagePending = false;
+		sendImage(lock, metadata, inContext, *dataUri);
+		return;
+	}
+
+	const ImageLoader::image_t dataUri = mImageLoader->getOrLoad(metadata.imageName);
+	metadata.isImagePending = !dataUri;
+	if (dataUri)
+		sendImage(lock, metadata, inContext, *dataUri);
 }
 
+/**
+	@brief Sends an image to the selected context, unless the context is already showing it
+
+	@param[in] lock proof that mVisibleContextsMutex is held
+	@param[in] metadata the context's metadata
+	@param[in] inContext the context to update
+	@param[in] image the data URI to show, or empty to go back to the default image
+**/
+void FFXIVOceanFishingTrackerPlugin::sendImage(const std::unique_lock<MeteredMutex>& lock, contextMetaData_t& metadata, const std::string& inContext, std::string_view image)
+{
+	if (!lock.owns_lock()) return;
+
+	if (!metadata.imageSendFilter.shouldSend(image))
+	{
+		mImageBytesSkipped += image.size();
+		return;
+	}
+
+	mImagesSent++;
+	mImageBytesSent += image.size();
+	mConnectionManager->SetImage(image, inContext, 0);
+}
 
 /**
-	@brief Updates the selected context's image icon
+	@brief Redraws a context's live image, the caller encodes and sends it if anything changed.
+	       The ring fills as the next voyage nears, and while a fishing window is open it is framed and drains until the window ends.
+	       Must be called while holding mLiveImagesMutex.
 
-	@param[in] name the tracker name. The function will look for the image file in Icons/<name>.png
+	@param[in] lock proof that mVisibleContextsMutex is held
+	@param[in] metadata the context's metadata
+	@param[in] currentTime the current time
+
+	@return true if the live image changed and needs sending
 **/
-void FFXIVOceanFishingTrackerPlugin::updateImage(const std::unique_lock<std::mutex>& lock, std::string& name, const std::string& inContext)
+bool FFXIVOceanFishingTrackerPlugin::drawLiveImage(const std::unique_lock<MeteredMutex>& lock, contextMetaData_t& metadata, const time_t& currentTime)
 {
-	const std::string defaultImageName = "default";
-	if (name.empty())
-		name = defaultImageName;
+	if (!lock.owns_lock()) return false;
 
-	const std::optional<std::string> imgData = loadBase64Image(lock, name);
+	// wait for the first recompute to pick the icon
+	if (metadata.imageName.empty()) return false;
 
-	if (!imgData)
-		mConnectionManager->LogMessage("Error: unable to load image icon for target: " + name);
+	if (!metadata.liveImage)
+		metadata.liveImage = std::make_shared<liveImage_t>(metadata.keySize != ImageLoader::ORIGINAL_SIZE ? metadata.keySize : LIVE_IMAGE_SIZE);
+	liveImage_t& liveImage = *metadata.liveImage;
+	ButtonCanvas& canvas = liveImage.canvas;
 
-	mConnectionManager->SetImage(imgData.value_or(""), inContext, 0);
+	if (liveImage.imageName != metadata.imageName)
+	{
+		// the icon is decoded on the loader thread, keep showing the last image until the next UI update picks it up
+		const ImageLoader::pixels_t icon = mImageLoader->getOrLoadPixels(metadata.imageName, canvas.getSize());
+		if (!icon) return false;
+
+		liveImage.imageName = metadata.imageName;
+		if (!icon->rgba.empty())
+			canvas.setBackground(icon->rgba.data(), icon->width, icon->height);
+		else
+			PLUGIN_LOG_ERROR(mLogger, "unable to load image icon for target: ", metadata.imageName);
+	}
+
+	const double windowTimeLeft = difftime(metadata.windowTime, currentTime);
+	const bool isWindowOpen = windowTimeLeft > 0 && windowTimeLeft <= FISHING_WINDOW_TIME;
+	canvas.setHighlight(isWindowOpen);
+	if (isWindowOpen)
+		canvas.setProgress(static_cast<float>(windowTimeLeft / FISHING_WINDOW_TIME));
+	else
+	{
+		const double voyageTimeLeft = (std::min)(difftime(metadata.voyageTime, currentTime), static_cast<double>(PROGRESS_RING_TIME));
+		canvas.setProgress(static_cast<float>(1.0 - voyageTimeLeft / PROGRESS_RING_TIME));
+	}
+
+	return canvas.hasChanged();
+}
+
+/**
+	@brief Runs on the image loader thread when an icon finishes loading, pushes it to the contexts waiting on it
+
+	@param[in] imageName the name of the image that was loaded
+	@param[in] size the key size the image was fitted to
+	@param[in] dataUri the loaded image, or nullptr if it failed to load
+**/
+void FFXIVOceanFishingTrackerPlugin::onImageLoaded(const std::string& imageName, const uint32_t size, const ImageLoader::image_t& dataUri)
+{
+	if (mConnectionManager == nullptr) return;
+
+	std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
+	for (auto& [context, metadata] : mContextServerMap)
+	{
+		if (!metadata.isImagePending || metadata.imageName != imageName || metadata.keySize != size)
+			continue;
+
+		if (!dataUri)
+			PLUGIN_LOG_ERROR(mLogger, "unable to load image icon for target: ", imageName);
+
+		sendImage(lock, metadata, context, dataUri ? std::string_view(*dataUri) : std::string_view());
+		metadata.isImagePending = false;
+	}
+}
+
+/**
+	@brief Publishes what a context shows to shared memory, for overlays and other tools
+
+	@param[in] lock proof that mVisibleContextsMutex is held
+	@param[in] metadata the context's last computed schedule
+	@param[in] inContext the context
+	@param[in] voyageTime when the next voyage leaves, 0 if none was found
+	@param[in] windowEnd when the window open now closes, 0 if none is open
+	@param[in] imageName the image the button shows
+	@param[in] buttonLabel the title the button shows
+**/
+void FFXIVOceanFishingTrackerPlugin::publishSchedule(const std::unique_lock<MeteredMutex>& lock, const contextMetaData_t& metadata, const std::string& inContext, const time_t& voyageTime, const time_t& windowEnd, const std::string& imageName, const std::string& buttonLabel)
+{
+	if (!lock.owns_lock() || !mSchedulePublisher->isInit()) return;
+
+	sharedschedule::contextState_t state{};
+	sharedschedule::copyText(state.routeName, metadata.routeName);
+	sharedschedule::copyText(state.tracker, metadata.tracker);
+	sharedschedule::copyText(state.targetName, metadata.targetName);
+	sharedschedule::copyText(state.buttonLabel, buttonLabel);
+	sharedschedule::copyText(state.imageName, imageName);
+	state.voyageTime = voyageTime;
+	state.windowEnd = windowEnd;
+	state.nextVoyageId = metadata.nextVoyageId;
+	if (!mSchedulePublisher->publish(inContext, state))
+		PLUGIN_LOG_ERROR(mLogger, "unable to publish the schedule of context: ", inContext, ", more than ", sharedschedule::MAX_CONTEXTS, " contexts are shown");
 }
 
 /**
 	@brief Runs when app shows up on streamdeck profile
 **/
-void FFXIVOceanFishingTrackerPlugin::WillAppearForAction(const std::string& /*inAction*/, const std::string& inContext, const json& inPayload, const std::string& /*inDeviceID*/)
+void FFXIVOceanFishingTrackerPlugin::WillAppearForAction(const std::string& /*inAction*/, const std::string& inContext, const json& inPayload, const std::string& inDeviceID)
 {
 	if (!mIsGlobalSettingsReceived)
 	{
 		mConnectionManager->GetGlobalSettings();
 		mIsGlobalSettingsReceived = true;
+
+		if (!mIconPack->isInit())
+			PLUGIN_LOG_ERROR(mLogger, mIconPack->getErrorMessage(), ", loading icons from file instead");
+		if (!mSchedulePublisher->isInit())
+			PLUGIN_LOG_ERROR(mLogger, mSchedulePublisher->getErrorMessage(), ", the schedule is not published for overlays");
 	}
 
 	// read payload for any saved settings, update image if needed
@@ -324,17 +712,28 @@ void FFXIVOceanFishingTrackerPlugin::WillAppearForAction(const std::string& /*in
 		data = readJsonIntoMetaData(inPayload["settings"]);
 	data.needUpdate = true;
 
-	std::unique_lock<std::mutex> lock(mVisibleContextsMutex);
+	std::unique_lock<std::mutex> timersLock(mTimersMutex);
+	std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
 
-	// if this is the first plugin to be displayed, boot up the timers
-	if (mContextServerMap.empty())
-		startTimers();
+	// if the UI timer was stopped because nothing was displayed, boot it back up
+	startTimers();
+
+	// the Stream Deck keeps showing the last image sent to a context while it is hidden, so carry on from it
+	if (const std::optional<ImageSendFilter> hidden = mHiddenImageSendFilters.reappear(inContext))
+		data.imageSendFilter = *hidden;
+
+	data.deviceId = inDeviceID;
+	if (const auto device = mDeviceKeySizes.find(inDeviceID); device != mDeviceKeySizes.end())
+		data.keySize = device->second;
 
 	// Remember the context and the saved server name for this app
 	mContextServerMap.emplace(inContext, data);
 
-	// update tracked timers
-	this->mTimer->wake();
+	if (mAppearBurstCount++ == 0)
+		mAppearBurstStart = mClock.steadyNow();
+
+	// update tracked timers once the rest of the page has appeared, only the new contexts are computed
+	this->mTimer->wake(CONTEXT_SETTLE_TIME);
 }
 
 /**
@@ -343,12 +742,18 @@ void FFXIVOceanFishingTrackerPlugin::WillAppearForAction(const std::string& /*in
 void FFXIVOceanFishingTrackerPlugin::WillDisappearForAction(const std::string& /*inAction*/, const std::string& inContext, const json &/*inPayload*/, const std::string& /*inDeviceID*/)
 {
 	// Remove this particular context so we don't have to process it when updating UI
-	std::unique_lock<std::mutex> lock(mVisibleContextsMutex);
-	mContextServerMap.erase(inContext);
+	std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
+	if (const auto it = mContextServerMap.find(inContext); it != mContextServerMap.end())
+	{
+		mHiddenImageSendFilters.hide(inContext, it->second.imageSendFilter);
+		mContextServerMap.erase(it);
+	}
+	mSchedulePublisher->remove(inContext);
 
-	// if we have no active plugin displayed, kill the timers to save cpu cycles
+	// if we have no active plugin displayed, let the timer kill the UI updates to save cpu cycles.
+	// Wait for the burst to settle first since a profile switch shows new buttons right after.
 	if (mContextServerMap.empty())
-		stopTimers();
+		this->mTimer->wake(CONTEXT_SETTLE_TIME);
 }
 
 /**
@@ -356,6 +761,13 @@ void FFXIVOceanFishingTrackerPlugin::WillDisappearForAction(const std::string& /
 **/
 void FFXIVOceanFishingTrackerPlugin::SendToPlugin(const std::string& /*inAction*/, const std::string& inContext, const json& inPayload, const std::string& /*inDeviceID*/)
 {
+	// metrics commands are not settings for this context
+	if (inPayload.contains("metrics"))
+	{
+		handleMetricsCommand(inPayload["metrics"]);
+		return;
+	}
+
 	// setup the routes menu
 	{
 		std::unique_lock<std::mutex> lock(mInitMutex);
@@ -370,20 +782,20 @@ void FFXIVOceanFishingTrackerPlugin::SendToPlugin(const std::string& /*inAction*
 	}
 
 	// PI dropdown menu has saved new settings for this context, load those
-	std::unique_lock<std::mutex> lock(mVisibleContextsMutex);
+	std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
 	if (!mContextServerMap.contains(inContext))
 	{
-		mConnectionManager->LogMessage("Error: SendToPlugin: could not find stored context: " + inContext + "\nPayload:\n" + inPayload.dump(4));
-		mConnectionManager->LogMessage(inContext);
+		PLUGIN_LOG_ERROR(mLogger, "SendToPlugin: could not find stored context: ", inContext, ", payload: ", inPayload);
 		return;
 	}
 
 	contextMetaData_t data = readJsonIntoMetaData(inPayload);
 	if (data.routeName != mContextServerMap.at(inContext).routeName ||
 		data.targetName != mContextServerMap.at(inContext).targetName ||
-		data.tracker != mContextServerMap.at(inContext).tracker)
+		data.tracker != mContextServerMap.at(inContext).tracker ||
+		data.showProgressRing != mContextServerMap.at(inContext).showProgressRing)
 	{
-		// update image since name changed
+		// update image since name or style changed
 		data.needUpdate = true;
 	}
 
@@ -395,7 +807,10 @@ void FFXIVOceanFishingTrackerPlugin::SendToPlugin(const std::string& /*inAction*
 		mConnectionManager->SetSettings(j, inContext);
 	}
 
-	// updated stored settings
+	// updated stored settings, the button is still showing the same image on the same key though
+	data.imageSendFilter = mContextServerMap.at(inContext).imageSendFilter;
+	data.deviceId = mContextServerMap.at(inContext).deviceId;
+	data.keySize = mContextServerMap.at(inContext).keySize;
 	mContextServerMap.at(inContext) = data;
 
 	// update tracked timers
@@ -407,13 +822,19 @@ void FFXIVOceanFishingTrackerPlugin::SendToPlugin(const std::string& /*inAction*
 **/
 void FFXIVOceanFishingTrackerPlugin::DidReceiveGlobalSettings(const json& inPayload)
 {
-	json j = inPayload["settings"];
+	const auto settings = inPayload.find("settings");
+	if (settings == inPayload.end())
+		return;
+
+	updateTracing(*settings);
+	updateLogging(*settings);
+	updateMetrics(*settings);
 
 	TIMEKEEPING_MODE timeMode = mTimekeepingMode;
-	if (j.contains("Timekeeping24HMode"))
-		timeMode = j["Timekeeping24HMode"].get<bool>() ? TIMEKEEPING_MODE::MODE_24H : TIMEKEEPING_MODE::MODE_12H;
+	if (const auto mode = settings->find("Timekeeping24HMode"); mode != settings->end())
+		timeMode = mode->get<bool>() ? TIMEKEEPING_MODE::MODE_24H : TIMEKEEPING_MODE::MODE_12H;
 
-	std::unique_lock<std::mutex> lock(mVisibleContextsMutex);
+	std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
 	if (timeMode == mTimekeepingMode) return;
 
 	mTimekeepingMode = timeMode;
@@ -421,12 +842,154 @@ void FFXIVOceanFishingTrackerPlugin::DidReceiveGlobalSettings(const json& inPayl
 	this->mTimer->wake();
 }
 
-void FFXIVOceanFishingTrackerPlugin::DeviceDidConnect(const std::string& /*inDeviceID*/, const json& /*inDeviceInfo*/)
+/**
+	@brief Starts recording a trace when "Tracing" is turned on in the global settings, and writes it out when turned off.
+	       The trace goes to "TraceFile" if set, otherwise to the temp folder.
+
+	@param[in] settings the global settings
+**/
+void FFXIVOceanFishingTrackerPlugin::updateTracing(const json& settings)
+{
+	const auto tracing = settings.find("Tracing");
+	if (tracing == settings.end() || !tracing->is_boolean())
+		return;
+
+	PluginTracer& tracer = PluginTracer::get();
+	if (tracing->get<bool>() == tracer.isEnabled())
+		return;
+
+	if (tracing->get<bool>())
+	{
+		mTraceFile = settings.value("TraceFile", "");
+		if (mTraceFile.empty())
+		{
+			std::error_code ec;
+			mTraceFile = (std::filesystem::temp_directory_path(ec) / "ffxivoceanfishing.trace.json").string();
+		}
+		tracer.clear();
+		tracer.setEnabled(true);
+		return;
+	}
+
+	tracer.setEnabled(false);
+	if (tracer.write(mTraceFile))
+		PLUGIN_LOG_INFO(mLogger, "Trace written to: ", mTraceFile);
+	else
+		PLUGIN_LOG_ERROR(mLogger, "could not write trace file: ", mTraceFile);
+}
+
+/**
+	@brief Sets the log level from "LogLevel" in the global settings, debug, info, warning or error,
+	       and sends the log to the rotating file "LogFile" if set, or the Stream Deck's log otherwise
+
+	@param[in] settings the global settings
+**/
+void FFXIVOceanFishingTrackerPlugin::updateLogging(const json& settings)
 {
-	// Nothing to do
+	if (const auto level = settings.find("LogLevel"); level != settings.end() && level->is_string())
+	{
+		if (const std::optional<LOG_LEVEL> logLevel = PluginLogger::toLevel(level->get<std::string>()))
+			mLogger.setLevel(*logLevel);
+	}
+
+	const std::string logFile = settings.value("LogFile", "");
+	if (logFile != mLogFile)
+	{
+		mLogFile = logFile;
+		mLogger.setFile(mLogFile);
+	}
 }
 
-void FFXIVOceanFishingTrackerPlugin::DeviceDidDisconnect(const std::string& /*inDeviceID*/)
+/**
+	@brief Turns metrics on or off from "Metrics" in the global settings. While on, a snapshot is written
+	       every METRICS_SETTING_INTERVAL, to the Stream Deck log unless the metrics command picked a file
+
+	@param[in] settings the global settings
+**/
+void FFXIVOceanFishingTrackerPlugin::updateMetrics(const json& settings)
 {
-	// Nothing to do
+	const auto metrics = settings.find("Metrics");
+	if (metrics == settings.end() || !metrics->is_boolean())
+		return;
+
+	PluginMetrics& registry = PluginMetrics::get();
+	if (metrics->get<bool>() == registry.isEnabled())
+		return;
+
+	if (metrics->get<bool>())
+	{
+		std::unique_lock<std::mutex> lock(mMetricsMutex);
+		mMetricsInterval = METRICS_SETTING_INTERVAL;
+		mLastMetricsReport = mClock.steadyNow();
+	}
+	registry.setEnabled(metrics->get<bool>());
+	PLUGIN_LOG_INFO(mLogger, "Metrics turned ", metrics->get<bool>() ? "on" : "off");
+}
+
+/**
+	@brief gets the pixel size of a device's keys, icons larger than this are shrunk before they are sent
+
+	@param[in] deviceInfo the device info sent with DeviceDidConnect
+
+	@return the key size, or ImageLoader::ORIGINAL_SIZE for device types newer than this plugin
+**/
+uint32_t FFXIVOceanFishingTrackerPlugin::getKeySize(const json& deviceInfo)
+{
+	if (!deviceInfo.contains(kESDSDKDeviceInfoType) || !deviceInfo[kESDSDKDeviceInfoType].is_number_integer())
+		return ImageLoader::ORIGINAL_SIZE;
+
+	switch (deviceInfo[kESDSDKDeviceInfoType].get<ESDSDKDeviceType>())
+	{
+	case kESDSDKDeviceType_StreamDeck:
+		return 72;
+	case kESDSDKDeviceType_StreamDeckMini:
+		return 80;
+	case kESDSDKDeviceType_StreamDeckXL:
+	case kESDSDKDeviceType_StreamDeckNeo:
+		return 96;
+	case kESDSDKDeviceType_StreamDeckPlus:
+		return 120;
+	// phones show keys at twice the standard size
+	case kESDSDKDeviceType_StreamDeckMobile:
+		return 144;
+	// keys with no screen, or a small touch strip, only need the standard size the Stream Deck app shows them at
+	case kESDSDKDeviceType_StreamDeckPedal:
+	case kESDSDKDeviceType_CorsairGKeys:
+	case kESDSDKDeviceType_CorsairVoyager:
+	case kESDSDKDeviceType_SCUFController:
+		return 72;
+	default:
+		return ImageLoader::ORIGINAL_SIZE;
+	}
+}
+
+/**
+	@brief Runs when a device is plugged in, and for every device at startup. Remembers its key size,
+	       and redraws buttons already showing on it if they were sized for another key.
+**/
+void FFXIVOceanFishingTrackerPlugin::DeviceDidConnect(const std::string& inDeviceID, const json& inDeviceInfo)
+{
+	const uint32_t keySize = getKeySize(inDeviceInfo);
+
+	std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
+	mDeviceKeySizes.insert_or_assign(inDeviceID, keySize);
+
+	bool isChanged = false;
+	for (auto& [context, metadata] : mContextServerMap)
+	{
+		if (metadata.deviceId != inDeviceID || metadata.keySize == keySize)
+			continue;
+		metadata.keySize = keySize;
+		metadata.liveImage.reset();
+		metadata.needUpdate = true;
+		isChanged = true;
+	}
+	if (isChanged)
+		this->mTimer->wake();
+}
+
+void FFXIVOceanFishingTrackerPlugin::DeviceDidDisconnect(const std::string& inDeviceID)
+{
+	std::unique_lock<MeteredMutex> lock(mVisibleContextsMutex);
+	mDeviceKeySizes.erase(inDeviceID);
 }
\ No newline at end of file
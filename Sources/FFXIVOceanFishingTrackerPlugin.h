@@ -8,12 +8,24 @@
 
 #include "Common/ESDBasePlugin.h"
 #include <mutex>
+#include <chrono>
 #include <unordered_map>
 #include <string>
 #include <optional>
+#include <limits>
 #include "Windows/Common.h"
+#include "Windows/Clock.h"
 #include "Windows/CallBackTimer.h"
+#include "Windows/PluginMetrics.h"
+#include "Windows/PluginTracer.h"
+#include "Windows/PluginLogger.h"
+#include "Windows/TitleFormatter.h"
+#include "Windows/ImageSendFilter.h"
+#include "Windows/ButtonCanvas.h"
+#include "Windows/ImageLoader.h"
+#include "Windows/IconPack.h"
 #include "Windows/FFXIVOceanFishingHelper.h"
+#include "Windows/SchedulePublisher.h"
 
 #include "Vendor/json/src/json.hpp"
 using json = nlohmann::json;
@@ -23,8 +35,8 @@ class FFXIVOceanFishingTrackerPlugin : public ESDBasePlugin
 {
 public:
 	
-	FFXIVOceanFishingTrackerPlugin();
-	virtual ~FFXIVOceanFishingTrackerPlugin() {};
+	explicit FFXIVOceanFishingTrackerPlugin(Clock& clock = Clock::system());
+	virtual ~FFXIVOceanFishingTrackerPlugin() { stopTimers(); mImageLoader.reset(); };
 	
 	void KeyDownForAction(const std::string& inAction, const std::string& inContext, const json &inPayload, const std::string& inDeviceID) override;
 	void KeyUpForAction(const std::string& inAction, const std::string& inContext, const json &inPayload, const std::string& inDeviceID) override;
@@ -38,6 +50,16 @@ public:
 	void SendToPlugin(const std::string& inAction, const std::string& inContext, const json &inPayload, const std::string& inDeviceID) override;
 	void DidReceiveGlobalSettings(const json& inPayload) override;
 private:
+	// the live image of a context, only drawn and encoded while holding mLiveImagesMutex
+	struct liveImage_t
+	{
+		explicit liveImage_t(const uint32_t size) : canvas(size) {};
+
+		ButtonCanvas canvas;
+		std::string imageName; // the icon currently drawn under the ring
+		std::string dataUri; // reusable buffer the image is encoded into
+	};
+
 	// this struct contains a context's saved settings
 	struct contextMetaData_t
 	{
@@ -46,13 +68,22 @@ private:
 		std::string tracker; // tracker type, ie: blue fish or voyage name
 		std::string buttonLabel; // the text on the top of the button
 		std::string imageName; // the name of the image to use for this button
+		bool isImagePending = false; // true while the image is loading, it is sent once the loader finishes
 		PRIORITY priority = PRIORITY::BLUE_FISH; // whether to prioritize showing achievements or blue fish for this button
 		bool needUpdate = false; // true if this button needs an update to image name and label
 		time_t voyageTime = 0; // time of next voyage
+		uint32_t nextVoyageId = 0; // the voyage whose window is open, or otherwise the next voyage
 		time_t windowTime = 0; // if we are in a fishing window, this holds the time remaining
+		time_t validUntil = 0; // time the voyage, window, image and label above go stale and need recomputing
 		bool dateOrTime = false; // true for date, false for time
 		uint32_t skips = 0; // number of times to skip over, a skip=1 is "find next", skip=2 is "find next next", etc.
 		std::string url; // webpage to open on click, each button can have a different webpage
+		TitleFormatter titleFormatter; // reusable buffer the title of this button is rendered into
+		ImageSendFilter imageSendFilter; // the image this button is showing, so it is not resent
+		std::string deviceId; // the device this button is on
+		uint32_t keySize = ImageLoader::ORIGINAL_SIZE; // pixel size of the key this button is on, icons are shrunk to fit it
+		bool showProgressRing = false; // true to draw a countdown ring and window highlight over the icon
+		std::shared_ptr<liveImage_t> liveImage; // the live image of this button, made on its first draw
 	};
 
 	// global settings for 12h or 24h time to be displayed when displaying a Date on the buttton
@@ -63,10 +94,10 @@ private:
 	};
 	TIMEKEEPING_MODE mTimekeepingMode = TIMEKEEPING_MODE::MODE_12H;
 
-	std::string createTitleString( const contextMetaData_t& metadata, const std::time_t& currentTime);
+	std::string_view createTitleString(contextMetaData_t& metadata, const std::time_t& currentTime);
 	void UpdateUI();
 	
-	std::mutex mVisibleContextsMutex;
+	MeteredMutex mVisibleContextsMutex{ PluginMetrics::HISTOGRAM::CONTEXTS_MUTEX_WAIT, PluginMetrics::HISTOGRAM::CONTEXTS_MUTEX_HOLD };
 
 	// on first time the app appears we need these to trigger sending Route settings
 	std::mutex mInitMutex;
@@ -75,18 +106,94 @@ private:
 	
 	std::unordered_map<std::string, contextMetaData_t> mContextServerMap;
 
+	// number of times a timer tick recomputed a context, versus skipped it because its results were still valid
+	uint64_t mRecomputedContexts = 0;
+	uint64_t mSkippedContexts = 0;
+
 	contextMetaData_t readJsonIntoMetaData(const json& payload);
 
-	// contains cache of base64 images that have been loaded
-	std::unordered_map<std::string, std::string> mImageNameToBase64Map;
-	std::optional<std::string> loadBase64Image(const std::unique_lock<std::mutex>& lock, const std::string& imageName);
+	// prebuilt data URIs of every shipped icon, mapped once at startup
+	std::unique_ptr<IconPack> mIconPack;
+
+	// loads and caches the base64 images off the timer thread, for icons missing from the pack
+	std::unique_ptr<ImageLoader> mImageLoader;
+	void onImageLoaded(const std::string& imageName, const uint32_t size, const ImageLoader::image_t& dataUri);
+
+	// key pixel size of each connected device, by device id
+	std::unordered_map<std::string, uint32_t> mDeviceKeySizes;
+	static uint32_t getKeySize(const json& deviceInfo);
+
+	void updateImage(const std::unique_lock<MeteredMutex>& lock, contextMetaData_t& metadata, const std::string& inContext);
+	void sendImage(const std::unique_lock<MeteredMutex>& lock, contextMetaData_t& metadata, const std::string& inContext, std::string_view image);
+
+	// serializes drawing and encoding the live images. Encoding runs outside mVisibleContextsMutex, lock this one before it
+	std::mutex mLiveImagesMutex;
+	// live images that changed in the current UI update, only used while holding mLiveImagesMutex
+	std::vector<std::pair<std::string, std::shared_ptr<liveImage_t>>> mChangedLiveImages;
+	bool drawLiveImage(const std::unique_lock<MeteredMutex>& lock, contextMetaData_t& metadata, const time_t& currentTime);
+
+	// live images are drawn at the key size, or the standard Stream Deck key size if it is not known.
+	// The ring fills over the last hour before a voyage, then drains over the fishing window
+	static constexpr uint32_t LIVE_IMAGE_SIZE = 72;
+	static constexpr time_t PROGRESS_RING_TIME = 60 * 60;
+	static constexpr time_t FISHING_WINDOW_TIME = 15 * 60;
+
+	// images last sent to contexts that are currently hidden, restored when they reappear
+	HiddenImageSendFilters mHiddenImageSendFilters;
 
-	void updateImage(const std::unique_lock<std::mutex>& lock, std::string& pngfile, const std::string& inContext);
+	// images and bytes of image data sent to the Stream Deck, versus bytes skipped because the button already showed that image
+	uint64_t mImagesSent = 0;
+	uint64_t mImageBytesSent = 0;
+	uint64_t mImageBytesSkipped = 0;
 	
 	std::unique_ptr<FFXIVOceanFishingHelper> mFFXIVOceanFishingHelper;
+
+	// every context's schedule, shared with overlays and other tools. Only used while holding mVisibleContextsMutex
+	std::unique_ptr<SchedulePublisher> mSchedulePublisher;
+	void publishSchedule(const std::unique_lock<MeteredMutex>& lock, const contextMetaData_t& metadata, const std::string& inContext, const time_t& voyageTime, const time_t& windowEnd, const std::string& imageName, const std::string& buttonLabel);
+	Clock& mClock;
 	std::unique_ptr <CallBackTimer> mTimer;
 	std::unique_ptr <CallBackTimer> mSecondsTimer;
 
+	// log lines are formatted on the calling thread and sent in batches from the logger's own thread
+	PluginLogger mLogger;
+
+	// the file the log goes to, set from the global settings, only used on the websocket thread
+	std::string mLogFile;
+	void updateLogging(const json& settings);
+
+	// guards starting and stopping the timers, lock before mVisibleContextsMutex
+	std::mutex mTimersMutex;
+
+	// trigger time returned to the timer when no context will ever go stale on its own
+	static constexpr time_t NO_STATE_CHANGE = (std::numeric_limits<time_t>::max)();
+
+	// a page of buttons appears/disappears as a burst of events, wait this long for it to end before recomputing
+	static constexpr std::chrono::milliseconds CONTEXT_SETTLE_TIME = std::chrono::milliseconds(50);
+
+	// start time and size of the current burst of appearing contexts, used to time how long a page takes to show
+	std::chrono::steady_clock::time_point mAppearBurstStart;
+	uint32_t mAppearBurstCount = 0;
+
+	// where metrics snapshots are written, set by the property inspector's metrics command or the "Metrics" global setting.
+	// An empty file logs them through the Stream Deck, a zero interval only writes them on request
+	std::mutex mMetricsMutex;
+	std::string mMetricsFile;
+	std::chrono::seconds mMetricsInterval = std::chrono::seconds(0);
+	std::chrono::steady_clock::time_point mLastMetricsReport;
+
+	void handleMetricsCommand(const json& command);
+
+	// how often snapshots are written while "Metrics" is on in the global settings
+	static constexpr std::chrono::seconds METRICS_SETTING_INTERVAL = std::chrono::minutes(1);
+	void updateMetrics(const json& settings);
+
+	// where the trace is written when tracing is turned off in the global settings, only used on the websocket thread
+	std::string mTraceFile;
+	void updateTracing(const json& settings);
+	json getMetricsSnapshot();
+	void reportMetrics(const bool isForced);
+
 	void startTimers();
 	void stopTimers();
 };
@@ -0,0 +1,340 @@
+//==============================================================================
+/**
+@file       ButtonCanvas.cpp
+@brief      Draws live button images and encodes them to png with low latency
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "ButtonCanvas.h"
+#include "../Vendor/lodepng/lodepng.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	constexpr size_t BYTES_PER_PIXEL = 4;
+	constexpr uint32_t ANGLE_STEPS = 65536;
+	constexpr double PI = 3.14159265358979323846;
+
+	constexpr uint8_t RING_COLOR[BYTES_PER_PIXEL] = { 0x4f, 0xc3, 0xf7, 0xff };
+	constexpr uint8_t HIGHLIGHT_COLOR[BYTES_PER_PIXEL] = { 0xff, 0xc1, 0x07, 0xff };
+
+	// a stored deflate block holds at most this many bytes, and each has a 5 byte header
+	constexpr size_t MAX_STORED_BLOCK = 65535;
+	constexpr size_t STORED_BLOCK_HEADER = 5;
+
+	// byte offsets in the stored png, the zlib stream starts after the signature, IHDR chunk and IDAT header
+	constexpr size_t PNG_SIGNATURE_SIZE = 8;
+	constexpr size_t IHDR_CHUNK_SIZE = 12 + 13;
+	constexpr size_t IDAT_TYPE_OFFSET = PNG_SIGNATURE_SIZE + IHDR_CHUNK_SIZE + 4;
+	constexpr size_t ZLIB_OFFSET = IDAT_TYPE_OFFSET + 4;
+	constexpr size_t ZLIB_HEADER_SIZE = 2;
+	constexpr size_t ADLER_SIZE = 4;
+
+	void writeU32(uint8_t* out, const uint32_t value)
+	{
+		out[0] = static_cast<uint8_t>(value >> 24);
+		out[1] = static_cast<uint8_t>(value >> 16);
+		out[2] = static_cast<uint8_t>(value >> 8);
+		out[3] = static_cast<uint8_t>(value);
+	}
+
+	/**
+		@brief maps an offset in the uncompressed image data to its offset in the stored png, skipping block headers
+	**/
+	size_t getStoredOffset(const size_t rawOffset)
+	{
+		return ZLIB_OFFSET + ZLIB_HEADER_SIZE +
+			(rawOffset / MAX_STORED_BLOCK + 1) * STORED_BLOCK_HEADER + rawOffset;
+	}
+
+	/**
+		@brief adler32 checksum, reducing modulo only as often as needed to not overflow
+	**/
+	void updateAdler32(uint32_t& a, uint32_t& b, const uint8_t* data, size_t size)
+	{
+		constexpr uint32_t ADLER_MOD = 65521;
+		constexpr size_t MAX_RUN = 5552;
+		while (size > 0)
+		{
+			const size_t run = (std::min)(size, MAX_RUN);
+			for (size_t i = 0; i < run; i++)
+			{
+				a += data[i];
+				b += a;
+			}
+			a %= ADLER_MOD;
+			b %= ADLER_MOD;
+			data += run;
+			size -= run;
+		}
+	}
+}
+
+/**
+	@brief allocates the pixels and works out which pixels the ring and frame cover.
+	       The canvas starts transparent with an empty ring and no highlight.
+
+	@param[in] size width and height in pixels
+**/
+ButtonCanvas::ButtonCanvas(const uint32_t size) :
+	mSize(size),
+	mPixels(static_cast<size_t>(size) * size * BYTES_PER_PIXEL, 0),
+	mBackground(mPixels.size(), 0),
+	mStoredLastDirtyRow(size)
+{
+	const uint32_t frameWidth = (std::max)(2u, size / 24);
+	const double outerRadius = size / 2.0 - frameWidth - 1;
+	const double innerRadius = outerRadius - (std::max)(3u, size / 16);
+	const double center = size / 2.0;
+
+	for (uint32_t y = 0; y < size; y++)
+	{
+		for (uint32_t x = 0; x < size; x++)
+		{
+			const uint32_t index = y * size + x;
+			if (x < frameWidth || y < frameWidth || x >= size - frameWidth || y >= size - frameWidth)
+			{
+				mFramePixels.push_back(index);
+				continue;
+			}
+
+			const double dx = x + 0.5 - center;
+			const double dy = y + 0.5 - center;
+			const double distance = std::sqrt(dx * dx + dy * dy);
+			if (distance < innerRadius || distance >= outerRadius)
+				continue;
+
+			double turn = std::atan2(dx, -dy) / (2 * PI);
+			if (turn < 0) turn += 1;
+			const uint32_t angle = (std::min)(static_cast<uint32_t>(turn * ANGLE_STEPS), ANGLE_STEPS - 1);
+			mRingPixels.push_back({ index, angle });
+		}
+	}
+
+	std::stable_sort(mRingPixels.begin(), mRingPixels.end(),
+		[](const ringPixel_t& a, const ringPixel_t& b) { return a.angle < b.angle; });
+}
+
+/**
+	@brief replaces the icon under the ring and frame, scaling it to the canvas with nearest neighbour sampling
+
+	@param[in] rgba the icon pixels
+	@param[in] width icon width
+	@param[in] height icon height
+**/
+void ButtonCanvas::setBackground(const uint8_t* rgba, const uint32_t width, const uint32_t height)
+{
+	if (rgba == nullptr || width == 0 || height == 0) return;
+
+	for (uint32_t y = 0; y < mSize; y++)
+	{
+		const uint8_t* srcRow = rgba + static_cast<size_t>(y * height / mSize) * width * BYTES_PER_PIXEL;
+		uint8_t* dstRow = mBackground.data() + static_cast<size_t>(y) * mSize * BYTES_PER_PIXEL;
+		for (uint32_t x = 0; x < mSize; x++)
+			std::memcpy(dstRow + x * BYTES_PER_PIXEL, srcRow + static_cast<size_t>(x * width / mSize) * BYTES_PER_PIXEL, BYTES_PER_PIXEL);
+	}
+
+	mPixels = mBackground;
+	for (size_t i = 0; i < mProgressCount; i++)
+		std::memcpy(&mPixels[mRingPixels[i].index * BYTES_PER_PIXEL], RING_COLOR, BYTES_PER_PIXEL);
+	if (mIsHighlighted)
+		for (const uint32_t index : mFramePixels)
+			std::memcpy(&mPixels[index * BYTES_PER_PIXEL], HIGHLIGHT_COLOR, BYTES_PER_PIXEL);
+
+	mHasChanged = true;
+	mStoredFirstDirtyRow = 0;
+	mStoredLastDirtyRow = mSize;
+}
+
+/**
+	@brief fills the ring clockwise from the top. Only the ring pixels between the old and new progress are redrawn.
+
+	@param[in] progress fraction of the ring to fill, clamped to [0, 1]
+**/
+void ButtonCanvas::setProgress(const float progress)
+{
+	const float clamped = std::clamp(progress, 0.0f, 1.0f);
+	const uint32_t threshold = static_cast<uint32_t>(clamped * ANGLE_STEPS);
+	const size_t count = std::lower_bound(mRingPixels.begin(), mRingPixels.end(), threshold,
+		[](const ringPixel_t& pixel, const uint32_t angle) { return pixel.angle < angle; }) - mRingPixels.begin();
+	if (count == mProgressCount) return;
+
+	const size_t first = (std::min)(count, mProgressCount);
+	const size_t last = (std::max)(count, mProgressCount);
+	const bool isFilling = count > mProgressCount;
+	mProgressCount = count;
+
+	for (size_t i = first; i < last; i++)
+	{
+		const uint32_t index = mRingPixels[i].index;
+		drawPixel(index, isFilling ? RING_COLOR : &mBackground[index * BYTES_PER_PIXEL]);
+	}
+}
+
+/**
+	@brief shows or hides the frame around the edge of the button
+
+	@param[in] isHighlighted true to draw the frame
+**/
+void ButtonCanvas::setHighlight(const bool isHighlighted)
+{
+	if (isHighlighted == mIsHighlighted) return;
+	mIsHighlighted = isHighlighted;
+
+	for (const uint32_t index : mFramePixels)
+		drawPixel(index, isHighlighted ? HIGHLIGHT_COLOR : &mBackground[index * BYTES_PER_PIXEL]);
+}
+
+/**
+	@brief sets a pixel and marks its row as changed
+
+	@param[in] index the pixel index
+	@param[in] color the RGBA color to set
+**/
+void ButtonCanvas::drawPixel(const uint32_t index, const uint8_t* color)
+{
+	std::memcpy(&mPixels[index * BYTES_PER_PIXEL], color, BYTES_PER_PIXEL);
+
+	const uint32_t row = index / mSize;
+	if (mStoredFirstDirtyRow >= mStoredLastDirtyRow)
+	{
+		mStoredFirstDirtyRow = row;
+		mStoredLastDirtyRow = row + 1;
+	}
+	else
+	{
+		mStoredFirstDirtyRow = (std::min)(mStoredFirstDirtyRow, row);
+		mStoredLastDirtyRow = (std::max)(mStoredLastDirtyRow, row + 1);
+	}
+	mHasChanged = true;
+}
+
+/**
+	@brief encodes the canvas as an RGBA png
+
+	@param[in] mode how to compress the png
+
+	@return the png, valid until the next encode of the same mode
+**/
+const std::vector<uint8_t>& ButtonCanvas::encodePng(const ENCODE_MODE mode)
+{
+	mHasChanged = false;
+	if (mode == ENCODE_MODE::STORED)
+		return encodeStoredPng();
+
+	lodepng::State state;
+	state.info_png.color.colortype = LCT_RGBA;
+	state.info_png.color.bitdepth = 8;
+	state.encoder.auto_convert = 0;
+	if (mode == ENCODE_MODE::FAST)
+	{
+		// the icons are flat art, so a short window and greedy matching still find most repeats.
+		// Fixed huffman codes were measured no faster, since the time goes into matching
+		state.encoder.filter_strategy = LFS_ZERO;
+		state.encoder.zlibsettings.windowsize = 1024;
+		state.encoder.zlibsettings.nicematch = 32;
+		state.encoder.zlibsettings.lazymatching = 0;
+	}
+
+	mCompressedPng.clear();
+	if (lodepng::encode(mCompressedPng, mPixels.data(), mSize, mSize, state) != 0)
+		mCompressedPng.clear();
+	return mCompressedPng;
+}
+
+/**
+	@brief lays out a png of uncompressed deflate blocks with no row filters,
+	       so every pixel has a fixed place in the file and changed rows can be copied straight in
+**/
+void ButtonCanvas::initStoredPng()
+{
+	const size_t rowSize = 1 + static_cast<size_t>(mSize) * BYTES_PER_PIXEL;
+	const size_t rawSize = rowSize * mSize;
+	const size_t blocks = (std::max<size_t>)(1, (rawSize + MAX_STORED_BLOCK - 1) / MAX_STORED_BLOCK);
+	const size_t zlibSize = ZLIB_HEADER_SIZE + blocks * STORED_BLOCK_HEADER + rawSize + ADLER_SIZE;
+
+	// the row filter bytes stay 0, which is no filter
+	mStoredPng.assign(ZLIB_OFFSET + zlibSize + 4 + 12, 0);
+	uint8_t* out = mStoredPng.data();
+
+	constexpr uint8_t SIGNATURE[PNG_SIGNATURE_SIZE] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	std::memcpy(out, SIGNATURE, PNG_SIGNATURE_SIZE);
+
+	uint8_t* ihdr = out + PNG_SIGNATURE_SIZE;
+	writeU32(ihdr, 13);
+	std::memcpy(ihdr + 4, "IHDR", 4);
+	writeU32(ihdr + 8, mSize);
+	writeU32(ihdr + 12, mSize);
+	ihdr[16] = 8; // bit depth
+	ihdr[17] = 6; // RGBA
+	writeU32(ihdr + 21, lodepng_crc32(ihdr + 4, 17));
+
+	writeU32(out + IDAT_TYPE_OFFSET - 4, static_cast<uint32_t>(zlibSize));
+	std::memcpy(out + IDAT_TYPE_OFFSET, "IDAT", 4);
+	out[ZLIB_OFFSET] = 0x78;
+	out[ZLIB_OFFSET + 1] = 0x01;
+	for (size_t block = 0; block < blocks; block++)
+	{
+		const bool isLast = block + 1 == blocks;
+		const uint16_t length = static_cast<uint16_t>(isLast ? rawSize - block * MAX_STORED_BLOCK : MAX_STORED_BLOCK);
+		uint8_t* header = out + getStoredOffset(block * MAX_STORED_BLOCK) - STORED_BLOCK_HEADER;
+		header[0] = isLast ? 1 : 0;
+		header[1] = static_cast<uint8_t>(length);
+		header[2] = static_cast<uint8_t>(length >> 8);
+		header[3] = static_cast<uint8_t>(~length);
+		header[4] = static_cast<uint8_t>(~length >> 8);
+	}
+
+	uint8_t* iend = mStoredPng.data() + mStoredPng.size() - 12;
+	std::memcpy(iend + 4, "IEND", 4);
+	writeU32(iend + 8, lodepng_crc32(iend + 4, 4));
+
+	mStoredFirstDirtyRow = 0;
+	mStoredLastDirtyRow = mSize;
+}
+
+/**
+	@brief copies the rows that changed since the last stored encode into the png, then redoes the checksums
+
+	@return the png
+**/
+const std::vector<uint8_t>& ButtonCanvas::encodeStoredPng()
+{
+	if (mStoredPng.empty())
+		initStoredPng();
+
+	const size_t pixelRowSize = static_cast<size_t>(mSize) * BYTES_PER_PIXEL;
+	const size_t rowSize = 1 + pixelRowSize;
+	for (uint32_t row = mStoredFirstDirtyRow; row < mStoredLastDirtyRow; row++)
+	{
+		const uint8_t* src = mPixels.data() + row * pixelRowSize;
+		size_t rawOffset = row * rowSize + 1;
+		size_t remaining = pixelRowSize;
+		while (remaining > 0)
+		{
+			// a row can straddle two blocks
+			const size_t run = (std::min)(remaining, MAX_STORED_BLOCK - rawOffset % MAX_STORED_BLOCK);
+			std::memcpy(&mStoredPng[getStoredOffset(rawOffset)], src, run);
+			src += run;
+			rawOffset += run;
+			remaining -= run;
+		}
+	}
+	mStoredFirstDirtyRow = mSize;
+	mStoredLastDirtyRow = 0;
+
+	const size_t rawSize = rowSize * mSize;
+	uint32_t a = 1;
+	uint32_t b = 0;
+	for (size_t blockStart = 0; blockStart < rawSize; blockStart += MAX_STORED_BLOCK)
+		updateAdler32(a, b, &mStoredPng[getStoredOffset(blockStart)], (std::min)(MAX_STORED_BLOCK, rawSize - blockStart));
+
+	uint8_t* const adler = mStoredPng.data() + mStoredPng.size() - 12 - 4 - ADLER_SIZE;
+	writeU32(adler, (b << 16) | a);
+	writeU32(adler + ADLER_SIZE, lodepng_crc32(&mStoredPng[IDAT_TYPE_OFFSET], adler + ADLER_SIZE - &mStoredPng[IDAT_TYPE_OFFSET]));
+	return mStoredPng;
+}
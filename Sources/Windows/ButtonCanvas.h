@@ -0,0 +1,76 @@
+//==============================================================================
+/**
+@file       ButtonCanvas.h
+@brief      Draws live button images and encodes them to png with low latency
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/**
+	@brief A square RGBA image for a single button, showing its icon with a countdown progress ring and
+	       a highlight frame while a fishing window is open.
+	       Pixels are preallocated once, and each change only redraws the pixels it touches from the icon.
+	       The stored png is kept between encodes so only the rows that changed are rewritten into it.
+**/
+class ButtonCanvas
+{
+public:
+	// how encodePng compresses, faster modes make bigger pngs
+	enum class ENCODE_MODE
+	{
+		STORED, // no compression, only the changed rows are copied into the previous png
+		FAST, // no row filters, a small lz77 window and greedy matching
+		DEFAULT, // lodepng's default settings, the smallest png
+	};
+
+	explicit ButtonCanvas(const uint32_t size);
+	~ButtonCanvas() {};
+
+	uint32_t getSize() const { return mSize; }
+	const std::vector<uint8_t>& getPixels() const { return mPixels; }
+	bool hasChanged() const { return mHasChanged; }
+
+	void setBackground(const uint8_t* rgba, const uint32_t width, const uint32_t height);
+	void setProgress(const float progress);
+	void setHighlight(const bool isHighlighted);
+
+	const std::vector<uint8_t>& encodePng(const ENCODE_MODE mode);
+
+private:
+	// a pixel of the progress ring, angle is the fraction of a clockwise turn from the top in 1/65536ths
+	struct ringPixel_t
+	{
+		uint32_t index = 0;
+		uint32_t angle = 0;
+	};
+
+	uint32_t mSize = 0;
+	std::vector<uint8_t> mPixels;
+	std::vector<uint8_t> mBackground;
+
+	// ring pixels sorted by angle, the first mProgressCount of them are filled
+	std::vector<ringPixel_t> mRingPixels;
+	size_t mProgressCount = 0;
+
+	std::vector<uint32_t> mFramePixels;
+	bool mIsHighlighted = false;
+
+	// true if the pixels changed since the last encode of any mode
+	bool mHasChanged = true;
+
+	// rows changed since the stored png was last written, empty while first >= last
+	uint32_t mStoredFirstDirtyRow = 0;
+	uint32_t mStoredLastDirtyRow = 0;
+
+	std::vector<uint8_t> mStoredPng;
+	std::vector<uint8_t> mCompressedPng;
+
+	void drawPixel(const uint32_t index, const uint8_t* color);
+	void initStoredPng();
+	const std::vector<uint8_t>& encodeStoredPng();
+};
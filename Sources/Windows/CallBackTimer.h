@@ -12,8 +12,14 @@
 #include <mutex>
 #include <vector>
 #include <functional> // for function
-#include <algorithm> // for min
+#include <algorithm> // for min, clamp
 #include <set>
+#include <chrono>
+#include <optional>
+#include <ctime>
+#include <thread>
+#include "Clock.h"
+#include "PluginMetrics.h"
 
 /**
 	@brief Timer that triggers on a specified interval
@@ -21,7 +27,10 @@
 class CallBackTimer
 {
 public:
-	CallBackTimer()
+	/**
+		@param[in] clock what the timer reads the time from and waits on, the system clock unless simulating
+	**/
+	explicit CallBackTimer(Clock& clock = Clock::system()) : timeSource(clock)
 	{
 		lock();
 	}
@@ -41,6 +50,7 @@ public:
 		{
 			unlock();
 		}
+		timeSource.notify();
 		if (thd.joinable())
 			thd.join();
 	}
@@ -60,6 +70,7 @@ public:
 		}
 
 		running = true;
+		timeSource.attach();
 
 		// start the timer thread
 		thd = std::thread([this, intervalMilliseconds, func]()
@@ -68,7 +79,7 @@ public:
 				{
 					func();
 					// wait
-					if (timerMutex.try_lock_for(std::chrono::milliseconds(intervalMilliseconds)))
+					if (waitFor(std::chrono::milliseconds(intervalMilliseconds)))
 					{
 						unlock();
 					}
@@ -77,6 +88,7 @@ public:
 						lock();
 					}
 				}
+				timeSource.detach();
 			});
 	};
 
@@ -95,6 +107,7 @@ public:
 		}
 
 		running = true;
+		timeSource.attach();
 
 		// start the timer thread
 		thd = std::thread([this, triggerMinutesOfTheHour, func]()
@@ -102,7 +115,7 @@ public:
 				while (running)
 				{
 					// get current time
-					time_t now = time(0);
+					time_t now = timeSource.now();
 					// find the closest trigger time
 					time_t nextTriggerTime = 0;
 					bool isFirst = true;
@@ -142,20 +155,70 @@ public:
 					else
 					{
 						// function may be slow, recompute current time, diff maybe be negative which in that case we immeadiatly unlock mutex
-						now = time(0);
+						now = timeSource.now();
 						waitTime = (int)(difftime(nextTriggerTime, now));
 					}
 
 					// wait
-					if (timerMutex.try_lock_for(std::chrono::seconds(waitTime)))
+					if (waitFor(std::chrono::seconds(waitTime)))
 					{
 						unlock();
+						settle();
 					}
 					if (!locked)
 					{
 						lock();
 					}
 				}
+				timeSource.detach();
+			});
+	}
+
+	/**
+		@brief starts the callback loop where the function picks its next trigger time, with ability to wake
+
+		@param[in] func the function to trigger, returns the next time it should be called, or nullopt on failure
+	**/
+	void start(std::function<std::optional<time_t>(void)> func)
+	{
+		// can't be already running
+		if (running == true)
+		{
+			return;
+		}
+
+		running = true;
+		timeSource.attach();
+
+		// start the timer thread
+		thd = std::thread([this, func]()
+			{
+				while (running)
+				{
+					// call the desired function
+					std::optional<time_t> nextTriggerTime = func();
+
+					int64_t waitTime = 5; // function failed, retry in 5s
+					if (nextTriggerTime)
+					{
+						// function may be slow, so compute from the current time. A trigger time behind us is called immediately.
+						// The wait is not on the wall clock, so cap it to catch up after the clock jumps or the pc sleeps.
+						const double secondsTillTrigger = difftime(*nextTriggerTime, timeSource.now());
+						waitTime = static_cast<int64_t>(std::clamp(secondsTillTrigger, 0.0, static_cast<double>(MAX_WAIT_TIME.count())));
+					}
+
+					// wait
+					if (waitFor(std::chrono::seconds(waitTime)))
+					{
+						unlock();
+						settle();
+					}
+					if (!locked)
+					{
+						lock();
+					}
+				}
+				timeSource.detach();
 			});
 	}
 
@@ -177,15 +240,77 @@ public:
 		if (is_running() && locked)
 		{
 			unlock();
+			timeSource.notify();
 		}
 	}
+
+	/**
+		@brief force a wakeup, but hold off calling the function until no other wake has arrived for settleTime.
+		       Used to coalesce bursts of wakes into a single call. Only applies to the loops that can be woken.
+
+		@param[in] settleTime how long the wakes must be quiet for before the function is called
+	**/
+	void wake(std::chrono::milliseconds settleTime)
+	{
+		settleMilliseconds = settleTime.count();
+		wake();
+	}
 private:
+	Clock& timeSource;
 	std::atomic_bool running = false;
 	std::thread thd;
 
 	std::timed_mutex timerMutex;
 	std::atomic_bool locked = false;
 
+	// settle time requested by the last wake, and a cap so a steady stream of wakes can't hold the function off forever
+	std::atomic<int64_t> settleMilliseconds = 0;
+	static constexpr std::chrono::milliseconds MAX_SETTLE_TIME = std::chrono::milliseconds(1000);
+
+	// longest a function picking its own trigger time is left waiting
+	static constexpr std::chrono::seconds MAX_WAIT_TIME = std::chrono::hours(1);
+
+	/**
+		@brief after a wake, keeps waiting while further wakes keep arriving within the requested settle time
+	**/
+	void settle()
+	{
+		const auto settleDeadline = timeSource.steadyNow() + MAX_SETTLE_TIME;
+		int64_t settleTime = settleMilliseconds.exchange(0);
+		while (running && settleTime > 0 && timeSource.steadyNow() < settleDeadline)
+		{
+			if (!locked)
+			{
+				lock();
+			}
+			if (!waitFor(std::chrono::milliseconds(settleTime)))
+			{
+				break; // quiet for the whole settle time
+			}
+			unlock();
+			settleTime = (std::max)(settleTime, settleMilliseconds.exchange(0));
+		}
+	}
+
+	/**
+		@brief waits for a wake or for the duration to pass, recording how late the timer woke up if it was not woken
+
+		@param[in] duration the longest to wait
+
+		@return true if woken, with timerMutex locked
+	**/
+	bool waitFor(const std::chrono::milliseconds duration)
+	{
+		if (!PluginMetrics::get().isEnabled())
+			return timeSource.tryLockFor(timerMutex, duration);
+
+		const auto deadline = timeSource.steadyNow() + duration;
+		const bool isWoken = timeSource.tryLockFor(timerMutex, duration);
+		if (!isWoken)
+			PluginMetrics::get().record(PluginMetrics::HISTOGRAM::TIMER_LATENESS, timeSource.steadyNow() - deadline);
+		return isWoken;
+	}
+
 	void lock()
 	{
 		timerMutex.lock();
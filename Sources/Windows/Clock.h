@@ -0,0 +1,65 @@
+//==============================================================================
+/**
+@file       Clock.h
+@brief      The source of time for the plugin and its timers, so it can be swapped for virtual time
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <mutex>
+
+/**
+	@brief Where the plugin and its timers read the time from and how they wait on it.
+	       Everything that reads or waits on time goes through a clock, so a simulation can run them against virtual time.
+**/
+class Clock
+{
+public:
+	virtual ~Clock() {};
+
+	// the wall clock, in seconds
+	virtual time_t now() = 0;
+
+	// a monotonic clock for measuring intervals
+	virtual std::chrono::steady_clock::time_point steadyNow() = 0;
+
+	/**
+		@brief waits for a timer's mutex to be unlocked by a wake, or for the duration to pass on this clock
+
+		@param[in] mutex the mutex to lock
+		@param[in] duration the longest to wait
+
+		@return true if the mutex was locked, false if the duration passed
+	**/
+	virtual bool tryLockFor(std::timed_mutex& mutex, const std::chrono::milliseconds duration) = 0;
+
+	// called after a mutex being waited on is unlocked
+	virtual void notify() {};
+
+	// called when a timer thread starts and after it stops waiting on this clock for good
+	virtual void attach() {};
+	virtual void detach() {};
+
+	static Clock& system();
+};
+
+/**
+	@brief The real time, used unless something else is injected
+**/
+class SystemClock : public Clock
+{
+public:
+	time_t now() override { return time(0); }
+	std::chrono::steady_clock::time_point steadyNow() override { return std::chrono::steady_clock::now(); }
+	bool tryLockFor(std::timed_mutex& mutex, const std::chrono::milliseconds duration) override { return mutex.try_lock_for(duration); }
+};
+
+inline Clock& Clock::system()
+{
+	static SystemClock clock;
+	return clock;
+}
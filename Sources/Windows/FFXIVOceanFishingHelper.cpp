@@ -55,6 +55,41 @@ bool FFXIVOceanFishingHelper::getSecondsUntilNextVoyage(
 	const std::string& routeName,
 	const uint32_t skips
 )
+{
+	uint32_t returnedVoyageId;
+	return getSecondsUntilNextVoyage(
+		secondsTillNextVoyage,
+		secondsLeftInWindow,
+		returnedVoyageId, // unused here
+		startTime,
+		voyageIds,
+		routeName,
+		skips
+	);
+}
+
+/**
+	@brief wrapper around getSecondsUntilNextVoyage for each route processor, also giving the voyage found
+
+	@param[out] secondsTillNextVoyage number of seconds until the next window, not including the one we are currently in
+	@param[out] secondsLeftInWindow number of seconds left in the current window. Is set to 0 if not in a current window
+	@param[out] nextVoyageId the voyage of the window found, the current one if we are in a window
+	@param[in] startTime the time to start counting from.
+	@param[in] voyageIds A set of voyageIds we are looking for per route name.
+	@param[in] routeName the name of the route
+	@param[in] skips number of windows to skip over
+
+	@return true if successful
+**/
+bool FFXIVOceanFishingHelper::getSecondsUntilNextVoyage(
+	uint32_t& secondsTillNextVoyage,
+	uint32_t& secondsLeftInWindow,
+	uint32_t& nextVoyageId,
+	const time_t& startTime,
+	const std::unordered_set<uint32_t>& voyageIds,
+	const std::string& routeName,
+	const uint32_t skips
+)
 {
 	if (!processors.contains(routeName))
 	{
@@ -63,17 +98,49 @@ bool FFXIVOceanFishingHelper::getSecondsUntilNextVoyage(
 		return false;
 	}
 
-	uint32_t returnedVoyageId;
 	return processors.at(routeName)->getSecondsUntilNextVoyage(
 		secondsTillNextVoyage,
 		secondsLeftInWindow,
-		returnedVoyageId, // unused here
+		nextVoyageId,
 		startTime,
 		voyageIds, // ids
 		skips
 	);
 }
 
+/**
+	@brief wrapper around getSecondsUntilNextStateChange for each route processor
+
+	@param[out] secondsTillStateChange number of seconds until the query result is stale
+	@param[in] startTime the time to start counting from.
+	@param[in] voyageIds A set of voyageIds we are looking for per route name.
+	@param[in] routeName the name of the route
+	@param[in] skips number of windows to skip over
+
+	@return true if successful
+**/
+bool FFXIVOceanFishingHelper::getSecondsUntilNextStateChange(
+	uint32_t& secondsTillStateChange,
+	const time_t& startTime,
+	const std::unordered_set<uint32_t>& voyageIds,
+	const std::string& routeName,
+	const uint32_t skips
+)
+{
+	if (!processors.contains(routeName))
+	{
+		secondsTillStateChange = UINT_MAX;
+		return false;
+	}
+
+	return processors.at(routeName)->getSecondsUntilNextStateChange(
+		secondsTillStateChange,
+		startTime,
+		voyageIds,
+		skips
+	);
+}
+
 /**
 	@brief wrapper around getImageNameAndLabel for each route processor
 
@@ -140,6 +207,19 @@ json FFXIVOceanFishingHelper::getTrackerTypesJson(const std::string& routeName)
 	return processors.at(routeName)->getTrackerTypesJson();
 }
 
+/**
+	@brief gets the short fish names used in image names of every route, mapped to the fish they stand for
+
+	@return map of short name -> fish name
+**/
+std::unordered_map<std::string, std::string> FFXIVOceanFishingHelper::getImageAliases()
+{
+	std::unordered_map<std::string, std::string> imageAliases;
+	for (const auto& [_, processor] : processors)
+		imageAliases.merge(processor->getImageAliases());
+	return imageAliases;
+}
+
 /**
 	@brief converts a target to a set of voyage ids that matches the target
 
@@ -159,4 +239,20 @@ std::unordered_set<uint32_t> FFXIVOceanFishingHelper::getVoyageIdByTracker(
 		return {};
 
 	return processors.at(routeName)->getVoyageIdByTracker(tracker, name);
+}
+
+/**
+	@brief lists when every target of every route has a voyage between two times
+
+	@param[in] from the start of the horizon, a window open at this time is included
+	@param[in] to the end of the horizon
+
+	@return map of route name -> the table of its targets' voyages
+**/
+std::unordered_map<std::string, ScheduleTable> FFXIVOceanFishingHelper::buildScheduleTables(const time_t& from, const time_t& to)
+{
+	std::unordered_map<std::string, ScheduleTable> tables;
+	for (const auto& [routeName, processor] : processors)
+		tables.emplace(routeName, processor->buildScheduleTable(from, to));
+	return tables;
 }
\ No newline at end of file
@@ -54,6 +54,24 @@ public:
 		const uint32_t skips = 0
 	);
 
+	bool getSecondsUntilNextVoyage(
+		uint32_t& secondsTillNextVoyage,
+		uint32_t& secondsLeftInWindow,
+		uint32_t& nextVoyageId,
+		const time_t& startTime,
+		const std::unordered_set<uint32_t>& voyageIds,
+		const std::string& routeNameUsed,
+		const uint32_t skips = 0
+	);
+
+	bool getSecondsUntilNextStateChange(
+		uint32_t& secondsTillStateChange,
+		const time_t& startTime,
+		const std::unordered_set<uint32_t>& voyageIds,
+		const std::string& routeName,
+		const uint32_t skips = 0
+	);
+
 	std::unordered_set<uint32_t> getVoyageIdByTracker(
 		const std::string& routeName,
 		const std::string& tracker,
@@ -73,6 +91,8 @@ public:
 	json getTargetsJson(const std::string& routeName);
 	json getTrackerTypesJson(const std::string& routeName);
 	json getRouteNames();
+	std::unordered_map<std::string, ScheduleTable> buildScheduleTables(const time_t& from, const time_t& to);
+	std::unordered_map<std::string, std::string> getImageAliases();
 
 private:
 	std::unordered_map<std::string, std::unique_ptr<FFXIVOceanFishingProcessor>> processors;
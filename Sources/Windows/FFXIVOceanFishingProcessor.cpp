@@ -191,6 +191,45 @@ bool FFXIVOceanFishingProcessor::getSecondsUntilNextVoyage(
 	return false;
 }
 
+/**
+	@brief gets the number of seconds until the result of a voyage query changes.
+	       This is the earliest of the found voyage starting, its window closing, or a skipped window closing.
+
+	@param[out] secondsTillStateChange number of seconds until the query result is stale
+	@param[in] startTime the time to start counting from.
+	@param[in] voyageIds A set of voyage ids we are looking for.
+	@param[in] skips number of windows to skip over. Default is 0.
+
+	@return true if successful
+**/
+bool FFXIVOceanFishingProcessor::getSecondsUntilNextStateChange(
+	uint32_t& secondsTillStateChange,
+	const time_t& startTime,
+	const std::unordered_set<uint32_t>& voyageIds,
+	const uint32_t skips
+)
+{
+	uint32_t secondsTillNextVoyage = 0;
+	uint32_t secondsLeftInWindow = 0;
+	uint32_t nextVoyageId = 0;
+	secondsTillStateChange = UINT32_MAX;
+	if (!getSecondsUntilNextVoyage(secondsTillNextVoyage, secondsLeftInWindow, nextVoyageId, startTime, voyageIds, skips))
+		return false;
+
+	// the found voyage either starts, or if we are in its window, the window closes
+	secondsTillStateChange = secondsLeftInWindow > 0 ? secondsLeftInWindow : secondsTillNextVoyage;
+
+	// when skipping, the first matching window closing shifts which voyage is skipped to, so it is also a state change
+	if (skips > 0 &&
+		getSecondsUntilNextVoyage(secondsTillNextVoyage, secondsLeftInWindow, nextVoyageId, startTime, voyageIds, 0))
+	{
+		const uint32_t secondsTillFirstWindowCloses = secondsLeftInWindow > 0 ? secondsLeftInWindow : secondsTillNextVoyage + 60 * 15;
+		secondsTillStateChange = (std::min)(secondsTillStateChange, secondsTillFirstWindowCloses);
+	}
+
+	return true;
+}
+
 /**
 	@brief gets the voyage name at a selected time, with option to skip. If in a window, that window is the voyages name. If not, the next window will be the name.
 
@@ -238,6 +277,19 @@ std::string FFXIVOceanFishingProcessor::getNextVoyageName(const time_t& t, const
 	return "";
 }
 
+/**
+	@brief lists when every target of the route has a voyage between two times, for looking up many windows far ahead
+
+	@param[in] from the start of the horizon, a window open at this time is included
+	@param[in] to the end of the horizon
+
+	@return the table of every target's voyages
+**/
+ScheduleTable FFXIVOceanFishingProcessor::buildScheduleTable(const time_t& from, const time_t& to)
+{
+	return ScheduleTable(mVoyagePattern, mPatternOffset, mTargetToVoyageIdMap, from, to);
+}
+
 /**
 	@brief converts a block id to a time
 	       this algorithm was obtained from https://github.com/proyebat/FFXIVOceanFishingTimeCalculator
@@ -435,6 +487,20 @@ json FFXIVOceanFishingProcessor::getTargetsJson()
 	return j;
 }
 
+/**
+	@brief gets the short fish names used in blue fish pattern image names, mapped to the fish they stand for
+
+	@return map of short name -> fish name
+**/
+std::unordered_map<std::string, std::string> FFXIVOceanFishingProcessor::getImageAliases()
+{
+	std::unordered_map<std::string, std::string> imageAliases;
+	for (const auto& [fishName, fish] : mFishes)
+		if (fish.shortName)
+			imageAliases.emplace(*fish.shortName, fishName);
+	return imageAliases;
+}
+
 /**
 	@brief gets tracker types as json
 
@@ -15,6 +15,7 @@
 #include <unordered_set>
 #include <vector>
 #include "Common.h"
+#include "ScheduleTable.h"
 
 #include "../Vendor/json/src/json.hpp"
 using json = nlohmann::json;
@@ -41,7 +42,14 @@ public:
 		const std::unordered_set<uint32_t>& voyageIds,
 		const uint32_t skips = 0
 	);
+	bool getSecondsUntilNextStateChange(
+		uint32_t& secondsTillStateChange,
+		const time_t& startTime,
+		const std::unordered_set<uint32_t>& voyageIds,
+		const uint32_t skips = 0
+	);
 	std::string getNextVoyageName(const time_t& t, const uint32_t skips = 0);
+	ScheduleTable buildScheduleTable(const time_t& from, const time_t& to);
 
 	std::unordered_set<uint32_t> getVoyageIdByTracker(const std::string& tracker, const std::string& name);
 	void getImageNameAndLabel(
@@ -56,6 +64,7 @@ public:
 
 	json getTargetsJson();
 	json getTrackerTypesJson();
+	std::unordered_map<std::string, std::string> getImageAliases();
 private:
 	bool mIsInit = false;
 	std::string mRouteName;
@@ -0,0 +1,167 @@
+//==============================================================================
+/**
+@file       IconCompositor.cpp
+@brief      Builds combined icons, ie: blue fish patterns, out of the single icons
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "IconCompositor.h"
+#include "../Vendor/lodepng/lodepng.h"
+#include <cstring>
+
+namespace
+{
+	// the part of a pattern name used for a stop without a blue fish
+	const std::string NO_TILE_NAME = "X";
+	const char TILE_DELIMITER = '-';
+}
+
+/**
+	@param[in] imageDirectory directory the icons are in, the icon <name> is loaded from <imageDirectory><name>.png
+	@param[in] imageAliases names used in image names that refer to a differently named icon
+**/
+IconCompositor::IconCompositor(const std::string& imageDirectory, const imageAliases_t& imageAliases) :
+	mImageDirectory(imageDirectory),
+	mImageAliases(imageAliases)
+{
+}
+
+/**
+	@brief splits a combined image name into the icons it is made of. Icon names can contain the delimiter
+	       themselves, ie: Un-Namazu, so the longest run of parts that names an icon is taken first.
+
+	@param[out] tileNames the icon names in order, X parts are left out
+	@param[in] imageName the combined image name, ie: Hafg-Elas-X
+
+	@return false if any part does not name an icon
+**/
+bool IconCompositor::getTileNames(std::vector<std::string>& tileNames, const std::string& imageName)
+{
+	tileNames.clear();
+
+	std::vector<std::string> parts;
+	size_t start = 0;
+	while (true)
+	{
+		const size_t end = imageName.find(TILE_DELIMITER, start);
+		parts.push_back(imageName.substr(start, end - start));
+		if (end == std::string::npos) break;
+		start = end + 1;
+	}
+
+	size_t first = 0;
+	while (first < parts.size())
+	{
+		if (parts[first] == NO_TILE_NAME)
+		{
+			first++;
+			continue;
+		}
+
+		bool isFound = false;
+		for (size_t last = parts.size(); last > first && !isFound; last--)
+		{
+			std::string name = parts[first];
+			for (size_t i = first + 1; i < last; i++)
+				name += TILE_DELIMITER + parts[i];
+
+			if (mImageAliases.contains(name))
+				name = mImageAliases.at(name);
+			if (getTile(name) == nullptr)
+				continue;
+
+			tileNames.push_back(name);
+			first = last;
+			isFound = true;
+		}
+		if (!isFound) return false;
+	}
+	return !tileNames.empty();
+}
+
+/**
+	@brief composes a combined icon and encodes it
+
+	@param[in] imageName the combined image name, ie: Hafg-Elas-X
+
+	@return the composed icon as png, or nullopt if the name does not resolve to icons of the same size
+**/
+std::optional<std::vector<uint8_t>> IconCompositor::compose(const std::string& imageName)
+{
+	const std::optional<icon_t> icon = composePixels(imageName);
+	if (!icon) return std::nullopt;
+
+	std::vector<uint8_t> png;
+	if (lodepng::encode(png, icon->rgba, icon->width, icon->height) != 0) return std::nullopt;
+	return png;
+}
+
+/**
+	@brief composes a combined icon. Each of the n icons keeps the middle 1/n of its width, and they are placed left to right.
+	       A single icon name gives that icon as is.
+
+	@param[in] imageName the combined image name, ie: Hafg-Elas-X
+
+	@return the composed RGBA pixels, or nullopt if the name does not resolve to icons of the same size
+**/
+std::optional<IconCompositor::icon_t> IconCompositor::composePixels(const std::string& imageName)
+{
+	std::vector<std::string> tileNames;
+	if (!getTileNames(tileNames, imageName)) return std::nullopt;
+
+	std::vector<const icon_t*> tiles;
+	for (const std::string& tileName : tileNames)
+		tiles.push_back(getTile(tileName));
+
+	const uint32_t width = tiles.front()->width;
+	const uint32_t height = tiles.front()->height;
+	for (const icon_t* tile : tiles)
+		if (tile->width != width || tile->height != height)
+			return std::nullopt;
+
+	// copy whole row slices at once, each row of a slice is contiguous in both images
+	constexpr size_t BYTES_PER_PIXEL = 4;
+	icon_t icon{ width, height, std::vector<uint8_t>(static_cast<size_t>(width) * height * BYTES_PER_PIXEL) };
+	const size_t rowBytes = static_cast<size_t>(width) * BYTES_PER_PIXEL;
+	for (size_t i = 0; i < tiles.size(); i++)
+	{
+		const size_t sliceStart = width * i / tiles.size();
+		const size_t sliceWidth = width * (i + 1) / tiles.size() - sliceStart;
+		const size_t cropStart = (width - sliceWidth) / 2;
+
+		const uint8_t* src = tiles[i]->rgba.data() + cropStart * BYTES_PER_PIXEL;
+		uint8_t* dst = icon.rgba.data() + sliceStart * BYTES_PER_PIXEL;
+		for (uint32_t y = 0; y < height; y++)
+			std::memcpy(dst + y * rowBytes, src + y * rowBytes, sliceWidth * BYTES_PER_PIXEL);
+	}
+	return icon;
+}
+
+/**
+	@brief gets a decoded icon, decoding it on first use
+
+	@param[in] name the icon name
+
+	@return the icon, or nullptr if it could not be loaded
+**/
+const IconCompositor::icon_t* IconCompositor::getTile(const std::string& name)
+{
+	auto it = mTiles.find(name);
+	if (it == mTiles.end())
+	{
+		std::optional<icon_t> tile = icon_t{};
+		unsigned width = 0;
+		unsigned height = 0;
+		if (lodepng::decode(tile->rgba, width, height, mImageDirectory + name + ".png") != 0)
+			tile = std::nullopt;
+		else
+		{
+			tile->width = width;
+			tile->height = height;
+		}
+		it = mTiles.emplace(name, std::move(tile)).first;
+	}
+	return it->second ? &*it->second : nullptr;
+}
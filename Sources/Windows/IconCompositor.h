@@ -0,0 +1,52 @@
+//==============================================================================
+/**
+@file       IconCompositor.h
+@brief      Builds combined icons, ie: blue fish patterns, out of the single icons
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+	@brief Composes icons named like "Hafg-Elas-X" or "Balloon-Manta" out of the icon of each part.
+	       Each part is cropped to its share of the width around its center and placed side by side, X parts are skipped.
+	       Parts are decoded once and kept, so later patterns with the same fish only pay for the copy and the encode.
+	       Not thread safe, meant to be owned by a single loader thread.
+**/
+class IconCompositor
+{
+public:
+	// maps a name used in image names to the icon it refers to, ie: short fish name -> fish name
+	using imageAliases_t = std::unordered_map<std::string, std::string>;
+
+	// a decoded icon
+	struct icon_t
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> rgba;
+	};
+
+	IconCompositor(const std::string& imageDirectory, const imageAliases_t& imageAliases = {});
+	~IconCompositor() {};
+
+	std::optional<std::vector<uint8_t>> compose(const std::string& imageName);
+	std::optional<icon_t> composePixels(const std::string& imageName);
+	bool getTileNames(std::vector<std::string>& tileNames, const std::string& imageName);
+
+private:
+	const std::string mImageDirectory;
+	const imageAliases_t mImageAliases;
+
+	// decoded icons by icon name, nullopt if the icon could not be loaded so it is not retried
+	std::unordered_map<std::string, std::optional<icon_t>> mTiles;
+
+	const icon_t* getTile(const std::string& name);
+};
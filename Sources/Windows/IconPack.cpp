@@ -0,0 +1,240 @@
+//==============================================================================
+/**
+@file       IconPack.cpp
+@brief      Memory maps a prebuilt pack of ready to send icon data URIs
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "IconPack.h"
+#include <charconv>
+#include <tuple>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const std::string_view ICON_PACK_MAGIC = "FFXIVICONPACK 1";
+
+	/**
+		@brief reads the next line of the index, without the line ending
+
+		@param[out] line the line that was read
+		@param[in,out] remaining the unread part of the pack, advanced past the line
+
+		@return false if no line ending was found
+	**/
+	bool readLine(std::string_view& line, std::string_view& remaining)
+	{
+		const size_t end = remaining.find('\n');
+		if (end == std::string_view::npos) return false;
+
+		line = remaining.substr(0, end);
+		if (!line.empty() && line.back() == '\r')
+			line.remove_suffix(1);
+		remaining.remove_prefix(end + 1);
+		return true;
+	}
+
+	/**
+		@brief reads a number followed by a space or the end of the field
+
+		@param[out] value the number that was read
+		@param[in,out] field the text to read from, advanced past the number and its trailing space
+
+		@return false if there was no number
+	**/
+	bool readNumber(size_t& value, std::string_view& field)
+	{
+		const auto [ptr, ec] = std::from_chars(field.data(), field.data() + field.size(), value);
+		if (ec != std::errc() || ptr == field.data()) return false;
+
+		field.remove_prefix(ptr - field.data());
+		if (!field.empty() && field.front() == ' ')
+			field.remove_prefix(1);
+		return true;
+	}
+}
+
+/**
+	@brief maps the pack and reads its index, check isInit() afterwards
+
+	@param[in] packFile path to the icon pack
+**/
+IconPack::IconPack(const std::string& packFile)
+{
+	if (map(packFile) && !parseIndex())
+	{
+		mImageNameToDataUri.clear();
+		unmap();
+	}
+}
+
+IconPack::~IconPack()
+{
+	unmap();
+}
+
+/**
+	@brief looks up an icon's data URI
+
+	@param[in] imageName the name of the image, the icon file name without .png
+
+	@return a view of the data URI inside the mapped pack, or nullopt if the pack does not have it
+**/
+std::optional<std::string_view> IconPack::find(const std::string& imageName) const
+{
+	const auto it = mImageNameToDataUri.find(imageName);
+	if (it == mImageNameToDataUri.end()) return std::nullopt;
+	return it->second;
+}
+
+/**
+	@brief maps the whole pack file read-only
+
+	@param[in] packFile path to the icon pack
+
+	@return true on success, otherwise the error message is set
+**/
+bool IconPack::map(const std::string& packFile)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(packFile.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		mErrorMessage = "Unable to open icon pack: " + packFile;
+		return false;
+	}
+	mFileHandle = file;
+
+	LARGE_INTEGER fileSize{};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		mErrorMessage = "Icon pack is empty: " + packFile;
+		unmap();
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		mErrorMessage = "Unable to map icon pack: " + packFile;
+		unmap();
+		return false;
+	}
+	mMappingHandle = mapping;
+
+	mData = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	mSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+	const int file = open(packFile.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		mErrorMessage = "Unable to open icon pack: " + packFile;
+		return false;
+	}
+
+	struct stat fileStat{};
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		mErrorMessage = "Icon pack is empty: " + packFile;
+		close(file);
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file); // the mapping keeps the file alive
+	mData = data == MAP_FAILED ? nullptr : static_cast<const char*>(data);
+	mSize = static_cast<size_t>(fileStat.st_size);
+#endif
+
+	if (mData == nullptr)
+	{
+		mErrorMessage = "Unable to map icon pack: " + packFile;
+		unmap();
+		return false;
+	}
+	return true;
+}
+
+/**
+	@brief releases the mapping, any views handed out are invalid afterwards
+**/
+void IconPack::unmap()
+{
+#ifdef _WIN32
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+	if (mMappingHandle != nullptr)
+		CloseHandle(mMappingHandle);
+	if (mFileHandle != nullptr)
+		CloseHandle(mFileHandle);
+	mMappingHandle = nullptr;
+	mFileHandle = nullptr;
+#else
+	if (mData != nullptr)
+		munmap(const_cast<char*>(mData), mSize);
+#endif
+	mData = nullptr;
+	mSize = 0;
+}
+
+/**
+	@brief reads the index at the top of the pack and points each image name at its data URI
+
+	@return true on success, otherwise the error message is set
+**/
+bool IconPack::parseIndex()
+{
+	std::string_view remaining(mData, mSize);
+	std::string_view line;
+
+	if (!readLine(line, remaining) || line != ICON_PACK_MAGIC)
+	{
+		mErrorMessage = "Icon pack has an unknown format";
+		return false;
+	}
+
+	size_t count = 0;
+	if (!readLine(line, remaining) || !readNumber(count, line))
+	{
+		mErrorMessage = "Icon pack is missing its icon count";
+		return false;
+	}
+
+	// offsets are from the end of the index, so read all the entries before resolving any of them
+	std::vector<std::tuple<size_t, size_t, std::string_view>> entries;
+	entries.reserve(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		size_t offset = 0;
+		size_t length = 0;
+		if (!readLine(line, remaining) || !readNumber(offset, line) || !readNumber(length, line) || line.empty())
+		{
+			mErrorMessage = "Icon pack index entry " + std::to_string(i) + " is malformed";
+			return false;
+		}
+		entries.emplace_back(offset, length, line);
+	}
+
+	mImageNameToDataUri.reserve(count);
+	for (const auto& [offset, length, imageName] : entries)
+	{
+		if (offset > remaining.size() || length > remaining.size() - offset)
+		{
+			mErrorMessage = "Icon pack entry " + std::string(imageName) + " is out of bounds";
+			return false;
+		}
+		mImageNameToDataUri.emplace(imageName, remaining.substr(offset, length));
+	}
+	return true;
+}
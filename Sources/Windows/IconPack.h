@@ -0,0 +1,59 @@
+//==============================================================================
+/**
+@file       IconPack.h
+@brief      Memory maps a prebuilt pack of ready to send icon data URIs
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+	@brief Read-only view of an icon pack made by Devtools/createIconPack.sh.
+
+	The pack is a text index followed by the data URIs back to back:
+		FFXIVICONPACK 1
+		<icon count>
+		<offset> <length> <image name>     (one line per icon, offset is from the end of the index)
+		<data URIs>
+
+	The whole file is mapped once, lookups hand out views into the mapping so sending an icon
+	needs no file I/O, no encoding and no copies. Views stay valid for the lifetime of the pack.
+**/
+class IconPack
+{
+public:
+	IconPack(const std::string& packFile);
+	~IconPack();
+
+	IconPack(const IconPack&) = delete;
+	IconPack& operator=(const IconPack&) = delete;
+
+	bool isInit() const { return mErrorMessage.empty(); };
+	std::string getErrorMessage() const { return mErrorMessage; };
+
+	std::optional<std::string_view> find(const std::string& imageName) const;
+	size_t size() const { return mImageNameToDataUri.size(); };
+
+private:
+	std::string mErrorMessage;
+
+	const char* mData = nullptr;
+	size_t mSize = 0;
+#ifdef _WIN32
+	void* mFileHandle = nullptr;
+	void* mMappingHandle = nullptr;
+#endif
+
+	std::unordered_map<std::string, std::string_view> mImageNameToDataUri;
+
+	bool map(const std::string& packFile);
+	void unmap();
+	bool parseIndex();
+};
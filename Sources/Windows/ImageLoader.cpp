@@ -0,0 +1,419 @@
+//==============================================================================
+/**
+@file       ImageLoader.cpp
+@brief      Loads button icons into a base64 cache on a background thread
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "ImageLoader.h"
+#include "ImageUtils.h"
+#include "PluginTracer.h"
+#include "../Vendor/lodepng/lodepng.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+/**
+	@brief starts the loader thread
+
+	@param[in] imageDirectory directory the icons are in, the image name <name> is loaded from <imageDirectory><name>.png
+	@param[in] onLoaded called on the loader thread every time an image finishes loading
+	@param[in] byteBudget the least recently used images are evicted once the cached data URIs of all sizes exceed this many bytes
+	@param[in] imageAliases names used in combined image names that refer to a differently named icon
+**/
+ImageLoader::ImageLoader(
+	const std::string& imageDirectory,
+	onLoaded_t onLoaded,
+	const size_t byteBudget,
+	const IconCompositor::imageAliases_t& imageAliases
+) :
+	mImageDirectory(imageDirectory),
+	mOnLoaded(std::move(onLoaded)),
+	mByteBudget(byteBudget),
+	mCompositor(imageDirectory, imageAliases)
+{
+	mThread = std::thread([this]() { run(); });
+}
+
+/**
+	@brief stops the loader thread, images still waiting to load are dropped
+**/
+ImageLoader::~ImageLoader()
+{
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mIsRunning = false;
+	}
+	mCondition.notify_one();
+	if (mThread.joinable())
+		mThread.join();
+}
+
+/**
+	@brief gets an image from the cache, or queues it to load in the background if it is not cached yet.
+	       If this returns nullptr, the onLoaded callback is guaranteed to be called for this image and size afterwards.
+
+	@param[in] imageName the name of the image
+	@param[in] size the key size in pixels to shrink the image to fit, or ORIGINAL_SIZE for the icon as shipped
+
+	@return the image's data URI if it was cached, otherwise nullptr
+**/
+ImageLoader::image_t ImageLoader::getOrLoad(const std::string& imageName, const uint32_t size)
+{
+	const std::string key = getKey(imageName, size);
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (const cacheEntry_t* entry = findCached(lock, key))
+	{
+		mStats.hits++;
+		return entry->dataUri;
+	}
+
+	mStats.misses++;
+	queueLoad(lock, imageName, size, key);
+	return nullptr;
+}
+
+/**
+	@brief queues an image to load in the background if it is not cached yet, so it is ready when it is needed
+
+	@param[in] imageName the name of the image
+	@param[in] size the key size in pixels to shrink the image to fit, or ORIGINAL_SIZE for the icon as shipped
+**/
+void ImageLoader::prefetch(const std::string& imageName, const uint32_t size)
+{
+	const std::string key = getKey(imageName, size);
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (!findCached(lock, key))
+		queueLoad(lock, imageName, size, key);
+}
+
+/**
+	@brief gets an icon decoded for drawing on, or queues it to decode in the background if it is not cached yet.
+	       There is no callback for pixels, call again later until they are ready.
+
+	@param[in] imageName the name of the image
+	@param[in] size the pixel size of the square the icon is drawn in, larger icons are shrunk to fit it
+
+	@return the decoded icon if it was cached, always square, with no pixels if it could not be loaded, otherwise nullptr
+**/
+ImageLoader::pixels_t ImageLoader::getOrLoadPixels(const std::string& imageName, const uint32_t size)
+{
+	const std::string key = getPixelsKey(imageName, size);
+	std::unique_lock<std::mutex> lock(mMutex);
+	if (const cacheEntry_t* entry = findCached(lock, key))
+	{
+		mStats.hits++;
+		return entry->pixels;
+	}
+
+	mStats.misses++;
+	queueLoad(lock, imageName, size, key, true);
+	return nullptr;
+}
+
+/**
+	@brief gets the cache counters and current size
+
+	@return the cache stats
+**/
+ImageLoader::cacheStats_t ImageLoader::getStats()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	cacheStats_t stats = mStats;
+	stats.entries = mImageNameToDataUriMap.size();
+	return stats;
+}
+
+/**
+	@brief gets the key an image at a size is cached and queued by
+
+	@param[in] imageName the name of the image
+	@param[in] size the key size in pixels, or ORIGINAL_SIZE
+
+	@return the key
+**/
+std::string ImageLoader::getKey(const std::string& imageName, const uint32_t size)
+{
+	return imageName + "@" + std::to_string(size);
+}
+
+/**
+	@brief gets the key the decoded pixels of an image at a size are cached and queued by
+
+	@param[in] imageName the name of the image
+	@param[in] size the pixel size of the square the icon is drawn in
+
+	@return the key
+**/
+std::string ImageLoader::getPixelsKey(const std::string& imageName, const uint32_t size)
+{
+	return getKey(imageName, size) + ":rgba";
+}
+
+/**
+	@brief gets how many bytes a cache entry counts against the budget
+
+	@param[in] entry the cache entry
+
+	@return the size of its data URI or pixels
+**/
+size_t ImageLoader::getBytes(const cacheEntry_t& entry)
+{
+	return entry.dataUri ? entry.dataUri->size() : entry.pixels->rgba.size();
+}
+
+/**
+	@brief looks up an image in the cache and marks it as the most recently used
+
+	@param[in] lock proof that mMutex is held
+	@param[in] key the key of the image
+
+	@return the cache entry, or nullptr if it is not cached. Only valid while mMutex is held
+**/
+const ImageLoader::cacheEntry_t* ImageLoader::findCached(const std::unique_lock<std::mutex>& lock, const std::string& key)
+{
+	if (!lock.owns_lock()) return nullptr;
+
+	const auto it = mImageNameToDataUriMap.find(key);
+	if (it == mImageNameToDataUriMap.end()) return nullptr;
+
+	mLruOrder.splice(mLruOrder.begin(), mLruOrder, it->second.lruPosition);
+	return &it->second;
+}
+
+/**
+	@brief adds an image to the cache, then evicts the least recently used images until the cache fits its budget.
+	       The new image is never evicted, so an image larger than the budget is still cached on its own.
+	       Evicted images stay alive for anyone still holding them.
+
+	@param[in] lock proof that mMutex is held
+	@param[in] key the key of the image
+	@param[in] dataUri the loaded image, or nullptr if caching pixels
+	@param[in] pixels the decoded image, only used if dataUri is nullptr
+**/
+void ImageLoader::addToCache(const std::unique_lock<std::mutex>& lock, const std::string& key, const image_t& dataUri, const pixels_t& pixels)
+{
+	if (!lock.owns_lock() || (!dataUri && !pixels)) return;
+
+	if (mImageNameToDataUriMap.contains(key)) return;
+
+	mLruOrder.push_front(key);
+	const cacheEntry_t& entry = mImageNameToDataUriMap.emplace(key, cacheEntry_t{ dataUri, dataUri ? nullptr : pixels, mLruOrder.begin() }).first->second;
+	mStats.bytes += getBytes(entry);
+
+	while (mStats.bytes > mByteBudget && mLruOrder.size() > 1)
+	{
+		const auto evicted = mImageNameToDataUriMap.find(mLruOrder.back());
+		mStats.bytes -= getBytes(evicted->second);
+		mStats.evictions++;
+		mImageNameToDataUriMap.erase(evicted);
+		mLruOrder.pop_back();
+	}
+}
+
+/**
+	@brief queues an image to load, unless it is already waiting or loading
+
+	@param[in] lock proof that mMutex is held
+	@param[in] imageName the name of the image
+	@param[in] size the key size in pixels, or ORIGINAL_SIZE
+	@param[in] key the key of the image at that size
+	@param[in] isPixels true to decode the image for drawing on, false to load it as a data URI
+**/
+void ImageLoader::queueLoad(const std::unique_lock<std::mutex>& lock, const std::string& imageName, const uint32_t size, const std::string& key, const bool isPixels)
+{
+	if (!lock.owns_lock()) return;
+
+	if (mPending.contains(key)) return;
+
+	mPending.insert(key);
+	mQueue.push_back(request_t{ imageName, size, key, isPixels });
+	mCondition.notify_one();
+}
+
+/**
+	@brief reads an icon from file, or composes it if it is a combined icon without a file.
+	       Icons larger than the key size are shrunk to fit it, then recompressed as small as possible.
+	       An icon that already fits is only swapped for its recompressed version if that is smaller.
+
+	@param[out] png the icon as png
+	@param[in] imageName the name of the image
+	@param[in] size the key size in pixels, or ORIGINAL_SIZE to keep the icon as shipped
+
+	@return false if the image could not be read or composed
+**/
+bool ImageLoader::loadPng(std::vector<uint8_t>& png, const std::string& imageName, const uint32_t size)
+{
+	png.clear();
+	std::ifstream ifs(mImageDirectory + imageName + ".png", std::ios::binary | std::ios::ate);
+	if (!ifs.fail())
+	{
+		png.resize(static_cast<size_t>(ifs.tellg()));
+		ifs.seekg(0);
+		if (!ifs.read(reinterpret_cast<char*>(png.data()), png.size())) return false;
+	}
+
+	IconCompositor::icon_t icon;
+	if (png.empty())
+	{
+		std::optional<IconCompositor::icon_t> composed = mCompositor.composePixels(imageName);
+		if (!composed) return false;
+		icon = std::move(*composed);
+	}
+	else if (size == ORIGINAL_SIZE)
+		return true;
+	else
+	{
+		unsigned width = 0;
+		unsigned height = 0;
+		if (lodepng::decode(icon.rgba, width, height, png) != 0) return true; // send it as is
+		icon.width = width;
+		icon.height = height;
+	}
+
+	// shrink to fit the key, keeping the aspect ratio
+	if (size != ORIGINAL_SIZE && (icon.width > size || icon.height > size))
+	{
+		const uint32_t longest = (std::max)(icon.width, icon.height);
+		const uint32_t width = (std::max)(1u, icon.width * size / longest);
+		const uint32_t height = (std::max)(1u, icon.height * size / longest);
+		std::vector<uint8_t> resized;
+		if (imageutils::resizeRgba(resized, icon.rgba, icon.width, icon.height, width, height))
+		{
+			icon = IconCompositor::icon_t{ width, height, std::move(resized) };
+			png.clear();
+		}
+	}
+
+	std::vector<uint8_t> recompressed;
+	if (!imageutils::encodePngSmallest(recompressed, icon.rgba, icon.width, icon.height))
+		return !png.empty();
+	if (png.empty() || recompressed.size() < png.size())
+		png.swap(recompressed);
+	return true;
+}
+
+/**
+	@brief loads an image and converts it to a base64 data URI
+
+	@param[in] imageName the name of the image
+	@param[in] size the key size in pixels, or ORIGINAL_SIZE to keep the icon as shipped
+
+	@return the data URI, or nullptr if the image could not be read or composed
+**/
+ImageLoader::image_t ImageLoader::loadDataUri(const std::string& imageName, const uint32_t size)
+{
+	std::vector<uint8_t> png;
+	if (!loadPng(png, imageName, size)) return nullptr;
+
+	std::string dataUri = "data:image/png;base64,";
+	imageutils::pngToBase64(dataUri, png);
+	return std::make_shared<const std::string>(std::move(dataUri));
+}
+
+/**
+	@brief decodes an icon for drawing on, or composes it if it is a combined icon without a file
+
+	@param[in] imageName the name of the image
+	@param[in] size the pixel size of the square the icon is drawn in, larger icons are shrunk to fit it
+
+	@return the decoded icon, always square, with no pixels if it could not be read, decoded or composed
+**/
+ImageLoader::pixels_t ImageLoader::loadPixels(const std::string& imageName, const uint32_t size)
+{
+	IconCompositor::icon_t icon;
+	std::vector<uint8_t> png;
+	std::ifstream ifs(mImageDirectory + imageName + ".png", std::ios::binary | std::ios::ate);
+	if (!ifs.fail())
+	{
+		png.resize(static_cast<size_t>(ifs.tellg()));
+		ifs.seekg(0);
+		unsigned width = 0;
+		unsigned height = 0;
+		if (!ifs.read(reinterpret_cast<char*>(png.data()), png.size()) ||
+			lodepng::decode(icon.rgba, width, height, png) != 0)
+			return std::make_shared<const IconCompositor::icon_t>();
+		icon.width = width;
+		icon.height = height;
+	}
+	else if (std::optional<IconCompositor::icon_t> composed = mCompositor.composePixels(imageName))
+		icon = std::move(*composed);
+	else
+		return std::make_shared<const IconCompositor::icon_t>();
+
+	// shrunk here so drawing only copies pixels, keeping the aspect ratio like loadPng
+	if (size != ORIGINAL_SIZE && (icon.width > size || icon.height > size))
+	{
+		const uint32_t longest = (std::max)(icon.width, icon.height);
+		const uint32_t width = (std::max)(1u, icon.width * size / longest);
+		const uint32_t height = (std::max)(1u, icon.height * size / longest);
+		std::vector<uint8_t> resized;
+		if (imageutils::resizeRgba(resized, icon.rgba, icon.width, icon.height, width, height))
+			icon = IconCompositor::icon_t{ width, height, std::move(resized) };
+	}
+
+	// the canvas stretches its background over the whole square, so a non-square icon is centred on a transparent square
+	if (icon.width != icon.height)
+	{
+		constexpr size_t BYTES_PER_PIXEL = 4;
+		const uint32_t side = (std::max)(icon.width, icon.height);
+		const size_t left = (side - icon.width) / 2;
+		const size_t top = (side - icon.height) / 2;
+		const size_t rowBytes = static_cast<size_t>(icon.width) * BYTES_PER_PIXEL;
+		std::vector<uint8_t> square(static_cast<size_t>(side) * side * BYTES_PER_PIXEL, 0);
+		for (size_t y = 0; y < icon.height; y++)
+			std::memcpy(square.data() + ((top + y) * side + left) * BYTES_PER_PIXEL, icon.rgba.data() + y * rowBytes, rowBytes);
+		icon = IconCompositor::icon_t{ side, side, std::move(square) };
+	}
+	return std::make_shared<const IconCompositor::icon_t>(std::move(icon));
+}
+
+/**
+	@brief loader thread, loads queued images one at a time without holding the lock
+**/
+void ImageLoader::run()
+{
+	PluginTracer::get().nameThread("image loader");
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true)
+	{
+		mCondition.wait(lock, [this]() { return !mIsRunning || !mQueue.empty(); });
+		if (!mIsRunning) return;
+
+		const request_t request = mQueue.front();
+		mQueue.pop_front();
+
+		lock.unlock();
+		if (request.isPixels)
+		{
+			pixels_t pixels;
+			{
+				const ScopedTraceSpan span("decodeImage", "image");
+				pixels = loadPixels(request.imageName, request.size);
+			}
+			lock.lock();
+			// icons that failed are cached too, so drawing does not retry them on every frame
+			addToCache(lock, request.key, nullptr, pixels);
+			mPending.erase(request.key);
+			continue;
+		}
+
+		image_t dataUri;
+		{
+			const ScopedTraceSpan span("loadImage", "image");
+			dataUri = loadDataUri(request.imageName, request.size);
+		}
+		lock.lock();
+
+		// publish to the cache before announcing, so anyone looking after the callback finds it
+		if (dataUri)
+			addToCache(lock, request.key, dataUri);
+		mPending.erase(request.key);
+
+		lock.unlock();
+		mOnLoaded(request.imageName, request.size, dataUri);
+		lock.lock();
+	}
+}
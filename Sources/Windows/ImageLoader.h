@@ -0,0 +1,124 @@
+//==============================================================================
+/**
+@file       ImageLoader.h
+@brief      Loads button icons into a base64 cache on a background thread
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "IconCompositor.h"
+
+/**
+	@brief Loads icons off the caller's thread. Finished images are published to a cache
+	       and announced through a callback, so callers never wait on disk I/O.
+	       Cached images are immutable data URIs shared with callers, so handing one out never copies it.
+	       Combined icons without their own file, ie: blue fish patterns, are composed from the single icons.
+       Images can be requested at a key size, they are then shrunk to fit and recompressed, and cached per size.
+       Icons can also be requested as decoded pixels for drawing on, these share the cache and its budget.
+**/
+class ImageLoader
+{
+public:
+	// a loaded image as a ready to send data URI, shared between the cache and whoever is sending it
+	using image_t = std::shared_ptr<const std::string>;
+
+	// a decoded icon shared between the cache and whoever is drawing it, with no pixels if it could not be loaded
+	using pixels_t = std::shared_ptr<const IconCompositor::icon_t>;
+
+	// called on the loader thread once an image finishes loading, with nullptr if it could not be loaded
+	using onLoaded_t = std::function<void(const std::string& imageName, const uint32_t size, const image_t& dataUri)>;
+
+	// image size to load an icon as shipped, without resizing or recompressing
+	static constexpr uint32_t ORIGINAL_SIZE = 0;
+
+	// cache activity since construction, for logging
+	struct cacheStats_t
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t evictions = 0;
+		size_t bytes = 0;
+		size_t entries = 0;
+	};
+
+	// default cache size, a little over the whole Icons/ set
+	static constexpr size_t DEFAULT_BYTE_BUDGET = 1024 * 1024;
+
+	ImageLoader(
+		const std::string& imageDirectory,
+		onLoaded_t onLoaded,
+		const size_t byteBudget = DEFAULT_BYTE_BUDGET,
+		const IconCompositor::imageAliases_t& imageAliases = {}
+	);
+	~ImageLoader();
+
+	image_t getOrLoad(const std::string& imageName, const uint32_t size = ORIGINAL_SIZE);
+	void prefetch(const std::string& imageName, const uint32_t size = ORIGINAL_SIZE);
+	pixels_t getOrLoadPixels(const std::string& imageName, const uint32_t size);
+	cacheStats_t getStats();
+
+private:
+	const std::string mImageDirectory;
+	const onLoaded_t mOnLoaded;
+	const size_t mByteBudget;
+
+	// only used on the loader thread
+	IconCompositor mCompositor;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	bool mIsRunning = true;
+
+	// an image at a size, images are cached and queued by their key "<name>@<size>"
+	struct request_t
+	{
+		std::string imageName;
+		uint32_t size = ORIGINAL_SIZE;
+		std::string key;
+		bool isPixels = false;
+	};
+
+	// images waiting to load, and the keys of those plus the one currently loading so each is only loaded once
+	std::deque<request_t> mQueue;
+	std::unordered_set<std::string> mPending;
+
+	// cache of images that have been loaded by key, mLruOrder has the most recently used key at the front
+	// each entry holds either a data URI or decoded pixels
+	struct cacheEntry_t
+	{
+		image_t dataUri;
+		pixels_t pixels;
+		std::list<std::string>::iterator lruPosition;
+	};
+	std::unordered_map<std::string, cacheEntry_t> mImageNameToDataUriMap;
+	std::list<std::string> mLruOrder;
+	cacheStats_t mStats;
+
+	std::thread mThread;
+
+	static std::string getKey(const std::string& imageName, const uint32_t size);
+	static std::string getPixelsKey(const std::string& imageName, const uint32_t size);
+	static size_t getBytes(const cacheEntry_t& entry);
+	const cacheEntry_t* findCached(const std::unique_lock<std::mutex>& lock, const std::string& key);
+	void addToCache(const std::unique_lock<std::mutex>& lock, const std::string& key, const image_t& dataUri, const pixels_t& pixels = nullptr);
+	void queueLoad(const std::unique_lock<std::mutex>& lock, const std::string& imageName, const uint32_t size, const std::string& key, const bool isPixels = false);
+	bool loadPng(std::vector<uint8_t>& png, const std::string& imageName, const uint32_t size);
+	image_t loadDataUri(const std::string& imageName, const uint32_t size);
+	pixels_t loadPixels(const std::string& imageName, const uint32_t size);
+	void run();
+};
@@ -0,0 +1,81 @@
+//==============================================================================
+/**
+@file       ImageSendFilter.cpp
+@brief      Remembers the last image sent to a button to skip resending it
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "ImageSendFilter.h"
+#include <functional>
+
+/**
+	@brief checks if an image differs from the one the button is showing, and if so records it as sent
+
+	@param[in] image the image about to be sent
+
+	@return true if the image should be sent, false if the button already shows it
+**/
+bool ImageSendFilter::shouldSend(std::string_view image)
+{
+	const size_t hash = std::hash<std::string_view>{}(image);
+	if (mHasSent && mSentSize == image.size() && mSentHash == hash)
+		return false;
+
+	mHasSent = true;
+	mSentHash = hash;
+	mSentSize = image.size();
+	return true;
+}
+
+/**
+	@brief forgets the sent image, so the next image is always sent
+**/
+void ImageSendFilter::reset()
+{
+	mHasSent = false;
+}
+
+/**
+	@brief keeps the filter of a context that was hidden, dropping the longest hidden context if over the limit
+
+	@param[in] context the context that was hidden
+	@param[in] filter the image filter of the context
+**/
+void HiddenImageSendFilters::hide(const std::string& context, const ImageSendFilter& filter)
+{
+	if (const auto it = mFilters.find(context); it != mFilters.end())
+	{
+		mHiddenOrder.erase(it->second.hiddenPosition);
+		mFilters.erase(it);
+	}
+
+	mHiddenOrder.push_front(context);
+	mFilters.emplace(context, hiddenFilter_t{ filter, mHiddenOrder.begin() });
+
+	while (mFilters.size() > mMaxContexts)
+	{
+		mFilters.erase(mHiddenOrder.back());
+		mHiddenOrder.pop_back();
+	}
+}
+
+/**
+	@brief takes back the filter of a context that reappeared
+
+	@param[in] context the context that reappeared
+
+	@return the filter the context was hidden with, or nothing if it was never hidden or was dropped
+**/
+std::optional<ImageSendFilter> HiddenImageSendFilters::reappear(const std::string& context)
+{
+	const auto it = mFilters.find(context);
+	if (it == mFilters.end())
+		return std::nullopt;
+
+	const ImageSendFilter filter = it->second.filter;
+	mHiddenOrder.erase(it->second.hiddenPosition);
+	mFilters.erase(it);
+	return filter;
+}
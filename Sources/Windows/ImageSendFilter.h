@@ -0,0 +1,67 @@
+//==============================================================================
+/**
+@file       ImageSendFilter.h
+@brief      Remembers the last image sent to a button to skip resending it
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/**
+	@brief Tracks the image a single button is showing. Each context owns one of these so
+	       recomputes, label changes and settings updates do not resend a multi-KB image the button already has.
+**/
+class ImageSendFilter
+{
+public:
+	ImageSendFilter() {};
+	~ImageSendFilter() {};
+
+	bool shouldSend(std::string_view image);
+	void reset();
+
+private:
+	// images are identified by their content so the same icon from any source matches
+	bool mHasSent = false;
+	size_t mSentHash = 0;
+	size_t mSentSize = 0;
+};
+
+/**
+	@brief Keeps the image filters of hidden contexts, so a context that reappears does not resend the image it still shows.
+	       This relies on the Stream Deck keeping the last image set on a context while it is hidden, and showing it again when it reappears.
+	       Contexts that never reappear, such as deleted buttons or those on other profiles, are dropped oldest first past a limit.
+**/
+class HiddenImageSendFilters
+{
+public:
+	// more hidden contexts than a few full profiles, a context hidden this long ago just resends its image
+	static constexpr size_t DEFAULT_MAX_CONTEXTS = 1024;
+
+	explicit HiddenImageSendFilters(const size_t maxContexts = DEFAULT_MAX_CONTEXTS) : mMaxContexts(maxContexts) {};
+	~HiddenImageSendFilters() {};
+
+	void hide(const std::string& context, const ImageSendFilter& filter);
+	std::optional<ImageSendFilter> reappear(const std::string& context);
+	size_t size() const { return mFilters.size(); };
+
+private:
+	struct hiddenFilter_t
+	{
+		ImageSendFilter filter;
+		std::list<std::string>::iterator hiddenPosition;
+	};
+
+	size_t mMaxContexts;
+	std::unordered_map<std::string, hiddenFilter_t> mFilters;
+	// hidden contexts with the most recently hidden at the front
+	std::list<std::string> mHiddenOrder;
+};
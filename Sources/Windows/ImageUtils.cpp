@@ -0,0 +1,384 @@
+//==============================================================================
+/**
+@file       ImageUtils.cpp
+@brief      utilities for image processing
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "ImageUtils.h"
+#include "../Vendor/lodepng/lodepng.h"
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define IMAGEUTILS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// msvc allows any intrinsic in any function, gcc and clang need the functions marked with the instruction set they use
+#if defined(__GNUC__)
+#define IMAGEUTILS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define IMAGEUTILS_TARGET(isa)
+#endif
+
+namespace imageutils
+{
+	namespace
+	{
+		/**
+			@brief builds a table mapping every 12 bit value to its two base64 characters
+		**/
+		constexpr std::array<char, 4096 * 2> makeBase64PairTable()
+		{
+			constexpr char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			std::array<char, 4096 * 2> table{};
+			for (size_t i = 0; i < 4096; i++)
+			{
+				table[i * 2] = alphabet[i >> 6];
+				table[i * 2 + 1] = alphabet[i & 0x3f];
+			}
+			return table;
+		}
+		constexpr std::array<char, 4096 * 2> BASE64_PAIRS = makeBase64PairTable();
+
+		/**
+			@brief encodes with two 12 bit table lookups per 3 bytes, also handles the padded tail
+
+			@param[out] out the output, must hold getBase64EncodedSize(size) characters
+			@param[in] in the bytes to encode
+			@param[in] size number of bytes to encode
+		**/
+		void encodeBase64Scalar(char* out, const uint8_t* in, size_t size)
+		{
+			while (size >= 3)
+			{
+				const uint32_t v = (uint32_t(in[0]) << 16) | (uint32_t(in[1]) << 8) | in[2];
+				std::memcpy(out, &BASE64_PAIRS[(v >> 12) * 2], 2);
+				std::memcpy(out + 2, &BASE64_PAIRS[(v & 0xfff) * 2], 2);
+				in += 3;
+				out += 4;
+				size -= 3;
+			}
+
+			if (size == 0) return;
+
+			const uint32_t v = (uint32_t(in[0]) << 16) | (size == 2 ? uint32_t(in[1]) << 8 : 0);
+			out[0] = BASE64[(v >> 18) & 0x3f];
+			out[1] = BASE64[(v >> 12) & 0x3f];
+			out[2] = size == 2 ? BASE64[(v >> 6) & 0x3f] : '=';
+			out[3] = '=';
+		}
+
+#ifdef IMAGEUTILS_X86
+		/**
+			@brief splits each 3 byte group of the first 12 bytes of every 16 byte lane into four 6 bit indices
+		**/
+		IMAGEUTILS_TARGET("ssse3")
+		inline __m128i splitBase64Indices(const __m128i in)
+		{
+			const __m128i shuffled = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+			const __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(shuffled, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+			const __m128i t1 = _mm_mullo_epi16(_mm_and_si128(shuffled, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+			return _mm_or_si128(t0, t1);
+		}
+
+		/**
+			@brief maps 6 bit indices to base64 characters by adding a per-range offset
+		**/
+		IMAGEUTILS_TARGET("ssse3")
+		inline __m128i translateBase64Indices(const __m128i indices)
+		{
+			// 0-25 -> 13, 26-51 -> 0, 52-61 -> 1-10, 62 -> 11, 63 -> 12, then look up the offset for that range
+			__m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+			range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+			const __m128i offsets = _mm_setr_epi8(
+				'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+				'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+			return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+		}
+
+		/**
+			@brief encodes 12 bytes into 16 characters per step, reading 16 bytes at a time
+		**/
+		IMAGEUTILS_TARGET("ssse3")
+		void encodeBase64SSSE3(char* out, const uint8_t* in, size_t size)
+		{
+			while (size >= 16)
+			{
+				const __m128i indices = splitBase64Indices(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), translateBase64Indices(indices));
+				in += 12;
+				out += 16;
+				size -= 12;
+			}
+			encodeBase64Scalar(out, in, size);
+		}
+
+		/**
+			@brief encodes 24 bytes into 32 characters per step, each 128 bit lane works like the SSSE3 kernel
+		**/
+		IMAGEUTILS_TARGET("avx2")
+		void encodeBase64AVX2(char* out, const uint8_t* in, size_t size)
+		{
+			const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+			const __m256i offsets = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+				'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+				'0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+
+			while (size >= 28)
+			{
+				const __m256i block = _mm256_inserti128_si256(
+					_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12)),
+					1);
+				const __m256i shuffled = _mm256_shuffle_epi8(block, shuffle);
+				const __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(shuffled, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+				const __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(shuffled, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+				const __m256i indices = _mm256_or_si256(t0, t1);
+
+				__m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+				range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices));
+
+				in += 24;
+				out += 32;
+				size -= 24;
+			}
+			encodeBase64SSSE3(out, in, size);
+		}
+
+		struct cpuFeatures_t
+		{
+			bool hasSSSE3 = false;
+			bool hasAVX2 = false;
+		};
+
+		/**
+			@brief queries the cpu, and for AVX2 also that the OS saves the wide registers
+		**/
+		cpuFeatures_t detectCpuFeatures()
+		{
+			cpuFeatures_t features;
+			unsigned int regs[4] = {};
+#if defined(_MSC_VER)
+			__cpuid(reinterpret_cast<int*>(regs), 0);
+			const unsigned int maxLeaf = regs[0];
+			__cpuid(reinterpret_cast<int*>(regs), 1);
+#else
+			const unsigned int maxLeaf = __get_cpuid_max(0, nullptr);
+			__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+			features.hasSSSE3 = (regs[2] & (1u << 9)) != 0;
+
+			const bool hasOSXSave = (regs[2] & (1u << 27)) != 0;
+			if (maxLeaf < 7 || !hasOSXSave)
+				return features;
+
+#if defined(_MSC_VER)
+			const bool isYmmSaved = (_xgetbv(0) & 0x6) == 0x6;
+			__cpuidex(reinterpret_cast<int*>(regs), 7, 0);
+#else
+			unsigned int xcr0Low = 0, xcr0High = 0;
+			__asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+			const bool isYmmSaved = (xcr0Low & 0x6) == 0x6;
+			__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+			features.hasAVX2 = isYmmSaved && (regs[1] & (1u << 5)) != 0;
+			return features;
+		}
+
+		const cpuFeatures_t& getCpuFeatures()
+		{
+			static const cpuFeatures_t features = detectCpuFeatures();
+			return features;
+		}
+#endif
+
+		// the source pixels one output pixel covers along an axis, and how much of each it covers
+		struct areaWeights_t
+		{
+			uint32_t first = 0;
+			std::vector<float> weights;
+		};
+
+		/**
+			@brief works out the box filter weights of each output pixel along an axis, the weights of each sum to 1
+		**/
+		std::vector<areaWeights_t> getAreaWeights(const uint32_t size, const uint32_t outSize)
+		{
+			const double scale = static_cast<double>(size) / outSize;
+			std::vector<areaWeights_t> areaWeights(outSize);
+			for (uint32_t o = 0; o < outSize; o++)
+			{
+				const double start = o * scale;
+				const double end = (o + 1) * scale;
+				areaWeights_t& area = areaWeights[o];
+				area.first = static_cast<uint32_t>(start);
+				const uint32_t last = (std::min)(static_cast<uint32_t>(std::ceil(end)), size);
+				for (uint32_t i = area.first; i < last; i++)
+					area.weights.push_back(static_cast<float>(((std::min)(end, i + 1.0) - (std::max)(start, static_cast<double>(i))) / scale));
+			}
+			return areaWeights;
+		}
+	}
+
+	/**
+		@brief resamples an RGBA image by averaging the area each output pixel covers, which keeps detail when shrinking.
+		       Colors are weighted by alpha so transparent pixels do not darken the edges of the icon.
+
+		@param[out] out the resampled pixels
+		@param[in] in the pixels to resample
+		@param[in] width width of in
+		@param[in] height height of in
+		@param[in] outWidth width to resample to
+		@param[in] outHeight height to resample to
+
+		@return false if a size is 0 or in does not hold width * height pixels
+	**/
+	bool resizeRgba(
+		std::vector<uint8_t>& out,
+		const std::vector<uint8_t>& in,
+		const uint32_t width,
+		const uint32_t height,
+		const uint32_t outWidth,
+		const uint32_t outHeight
+	)
+	{
+		constexpr size_t CHANNELS = 4;
+		if (width == 0 || height == 0 || outWidth == 0 || outHeight == 0) return false;
+		if (in.size() != static_cast<size_t>(width) * height * CHANNELS) return false;
+
+		// premultiply once, then filter rows into a narrow image and its columns into the output
+		std::vector<float> premultiplied(in.size());
+		for (size_t i = 0; i < in.size(); i += CHANNELS)
+		{
+			const float alpha = in[i + 3] / 255.0f;
+			premultiplied[i] = in[i] * alpha;
+			premultiplied[i + 1] = in[i + 1] * alpha;
+			premultiplied[i + 2] = in[i + 2] * alpha;
+			premultiplied[i + 3] = in[i + 3];
+		}
+
+		const std::vector<areaWeights_t> columns = getAreaWeights(width, outWidth);
+		std::vector<float> narrow(static_cast<size_t>(outWidth) * height * CHANNELS, 0.0f);
+		for (uint32_t y = 0; y < height; y++)
+			for (uint32_t x = 0; x < outWidth; x++)
+			{
+				float* dst = &narrow[(static_cast<size_t>(y) * outWidth + x) * CHANNELS];
+				for (size_t i = 0; i < columns[x].weights.size(); i++)
+				{
+					const float* src = &premultiplied[(static_cast<size_t>(y) * width + columns[x].first + i) * CHANNELS];
+					for (size_t c = 0; c < CHANNELS; c++)
+						dst[c] += src[c] * columns[x].weights[i];
+				}
+			}
+
+		const std::vector<areaWeights_t> rows = getAreaWeights(height, outHeight);
+		out.assign(static_cast<size_t>(outWidth) * outHeight * CHANNELS, 0);
+		for (uint32_t y = 0; y < outHeight; y++)
+			for (uint32_t x = 0; x < outWidth; x++)
+			{
+				float pixel[CHANNELS] = {};
+				for (size_t i = 0; i < rows[y].weights.size(); i++)
+				{
+					const float* src = &narrow[((rows[y].first + i) * outWidth + x) * CHANNELS];
+					for (size_t c = 0; c < CHANNELS; c++)
+						pixel[c] += src[c] * rows[y].weights[i];
+				}
+
+				uint8_t* dst = &out[(static_cast<size_t>(y) * outWidth + x) * CHANNELS];
+				const float alpha = pixel[3];
+				for (size_t c = 0; c < 3; c++)
+					dst[c] = alpha > 0 ? static_cast<uint8_t>(std::lround((std::min)(pixel[c] / (alpha / 255.0f), 255.0f))) : 0;
+				dst[3] = static_cast<uint8_t>(std::lround((std::min)(alpha, 255.0f)));
+			}
+		return true;
+	}
+
+	/**
+		@brief encodes a png as small as lodepng can make it in reasonable time, trying each row filter heuristic
+		       and keeping the smallest. Meant for images that are encoded once and sent often.
+
+		@param[out] out the png
+		@param[in] rgba the pixels
+		@param[in] width image width
+		@param[in] height image height
+
+		@return false if the image could not be encoded
+	**/
+	bool encodePngSmallest(std::vector<uint8_t>& out, const std::vector<uint8_t>& rgba, const uint32_t width, const uint32_t height)
+	{
+		out.clear();
+		std::vector<uint8_t> png;
+		for (const LodePNGFilterStrategy strategy : { LFS_ZERO, LFS_MINSUM, LFS_ENTROPY })
+		{
+			// larger lz77 windows were measured to be several times slower without making the icons smaller
+			lodepng::State state;
+			state.encoder.filter_strategy = strategy;
+
+			png.clear();
+			if (lodepng::encode(png, rgba, width, height, state) != 0) continue;
+			if (out.empty() || png.size() < out.size())
+				out.swap(png);
+		}
+		return !out.empty();
+	}
+
+	/**
+		@brief checks if a base64 kernel can run on this cpu
+
+		@param[in] kernel the kernel to check
+
+		@return true if the kernel is supported
+	**/
+	bool isBase64KernelSupported(const BASE64_KERNEL kernel)
+	{
+		switch (kernel)
+		{
+		case BASE64_KERNEL::AUTO:
+		case BASE64_KERNEL::SCALAR:
+			return true;
+#ifdef IMAGEUTILS_X86
+		case BASE64_KERNEL::SSSE3:
+			return getCpuFeatures().hasSSSE3;
+		case BASE64_KERNEL::AVX2:
+			return getCpuFeatures().hasAVX2;
+#endif
+		default:
+			return false;
+		}
+	}
+
+	/**
+		@brief base64 encodes bytes with padding. Unsupported kernels fall back to the scalar one.
+
+		@param[out] out the output, must hold getBase64EncodedSize(size) characters
+		@param[in] in the bytes to encode
+		@param[in] size number of bytes to encode
+		@param[in] kernel the kernel to use, AUTO picks the fastest supported one
+	**/
+	void encodeBase64(char* out, const uint8_t* in, const size_t size, BASE64_KERNEL kernel)
+	{
+		if (kernel == BASE64_KERNEL::AUTO)
+			kernel = isBase64KernelSupported(BASE64_KERNEL::AVX2) ? BASE64_KERNEL::AVX2 :
+				isBase64KernelSupported(BASE64_KERNEL::SSSE3) ? BASE64_KERNEL::SSSE3 :
+				BASE64_KERNEL::SCALAR;
+
+#ifdef IMAGEUTILS_X86
+		if (kernel == BASE64_KERNEL::AVX2 && isBase64KernelSupported(kernel))
+			return encodeBase64AVX2(out, in, size);
+		if (kernel == BASE64_KERNEL::SSSE3 && isBase64KernelSupported(kernel))
+			return encodeBase64SSSE3(out, in, size);
+#endif
+		encodeBase64Scalar(out, in, size);
+	}
+}
@@ -8,29 +8,61 @@
 
 #pragma once
 #include <string>
+#include <cstdint>
+#include <vector>
 
 namespace imageutils
 {
 	static const std::string BASE64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
+	// the base64 encoding kernels, AUTO picks the fastest one this cpu supports
+	enum class BASE64_KERNEL
+	{
+		AUTO,
+		SCALAR,
+		SSSE3,
+		AVX2,
+	};
+
+	/**
+		@brief gets the exact number of characters base64 encoding produces, including padding
+
+		@param[in] size number of bytes to encode
+
+		@return the encoded length
+	**/
+	constexpr size_t getBase64EncodedSize(const size_t size)
+	{
+		return (size + 2) / 3 * 4;
+	}
+
+	bool isBase64KernelSupported(const BASE64_KERNEL kernel);
+	void encodeBase64(char* out, const uint8_t* in, const size_t size, const BASE64_KERNEL kernel = BASE64_KERNEL::AUTO);
+
+	bool resizeRgba(
+		std::vector<uint8_t>& out,
+		const std::vector<uint8_t>& in,
+		const uint32_t width,
+		const uint32_t height,
+		const uint32_t outWidth,
+		const uint32_t outHeight
+	);
+	bool encodePngSmallest(std::vector<uint8_t>& out, const std::vector<uint8_t>& rgba, const uint32_t width, const uint32_t height);
+
 	/**
-		@brief converts loaded png into base64. Function obtained from lodepng example documentation
+		@brief converts loaded png into base64, appending it to out
 
 		@param[out] out the output base 64
 		@param[in] in the input image
 	**/
 	template<typename T, typename U> //T and U can be std::string or std::vector<unsigned char>
 	void pngToBase64(T& out, const U& in) {
-		for (size_t i = 0; i < in.size(); i += 3) {
-			int v = 65536 * in[i];
-			if (i + 1 < in.size()) v += 256 * in[i + 1];
-			if (i + 2 < in.size()) v += in[i + 2];
-			out.push_back(BASE64[(v >> 18) & 0x3f]);
-			out.push_back(BASE64[(v >> 12) & 0x3f]);
-			if (i + 1 < in.size()) out.push_back(BASE64[(v >> 6) & 0x3f]);
-			else out.push_back('=');
-			if (i + 2 < in.size()) out.push_back(BASE64[(v >> 0) & 0x3f]);
-			else out.push_back('=');
-		}
+		const size_t start = out.size();
+		out.resize(start + getBase64EncodedSize(in.size()));
+		encodeBase64(
+			reinterpret_cast<char*>(out.data() + start),
+			reinterpret_cast<const uint8_t*>(in.data()),
+			in.size()
+		);
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,119 @@
+//==============================================================================
+/**
+@file       InMemoryTransport.cpp
+@brief      Runs a plugin without the Stream Deck application, for tests and load tests
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "InMemoryTransport.h"
+
+/**
+	@brief creates the transport and connects it to the plugin
+
+	@param[in] plugin the plugin to run
+	@param[in] isRecording true to keep every sent message for takeMessages, false to only count them
+	@param[in] pluginUUID the uuid the plugin was registered with, sent as the context of global settings
+**/
+InMemoryTransport::InMemoryTransport(ESDBasePlugin* plugin, const bool isRecording, const std::string& pluginUUID) :
+	ESDTransport(pluginUUID, plugin),
+	mIsRecording(isRecording)
+{
+}
+
+/**
+	@brief hands an event to the plugin as if the Stream Deck application had sent it, returns once the plugin handled it
+
+	@param[in] message the json event
+**/
+void InMemoryTransport::inject(std::string_view message)
+{
+	std::lock_guard<std::mutex> lock(mInjectMutex);
+	Dispatch(message);
+}
+
+/**
+	@brief takes the messages recorded so far
+
+	@return every message sent since the last take, in the order they were sent
+**/
+std::vector<std::string> InMemoryTransport::takeMessages()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::vector<std::string> messages;
+	messages.swap(mMessages);
+	return messages;
+}
+
+/**
+	@brief gets how much the plugin has sent
+
+	@return the counts since construction or the last clear
+**/
+InMemoryTransport::transportStats_t InMemoryTransport::getStats()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	transportStats_t stats = mStats;
+	stats.titledContexts = mTitledContexts.size();
+	stats.imagedContexts = mImagedContexts.size();
+	return stats;
+}
+
+/**
+	@brief forgets every message and count, so the next step of a session can be measured on its own
+**/
+void InMemoryTransport::clear()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mMessages.clear();
+	mStats = {};
+	mTitledContexts.clear();
+	mImagedContexts.clear();
+}
+
+/**
+	@brief waits until enough buttons have been given a title and an image since the last clear
+
+	@param[in] titledContexts how many contexts need a title
+	@param[in] imagedContexts how many contexts need an image
+	@param[in] timeout the longest to wait
+
+	@return true if they were all sent before the timeout
+**/
+bool InMemoryTransport::waitForContexts(const size_t titledContexts, const size_t imagedContexts, const std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mCondition.wait_for(lock, timeout, [&]()
+		{
+			return mTitledContexts.size() >= titledContexts && mImagedContexts.size() >= imagedContexts;
+		});
+}
+
+/**
+	@brief records a message the plugin sent
+**/
+void InMemoryTransport::Send(std::string_view inMessage, const MessageQueue::COALESCE inCoalesce, std::string_view inContext)
+{
+	bool isNewContext = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStats.messages++;
+		mStats.bytes += inMessage.size();
+		if (mIsRecording)
+			mMessages.emplace_back(inMessage);
+
+		if (inCoalesce == MessageQueue::COALESCE::TITLE)
+		{
+			mStats.titles++;
+			isNewContext = mTitledContexts.emplace(inContext).second;
+		}
+		else if (inCoalesce == MessageQueue::COALESCE::IMAGE)
+		{
+			mStats.images++;
+			isNewContext = mImagedContexts.emplace(inContext).second;
+		}
+	}
+	if (isNewContext)
+		mCondition.notify_all();
+}
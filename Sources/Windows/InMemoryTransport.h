@@ -0,0 +1,65 @@
+//==============================================================================
+/**
+@file       InMemoryTransport.h
+@brief      Runs a plugin without the Stream Deck application, for tests and load tests
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+#include "../Common/ESDTransport.h"
+
+/**
+	@brief A transport that records what the plugin sends instead of sending it, and hands it
+	       Stream Deck events through the same dispatch as the websocket.
+	       Recording the messages themselves is optional so very large sessions only pay for counting them.
+**/
+class InMemoryTransport : public ESDTransport
+{
+public:
+	// what the plugin has sent since construction or the last clear
+	struct transportStats_t
+	{
+		uint64_t messages = 0;
+		uint64_t bytes = 0;
+		uint64_t titles = 0;
+		uint64_t images = 0;
+		size_t titledContexts = 0;
+		size_t imagedContexts = 0;
+	};
+
+	InMemoryTransport(ESDBasePlugin* plugin, const bool isRecording = true, const std::string& pluginUUID = "InMemoryTransport");
+	~InMemoryTransport() {};
+
+	void inject(std::string_view message);
+
+	std::vector<std::string> takeMessages();
+	transportStats_t getStats();
+	void clear();
+	bool waitForContexts(const size_t titledContexts, const size_t imagedContexts, const std::chrono::milliseconds timeout);
+
+protected:
+	void Send(std::string_view inMessage, const MessageQueue::COALESCE inCoalesce, std::string_view inContext) override;
+
+private:
+	const bool mIsRecording;
+
+	// events are handed to the plugin one at a time, like the websocket thread does
+	std::mutex mInjectMutex;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::vector<std::string> mMessages;
+	transportStats_t mStats;
+	std::unordered_set<std::string> mTitledContexts;
+	std::unordered_set<std::string> mImagedContexts;
+};
@@ -0,0 +1,312 @@
+//==============================================================================
+/**
+@file       InboundMessage.cpp
+@brief      Reads the events sent by the Stream Deck without parsing the whole message
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "InboundMessage.h"
+#include "../Common/ESDSDKDefines.h"
+#include <array>
+#include <utility>
+
+namespace
+{
+	using EVENT = InboundMessage::EVENT;
+
+	constexpr std::array<std::pair<std::string_view, EVENT>, 15> EVENT_NAMES = { {
+		{ kESDSDKEventKeyDown, EVENT::KEY_DOWN },
+		{ kESDSDKEventKeyUp, EVENT::KEY_UP },
+		{ kESDSDKEventWillAppear, EVENT::WILL_APPEAR },
+		{ kESDSDKEventWillDisappear, EVENT::WILL_DISAPPEAR },
+		{ kESDSDKEventDeviceDidConnect, EVENT::DEVICE_DID_CONNECT },
+		{ kESDSDKEventDeviceDidDisconnect, EVENT::DEVICE_DID_DISCONNECT },
+		{ kESDSDKEventApplicationDidLaunch, EVENT::APPLICATION_DID_LAUNCH },
+		{ kESDSDKEventApplicationDidTerminate, EVENT::APPLICATION_DID_TERMINATE },
+		{ kESDSDKEventSystemDidWakeUp, EVENT::SYSTEM_DID_WAKE_UP },
+		{ kESDSDKEventTitleParametersDidChange, EVENT::TITLE_PARAMETERS_DID_CHANGE },
+		{ kESDSDKEventDidReceiveSettings, EVENT::DID_RECEIVE_SETTINGS },
+		{ kESDSDKEventDidReceiveGlobalSettings, EVENT::DID_RECEIVE_GLOBAL_SETTINGS },
+		{ kESDSDKEventPropertyInspectorDidAppear, EVENT::PROPERTY_INSPECTOR_DID_APPEAR },
+		{ kESDSDKEventPropertyInspectorDidDisappear, EVENT::PROPERTY_INSPECTOR_DID_DISAPPEAR },
+		{ kESDSDKEventSendToPlugin, EVENT::SEND_TO_PLUGIN },
+	} };
+
+	// length plus first letter is unique for every event name
+	constexpr size_t EVENT_HASH_SIZE = 32;
+	constexpr size_t hashEventName(std::string_view name)
+	{
+		return (name.size() + static_cast<unsigned char>(name[0])) % EVENT_HASH_SIZE;
+	}
+
+	constexpr bool isPerfectHash()
+	{
+		for (size_t i = 0; i < EVENT_NAMES.size(); i++)
+			for (size_t j = i + 1; j < EVENT_NAMES.size(); j++)
+				if (hashEventName(EVENT_NAMES[i].first) == hashEventName(EVENT_NAMES[j].first))
+					return false;
+		return true;
+	}
+	static_assert(isPerfectHash(), "two event names hash to the same slot, change hashEventName");
+
+	// slot to index into EVENT_NAMES, or EVENT_NAMES.size() when empty
+	constexpr std::array<uint8_t, EVENT_HASH_SIZE> buildEventTable()
+	{
+		std::array<uint8_t, EVENT_HASH_SIZE> table{};
+		table.fill(static_cast<uint8_t>(EVENT_NAMES.size()));
+		for (size_t i = 0; i < EVENT_NAMES.size(); i++)
+			table[hashEventName(EVENT_NAMES[i].first)] = static_cast<uint8_t>(i);
+		return table;
+	}
+	constexpr std::array<uint8_t, EVENT_HASH_SIZE> EVENT_TABLE = buildEventTable();
+
+	size_t skipWhitespace(std::string_view text, size_t i)
+	{
+		while (i < text.size() && (text[i] == ' ' || text[i] == '\t' || text[i] == '\n' || text[i] == '\r'))
+			i++;
+		return i;
+	}
+
+	/**
+		@brief finds the end of the json string starting at i
+
+		@param[in] text the message
+		@param[in] i the index of the opening quote
+		@param[out] hasEscape true if the string has any escape sequence
+
+		@return the index after the closing quote, or npos if the string does not end
+	**/
+	size_t skipString(std::string_view text, size_t i, bool& hasEscape)
+	{
+		hasEscape = false;
+		for (i++; i < text.size(); i++)
+		{
+			if (text[i] == '"')
+				return i + 1;
+			if (text[i] == '\\')
+			{
+				hasEscape = true;
+				i++;
+			}
+		}
+		return std::string_view::npos;
+	}
+
+	/**
+		@brief finds the end of the json value starting at i, nested objects and arrays are skipped whole without being checked
+
+		@return the index after the value, or npos if it does not end
+	**/
+	size_t skipValue(std::string_view text, size_t i)
+	{
+		bool hasEscape = false;
+		if (text[i] == '"')
+			return skipString(text, i, hasEscape);
+
+		if (text[i] == '{' || text[i] == '[')
+		{
+			size_t depth = 0;
+			while (i < text.size())
+			{
+				if (text[i] == '"')
+				{
+					i = skipString(text, i, hasEscape);
+					if (i == std::string_view::npos)
+						return i;
+					continue;
+				}
+				if (text[i] == '{' || text[i] == '[')
+					depth++;
+				else if ((text[i] == '}' || text[i] == ']') && --depth == 0)
+					return i + 1;
+				i++;
+			}
+			return std::string_view::npos;
+		}
+
+		// numbers, true, false and null
+		while (i < text.size() && text[i] != ',' && text[i] != '}' && text[i] != ']' &&
+			text[i] != ' ' && text[i] != '\t' && text[i] != '\n' && text[i] != '\r')
+			i++;
+		return i;
+	}
+
+	/**
+		@brief copies a json string value into a reused buffer, only going through the json parser if it has escapes
+
+		@param[in] value the raw json value including its quotes
+		@param[in] hasEscape true if the value has escape sequences
+		@param[out] out the string, empty if the value is not a string
+	**/
+	void assignString(std::string_view value, const bool hasEscape, std::string& out)
+	{
+		out.clear();
+		if (value.size() < 2 || value.front() != '"')
+			return;
+		if (!hasEscape)
+		{
+			out.assign(value.substr(1, value.size() - 2));
+			return;
+		}
+		const json unescaped = json::parse(value.begin(), value.end(), nullptr, false);
+		if (unescaped.is_string())
+			out = unescaped.get_ref<const std::string&>();
+	}
+}
+
+/**
+	@brief maps a Stream Deck event name to its enum
+
+	@param[in] eventName the event field of a message
+
+	@return the event, UNKNOWN if it is not one the Stream Deck sends to plugins
+**/
+InboundMessage::EVENT InboundMessage::toEvent(std::string_view eventName)
+{
+	if (eventName.empty())
+		return EVENT::UNKNOWN;
+	const uint8_t index = EVENT_TABLE[hashEventName(eventName)];
+	if (index == EVENT_NAMES.size() || EVENT_NAMES[index].first != eventName)
+		return EVENT::UNKNOWN;
+	return EVENT_NAMES[index].second;
+}
+
+/**
+	@brief gets the Stream Deck name of an event
+
+	@param[in] event the event
+
+	@return the event name, or "unknown"
+**/
+std::string_view InboundMessage::toName(const EVENT event)
+{
+	for (const auto& [name, value] : EVENT_NAMES)
+		if (value == event)
+			return name;
+	return "unknown";
+}
+
+/**
+	@brief scans a message for its event, context, action, device, payload and device info
+
+	@param[in] message the json message, it must outlive any use of the payload or device info
+
+	@return false if the message is not a json object
+**/
+bool InboundMessage::parse(std::string_view message)
+{
+	mEvent = EVENT::UNKNOWN;
+	mEventName.clear();
+	mContext.clear();
+	mAction.clear();
+	mDevice.clear();
+	mPayloadText = {};
+	mDeviceInfoText = {};
+	mIsPayloadParsed = false;
+	mIsDeviceInfoParsed = false;
+
+	size_t i = skipWhitespace(message, 0);
+	if (i >= message.size() || message[i] != '{')
+		return false;
+	i = skipWhitespace(message, i + 1);
+	if (i < message.size() && message[i] == '}')
+		return true;
+
+	while (i < message.size())
+	{
+		bool hasEscape = false;
+		if (message[i] != '"')
+			return false;
+		const size_t keyEnd = skipString(message, i, hasEscape);
+		if (keyEnd == std::string_view::npos)
+			return false;
+		const std::string_view key = message.substr(i + 1, keyEnd - i - 2);
+
+		i = skipWhitespace(message, keyEnd);
+		if (i >= message.size() || message[i] != ':')
+			return false;
+		i = skipWhitespace(message, i + 1);
+		if (i >= message.size())
+			return false;
+
+		const size_t valueEnd = skipValue(message, i);
+		if (valueEnd == std::string_view::npos)
+			return false;
+		const std::string_view value = message.substr(i, valueEnd - i);
+		hasEscape = value.find('\\') != std::string_view::npos;
+
+		if (key == kESDSDKCommonEvent)
+		{
+			assignString(value, hasEscape, mEventName);
+			mEvent = toEvent(mEventName);
+		}
+		else if (key == kESDSDKCommonContext)
+			assignString(value, hasEscape, mContext);
+		else if (key == kESDSDKCommonAction)
+			assignString(value, hasEscape, mAction);
+		else if (key == kESDSDKCommonDevice)
+			assignString(value, hasEscape, mDevice);
+		else if (key == kESDSDKCommonPayload)
+			mPayloadText = value;
+		else if (key == kESDSDKCommonDeviceInfo)
+			mDeviceInfoText = value;
+
+		i = skipWhitespace(message, valueEnd);
+		if (i < message.size() && message[i] == '}')
+			return true;
+		if (i >= message.size() || message[i] != ',')
+			return false;
+		i = skipWhitespace(message, i + 1);
+	}
+	return false;
+}
+
+/**
+	@brief parses the payload the first time it is asked for
+
+	@return the payload object, null if the message has none or it is not an object
+**/
+const json& InboundMessage::getPayload()
+{
+	if (!mIsPayloadParsed)
+	{
+		parseObject(mPayloadText, mPayload);
+		mIsPayloadParsed = true;
+	}
+	return mPayload;
+}
+
+/**
+	@brief parses the device info the first time it is asked for
+
+	@return the device info object, null if the message has none or it is not an object
+**/
+const json& InboundMessage::getDeviceInfo()
+{
+	if (!mIsDeviceInfoParsed)
+	{
+		parseObject(mDeviceInfoText, mDeviceInfo);
+		mIsDeviceInfoParsed = true;
+	}
+	return mDeviceInfo;
+}
+
+/**
+	@brief parses a raw object field
+
+	@param[in] text the raw json of the field, may be empty
+	@param[out] out the object, or null if it is missing or not a valid object
+**/
+void InboundMessage::parseObject(std::string_view text, json& out)
+{
+	if (text.empty() || text.front() != '{')
+	{
+		out = nullptr;
+		return;
+	}
+	out = json::parse(text.begin(), text.end(), nullptr, false);
+	if (!out.is_object())
+		out = nullptr;
+}
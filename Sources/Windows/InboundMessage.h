@@ -0,0 +1,83 @@
+//==============================================================================
+/**
+@file       InboundMessage.h
+@brief      Reads the events sent by the Stream Deck without parsing the whole message
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "../Vendor/json/src/json.hpp"
+using json = nlohmann::json;
+
+/**
+	@brief Scans a Stream Deck event in place for its top level fields, and only builds a json DOM
+	       for the payload or device info once a handler asks for it, so ignored events are never parsed.
+	       The event name is looked up through a perfect hash. Strings are kept in buffers reused from
+	       one message to the next, so handlers borrow everything and nothing is allocated once warmed up.
+	       Everything returned is valid until the next parse. Not thread safe, use one per thread.
+**/
+class InboundMessage
+{
+public:
+	enum class EVENT
+	{
+		UNKNOWN,
+		KEY_DOWN,
+		KEY_UP,
+		WILL_APPEAR,
+		WILL_DISAPPEAR,
+		DEVICE_DID_CONNECT,
+		DEVICE_DID_DISCONNECT,
+		APPLICATION_DID_LAUNCH,
+		APPLICATION_DID_TERMINATE,
+		SYSTEM_DID_WAKE_UP,
+		TITLE_PARAMETERS_DID_CHANGE,
+		DID_RECEIVE_SETTINGS,
+		DID_RECEIVE_GLOBAL_SETTINGS,
+		PROPERTY_INSPECTOR_DID_APPEAR,
+		PROPERTY_INSPECTOR_DID_DISAPPEAR,
+		SEND_TO_PLUGIN,
+	};
+
+	InboundMessage() {};
+	~InboundMessage() {};
+
+	static EVENT toEvent(std::string_view eventName);
+	static std::string_view toName(const EVENT event);
+
+	// number of EVENT values, for tables indexed by event
+	static constexpr size_t EVENT_COUNT = static_cast<size_t>(EVENT::SEND_TO_PLUGIN) + 1;
+
+	bool parse(std::string_view message);
+
+	EVENT getEvent() const { return mEvent; }
+	const std::string& getEventName() const { return mEventName; }
+	const std::string& getContext() const { return mContext; }
+	const std::string& getAction() const { return mAction; }
+	const std::string& getDevice() const { return mDevice; }
+	const json& getPayload();
+	const json& getDeviceInfo();
+
+private:
+	EVENT mEvent = EVENT::UNKNOWN;
+	std::string mEventName;
+	std::string mContext;
+	std::string mAction;
+	std::string mDevice;
+
+	// raw json of the object fields, pointing into the message, parsed on first use
+	std::string_view mPayloadText;
+	std::string_view mDeviceInfoText;
+	json mPayload;
+	json mDeviceInfo;
+	bool mIsPayloadParsed = false;
+	bool mIsDeviceInfoParsed = false;
+
+	static void parseObject(std::string_view text, json& out);
+};
@@ -0,0 +1,67 @@
+//==============================================================================
+/**
+@file       MessageQueue.cpp
+@brief      Queues outbound Stream Deck messages until the websocket thread sends them
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "MessageQueue.h"
+
+/**
+	@brief adds a message to the queue, replacing the pending message it coalesces with if any
+
+	@param[in] text the serialized message, copied into the queue
+	@param[in] coalesce which kind of message this replaces, NONE to always send it
+	@param[in] context the context the message is for, only used when coalescing
+
+	@return true if the queue was empty, the caller then needs to schedule a flush
+**/
+bool MessageQueue::push(std::string_view text, const COALESCE coalesce, std::string_view context)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStats.pushed++;
+
+	if (coalesce != COALESCE::NONE)
+	{
+		pendingIndex_t& index = (coalesce == COALESCE::TITLE) ? mPendingTitles : mPendingImages;
+		if (const auto it = index.find(context); it != index.end())
+		{
+			mPending[it->second].text.assign(text);
+			return false;
+		}
+		index.emplace(context, mPending.size());
+	}
+
+	const bool wasEmpty = mPending.empty();
+	mPending.push_back({ coalesce, std::string(context), std::string(text) });
+	return wasEmpty;
+}
+
+/**
+	@brief takes every pending message, the next push after this schedules a new flush
+
+	@param[out] batch the messages to send in order, anything already in it is discarded
+**/
+void MessageQueue::drain(std::vector<message_t>& batch)
+{
+	batch.clear();
+	std::lock_guard<std::mutex> lock(mMutex);
+	batch.swap(mPending);
+	mPendingTitles.clear();
+	mPendingImages.clear();
+	mStats.sent += batch.size();
+	mStats.flushes++;
+}
+
+/**
+	@brief gets how many messages were pushed and sent
+
+	@return the counts since construction
+**/
+MessageQueue::queueStats_t MessageQueue::getStats()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
@@ -0,0 +1,71 @@
+//==============================================================================
+/**
+@file       MessageQueue.h
+@brief      Queues outbound Stream Deck messages until the websocket thread sends them
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+	@brief Collects messages from any thread so only the websocket thread sends them, in one batch per flush.
+	       Pending titles and images replace the pending one of the same context, so a burst of updates
+	       only sends the latest. Other messages are always sent, in the order they were pushed.
+**/
+class MessageQueue
+{
+public:
+	// messages that only matter for their latest value per context
+	enum class COALESCE
+	{
+		NONE,
+		TITLE,
+		IMAGE,
+	};
+
+	struct message_t
+	{
+		COALESCE coalesce = COALESCE::NONE;
+		std::string context;
+		std::string text;
+	};
+
+	// messages pushed and sent since construction, for logging
+	struct queueStats_t
+	{
+		uint64_t pushed = 0;
+		uint64_t sent = 0;
+		uint64_t flushes = 0;
+	};
+
+	MessageQueue() {};
+	~MessageQueue() {};
+
+	bool push(std::string_view text, const COALESCE coalesce = COALESCE::NONE, std::string_view context = {});
+	void drain(std::vector<message_t>& batch);
+	queueStats_t getStats();
+
+private:
+	// hashes contexts by view, so a push can look its context up without copying it
+	struct contextHash_t
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view context) const noexcept { return std::hash<std::string_view>{}(context); }
+	};
+	using pendingIndex_t = std::unordered_map<std::string, size_t, contextHash_t, std::equal_to<>>;
+
+	std::mutex mMutex;
+	std::vector<message_t> mPending;
+	// where each context's pending title and image are in mPending, so a push replaces them in constant time
+	pendingIndex_t mPendingTitles;
+	pendingIndex_t mPendingImages;
+	queueStats_t mStats;
+};
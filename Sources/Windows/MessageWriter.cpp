@@ -0,0 +1,336 @@
+//==============================================================================
+/**
+@file       MessageWriter.cpp
+@brief      Writes the messages sent to the Stream Deck without building a json DOM
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "MessageWriter.h"
+#include "../Common/ESDSDKDefines.h"
+#include <array>
+#include <charconv>
+
+namespace
+{
+	const std::string_view DATA_URI_PREFIX = "data:image/png;base64,";
+
+	/**
+		@brief builds a table of which bytes need escaping in a json string
+	**/
+	constexpr std::array<bool, 256> makeEscapeTable()
+	{
+		std::array<bool, 256> table{};
+		for (size_t i = 0; i < 0x20; i++)
+			table[i] = true;
+		table['"'] = true;
+		table['\\'] = true;
+		return table;
+	}
+	constexpr std::array<bool, 256> NEEDS_ESCAPE = makeEscapeTable();
+}
+
+/**
+	@brief appends a json string, copying runs that need no escaping in one go
+
+	@param[in] value the string contents
+**/
+void MessageWriter::appendEscaped(std::string_view value)
+{
+	mBuffer.push_back('"');
+	size_t runStart = 0;
+	for (size_t i = 0; i < value.size(); i++)
+	{
+		const unsigned char c = static_cast<unsigned char>(value[i]);
+		if (!NEEDS_ESCAPE[c]) continue;
+
+		mBuffer.append(value.data() + runStart, i - runStart);
+		runStart = i + 1;
+		switch (c)
+		{
+		case '"': mBuffer.append("\\\""); break;
+		case '\\': mBuffer.append("\\\\"); break;
+		case '\b': mBuffer.append("\\b"); break;
+		case '\f': mBuffer.append("\\f"); break;
+		case '\n': mBuffer.append("\\n"); break;
+		case '\r': mBuffer.append("\\r"); break;
+		case '\t': mBuffer.append("\\t"); break;
+		default:
+		{
+			constexpr char HEX[] = "0123456789abcdef";
+			const char escaped[] = { '\\', 'u', '0', '0', HEX[c >> 4], HEX[c & 0xf] };
+			mBuffer.append(escaped, sizeof(escaped));
+		}
+		}
+	}
+	mBuffer.append(value.data() + runStart, value.size() - runStart);
+	mBuffer.push_back('"');
+}
+
+/**
+	@brief appends "key":, keys are fixed names that never need escaping
+
+	@param[in] key the key
+**/
+void MessageWriter::appendKey(std::string_view key)
+{
+	mBuffer.push_back('"');
+	mBuffer.append(key);
+	mBuffer.append("\":");
+}
+
+/**
+	@brief appends "key":"value" with the value escaped
+
+	@param[in] key the key
+	@param[in] value the value
+**/
+void MessageWriter::appendString(std::string_view key, std::string_view value)
+{
+	appendKey(key);
+	appendEscaped(value);
+}
+
+/**
+	@brief appends "key":value for a number
+
+	@param[in] key the key
+	@param[in] value the value
+**/
+void MessageWriter::appendNumber(std::string_view key, const int value)
+{
+	appendKey(key);
+	char digits[16];
+	const std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+	mBuffer.append(digits, result.ptr);
+}
+
+/**
+	@brief writes the message registering the plugin when the connection opens
+
+	@param[in] event the registration event given on the command line
+	@param[in] uuid the plugin uuid
+
+	@return the message
+**/
+std::string_view MessageWriter::registerPlugin(std::string_view event, std::string_view uuid)
+{
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonEvent, event);
+	mBuffer.push_back(',');
+	appendString("uuid", uuid);
+	mBuffer.push_back('}');
+	return mBuffer;
+}
+
+/**
+	@brief writes a setTitle message
+
+	@param[in] context the context to set the title of
+	@param[in] title the title
+	@param[in] target hardware, software or both
+
+	@return the message
+**/
+std::string_view MessageWriter::setTitle(std::string_view context, std::string_view title, const int target)
+{
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonContext, context);
+	mBuffer.push_back(',');
+	appendString(kESDSDKCommonEvent, kESDSDKEventSetTitle);
+	mBuffer.push_back(',');
+	appendKey(kESDSDKCommonPayload);
+	mBuffer.push_back('{');
+	appendNumber(kESDSDKPayloadTarget, target);
+	mBuffer.push_back(',');
+	appendString(kESDSDKPayloadTitle, title);
+	mBuffer.append("}}");
+	return mBuffer;
+}
+
+/**
+	@brief writes a setImage message. The image is copied in as is, base64 data URIs have nothing to escape.
+
+	@param[in] context the context to set the image of
+	@param[in] image a png data URI or bare base64 png, or empty to go back to the default image
+	@param[in] target hardware, software or both
+
+	@return the message
+**/
+std::string_view MessageWriter::setImage(std::string_view context, std::string_view image, const int target)
+{
+	const bool needsPrefix = !image.empty() && !image.starts_with(DATA_URI_PREFIX);
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonContext, context);
+	mBuffer.push_back(',');
+	appendString(kESDSDKCommonEvent, kESDSDKEventSetImage);
+	mBuffer.push_back(',');
+	appendKey(kESDSDKCommonPayload);
+	mBuffer.push_back('{');
+	appendKey(kESDSDKPayloadImage);
+
+	// grow once to fit the image and the rest of the message
+	mBuffer.reserve(mBuffer.size() + DATA_URI_PREFIX.size() + image.size() + 32);
+	mBuffer.push_back('"');
+	if (needsPrefix)
+		mBuffer.append(DATA_URI_PREFIX);
+	mBuffer.append(image);
+	mBuffer.append("\",");
+	appendNumber(kESDSDKPayloadTarget, target);
+	mBuffer.append("}}");
+	return mBuffer;
+}
+
+/**
+	@brief writes a message that only has an event and a context, ie: showAlert, showOk and getGlobalSettings
+
+	@param[in] event the event
+	@param[in] context the context, or the plugin uuid for plugin wide events
+
+	@return the message
+**/
+std::string_view MessageWriter::contextEvent(std::string_view event, std::string_view context)
+{
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonContext, context);
+	mBuffer.push_back(',');
+	appendString(kESDSDKCommonEvent, event);
+	mBuffer.push_back('}');
+	return mBuffer;
+}
+
+/**
+	@brief writes a message with an event, a context and an already serialized payload, ie: setSettings
+
+	@param[in] event the event
+	@param[in] context the context, or the plugin uuid for plugin wide events
+	@param[in] payloadJson the serialized payload
+
+	@return the message
+**/
+std::string_view MessageWriter::contextPayloadEvent(std::string_view event, std::string_view context, std::string_view payloadJson)
+{
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonContext, context);
+	mBuffer.push_back(',');
+	appendString(kESDSDKCommonEvent, event);
+	mBuffer.push_back(',');
+	appendKey(kESDSDKCommonPayload);
+	mBuffer.append(payloadJson);
+	mBuffer.push_back('}');
+	return mBuffer;
+}
+
+/**
+	@brief writes a setState message
+
+	@param[in] context the context to set the state of
+	@param[in] state the state
+
+	@return the message
+**/
+std::string_view MessageWriter::setState(std::string_view context, const int state)
+{
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonContext, context);
+	mBuffer.push_back(',');
+	appendString(kESDSDKCommonEvent, kESDSDKEventSetState);
+	mBuffer.push_back(',');
+	appendKey(kESDSDKCommonPayload);
+	mBuffer.push_back('{');
+	appendNumber(kESDSDKPayloadState, state);
+	mBuffer.append("}}");
+	return mBuffer;
+}
+
+/**
+	@brief writes a sendToPropertyInspector message
+
+	@param[in] action the action of the property inspector
+	@param[in] context the context of the property inspector
+	@param[in] payloadJson the serialized payload
+
+	@return the message
+**/
+std::string_view MessageWriter::sendToPropertyInspector(std::string_view action, std::string_view context, std::string_view payloadJson)
+{
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonAction, action);
+	mBuffer.push_back(',');
+	appendString(kESDSDKCommonContext, context);
+	mBuffer.push_back(',');
+	appendString(kESDSDKCommonEvent, kESDSDKEventSendToPropertyInspector);
+	mBuffer.push_back(',');
+	appendKey(kESDSDKCommonPayload);
+	mBuffer.append(payloadJson);
+	mBuffer.push_back('}');
+	return mBuffer;
+}
+
+/**
+	@brief writes a switchToProfile message
+
+	@param[in] context the plugin uuid
+	@param[in] device the device to switch
+	@param[in] profile the profile to switch to, or empty to leave the payload out
+
+	@return the message
+**/
+std::string_view MessageWriter::switchToProfile(std::string_view context, std::string_view device, std::string_view profile)
+{
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonContext, context);
+	mBuffer.push_back(',');
+	appendString(kESDSDKCommonDevice, device);
+	mBuffer.push_back(',');
+	appendString(kESDSDKCommonEvent, kESDSDKEventSwitchToProfile);
+	if (!profile.empty())
+	{
+		mBuffer.push_back(',');
+		appendKey(kESDSDKCommonPayload);
+		mBuffer.push_back('{');
+		appendString(kESDSDKPayloadProfile, profile);
+		mBuffer.push_back('}');
+	}
+	mBuffer.push_back('}');
+	return mBuffer;
+}
+
+/**
+	@brief writes a logMessage message
+
+	@param[in] message the text to log
+
+	@return the message
+**/
+std::string_view MessageWriter::logMessage(std::string_view message)
+{
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonEvent, kESDSDKEventLogMessage);
+	mBuffer.push_back(',');
+	appendKey(kESDSDKCommonPayload);
+	mBuffer.push_back('{');
+	appendString(kESDSDKPayloadMessage, message);
+	mBuffer.append("}}");
+	return mBuffer;
+}
+
+/**
+	@brief writes an openUrl message
+
+	@param[in] url the url to open
+
+	@return the message
+**/
+std::string_view MessageWriter::openUrl(std::string_view url)
+{
+	mBuffer.assign("{");
+	appendString(kESDSDKCommonEvent, kESDSDKEventOpenURL);
+	mBuffer.push_back(',');
+	appendKey(kESDSDKCommonPayload);
+	mBuffer.push_back('{');
+	appendString(kESDSDKPayloadURL, url);
+	mBuffer.append("}}");
+	return mBuffer;
+}
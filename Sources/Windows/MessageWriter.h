@@ -0,0 +1,44 @@
+//==============================================================================
+/**
+@file       MessageWriter.h
+@brief      Writes the messages sent to the Stream Deck without building a json DOM
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+	@brief Serializes the fixed outbound Stream Deck messages straight into a reusable buffer.
+	       Only the variable fields are escaped, and images are copied in once with no escaping since data URIs never need it.
+	       Output is byte for byte what nlohmann::json::dump() makes of the same message, keys in the same sorted order.
+	       Each returned view is valid until the next message is written. Not thread safe, use one writer per thread.
+**/
+class MessageWriter
+{
+public:
+	MessageWriter() {};
+	~MessageWriter() {};
+
+	std::string_view registerPlugin(std::string_view event, std::string_view uuid);
+	std::string_view setTitle(std::string_view context, std::string_view title, const int target);
+	std::string_view setImage(std::string_view context, std::string_view image, const int target);
+	std::string_view contextEvent(std::string_view event, std::string_view context);
+	std::string_view contextPayloadEvent(std::string_view event, std::string_view context, std::string_view payloadJson);
+	std::string_view setState(std::string_view context, const int state);
+	std::string_view sendToPropertyInspector(std::string_view action, std::string_view context, std::string_view payloadJson);
+	std::string_view switchToProfile(std::string_view context, std::string_view device, std::string_view profile);
+	std::string_view logMessage(std::string_view message);
+	std::string_view openUrl(std::string_view url);
+
+private:
+	std::string mBuffer;
+
+	void appendEscaped(std::string_view value);
+	void appendKey(std::string_view key);
+	void appendString(std::string_view key, std::string_view value);
+	void appendNumber(std::string_view key, const int value);
+};
@@ -0,0 +1,109 @@
+//==============================================================================
+/**
+@file       Benchmark.h
+@brief      Minimal self-registering benchmark harness
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+	/**
+		@brief keeps the compiler from optimizing away a value computed in a benchmark loop
+	**/
+	template <typename T>
+	inline void doNotOptimize(const T& value)
+	{
+		const volatile void* sink = &value;
+		(void)sink;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+
+	/**
+		@brief state handed to a benchmark case, drives the timed loop and collects counters
+	**/
+	class BenchmarkState
+	{
+	public:
+		BenchmarkState(std::chrono::nanoseconds minTime) : mMinTime(minTime) {};
+
+		/**
+			@brief call in a while loop around the code to measure
+
+			@return true while more iterations should be run
+		**/
+		bool keepRunning()
+		{
+			if (mIterations == 0)
+				mStart = std::chrono::steady_clock::now();
+
+			// checking the clock every iteration would dominate very fast cases, so check progressively less often
+			if (mIterations == mNextCheck)
+			{
+				mElapsed = std::chrono::steady_clock::now() - mStart;
+				if (mElapsed >= mMinTime)
+					return false;
+				mNextCheck += std::max<uint64_t>(1, mIterations / 8);
+			}
+			mIterations++;
+			return true;
+		}
+
+		void setItemsProcessed(uint64_t items) { mItemsProcessed = items; };
+		void setBytesProcessed(uint64_t bytes) { mBytesProcessed = bytes; };
+		void setCounter(const std::string& name, double value) { mCounters[name] = value; };
+
+		uint64_t getIterations() const { return mIterations; };
+		uint64_t getItemsProcessed() const { return mItemsProcessed ? mItemsProcessed : mIterations; };
+		uint64_t getBytesProcessed() const { return mBytesProcessed; };
+		double getSeconds() const { return std::chrono::duration<double>(mElapsed).count(); };
+		const std::map<std::string, double>& getCounters() const { return mCounters; };
+
+	private:
+		const std::chrono::nanoseconds mMinTime;
+		std::chrono::steady_clock::time_point mStart;
+		std::chrono::steady_clock::duration mElapsed{};
+		uint64_t mIterations = 0;
+		uint64_t mNextCheck = 1;
+		uint64_t mItemsProcessed = 0;
+		uint64_t mBytesProcessed = 0;
+		std::map<std::string, double> mCounters;
+	};
+
+	using benchmarkFunction_t = std::function<void(BenchmarkState&)>;
+
+	struct benchmarkCase_t
+	{
+		std::string name;
+		benchmarkFunction_t func;
+	};
+
+	inline std::vector<benchmarkCase_t>& getRegistry()
+	{
+		static std::vector<benchmarkCase_t> registry;
+		return registry;
+	}
+
+	struct BenchmarkRegistrar
+	{
+		BenchmarkRegistrar(const std::string& name, benchmarkFunction_t func)
+		{
+			getRegistry().push_back({ name, std::move(func) });
+		}
+	};
+}
+
+#define BENCHMARK_CASE(name) \
+	static void name(benchmarks::BenchmarkState& state); \
+	static benchmarks::BenchmarkRegistrar name##Registrar(#name, name); \
+	static void name(benchmarks::BenchmarkState& state)
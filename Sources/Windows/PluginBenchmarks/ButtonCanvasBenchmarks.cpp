@@ -0,0 +1,75 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../ButtonCanvas.h"
+#include "../IconCompositor.h"
+
+namespace ButtonCanvasBenchmarks
+{
+	const std::string iconDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/Icons/";
+
+	const IconCompositor::icon_t& getIcon()
+	{
+		static const IconCompositor::icon_t icon = []()
+		{
+			IconCompositor compositor(iconDirectory);
+			return compositor.composePixels("Hafgufa").value_or(IconCompositor::icon_t{});
+		}();
+		return icon;
+	}
+
+	// a countdown ticking forward, every encode follows a redraw of a few ring pixels like the live buttons
+	void encodeCountdown(benchmarks::BenchmarkState& state, const uint32_t size, const ButtonCanvas::ENCODE_MODE mode)
+	{
+		const IconCompositor::icon_t& icon = getIcon();
+		ButtonCanvas canvas(size);
+		canvas.setBackground(icon.rgba.data(), icon.width, icon.height);
+
+		constexpr uint32_t STEPS = 360;
+		uint32_t step = 0;
+		uint64_t pngBytes = 0;
+		while (state.keepRunning())
+		{
+			step = (step + 1) % STEPS;
+			canvas.setProgress(static_cast<float>(step) / STEPS);
+			canvas.setHighlight(step >= STEPS / 2);
+			const std::vector<uint8_t>& png = canvas.encodePng(mode);
+			pngBytes += png.size();
+			benchmarks::doNotOptimize(png);
+		}
+		state.setItemsProcessed(state.getIterations());
+		state.setBytesProcessed(state.getIterations() * size * size * 4);
+		state.setCounter("png bytes", static_cast<double>(pngBytes) / (std::max<uint64_t>)(1, state.getIterations()));
+	}
+
+	BENCHMARK_CASE(EncodeButton72Default)
+	{
+		encodeCountdown(state, 72, ButtonCanvas::ENCODE_MODE::DEFAULT);
+	}
+
+	BENCHMARK_CASE(EncodeButton72Fast)
+	{
+		encodeCountdown(state, 72, ButtonCanvas::ENCODE_MODE::FAST);
+	}
+
+	BENCHMARK_CASE(EncodeButton72Stored)
+	{
+		encodeCountdown(state, 72, ButtonCanvas::ENCODE_MODE::STORED);
+	}
+
+	BENCHMARK_CASE(EncodeButton144Default)
+	{
+		encodeCountdown(state, 144, ButtonCanvas::ENCODE_MODE::DEFAULT);
+	}
+
+	BENCHMARK_CASE(EncodeButton144Fast)
+	{
+		encodeCountdown(state, 144, ButtonCanvas::ENCODE_MODE::FAST);
+	}
+
+	BENCHMARK_CASE(EncodeButton144Stored)
+	{
+		encodeCountdown(state, 144, ButtonCanvas::ENCODE_MODE::STORED);
+	}
+}
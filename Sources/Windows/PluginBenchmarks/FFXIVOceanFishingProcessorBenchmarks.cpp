@@ -0,0 +1,187 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <filesystem>
+#include "../FFXIVOceanFishingProcessor.h"
+#include "../FFXIVOceanFishingHelper.h"
+
+namespace FFXIVOceanFishingProcessorBenchmarks
+{
+	const std::string pluginDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/";
+	const std::vector<std::string> dataFiles = {
+		pluginDirectory + "oceanFishingDatabase - Indigo Route.json",
+		pluginDirectory + "oceanFishingDatabase - Ruby Route.json"
+	};
+	const time_t startTime = 1700000000;
+
+	// queries step through time by a prime number of seconds, so they land at every point of the 2 hour voyage blocks
+	const time_t queryStep = 7 * 60 + 13;
+
+	// a target a button can track, with the voyages it resolves to
+	struct query_t
+	{
+		std::string routeName;
+		std::string tracker;
+		std::string name;
+		std::unordered_set<uint32_t> voyageIds;
+	};
+
+	struct schedule_t
+	{
+		std::unordered_map<std::string, std::unique_ptr<FFXIVOceanFishingProcessor>> processors;
+		std::unique_ptr<FFXIVOceanFishingHelper> helper;
+		std::vector<query_t> queries;
+	};
+
+	// every target of every shipped route, loaded once
+	const schedule_t& getSchedule()
+	{
+		static const schedule_t schedule = []()
+		{
+			schedule_t schedule;
+			schedule.helper = std::make_unique<FFXIVOceanFishingHelper>(dataFiles);
+			for (const std::string& dataFile : dataFiles)
+			{
+				auto processor = std::make_unique<FFXIVOceanFishingProcessor>(dataFile);
+				const std::string routeName = processor->getRouteName();
+				const json targets = processor->getTargetsJson();
+				for (const auto& [name, tracker] : targets.items())
+					schedule.queries.push_back({ routeName, tracker.get<std::string>(), name, processor->getVoyageIdByTracker(tracker.get<std::string>(), name) });
+				schedule.processors.emplace(routeName, std::move(processor));
+			}
+			return schedule;
+		}();
+		return schedule;
+	}
+
+	void constructProcessor(benchmarks::BenchmarkState& state, const std::string& dataFile)
+	{
+		while (state.keepRunning())
+		{
+			FFXIVOceanFishingProcessor processor(dataFile);
+			benchmarks::doNotOptimize(processor.isInit());
+		}
+		state.setBytesProcessed(state.getIterations() * std::filesystem::file_size(dataFile));
+	}
+
+	BENCHMARK_CASE(ConstructProcessorIndigoRoute)
+	{
+		constructProcessor(state, dataFiles[0]);
+	}
+
+	BENCHMARK_CASE(ConstructProcessorRubyRoute)
+	{
+		constructProcessor(state, dataFiles[1]);
+	}
+
+	// the query each context makes when it goes stale, for every target in turn
+	void secondsUntilNextVoyage(benchmarks::BenchmarkState& state, const uint32_t skips)
+	{
+		const schedule_t& schedule = getSchedule();
+		size_t queryIndex = 0;
+		time_t t = startTime;
+		while (state.keepRunning())
+		{
+			const query_t& query = schedule.queries[queryIndex];
+			uint32_t secondsTillNextVoyage = 0;
+			uint32_t secondsLeftInWindow = 0;
+			uint32_t nextVoyageId = 0;
+			benchmarks::doNotOptimize(schedule.processors.at(query.routeName)->getSecondsUntilNextVoyage(
+				secondsTillNextVoyage, secondsLeftInWindow, nextVoyageId, t, query.voyageIds, skips));
+			benchmarks::doNotOptimize(secondsTillNextVoyage);
+
+			if (++queryIndex == schedule.queries.size())
+			{
+				queryIndex = 0;
+				t += queryStep;
+			}
+		}
+		state.setCounter("targets", static_cast<double>(schedule.queries.size()));
+	}
+
+	BENCHMARK_CASE(SecondsUntilNextVoyageSkips0)
+	{
+		secondsUntilNextVoyage(state, 0);
+	}
+
+	BENCHMARK_CASE(SecondsUntilNextVoyageSkips1)
+	{
+		secondsUntilNextVoyage(state, 1);
+	}
+
+	BENCHMARK_CASE(SecondsUntilNextVoyageSkips5)
+	{
+		secondsUntilNextVoyage(state, 5);
+	}
+
+	BENCHMARK_CASE(GetImageNameAndLabel)
+	{
+		const schedule_t& schedule = getSchedule();
+		size_t queryIndex = 0;
+		time_t t = startTime;
+		std::string imageName;
+		std::string buttonLabel;
+		while (state.keepRunning())
+		{
+			const query_t& query = schedule.queries[queryIndex];
+			const PRIORITY priority = (queryIndex & 1) ? PRIORITY::ACHIEVEMENTS : PRIORITY::BLUE_FISH;
+			schedule.processors.at(query.routeName)->getImageNameAndLabel(imageName, buttonLabel, query.tracker, query.name, t, priority, 0);
+			benchmarks::doNotOptimize(imageName);
+
+			if (++queryIndex == schedule.queries.size())
+			{
+				queryIndex = 0;
+				t += queryStep;
+			}
+		}
+	}
+
+	BENCHMARK_CASE(GetNextVoyageName)
+	{
+		const schedule_t& schedule = getSchedule();
+		FFXIVOceanFishingProcessor& processor = *schedule.processors.begin()->second;
+		time_t t = startTime;
+		while (state.keepRunning())
+		{
+			benchmarks::doNotOptimize(processor.getNextVoyageName(t, 0));
+			t += queryStep;
+		}
+	}
+
+	// the same lookups as the plugin makes them, through the helper: route lookup and tracker resolution on every call.
+	// Compare with SecondsUntilNextVoyageSkips0 for the overhead the helper adds
+	BENCHMARK_CASE(HelperSecondsUntilNextVoyage)
+	{
+		const schedule_t& schedule = getSchedule();
+		size_t queryIndex = 0;
+		time_t t = startTime;
+		while (state.keepRunning())
+		{
+			const query_t& query = schedule.queries[queryIndex];
+			uint32_t secondsTillNextVoyage = 0;
+			uint32_t secondsLeftInWindow = 0;
+			benchmarks::doNotOptimize(schedule.helper->getSecondsUntilNextVoyage(
+				secondsTillNextVoyage, secondsLeftInWindow, t, query.voyageIds, query.routeName, 0));
+			benchmarks::doNotOptimize(secondsTillNextVoyage);
+
+			if (++queryIndex == schedule.queries.size())
+			{
+				queryIndex = 0;
+				t += queryStep;
+			}
+		}
+	}
+
+	BENCHMARK_CASE(HelperGetVoyageIdByTracker)
+	{
+		const schedule_t& schedule = getSchedule();
+		size_t queryIndex = 0;
+		while (state.keepRunning())
+		{
+			const query_t& query = schedule.queries[queryIndex];
+			benchmarks::doNotOptimize(schedule.helper->getVoyageIdByTracker(query.routeName, query.tracker, query.name));
+			queryIndex = (queryIndex + 1) % schedule.queries.size();
+		}
+	}
+}
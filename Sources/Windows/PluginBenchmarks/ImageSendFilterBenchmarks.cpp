@@ -0,0 +1,141 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../FFXIVOceanFishingHelper.h"
+#include "../IconPack.h"
+#include "../ImageSendFilter.h"
+
+namespace ImageSendFilterBenchmarks
+{
+	const std::string pluginDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/";
+	const time_t startTime = 1700000000;
+	const time_t simulatedTime = 24 * 60 * 60;
+	const size_t buttonCount = 30;
+	const time_t pageFlipInterval = 30 * 60; // the page with the buttons is switched away from and back to this often
+
+	struct button_t
+	{
+		std::string routeName;
+		std::string tracker;
+		std::string targetName;
+		PRIORITY priority = PRIORITY::BLUE_FISH;
+	};
+
+	/**
+		@brief makes a page of buttons covering every tracker type, spread over both routes
+	**/
+	std::vector<button_t> makeButtons(FFXIVOceanFishingHelper& helper)
+	{
+		std::vector<std::vector<button_t>> perRoute;
+		for (const std::string& routeName : helper.getRouteNames())
+		{
+			const json targets = helper.getTargetsJson(routeName);
+			std::vector<button_t> routeButtons;
+			for (const auto& [targetName, tracker] : targets.items())
+				routeButtons.push_back({ routeName, tracker.get<std::string>(), targetName,
+					routeButtons.size() % 2 ? PRIORITY::ACHIEVEMENTS : PRIORITY::BLUE_FISH });
+			perRoute.push_back(std::move(routeButtons));
+		}
+
+		// take from each route in turn, striding so every tracker type gets a few buttons
+		std::vector<button_t> buttons;
+		for (size_t i = 0; buttons.size() < buttonCount; i++)
+		{
+			const std::vector<button_t>& routeButtons = perRoute[i % perRoute.size()];
+			const size_t stride = (std::max<size_t>)(1, routeButtons.size() / buttonCount);
+			buttons.push_back(routeButtons[(i / perRoute.size() * stride) % routeButtons.size()]);
+		}
+		return buttons;
+	}
+
+	// replays a day of state changes and page flips for a page of buttons the way the plugin does, counting image bytes
+	// sent by the old rule (resend on reappearing and on any image or label change) and with the per-context send filter
+	BENCHMARK_CASE(ImageSendFilterSimulatedDay)
+	{
+		FFXIVOceanFishingHelper helper({
+			pluginDirectory + "oceanFishingDatabase - Indigo Route.json",
+			pluginDirectory + "oceanFishingDatabase - Ruby Route.json"
+		});
+		const IconPack iconPack(pluginDirectory + "Icons.pack");
+		const std::vector<button_t> buttons = makeButtons(helper);
+
+		const std::string_view defaultImage = iconPack.find("default").value_or("");
+		uint64_t bytesBefore = 0;
+		uint64_t bytesAfter = 0;
+		uint64_t sendsBefore = 0;
+		uint64_t sendsAfter = 0;
+
+		while (state.keepRunning())
+		{
+			bytesBefore = bytesAfter = sendsBefore = sendsAfter = 0;
+			for (const button_t& button : buttons)
+			{
+				ImageSendFilter filter;
+				const std::unordered_set<uint32_t> voyageIds = helper.getVoyageIdByTracker(button.routeName, button.tracker, button.targetName);
+				std::string lastImageName;
+				std::string lastButtonLabel;
+				time_t nextStateChange = startTime;
+				time_t nextPageFlip = startTime;
+
+				while (true)
+				{
+					const time_t now = (std::min)(nextStateChange, nextPageFlip);
+					if (now >= startTime + simulatedTime)
+						break;
+
+					// reappearing sets needUpdate, which always resent the image
+					const bool isAppearing = now == nextPageFlip;
+					if (isAppearing)
+						nextPageFlip += pageFlipInterval;
+
+					std::string imageName;
+					std::string buttonLabel;
+					helper.getImageNameAndLabel(imageName, buttonLabel, button.routeName, button.tracker, button.targetName, now, button.priority, 0);
+
+					if (isAppearing || imageName != lastImageName || buttonLabel != lastButtonLabel)
+					{
+						const std::string_view image = iconPack.find(imageName.empty() ? "default" : imageName).value_or(defaultImage);
+						bytesBefore += image.size();
+						sendsBefore++;
+						if (filter.shouldSend(image))
+						{
+							bytesAfter += image.size();
+							sendsAfter++;
+						}
+					}
+					lastImageName = imageName;
+					lastButtonLabel = buttonLabel;
+
+					if (now == nextStateChange)
+					{
+						uint32_t secondsTillStateChange = 0;
+						if (helper.getSecondsUntilNextStateChange(secondsTillStateChange, now, voyageIds, button.routeName))
+							nextStateChange = now + (std::max<uint32_t>)(1, secondsTillStateChange);
+						else
+							nextStateChange = startTime + simulatedTime;
+					}
+				}
+			}
+			benchmarks::doNotOptimize(bytesAfter);
+		}
+
+		state.setItemsProcessed(state.getIterations() * buttons.size());
+		state.setCounter("sendsBefore", static_cast<double>(sendsBefore));
+		state.setCounter("sendsAfter", static_cast<double>(sendsAfter));
+		state.setCounter("bytesBefore", static_cast<double>(bytesBefore));
+		state.setCounter("bytesAfter", static_cast<double>(bytesAfter));
+		state.setCounter("bytesSaved", static_cast<double>(bytesBefore - bytesAfter));
+	}
+
+	// cost of the check itself on an icon sized image
+	BENCHMARK_CASE(ImageSendFilterShouldSend)
+	{
+		const IconPack iconPack(pluginDirectory + "Icons.pack");
+		const std::string_view image = iconPack.find("Hafgufa").value_or("");
+		ImageSendFilter filter;
+		while (state.keepRunning())
+			benchmarks::doNotOptimize(filter.shouldSend(image));
+		state.setBytesProcessed(state.getIterations() * image.size());
+	}
+}
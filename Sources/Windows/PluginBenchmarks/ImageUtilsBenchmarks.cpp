@@ -0,0 +1,187 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include "../ImageUtils.h"
+#include "../../Vendor/lodepng/lodepng.h"
+
+namespace ImageUtilsBenchmarks
+{
+	const std::string iconDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/Icons/";
+
+	// every icon the plugin ships, loaded once and shared by all cases
+	const std::vector<std::vector<uint8_t>>& getIcons()
+	{
+		static const std::vector<std::vector<uint8_t>> icons = []()
+		{
+			std::vector<std::vector<uint8_t>> icons;
+			for (const auto& entry : std::filesystem::directory_iterator(iconDirectory))
+			{
+				if (entry.path().extension() != ".png") continue;
+				std::ifstream ifs(entry.path(), std::ios::binary);
+				icons.emplace_back((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+			}
+			return icons;
+		}();
+		return icons;
+	}
+
+	uint64_t getIconBytes()
+	{
+		uint64_t bytes = 0;
+		for (const std::vector<uint8_t>& icon : getIcons())
+			bytes += icon.size();
+		return bytes;
+	}
+
+	// the original lodepng example encoder, kept as the baseline
+	void legacyPngToBase64(std::string& out, const std::vector<uint8_t>& in)
+	{
+		for (size_t i = 0; i < in.size(); i += 3) {
+			int v = 65536 * in[i];
+			if (i + 1 < in.size()) v += 256 * in[i + 1];
+			if (i + 2 < in.size()) v += in[i + 2];
+			out.push_back(imageutils::BASE64[(v >> 18) & 0x3f]);
+			out.push_back(imageutils::BASE64[(v >> 12) & 0x3f]);
+			if (i + 1 < in.size()) out.push_back(imageutils::BASE64[(v >> 6) & 0x3f]);
+			else out.push_back('=');
+			if (i + 2 < in.size()) out.push_back(imageutils::BASE64[(v >> 0) & 0x3f]);
+			else out.push_back('=');
+		}
+	}
+
+	void encodeAllIcons(benchmarks::BenchmarkState& state, const imageutils::BASE64_KERNEL kernel)
+	{
+		if (!imageutils::isBase64KernelSupported(kernel))
+		{
+			state.setCounter("unsupported", 1);
+			while (state.keepRunning()) {}
+			return;
+		}
+
+		const std::vector<std::vector<uint8_t>>& icons = getIcons();
+		std::string out;
+		while (state.keepRunning())
+		{
+			for (const std::vector<uint8_t>& icon : icons)
+			{
+				out.resize(imageutils::getBase64EncodedSize(icon.size()));
+				imageutils::encodeBase64(out.data(), icon.data(), icon.size(), kernel);
+				benchmarks::doNotOptimize(out);
+			}
+		}
+		state.setItemsProcessed(state.getIterations() * icons.size());
+		state.setBytesProcessed(state.getIterations() * getIconBytes());
+	}
+
+	// a fresh string per icon, the way the image cache used to build each entry
+	BENCHMARK_CASE(Base64IconsLegacy)
+	{
+		const std::vector<std::vector<uint8_t>>& icons = getIcons();
+		while (state.keepRunning())
+		{
+			for (const std::vector<uint8_t>& icon : icons)
+			{
+				std::string out;
+				legacyPngToBase64(out, icon);
+				benchmarks::doNotOptimize(out);
+			}
+		}
+		state.setItemsProcessed(state.getIterations() * icons.size());
+		state.setBytesProcessed(state.getIterations() * getIconBytes());
+	}
+
+	BENCHMARK_CASE(Base64IconsPngToBase64)
+	{
+		const std::vector<std::vector<uint8_t>>& icons = getIcons();
+		while (state.keepRunning())
+		{
+			for (const std::vector<uint8_t>& icon : icons)
+			{
+				std::string out;
+				imageutils::pngToBase64(out, icon);
+				benchmarks::doNotOptimize(out);
+			}
+		}
+		state.setItemsProcessed(state.getIterations() * icons.size());
+		state.setBytesProcessed(state.getIterations() * getIconBytes());
+	}
+
+	BENCHMARK_CASE(Base64IconsScalar)
+	{
+		encodeAllIcons(state, imageutils::BASE64_KERNEL::SCALAR);
+	}
+
+	BENCHMARK_CASE(Base64IconsSSSE3)
+	{
+		encodeAllIcons(state, imageutils::BASE64_KERNEL::SSSE3);
+	}
+
+	BENCHMARK_CASE(Base64IconsAVX2)
+	{
+		encodeAllIcons(state, imageutils::BASE64_KERNEL::AVX2);
+	}
+
+	// shrinks and recompresses every icon for a key size the way the image loader does, and
+	// reports the average setImage payload of the icons as shipped against the fitted ones
+	void fitAllIcons(benchmarks::BenchmarkState& state, const uint32_t size)
+	{
+		const std::vector<std::vector<uint8_t>>& icons = getIcons();
+		const std::string prefix = "data:image/png;base64,";
+		uint64_t fittedBytes = 0;
+		while (state.keepRunning())
+		{
+			fittedBytes = 0;
+			for (const std::vector<uint8_t>& icon : icons)
+			{
+				std::vector<uint8_t> rgba;
+				unsigned width = 0;
+				unsigned height = 0;
+				lodepng::decode(rgba, width, height, icon);
+
+				std::vector<uint8_t> png = icon;
+				bool isResized = false;
+				if (width > size || height > size)
+				{
+					std::vector<uint8_t> resized;
+					imageutils::resizeRgba(resized, rgba, width, height, size, size);
+					rgba.swap(resized);
+					width = height = size;
+					isResized = true;
+				}
+
+				std::vector<uint8_t> recompressed;
+				imageutils::encodePngSmallest(recompressed, rgba, width, height);
+				if (isResized || recompressed.size() < png.size())
+					png.swap(recompressed);
+				fittedBytes += prefix.size() + imageutils::getBase64EncodedSize(png.size());
+				benchmarks::doNotOptimize(png);
+			}
+		}
+
+		uint64_t originalBytes = 0;
+		for (const std::vector<uint8_t>& icon : icons)
+			originalBytes += prefix.size() + imageutils::getBase64EncodedSize(icon.size());
+		state.setItemsProcessed(state.getIterations() * icons.size());
+		state.setCounter("setImage bytes before", static_cast<double>(originalBytes) / icons.size());
+		state.setCounter("setImage bytes after", static_cast<double>(fittedBytes) / icons.size());
+	}
+
+	BENCHMARK_CASE(FitIconsTo72)
+	{
+		fitAllIcons(state, 72);
+	}
+
+	BENCHMARK_CASE(FitIconsTo96)
+	{
+		fitAllIcons(state, 96);
+	}
+
+	BENCHMARK_CASE(FitIconsTo144)
+	{
+		fitAllIcons(state, 144);
+	}
+}
@@ -0,0 +1,105 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../InboundMessage.h"
+#include "../../Common/EPLJSONUtils.h"
+#include "../../Common/ESDSDKDefines.h"
+
+namespace InboundMessageBenchmarks
+{
+	// what a page of buttons appearing looks like, with the events the plugin ignores mixed in
+	const std::vector<std::string>& getStream()
+	{
+		static const std::vector<std::string> stream = []()
+		{
+			std::vector<std::string> messages;
+			for (int i = 0; i < 32; i++)
+			{
+				const std::string context = "\"context\":\"6A1B7F0E5C0D4C26A5D2C5B6F0A1E3" + std::to_string(10 + i) + "\"";
+				const std::string header = "{\"action\":\"com.elgato.ffxivoceanfishing.action\"," + context + ",\"device\":\"7F3C2A1B9E8D7C6B5A4F3E2D1C0B9A88\",";
+				const std::string settings = "\"settings\":{\"Route\":\"Indigo\",\"Tracker\":\"Fish\",\"Name\":\"Hafgufa\",\"Skips\":0,\"ProgressRing\":true}";
+				messages.push_back(header + "\"event\":\"willAppear\",\"payload\":{\"coordinates\":{\"column\":" + std::to_string(i % 8) +
+					",\"row\":" + std::to_string(i / 8) + "},\"isInMultiAction\":false," + settings + "}}");
+				messages.push_back(header + "\"event\":\"titleParametersDidChange\",\"payload\":{\"coordinates\":{\"column\":1,\"row\":2}," + settings +
+					",\"state\":0,\"title\":\"\",\"titleParameters\":{\"fontFamily\":\"\",\"fontSize\":9,\"fontStyle\":\"\",\"fontUnderline\":false,"
+					"\"showTitle\":true,\"titleAlignment\":\"bottom\",\"titleColor\":\"#ffffff\"}}}");
+				messages.push_back(header + "\"event\":\"keyDown\",\"payload\":{\"coordinates\":{\"column\":1,\"row\":2},\"isInMultiAction\":false," + settings + "}}");
+				messages.push_back(header + "\"event\":\"keyUp\",\"payload\":{\"coordinates\":{\"column\":1,\"row\":2},\"isInMultiAction\":false," + settings + "}}");
+			}
+			return messages;
+		}();
+		return stream;
+	}
+
+	// stands in for the plugin, reads what its handlers read
+	size_t handle(const std::string& context, const json& payload)
+	{
+		const auto settings = payload.find("settings");
+		return context.size() + (settings != payload.end() ? settings->size() : 0);
+	}
+
+	void reportEvents(benchmarks::BenchmarkState& state)
+	{
+		size_t bytes = 0;
+		for (const std::string& message : getStream())
+			bytes += message.size();
+		state.setItemsProcessed(state.getIterations() * getStream().size());
+		state.setBytesProcessed(state.getIterations() * bytes);
+	}
+
+	// the DOM path OnMessage used, a copy of the message, a full parse, a copy of every field and a chain of compares
+	BENCHMARK_CASE(DispatchDom)
+	{
+		size_t handled = 0;
+		while (state.keepRunning())
+		{
+			for (const std::string& inMessage : getStream())
+			{
+				std::string message = inMessage;
+				json receivedJson = json::parse(message);
+
+				std::string event = EPLJSONUtils::GetStringByName(receivedJson, kESDSDKCommonEvent);
+				std::string context = EPLJSONUtils::GetStringByName(receivedJson, kESDSDKCommonContext);
+				std::string action = EPLJSONUtils::GetStringByName(receivedJson, kESDSDKCommonAction);
+				std::string deviceID = EPLJSONUtils::GetStringByName(receivedJson, kESDSDKCommonDevice);
+				json payload;
+				EPLJSONUtils::GetObjectByName(receivedJson, kESDSDKCommonPayload, payload);
+
+				if (event == kESDSDKEventKeyDown || event == kESDSDKEventKeyUp || event == kESDSDKEventWillAppear ||
+					event == kESDSDKEventWillDisappear || event == kESDSDKEventSendToPlugin)
+					handled += handle(context, payload);
+			}
+			benchmarks::doNotOptimize(handled);
+		}
+		reportEvents(state);
+	}
+
+	BENCHMARK_CASE(DispatchInPlace)
+	{
+		InboundMessage inbound;
+		size_t handled = 0;
+		while (state.keepRunning())
+		{
+			for (const std::string& message : getStream())
+			{
+				if (!inbound.parse(message))
+					continue;
+				switch (inbound.getEvent())
+				{
+				case InboundMessage::EVENT::KEY_DOWN:
+				case InboundMessage::EVENT::KEY_UP:
+				case InboundMessage::EVENT::WILL_APPEAR:
+				case InboundMessage::EVENT::WILL_DISAPPEAR:
+				case InboundMessage::EVENT::SEND_TO_PLUGIN:
+					handled += handle(inbound.getContext(), inbound.getPayload());
+					break;
+				default:
+					break;
+				}
+			}
+			benchmarks::doNotOptimize(handled);
+		}
+		reportEvents(state);
+	}
+}
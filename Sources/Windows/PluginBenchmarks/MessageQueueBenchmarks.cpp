@@ -0,0 +1,57 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../MessageQueue.h"
+
+namespace MessageQueueBenchmarks
+{
+	/**
+		@brief pushes every visible button a few title and image updates before the websocket thread flushes
+
+		@param[in] state the benchmark state
+		@param[in] contextCount the number of visible buttons
+	**/
+	void coalesceBurst(benchmarks::BenchmarkState& state, const int contextCount)
+	{
+		constexpr int UPDATES = 3;
+		std::vector<std::string> contexts;
+		for (int i = 0; i < contextCount; i++)
+			contexts.push_back("6A1B7F0E5C0D4C26A5D2C5B6F0A1E3" + std::to_string(10 + i));
+		const std::string title(160, 't');
+		const std::string image(4500, 'i');
+
+		MessageQueue queue;
+		std::vector<MessageQueue::message_t> batch;
+		while (state.keepRunning())
+		{
+			for (int update = 0; update < UPDATES; update++)
+			{
+				for (const std::string& context : contexts)
+				{
+					queue.push(title, MessageQueue::COALESCE::TITLE, context);
+					queue.push(image, MessageQueue::COALESCE::IMAGE, context);
+				}
+			}
+			queue.drain(batch);
+			benchmarks::doNotOptimize(batch);
+		}
+
+		const MessageQueue::queueStats_t stats = queue.getStats();
+		state.setItemsProcessed(stats.pushed);
+		state.setCounter("pushed per flush", static_cast<double>(stats.pushed) / (std::max<uint64_t>)(1, stats.flushes));
+		state.setCounter("sent per flush", static_cast<double>(stats.sent) / (std::max<uint64_t>)(1, stats.flushes));
+	}
+
+	// a burst like a schedule change on a page of buttons
+	BENCHMARK_CASE(CoalesceBurst)
+	{
+		coalesceBurst(state, 32);
+	}
+
+	// the same burst over every button of a very large session, each push must stay constant time
+	BENCHMARK_CASE(CoalesceBurstManyButtons)
+	{
+		coalesceBurst(state, 4096);
+	}
+}
@@ -0,0 +1,109 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../MessageWriter.h"
+#include "../../Common/ESDSDKDefines.h"
+
+namespace MessageWriterBenchmarks
+{
+	const std::string context = "6A1B7F0E5C0D4C26A5D2C5B6F0A1E3D4";
+	const std::string title = "Hafgufa\n\n\nWindow ends:\n00:14:59";
+
+	// a data uri the size of an average fitted icon
+	const std::string& getImage()
+	{
+		static const std::string image = []()
+		{
+			std::string uri = "data:image/png;base64,";
+			const std::string_view base64 = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+			for (size_t i = 0; i < 4412; i++)
+				uri.push_back(base64[(i * 37) % base64.size()]);
+			return uri;
+		}();
+		return image;
+	}
+
+	// the json DOM path ESDConnectionManager used, each field is copied into the payload, the payload is copied into the message
+	// and the message is copied again by dump()
+	std::string domSetTitle(const std::string& inContext, std::string_view inTitle, uint64_t& bytesCopied)
+	{
+		json jsonObject;
+		jsonObject[kESDSDKCommonEvent] = kESDSDKEventSetTitle;
+		jsonObject[kESDSDKCommonContext] = inContext;
+
+		json payload;
+		payload[kESDSDKPayloadTarget] = 0;
+		payload[kESDSDKPayloadTitle] = inTitle;
+		jsonObject[kESDSDKCommonPayload] = payload;
+
+		std::string message = jsonObject.dump();
+		bytesCopied += inContext.size() + inTitle.size() * 2 + message.size();
+		return message;
+	}
+
+	std::string domSetImage(const std::string& inContext, std::string_view inImage, uint64_t& bytesCopied)
+	{
+		json jsonObject;
+		jsonObject[kESDSDKCommonEvent] = kESDSDKEventSetImage;
+		jsonObject[kESDSDKCommonContext] = inContext;
+
+		json payload;
+		payload[kESDSDKPayloadTarget] = 0;
+		payload[kESDSDKPayloadImage] = inImage;
+		jsonObject[kESDSDKCommonPayload] = payload;
+
+		std::string message = jsonObject.dump();
+		bytesCopied += inContext.size() + inImage.size() * 2 + message.size();
+		return message;
+	}
+
+	void reportMessages(benchmarks::BenchmarkState& state, const uint64_t bytesCopied)
+	{
+		state.setItemsProcessed(state.getIterations());
+		state.setBytesProcessed(bytesCopied);
+		state.setCounter("bytes copied", static_cast<double>(bytesCopied) / (std::max<uint64_t>)(1, state.getIterations()));
+	}
+
+	BENCHMARK_CASE(SetTitleDom)
+	{
+		uint64_t bytesCopied = 0;
+		while (state.keepRunning())
+			benchmarks::doNotOptimize(domSetTitle(context, title, bytesCopied));
+		reportMessages(state, bytesCopied);
+	}
+
+	BENCHMARK_CASE(SetTitleWriter)
+	{
+		MessageWriter writer;
+		uint64_t bytesCopied = 0;
+		while (state.keepRunning())
+		{
+			const std::string_view message = writer.setTitle(context, title, 0);
+			bytesCopied += message.size();
+			benchmarks::doNotOptimize(message);
+		}
+		reportMessages(state, bytesCopied);
+	}
+
+	BENCHMARK_CASE(SetImageDom)
+	{
+		uint64_t bytesCopied = 0;
+		while (state.keepRunning())
+			benchmarks::doNotOptimize(domSetImage(context, getImage(), bytesCopied));
+		reportMessages(state, bytesCopied);
+	}
+
+	BENCHMARK_CASE(SetImageWriter)
+	{
+		MessageWriter writer;
+		uint64_t bytesCopied = 0;
+		while (state.keepRunning())
+		{
+			const std::string_view message = writer.setImage(context, getImage(), 0);
+			bytesCopied += message.size();
+			benchmarks::doNotOptimize(message);
+		}
+		reportMessages(state, bytesCopied);
+	}
+}
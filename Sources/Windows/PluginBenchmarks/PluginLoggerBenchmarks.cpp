@@ -0,0 +1,54 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../PluginLogger.h"
+
+namespace PluginLoggerBenchmarks
+{
+	// a debug line in a hot path, with the level set above it
+	BENCHMARK_CASE(LogBelowLevel)
+	{
+		PluginLogger logger([](std::string_view) {});
+		logger.setLevel(LOG_LEVEL::WARNING);
+		const json settings = { { "Route", "Indigo Route" }, { "Priority", "Fish" } };
+		uint64_t lines = 0;
+		while (state.keepRunning())
+		{
+			for (int i = 0; i < 1000; i++)
+				PLUGIN_LOG_INFO(logger, "settings ", settings, " at ", i);
+			lines += 1000;
+		}
+		state.setItemsProcessed(lines);
+	}
+
+	// a call site logging far past its rate limit
+	BENCHMARK_CASE(LogRateLimited)
+	{
+		PluginLogger logger([](std::string_view) {});
+		const json settings = { { "Route", "Indigo Route" }, { "Priority", "Fish" } };
+		uint64_t lines = 0;
+		while (state.keepRunning())
+		{
+			for (int i = 0; i < 1000; i++)
+				PLUGIN_LOG_INFO(logger, "settings ", settings, " at ", i);
+			lines += 1000;
+		}
+		state.setItemsProcessed(lines);
+	}
+
+	// formatting and queueing a line, the writer batching them out behind
+	BENCHMARK_CASE(LogQueued)
+	{
+		PluginLogger logger([](std::string_view) {});
+		uint64_t lines = 0;
+		while (state.keepRunning())
+		{
+			for (int i = 0; i < 100; i++)
+				logger.log(LOG_LEVEL::INFO, 0, "context ", "ABCDEF0123456789", " recomputed at ", i);
+			lines += 100;
+			logger.flush();
+		}
+		state.setItemsProcessed(lines);
+	}
+}
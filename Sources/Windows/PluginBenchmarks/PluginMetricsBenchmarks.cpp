@@ -0,0 +1,114 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../PluginMetrics.h"
+
+namespace PluginMetricsBenchmarks
+{
+	using HISTOGRAM = PluginMetrics::HISTOGRAM;
+
+	// turns metrics on or off for one benchmark, leaving them off and empty after
+	class MetricsEnabled
+	{
+	public:
+		explicit MetricsEnabled(const bool isEnabled) { PluginMetrics::get().reset(); PluginMetrics::get().setEnabled(isEnabled); }
+		~MetricsEnabled() { PluginMetrics::get().setEnabled(false); PluginMetrics::get().reset(); }
+	};
+
+	// what the plugin pays per message sent, a counter and byte count bump
+	void runCountSent(benchmarks::BenchmarkState& state, const bool isEnabled)
+	{
+		MetricsEnabled enabled(isEnabled);
+		uint64_t messages = 0;
+		while (state.keepRunning())
+		{
+			for (int i = 0; i < 1000; i++)
+				PluginMetrics::get().countSent(PluginMetrics::SENT::SET_TITLE, 160);
+			messages += 1000;
+		}
+		state.setItemsProcessed(messages);
+	}
+
+	// what the plugin pays per timed scope, like each UpdateUI or timer callback
+	void runScopedTimer(benchmarks::BenchmarkState& state, const bool isEnabled)
+	{
+		MetricsEnabled enabled(isEnabled);
+		uint64_t scopes = 0;
+		while (state.keepRunning())
+		{
+			for (int i = 0; i < 1000; i++)
+			{
+				ScopedMetricsTimer timer(HISTOGRAM::UPDATE_UI);
+				benchmarks::doNotOptimize(timer);
+			}
+			scopes += 1000;
+		}
+		state.setItemsProcessed(scopes);
+	}
+
+	// an uncontended lock and unlock of mVisibleContextsMutex
+	void runMeteredMutex(benchmarks::BenchmarkState& state, const bool isEnabled)
+	{
+		MetricsEnabled enabled(isEnabled);
+		MeteredMutex mutex(HISTOGRAM::CONTEXTS_MUTEX_WAIT, HISTOGRAM::CONTEXTS_MUTEX_HOLD);
+		uint64_t locks = 0;
+		while (state.keepRunning())
+		{
+			for (int i = 0; i < 1000; i++)
+			{
+				std::unique_lock<MeteredMutex> lock(mutex);
+				benchmarks::doNotOptimize(lock);
+			}
+			locks += 1000;
+		}
+		state.setItemsProcessed(locks);
+	}
+
+	BENCHMARK_CASE(MetricsCountSentDisabled)
+	{
+		runCountSent(state, false);
+	}
+
+	BENCHMARK_CASE(MetricsCountSentEnabled)
+	{
+		runCountSent(state, true);
+	}
+
+	BENCHMARK_CASE(MetricsScopedTimerDisabled)
+	{
+		runScopedTimer(state, false);
+	}
+
+	BENCHMARK_CASE(MetricsScopedTimerEnabled)
+	{
+		runScopedTimer(state, true);
+	}
+
+	BENCHMARK_CASE(MetricsMutexDisabled)
+	{
+		runMeteredMutex(state, false);
+	}
+
+	BENCHMARK_CASE(MetricsMutexEnabled)
+	{
+		runMeteredMutex(state, true);
+	}
+
+	// a snapshot with every histogram filled, as written each reporting interval
+	BENCHMARK_CASE(MetricsSnapshot)
+	{
+		MetricsEnabled enabled(true);
+		for (int i = 0; i < 10000; i++)
+			PluginMetrics::get().record(static_cast<HISTOGRAM>(i % static_cast<int>(HISTOGRAM::COUNT)), std::chrono::microseconds(i));
+
+		uint64_t bytes = 0;
+		while (state.keepRunning())
+		{
+			const std::string line = PluginMetrics::get().snapshot().dump();
+			bytes += line.size();
+			benchmarks::doNotOptimize(line);
+		}
+		state.setBytesProcessed(bytes);
+	}
+}
@@ -0,0 +1,220 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <filesystem>
+#include "../../FFXIVOceanFishingTrackerPlugin.h"
+#include "../../Common/ESDConnectionManager.h"
+#include "../InMemoryTransport.h"
+#include "../StreamDeckSession.h"
+#include "../StreamDeckStandIn.h"
+
+namespace PluginSessionBenchmarks
+{
+	const std::string pluginDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/";
+	const std::chrono::milliseconds TIMEOUT = std::chrono::seconds(120);
+
+	// the plugin loads its database and icons relative to the working directory, like it does when the Stream Deck starts it
+	class PluginDirectory
+	{
+	public:
+		PluginDirectory() : mPrevious(std::filesystem::current_path()) { std::filesystem::current_path(pluginDirectory); }
+		~PluginDirectory() { std::filesystem::current_path(mPrevious); }
+	private:
+		const std::filesystem::path mPrevious;
+	};
+
+	const json& getRouteTargets()
+	{
+		static const json routeTargets = []()
+		{
+			PluginDirectory directory;
+			FFXIVOceanFishingHelper helper({ "oceanFishingDatabase - Indigo Route.json", "oceanFishingDatabase - Ruby Route.json" });
+			json targets;
+			for (const std::string route : helper.getRouteNames())
+				targets[route] = helper.getTargetsJson(route);
+			return targets;
+		}();
+		return routeTargets;
+	}
+
+	void reportSession(benchmarks::BenchmarkState& state, const uint64_t buttons, const uint64_t messages, const uint64_t bytes)
+	{
+		state.setItemsProcessed(buttons);
+		state.setBytesProcessed(bytes);
+		state.setCounter("messages per button", static_cast<double>(messages) / (std::max<uint64_t>)(1, buttons));
+	}
+
+	/**
+		@brief opens a profile of new buttons each iteration, waits for all of them to get a title and image, presses
+		       a few keys and closes the profile. The plugin settles appear bursts for CONTEXT_SETTLE_TIME before computing them.
+	**/
+	void runInMemory(benchmarks::BenchmarkState& state, const size_t buttonCount)
+	{
+		const json& routeTargets = getRouteTargets();
+		PluginDirectory directory;
+		// the plugin's timers send through the transport, so the plugin goes first
+		auto plugin = std::make_unique<FFXIVOceanFishingTrackerPlugin>();
+		InMemoryTransport transport(plugin.get(), false);
+
+		uint64_t buttons = 0;
+		while (state.keepRunning())
+		{
+			const std::vector<streamdecksession::button_t> page = streamdecksession::makeButtons(buttonCount, routeTargets, buttons);
+			for (const std::string& message : streamdecksession::makeAppear(page, "InMemoryTransport"))
+				transport.inject(message);
+			if (!transport.waitForContexts(buttons + buttonCount, buttons + buttonCount, TIMEOUT))
+			{
+				std::printf("timed out waiting for %zu buttons\n", buttonCount);
+				break;
+			}
+
+			for (const std::string& message : streamdecksession::makeKeyPresses(page, 10))
+				transport.inject(message);
+			for (const std::string& message : streamdecksession::makeDisappear(page))
+				transport.inject(message);
+			buttons += buttonCount;
+		}
+
+		plugin.reset();
+		const InMemoryTransport::transportStats_t stats = transport.getStats();
+		reportSession(state, buttons, stats.messages, stats.bytes);
+	}
+
+	/**
+		@brief opens a profile of new buttons each iteration and times how long it takes from the first WillAppear
+		       until every button has its title, which includes the CONTEXT_SETTLE_TIME the plugin waits for the burst to end
+	**/
+	void runAppearLatency(benchmarks::BenchmarkState& state, const size_t buttonCount)
+	{
+		const json& routeTargets = getRouteTargets();
+		PluginDirectory directory;
+		auto plugin = std::make_unique<FFXIVOceanFishingTrackerPlugin>();
+		InMemoryTransport transport(plugin.get(), false);
+
+		uint64_t buttons = 0;
+		std::chrono::microseconds totalLatency(0);
+		std::chrono::microseconds maxLatency(0);
+		while (state.keepRunning())
+		{
+			const std::vector<streamdecksession::button_t> page = streamdecksession::makeButtons(buttonCount, routeTargets, buttons);
+			const std::vector<std::string> appear = streamdecksession::makeAppear(page, "InMemoryTransport");
+			const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (const std::string& message : appear)
+				transport.inject(message);
+			if (!transport.waitForContexts(buttons + buttonCount, 0, TIMEOUT))
+			{
+				std::printf("timed out waiting for %zu buttons\n", buttonCount);
+				break;
+			}
+			const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+			totalLatency += latency;
+			maxLatency = (std::max)(maxLatency, latency);
+
+			for (const std::string& message : streamdecksession::makeDisappear(page))
+				transport.inject(message);
+			buttons += buttonCount;
+		}
+
+		plugin.reset();
+		const InMemoryTransport::transportStats_t stats = transport.getStats();
+		reportSession(state, buttons, stats.messages, stats.bytes);
+		const uint64_t pages = buttons / (std::max<uint64_t>)(1, buttonCount);
+		state.setCounter("mean appear to last title ms", totalLatency.count() / 1000.0 / (std::max<uint64_t>)(1, pages));
+		state.setCounter("max appear to last title ms", maxLatency.count() / 1000.0);
+	}
+
+	// the same session over a real websocket, the plugin connects to a local stand in for the Stream Deck application
+	void runWebsocket(benchmarks::BenchmarkState& state, const size_t buttonCount)
+	{
+		const json& routeTargets = getRouteTargets();
+		PluginDirectory directory;
+		auto standIn = std::make_unique<StreamDeckStandIn>(std::vector<std::string>());
+		if (!standIn->isInit())
+		{
+			std::printf("%s\n", standIn->getErrorMessage().c_str());
+			return;
+		}
+
+		auto plugin = std::make_unique<FFXIVOceanFishingTrackerPlugin>();
+		auto connectionManager = std::make_unique<ESDConnectionManager>(standIn->getPort(), "StreamDeckStandIn", "registerPlugin", "{}", plugin.get());
+		std::thread connectionThread([&connectionManager]() { connectionManager->Run(); });
+
+		uint64_t buttons = 0;
+		while (state.keepRunning())
+		{
+			const std::vector<streamdecksession::button_t> page = streamdecksession::makeButtons(buttonCount, routeTargets, buttons);
+			standIn->replay(streamdecksession::makeAppear(page, "StreamDeckStandIn"));
+			if (!standIn->waitForContexts(buttons + buttonCount, buttons + buttonCount, TIMEOUT))
+			{
+				std::printf("timed out waiting for %zu buttons\n", buttonCount);
+				break;
+			}
+
+			standIn->replay(streamdecksession::makeKeyPresses(page, 10));
+			standIn->replay(streamdecksession::makeDisappear(page));
+			buttons += buttonCount;
+		}
+
+		const StreamDeckStandIn::standInStats_t stats = standIn->getStats();
+		reportSession(state, buttons, stats.messages, stats.bytes);
+		state.setCounter("mean title ms", stats.meanTitleLatency.count() / 1000.0);
+		state.setCounter("max title ms", stats.maxTitleLatency.count() / 1000.0);
+
+		// the connection closes with the stand in, the plugin has to stop sending before its transport goes
+		standIn.reset();
+		connectionThread.join();
+		plugin.reset();
+		connectionManager.reset();
+	}
+
+	BENCHMARK_CASE(SessionInMemory10)
+	{
+		runInMemory(state, 10);
+	}
+
+	BENCHMARK_CASE(SessionInMemory100)
+	{
+		runInMemory(state, 100);
+	}
+
+	BENCHMARK_CASE(SessionInMemory1000)
+	{
+		runInMemory(state, 1000);
+	}
+
+	BENCHMARK_CASE(SessionInMemory10000)
+	{
+		runInMemory(state, 10000);
+	}
+
+	BENCHMARK_CASE(SessionAppearLatency8)
+	{
+		runAppearLatency(state, 8);
+	}
+
+	BENCHMARK_CASE(SessionAppearLatency32)
+	{
+		runAppearLatency(state, 32);
+	}
+
+	BENCHMARK_CASE(SessionAppearLatency128)
+	{
+		runAppearLatency(state, 128);
+	}
+
+	BENCHMARK_CASE(SessionWebsocket10)
+	{
+		runWebsocket(state, 10);
+	}
+
+	BENCHMARK_CASE(SessionWebsocket1000)
+	{
+		runWebsocket(state, 1000);
+	}
+
+	BENCHMARK_CASE(SessionWebsocket10000)
+	{
+		runWebsocket(state, 10000);
+	}
+}
@@ -0,0 +1,67 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <filesystem>
+#include "../FFXIVOceanFishingHelper.h"
+#include "../PluginSimulator.h"
+
+namespace PluginSimulatorBenchmarks
+{
+	const std::string pluginDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/";
+
+	// 2023-01-01 01:00:00 UTC, an hour before a voyage leaves
+	const time_t START_TIME = 1672534800;
+
+	json getRouteTargets()
+	{
+		FFXIVOceanFishingHelper helper({ "oceanFishingDatabase - Indigo Route.json", "oceanFishingDatabase - Ruby Route.json" });
+		json targets;
+		for (const std::string route : helper.getRouteNames())
+			targets[route] = helper.getTargetsJson(route);
+		return targets;
+	}
+
+	/**
+		@brief runs the plugin with a page of buttons for a stretch of virtual time, a simulated day at a time.
+		       Reports the cost per simulated hour, the messages per voyage and how much the process grew.
+	**/
+	void simulate(benchmarks::BenchmarkState& state, const size_t buttonCount, const std::chrono::hours duration)
+	{
+		const std::filesystem::path previous = std::filesystem::current_path();
+		std::filesystem::current_path(pluginDirectory);
+		{
+			PluginSimulator simulator(streamdecksession::makeButtons(buttonCount, getRouteTargets()), START_TIME);
+			while (state.keepRunning())
+			{
+				for (std::chrono::hours simulated(0); simulated < duration; simulated += std::chrono::hours(24))
+					simulator.run((std::min)(std::chrono::hours(24), duration - simulated));
+			}
+
+			const PluginSimulator::simulationStats_t stats = simulator.getStats();
+			const double hours = std::chrono::duration<double, std::ratio<3600>>(stats.simulated).count();
+			state.setItemsProcessed(stats.messages);
+			state.setBytesProcessed(stats.bytes);
+			state.setCounter("cpu ms per simulated hour", stats.cpuSeconds * 1000.0 / hours);
+			state.setCounter("messages per voyage", static_cast<double>(stats.messages) / (std::max<uint64_t>)(1, stats.voyages));
+			state.setCounter("memory growth KB", stats.memoryGrowth / 1024.0);
+			state.setCounter("times real speed", stats.simulated.count() / stats.wallSeconds);
+		}
+		std::filesystem::current_path(previous);
+	}
+
+	BENCHMARK_CASE(SimulateDay4)
+	{
+		simulate(state, 4, std::chrono::hours(24));
+	}
+
+	BENCHMARK_CASE(SimulateDay32)
+	{
+		simulate(state, 32, std::chrono::hours(24));
+	}
+
+	BENCHMARK_CASE(SimulateMonth4)
+	{
+		simulate(state, 4, std::chrono::hours(24 * 30));
+	}
+}
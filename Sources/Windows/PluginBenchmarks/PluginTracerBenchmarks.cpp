@@ -0,0 +1,63 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <sstream>
+#include "../PluginTracer.h"
+
+namespace PluginTracerBenchmarks
+{
+	// what the plugin pays per traced scope, like each setTitle or query
+	void runSpan(benchmarks::BenchmarkState& state, const bool isEnabled)
+	{
+		PluginTracer& tracer = PluginTracer::get();
+		tracer.clear();
+		tracer.setEnabled(isEnabled);
+		uint64_t spans = 0;
+		while (state.keepRunning())
+		{
+			for (int i = 0; i < 1000; i++)
+			{
+				ScopedTraceSpan span("span", "benchmark");
+				benchmarks::doNotOptimize(span);
+			}
+			spans += 1000;
+		}
+		tracer.setEnabled(false);
+		tracer.clear();
+		state.setItemsProcessed(spans);
+	}
+
+	BENCHMARK_CASE(TraceSpanDisabled)
+	{
+		runSpan(state, false);
+	}
+
+	BENCHMARK_CASE(TraceSpanEnabled)
+	{
+		runSpan(state, true);
+	}
+
+	// writing out every buffer of a full trace
+	BENCHMARK_CASE(TraceWrite)
+	{
+		PluginTracer& tracer = PluginTracer::get();
+		tracer.clear();
+		tracer.setEnabled(true);
+		for (size_t i = 0; i < PluginTracer::EVENTS_PER_THREAD; i++)
+		{
+			ScopedTraceSpan span("span", "benchmark");
+		}
+		tracer.setEnabled(false);
+
+		uint64_t bytes = 0;
+		while (state.keepRunning())
+		{
+			std::ostringstream output;
+			tracer.write(output);
+			bytes += output.str().size();
+		}
+		tracer.clear();
+		state.setBytesProcessed(bytes);
+	}
+}
@@ -0,0 +1,79 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../SchedulePublisher.h"
+#include "../ScheduleReader.h"
+
+namespace SchedulePublisherBenchmarks
+{
+#ifdef _WIN32
+	const std::string segmentName = "Local\\FFXIVOceanFishingScheduleBenchmarks";
+#else
+	const std::string segmentName = "/FFXIVOceanFishingScheduleBenchmarks";
+#endif
+	const size_t contextCount = 32;
+
+	sharedschedule::contextState_t makeState(const int64_t voyageTime)
+	{
+		sharedschedule::contextState_t state{};
+		sharedschedule::copyText(state.routeName, "Indigo Route");
+		sharedschedule::copyText(state.tracker, "Blue Fish");
+		sharedschedule::copyText(state.targetName, "Sothis");
+		sharedschedule::copyText(state.buttonLabel, "Sothis");
+		sharedschedule::copyText(state.imageName, "Sothis");
+		state.voyageTime = voyageTime;
+		state.nextVoyageId = 4;
+		return state;
+	}
+
+	// a page of buttons recomputed with nothing changed, as most timer ticks are
+	BENCHMARK_CASE(SchedulePublishUnchanged)
+	{
+		SchedulePublisher publisher(segmentName);
+		const sharedschedule::contextState_t published = makeState(1700006400);
+		std::vector<std::string> contexts;
+		for (size_t i = 0; i < contextCount; i++)
+		{
+			contexts.push_back("context" + std::to_string(i));
+			publisher.publish(contexts.back(), published);
+		}
+
+		while (state.keepRunning())
+			for (const std::string& context : contexts)
+				publisher.publish(context, published);
+		state.setItemsProcessed(state.getIterations() * contexts.size());
+	}
+
+	BENCHMARK_CASE(SchedulePublishChanged)
+	{
+		SchedulePublisher publisher(segmentName);
+		std::vector<std::string> contexts;
+		for (size_t i = 0; i < contextCount; i++)
+			contexts.push_back("context" + std::to_string(i));
+
+		int64_t voyageTime = 1700006400;
+		while (state.keepRunning())
+		{
+			const sharedschedule::contextState_t published = makeState(voyageTime++);
+			for (const std::string& context : contexts)
+				publisher.publish(context, published);
+		}
+		state.setItemsProcessed(state.getIterations() * contexts.size());
+	}
+
+	// an overlay reading every button after the change count moved
+	BENCHMARK_CASE(ScheduleReadAll)
+	{
+		SchedulePublisher publisher(segmentName);
+		for (size_t i = 0; i < contextCount; i++)
+			publisher.publish("context" + std::to_string(i), makeState(1700006400));
+		ScheduleReader reader(segmentName);
+
+		std::vector<sharedschedule::contextState_t> states;
+		uint64_t reads = 0;
+		while (state.keepRunning())
+			reads += reader.readAll(states);
+		state.setItemsProcessed(reads);
+	}
+}
@@ -0,0 +1,86 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <sstream>
+#include "../ScheduleQueryRunner.h"
+
+namespace ScheduleQueryRunnerBenchmarks
+{
+	const std::string pluginDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/";
+	const time_t startTime = 1700000000;
+
+	// every target of every route at 0 to 19 skips, listed over a week, as ScheduleQuery --all would for each skip
+	void runBatch(benchmarks::BenchmarkState& state, const size_t threadCount)
+	{
+		FFXIVOceanFishingHelper helper({
+			pluginDirectory + "oceanFishingDatabase - Indigo Route.json",
+			pluginDirectory + "oceanFishingDatabase - Ruby Route.json"
+		});
+		ScheduleQueryRunner runner(helper, startTime, startTime + 7 * 24 * 60 * 60);
+		std::vector<ScheduleQueryRunner::query_t> queries;
+		for (uint32_t skips = 0; skips < 20; skips++)
+			for (ScheduleQueryRunner::query_t query : runner.getAllTargetQueries())
+			{
+				query.skips = skips;
+				queries.push_back(query);
+			}
+
+		uint64_t windows = 0;
+		uint64_t bytes = 0;
+		while (state.keepRunning())
+		{
+			std::ostringstream output;
+			const ScheduleQueryRunner::batchStats_t stats = runner.runBatch(output, queries, ScheduleQueryRunner::FORMAT::CSV, threadCount);
+			windows += stats.windows;
+			bytes += stats.bytes;
+		}
+		state.setItemsProcessed(state.getIterations() * queries.size());
+		state.setBytesProcessed(bytes);
+		state.setCounter("windows", static_cast<double>(windows) / (std::max)(state.getIterations(), static_cast<uint64_t>(1)));
+	}
+
+	// a year of every target of every route as one calendar, as a crew would share it
+	void runCalendar(benchmarks::BenchmarkState& state, const size_t threadCount)
+	{
+		FFXIVOceanFishingHelper helper({
+			pluginDirectory + "oceanFishingDatabase - Indigo Route.json",
+			pluginDirectory + "oceanFishingDatabase - Ruby Route.json"
+		});
+		ScheduleQueryRunner runner(helper, startTime, startTime + 365 * 24 * 60 * 60);
+		const std::vector<ScheduleQueryRunner::query_t> queries = runner.getAllTargetQueries();
+
+		uint64_t windows = 0;
+		uint64_t bytes = 0;
+		while (state.keepRunning())
+		{
+			std::ostringstream output;
+			const ScheduleQueryRunner::batchStats_t stats = runner.runBatch(output, queries, ScheduleQueryRunner::FORMAT::ICS, threadCount);
+			windows += stats.windows;
+			bytes += stats.bytes;
+		}
+		state.setItemsProcessed(windows);
+		state.setBytesProcessed(bytes);
+		state.setCounter("events", static_cast<double>(windows) / (std::max)(state.getIterations(), static_cast<uint64_t>(1)));
+	}
+
+	BENCHMARK_CASE(ScheduleQueryBatchSingleThread)
+	{
+		runBatch(state, 1);
+	}
+
+	BENCHMARK_CASE(ScheduleQueryBatchAllThreads)
+	{
+		runBatch(state, (std::max)(std::thread::hardware_concurrency(), 1u));
+	}
+
+	BENCHMARK_CASE(ScheduleQueryCalendarYearSingleThread)
+	{
+		runCalendar(state, 1);
+	}
+
+	BENCHMARK_CASE(ScheduleQueryCalendarYearAllThreads)
+	{
+		runCalendar(state, (std::max)(std::thread::hardware_concurrency(), 1u));
+	}
+}
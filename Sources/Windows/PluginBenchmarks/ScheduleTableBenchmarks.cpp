@@ -0,0 +1,71 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../FFXIVOceanFishingHelper.h"
+
+namespace ScheduleTableBenchmarks
+{
+	const std::string pluginDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/";
+	const time_t startTime = 1700000000;
+	const time_t year = 365 * 24 * 60 * 60;
+
+	FFXIVOceanFishingHelper& getHelper()
+	{
+		static FFXIVOceanFishingHelper helper({
+			pluginDirectory + "oceanFishingDatabase - Indigo Route.json",
+			pluginDirectory + "oceanFishingDatabase - Ruby Route.json"
+		});
+		return helper;
+	}
+
+	// a year of every target of both routes, as a planning view would build on opening
+	BENCHMARK_CASE(ScheduleTableBuildYear)
+	{
+		FFXIVOceanFishingHelper& helper = getHelper();
+		size_t targets = 0;
+		size_t bytes = 0;
+		while (state.keepRunning())
+		{
+			const std::unordered_map<std::string, ScheduleTable> tables = helper.buildScheduleTables(startTime, startTime + year);
+			targets = 0;
+			bytes = 0;
+			for (const auto& [_, table] : tables)
+			{
+				targets += table.getTargetCount();
+				bytes += table.getMemoryBytes();
+			}
+		}
+		state.setItemsProcessed(state.getIterations() * targets);
+		state.setCounter("targets", static_cast<double>(targets));
+		state.setCounter("bytesPerTarget", static_cast<double>(bytes) / (std::max)(targets, static_cast<size_t>(1)));
+	}
+
+	// the next 20 windows of every target from times spread over the year
+	BENCHMARK_CASE(ScheduleTableLookUp)
+	{
+		FFXIVOceanFishingHelper& helper = getHelper();
+		const std::unordered_map<std::string, ScheduleTable> tables = helper.buildScheduleTables(startTime, startTime + year);
+		std::vector<std::tuple<const ScheduleTable*, std::string, std::string>> targets;
+		for (const auto& [routeName, table] : tables)
+		{
+			const json routeTargets = helper.getTargetsJson(routeName);
+			for (const auto& [name, tracker] : routeTargets.items())
+				targets.emplace_back(&table, tracker.get<std::string>(), name);
+		}
+
+		std::vector<time_t> times;
+		uint64_t lookUps = 0;
+		uint64_t windows = 0;
+		time_t t = startTime;
+		while (state.keepRunning())
+		{
+			for (const auto& [table, tracker, name] : targets)
+				windows += table->getNextOccurrences(times, tracker, name, t, 20);
+			lookUps += targets.size();
+			t = startTime + (t - startTime + 7 * 60 * 60 + 13) % (year - 30 * 24 * 60 * 60);
+		}
+		state.setItemsProcessed(lookUps);
+		state.setCounter("windows", static_cast<double>(windows) / (std::max)(lookUps, static_cast<uint64_t>(1)));
+	}
+}
@@ -0,0 +1,58 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../TitleFormatter.h"
+
+namespace TitleFormatterBenchmarks
+{
+	const std::string buttonLabel = "Hafgufa-Elasmosaurus-X";
+	const time_t startTime = 1700000000;
+
+	// countdown titles change every tick, so this is the per-button cost of the 500ms UI timer
+	BENCHMARK_CASE(TitleRenderCountdown)
+	{
+		TitleFormatter formatter;
+		time_t now = startTime;
+		while (state.keepRunning())
+		{
+			benchmarks::doNotOptimize(formatter.format(buttonLabel, 1, now + 600, now + 5400, false, false, now));
+			now++;
+		}
+	}
+
+	// date titles hit the cached date string on every tick after the first
+	BENCHMARK_CASE(TitleRenderDate12H)
+	{
+		TitleFormatter formatter;
+		time_t now = startTime;
+		while (state.keepRunning())
+		{
+			benchmarks::doNotOptimize(formatter.format(buttonLabel, 0, 0, startTime + 7200, true, false, now));
+			now++;
+		}
+	}
+
+	BENCHMARK_CASE(TitleRenderDate24H)
+	{
+		TitleFormatter formatter;
+		time_t now = startTime;
+		while (state.keepRunning())
+		{
+			benchmarks::doNotOptimize(formatter.format(buttonLabel, 0, 0, startTime + 7200, true, true, now));
+			now++;
+		}
+	}
+
+	// worst case for the date cache: the voyage time changes on every render
+	BENCHMARK_CASE(TitleRenderDateUncached)
+	{
+		TitleFormatter formatter;
+		time_t now = startTime;
+		while (state.keepRunning())
+		{
+			benchmarks::doNotOptimize(formatter.format(buttonLabel, 0, 0, now + 7200, true, false, now));
+			now++;
+		}
+	}
+}
@@ -0,0 +1,84 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+
+/**
+	@brief runs every registered benchmark case, or only those whose name contains the filter.
+	       With --json=<file> the results are also written in the layout of Google Benchmark's json output,
+	       one benchmark per line, for Devtools/compareBenchmarks.sh to compare between builds.
+**/
+int main(int argc, char* argv[])
+{
+	const char* filter = "";
+	std::string jsonFile;
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strncmp(argv[i], "--json=", 7) == 0)
+			jsonFile = argv[i] + 7;
+		else
+			filter = argv[i];
+	}
+	const std::chrono::milliseconds minTime(500);
+
+	std::vector<std::string> results;
+	std::printf("%-48s %14s %14s %16s\n", "Benchmark", "Iterations", "ns/iter", "items/s");
+	for (const auto& [name, func] : benchmarks::getRegistry())
+	{
+		if (name.find(filter) == std::string::npos)
+			continue;
+
+		benchmarks::BenchmarkState state(minTime);
+		func(state);
+
+		const double seconds = state.getSeconds();
+		const double nsPerIteration = state.getIterations() ? seconds * 1e9 / state.getIterations() : 0.0;
+		const double itemsPerSecond = seconds > 0.0 ? state.getItemsProcessed() / seconds : 0.0;
+		std::printf("%-48s %14llu %14.1f %16.0f", name.c_str(), static_cast<unsigned long long>(state.getIterations()), nsPerIteration, itemsPerSecond);
+		if (state.getBytesProcessed() && seconds > 0.0)
+			std::printf(" %10.1f MB/s", state.getBytesProcessed() / seconds / 1e6);
+		for (const auto& [counterName, value] : state.getCounters())
+			std::printf(" %s=%g", counterName.c_str(), value);
+		std::printf("\n");
+
+		if (jsonFile.empty())
+			continue;
+		json result = {
+			{ "name", name },
+			{ "iterations", state.getIterations() },
+			{ "real_time", nsPerIteration },
+			{ "time_unit", "ns" },
+			{ "items_per_second", itemsPerSecond }
+		};
+		if (state.getBytesProcessed() && seconds > 0.0)
+			result["bytes_per_second"] = state.getBytesProcessed() / seconds;
+		for (const auto& [counterName, value] : state.getCounters())
+			result[counterName] = value;
+		results.push_back(result.dump());
+	}
+
+	if (!jsonFile.empty())
+	{
+		std::ofstream file(jsonFile, std::ios::binary);
+		char date[32] = {};
+		const time_t now = time(0);
+		struct tm utc {};
+		gmtime_s(&utc, &now);
+		std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", &utc);
+
+		file << "{\n\"context\": " << json({ { "date", date }, { "executable", argv[0] } }).dump() << ",\n\"benchmarks\": [\n";
+		for (size_t i = 0; i < results.size(); i++)
+			file << results[i] << (i + 1 < results.size() ? ",\n" : "\n");
+		file << "]\n}\n";
+		if (!file)
+		{
+			std::fprintf(stderr, "Unable to write %s\n", jsonFile.c_str());
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,16 @@
+//
+// pch.h
+//
+
+#pragma once
+
+#include "../../Vendor/json/src/json.hpp"
+
+using json = nlohmann::json;
+
+#include "Benchmark.h"
+
+// the session benchmarks run the plugin over websocketpp against a stand in Stream Deck
+#include <winsock2.h>
+#define ASIO_STANDALONE
+#define DebugPrint(...) while(0)
@@ -0,0 +1,297 @@
+//==============================================================================
+/**
+@file       PluginLogger.cpp
+@brief      Leveled, rate limited logging written out by a background thread
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "PluginLogger.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+
+namespace
+{
+	constexpr std::array<std::string_view, 4> LEVEL_NAMES = {
+		"DEBUG",
+		"INFO",
+		"WARNING",
+		"ERROR",
+	};
+}
+
+/**
+	@param[in] sink where batches of lines go while no file is set, called on the logger's thread
+	@param[in] clock where rate limit windows and file timestamps are read from
+**/
+PluginLogger::PluginLogger(sink_t sink, Clock& clock) :
+	mSink(std::move(sink)),
+	mClock(clock)
+{
+	for (size_t i = 0; i < QUEUE_CAPACITY; i++)
+		mCells[i].sequence.store(i, std::memory_order_relaxed);
+	mThread = std::thread([this]() { run(); });
+}
+
+/**
+	@brief writes out everything still queued before stopping
+**/
+PluginLogger::~PluginLogger()
+{
+	{
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mIsRunning = false;
+	}
+	mWakeCondition.notify_one();
+	if (mThread.joinable())
+		mThread.join();
+}
+
+/**
+	@brief checks a call site's rate limit, allowing MAX_LINES_PER_SITE_PER_SECOND lines a second.
+	       Sites racing across a window boundary may let a line or two more through, which is fine for logging.
+
+	@param[in] site the call site's rate limit state
+	@param[out] suppressed lines this site had suppressed since its last line, if allowed
+
+	@return true if the line should be logged
+**/
+bool PluginLogger::isAllowed(site_t& site, uint32_t& suppressed)
+{
+	const int64_t window = std::chrono::duration_cast<std::chrono::seconds>(mClock.steadyNow().time_since_epoch()).count();
+	int64_t siteWindow = site.window.load(std::memory_order_relaxed);
+	if (siteWindow != window && site.window.compare_exchange_strong(siteWindow, window, std::memory_order_relaxed))
+		site.count.store(0, std::memory_order_relaxed);
+
+	if (site.count.fetch_add(1, std::memory_order_relaxed) >= MAX_LINES_PER_SITE_PER_SECOND)
+	{
+		site.suppressed.fetch_add(1, std::memory_order_relaxed);
+		mSuppressed.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+	return true;
+}
+
+/**
+	@brief sends lines to a file instead of the sink, keeping fileCount files of up to maxBytes each
+
+	@param[in] path the file to append to, path.1, path.2 and so on hold older lines. Empty to go back to the sink
+	@param[in] maxBytes size a file is rotated at
+	@param[in] fileCount number of files kept, including the one being written
+**/
+void PluginLogger::setFile(const std::string& path, const size_t maxBytes, const size_t fileCount)
+{
+	std::unique_lock<std::mutex> lock(mFileMutex);
+	mFilePath = path;
+	mFileMaxBytes = maxBytes;
+	mFileCount = (std::max)(fileCount, static_cast<size_t>(1));
+	mIsFileChanged = true;
+}
+
+/**
+	@brief queues a line for the logger's thread, dropping it if the queue is full
+
+	@param[in] line the formatted line
+**/
+void PluginLogger::push(std::string&& line)
+{
+	size_t position = mEnqueuePosition.load(std::memory_order_relaxed);
+	cell_t* cell = nullptr;
+	while (true)
+	{
+		cell = &mCells[position % QUEUE_CAPACITY];
+		const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+		const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+		if (difference == 0)
+		{
+			if (mEnqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				break;
+		}
+		else if (difference < 0)
+		{
+			mDropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else
+			position = mEnqueuePosition.load(std::memory_order_relaxed);
+	}
+
+	cell->line = std::move(line);
+	cell->sequence.store(position + 1, std::memory_order_release);
+	mLogged.fetch_add(1, std::memory_order_relaxed);
+
+	// the first line after the logger's thread went to sleep wakes it, the rest are picked up in the same batch
+	if (!mIsWoken.exchange(true, std::memory_order_acq_rel))
+		mWakeCondition.notify_one();
+}
+
+/**
+	@brief waits until every line logged before this call has been written out
+**/
+void PluginLogger::flush()
+{
+	const size_t target = mEnqueuePosition.load(std::memory_order_acquire);
+	mIsWoken.store(true, std::memory_order_release);
+	mWakeCondition.notify_one();
+
+	std::unique_lock<std::mutex> lock(mWakeMutex);
+	mFlushedCondition.wait(lock, [this, target]() { return mWritten >= target || !mIsRunning; });
+}
+
+PluginLogger::loggerStats_t PluginLogger::getStats() const
+{
+	loggerStats_t stats;
+	stats.logged = mLogged.load(std::memory_order_relaxed);
+	stats.suppressed = mSuppressed.load(std::memory_order_relaxed);
+	stats.dropped = mDropped.load(std::memory_order_relaxed);
+	stats.batches = mBatches.load(std::memory_order_relaxed);
+	return stats;
+}
+
+/**
+	@brief the logger's thread, writes out whatever has been queued each time it is woken
+**/
+void PluginLogger::run()
+{
+	std::string batch;
+	bool isRunning = true;
+	while (isRunning)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mWakeMutex);
+			mWakeCondition.wait_for(lock, FLUSH_INTERVAL, [this]() { return !mIsRunning || mIsWoken.load(std::memory_order_acquire); });
+			isRunning = mIsRunning;
+		}
+		mIsWoken.store(false, std::memory_order_release);
+
+		batch.clear();
+		while (true)
+		{
+			cell_t& cell = mCells[mDequeuePosition % QUEUE_CAPACITY];
+			if (cell.sequence.load(std::memory_order_acquire) != mDequeuePosition + 1)
+				break;
+			batch += cell.line;
+			batch += '\n';
+			cell.line.clear();
+			cell.sequence.store(mDequeuePosition + QUEUE_CAPACITY, std::memory_order_release);
+			mDequeuePosition++;
+		}
+		if (!batch.empty())
+			write(batch);
+
+		{
+			std::unique_lock<std::mutex> lock(mWakeMutex);
+			mWritten = mDequeuePosition;
+		}
+		mFlushedCondition.notify_all();
+	}
+	mFile.close();
+}
+
+/**
+	@brief writes a batch to the file if one is set, or the sink
+
+	@param[in] batch the lines, each ending in a newline
+**/
+void PluginLogger::write(std::string& batch)
+{
+	mBatches.fetch_add(1, std::memory_order_relaxed);
+	{
+		std::unique_lock<std::mutex> lock(mFileMutex);
+		if (mIsFileChanged)
+		{
+			mIsFileChanged = false;
+			mFile.close();
+			mOpenFilePath = mFilePath;
+			mFileBytes = 0;
+			if (!mOpenFilePath.empty())
+			{
+				mFile.open(mOpenFilePath, std::ios::app | std::ios::binary);
+				if (mFile)
+				{
+					mFile.seekp(0, std::ios::end);
+					mFileBytes = static_cast<size_t>(mFile.tellp());
+				}
+				else
+				{
+					const std::string error = "[ERROR] could not open log file: " + mOpenFilePath + "\n";
+					batch.insert(0, error);
+					mOpenFilePath.clear();
+				}
+			}
+		}
+	}
+
+	if (mOpenFilePath.empty())
+	{
+		if (mSink)
+			mSink(std::string_view(batch).substr(0, batch.size() - 1));
+		return;
+	}
+
+	// lines in a file are stamped with the time they were written, within a FLUSH_INTERVAL of when they were logged
+	const time_t now = mClock.now();
+	struct tm localTime {};
+	localtime_s(&localTime, &now);
+	char timestamp[32];
+	const size_t timestampLength = std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S ", &localTime);
+
+	std::unique_lock<std::mutex> lock(mFileMutex);
+	size_t start = 0;
+	while (start < batch.size())
+	{
+		const size_t end = batch.find('\n', start) + 1;
+		const size_t length = timestampLength + end - start;
+		if (mFileBytes > 0 && mFileBytes + length > mFileMaxBytes)
+			rotate();
+		mFile.write(timestamp, timestampLength);
+		mFile.write(batch.data() + start, end - start);
+		mFileBytes += length;
+		start = end;
+	}
+	mFile.flush();
+}
+
+/**
+	@brief moves path to path.1, path.1 to path.2 and so on, dropping the oldest, then starts a new file. Needs mFileMutex
+**/
+void PluginLogger::rotate()
+{
+	mFile.close();
+	const auto numbered = [this](const size_t number) { return mOpenFilePath + "." + std::to_string(number); };
+	if (mFileCount > 1)
+	{
+		std::remove(numbered(mFileCount - 1).c_str());
+		for (size_t number = mFileCount - 1; number > 1; number--)
+			std::rename(numbered(number - 1).c_str(), numbered(number).c_str());
+		std::rename(mOpenFilePath.c_str(), numbered(1).c_str());
+	}
+	mFile.open(mOpenFilePath, std::ios::trunc | std::ios::binary);
+	mFileBytes = 0;
+}
+
+std::string_view PluginLogger::toName(const LOG_LEVEL level)
+{
+	return LEVEL_NAMES[static_cast<size_t>(level)];
+}
+
+/**
+	@brief reads a level by name, case insensitively
+
+	@param[in] name debug, info, warning or error
+
+	@return the level, or nullopt if the name is not one
+**/
+std::optional<LOG_LEVEL> PluginLogger::toLevel(std::string_view name)
+{
+	for (size_t i = 0; i < LEVEL_NAMES.size(); i++)
+	{
+		if (name.size() == LEVEL_NAMES[i].size() &&
+			std::equal(name.begin(), name.end(), LEVEL_NAMES[i].begin(), [](const char a, const char b) { return std::toupper(static_cast<unsigned char>(a)) == b; }))
+			return static_cast<LOG_LEVEL>(i);
+	}
+	return std::nullopt;
+}
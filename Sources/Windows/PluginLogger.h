@@ -0,0 +1,211 @@
+//==============================================================================
+/**
+@file       PluginLogger.h
+@brief      Leveled, rate limited logging written out by a background thread
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include "Clock.h"
+
+#include "../Vendor/json/src/json.hpp"
+using json = nlohmann::json;
+
+// not DEBUG or ERROR, pch.h and windows.h define them
+enum class LOG_LEVEL
+{
+	DBG,
+	INFO,
+	WARNING,
+	ERR,
+};
+
+// log calls below this level are compiled out, debug logging is only built into debug builds unless set otherwise
+#ifndef PLUGIN_LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define PLUGIN_LOG_MIN_LEVEL 0
+#else
+#define PLUGIN_LOG_MIN_LEVEL 1
+#endif
+#endif
+
+/**
+	@brief Logs a line made of the arguments appended together, if the level is on and this call site is under its rate limit.
+	       The arguments are only evaluated and formatted when the line is logged, json is dumped, numbers are printed.
+**/
+#define PLUGIN_LOG(logger, level, ...) \
+	do \
+	{ \
+		if constexpr (static_cast<int>(level) >= PLUGIN_LOG_MIN_LEVEL) \
+		{ \
+			static PluginLogger::site_t pluginLogSite; \
+			uint32_t pluginLogSuppressed = 0; \
+			if ((logger).isEnabled(level) && (logger).isAllowed(pluginLogSite, pluginLogSuppressed)) \
+				(logger).log(level, pluginLogSuppressed, __VA_ARGS__); \
+		} \
+	} while (false)
+
+#define PLUGIN_LOG_DEBUG(logger, ...) PLUGIN_LOG(logger, LOG_LEVEL::DBG, __VA_ARGS__)
+#define PLUGIN_LOG_INFO(logger, ...) PLUGIN_LOG(logger, LOG_LEVEL::INFO, __VA_ARGS__)
+#define PLUGIN_LOG_WARNING(logger, ...) PLUGIN_LOG(logger, LOG_LEVEL::WARNING, __VA_ARGS__)
+#define PLUGIN_LOG_ERROR(logger, ...) PLUGIN_LOG(logger, LOG_LEVEL::ERR, __VA_ARGS__)
+
+/**
+	@brief Formats log lines on the calling thread and hands them through a lock free queue to a background thread,
+	       which writes whatever has queued up as one batch, to a sink such as the Stream Deck's log or to a rotating file.
+	       Logging never waits on the sink, lines that do not fit in the queue are dropped and counted.
+**/
+class PluginLogger
+{
+public:
+	// receives a batch of lines separated by newlines
+	using sink_t = std::function<void(std::string_view lines)>;
+
+	// rate limit state of one log call site, one second windows
+	struct site_t
+	{
+		std::atomic<int64_t> window = -1;
+		std::atomic<uint32_t> count = 0;
+		std::atomic<uint32_t> suppressed = 0;
+	};
+
+	// lines handled since construction
+	struct loggerStats_t
+	{
+		uint64_t logged = 0;
+		uint64_t suppressed = 0; // over a call site's rate limit
+		uint64_t dropped = 0; // queue was full
+		uint64_t batches = 0;
+	};
+
+	static constexpr size_t QUEUE_CAPACITY = 1024;
+	static constexpr uint32_t MAX_LINES_PER_SITE_PER_SECOND = 5;
+	static constexpr size_t DEFAULT_FILE_BYTES = 1024 * 1024;
+	static constexpr size_t DEFAULT_FILE_COUNT = 3;
+
+	explicit PluginLogger(sink_t sink, Clock& clock = Clock::system());
+	~PluginLogger();
+
+	PluginLogger(const PluginLogger&) = delete;
+	PluginLogger& operator=(const PluginLogger&) = delete;
+
+	bool isEnabled(const LOG_LEVEL level) const { return level >= mLevel.load(std::memory_order_relaxed); }
+	void setLevel(const LOG_LEVEL level) { mLevel.store(level, std::memory_order_relaxed); }
+	bool isAllowed(site_t& site, uint32_t& suppressed);
+
+	void setFile(const std::string& path, const size_t maxBytes = DEFAULT_FILE_BYTES, const size_t fileCount = DEFAULT_FILE_COUNT);
+
+	/**
+		@brief formats and queues a line, without checking the level or rate limit
+
+		@param[in] level the level of the line
+		@param[in] suppressed lines from the same call site dropped since its last line, noted on the end
+		@param[in] args what to append together into the line
+	**/
+	template <typename... Args>
+	void log(const LOG_LEVEL level, const uint32_t suppressed, const Args&... args)
+	{
+		std::string line;
+		line.reserve(128);
+		line += '[';
+		line += toName(level);
+		line += "] ";
+		(append(line, args), ...);
+		if (suppressed > 0)
+		{
+			line += " (";
+			append(line, suppressed);
+			line += " similar suppressed)";
+		}
+		push(std::move(line));
+	}
+
+	void flush();
+	loggerStats_t getStats() const;
+
+	static std::string_view toName(const LOG_LEVEL level);
+	static std::optional<LOG_LEVEL> toLevel(std::string_view name);
+
+private:
+	template <typename T>
+	static void append(std::string& line, const T& value)
+	{
+		if constexpr (std::is_same_v<T, json>)
+			line += value.dump();
+		else if constexpr (std::is_same_v<T, bool>)
+			line += value ? "true" : "false";
+		else if constexpr (std::is_same_v<T, char>)
+			line += value;
+		else if constexpr (std::is_arithmetic_v<T>)
+		{
+			char buffer[32];
+			const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			line.append(buffer, end);
+		}
+		else
+			line += std::string_view(value);
+	}
+
+	void push(std::string&& line);
+	void run();
+	void write(std::string& batch);
+	void rotate();
+
+	// bounded queue for many producers and the one writer thread. A cell is free for the producer that claims position p
+	// when its sequence is p, and holds a line for the writer when it is p + 1
+	struct cell_t
+	{
+		std::atomic<size_t> sequence = 0;
+		std::string line;
+	};
+	std::array<cell_t, QUEUE_CAPACITY> mCells;
+	std::atomic<size_t> mEnqueuePosition = 0;
+	size_t mDequeuePosition = 0; // only used by the writer thread
+
+	const sink_t mSink;
+	Clock& mClock;
+	std::atomic<LOG_LEVEL> mLevel = LOG_LEVEL::INFO;
+
+	std::atomic<uint64_t> mLogged = 0;
+	std::atomic<uint64_t> mSuppressed = 0;
+	std::atomic<uint64_t> mDropped = 0;
+	std::atomic<uint64_t> mBatches = 0;
+
+	// wakes the writer, which also wakes on its own every FLUSH_INTERVAL in case a wake slipped past it
+	static constexpr std::chrono::milliseconds FLUSH_INTERVAL = std::chrono::milliseconds(100);
+	std::mutex mWakeMutex;
+	std::condition_variable mWakeCondition;
+	std::condition_variable mFlushedCondition;
+	std::atomic_bool mIsWoken = false;
+	bool mIsRunning = true;
+	size_t mWritten = 0; // queue positions written out, guarded by mWakeMutex
+
+	// the file lines go to instead of the sink, set from any thread and opened by the writer
+	std::mutex mFileMutex;
+	std::string mFilePath;
+	size_t mFileMaxBytes = DEFAULT_FILE_BYTES;
+	size_t mFileCount = DEFAULT_FILE_COUNT;
+	bool mIsFileChanged = false;
+
+	// only used by the writer thread
+	std::ofstream mFile;
+	std::string mOpenFilePath;
+	size_t mFileBytes = 0;
+
+	std::thread mThread;
+};
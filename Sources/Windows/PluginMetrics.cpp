@@ -0,0 +1,189 @@
+//==============================================================================
+/**
+@file       PluginMetrics.cpp
+@brief      Counters and latency histograms for the plugin's hot paths
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "PluginMetrics.h"
+#include "../Common/ESDSDKDefines.h"
+#include <bit>
+
+namespace
+{
+	constexpr std::array<std::string_view, static_cast<size_t>(PluginMetrics::SENT::COUNT)> SENT_NAMES = {
+		kESDSDKEventSetTitle,
+		kESDSDKEventSetImage,
+		kESDSDKEventShowAlert,
+		kESDSDKEventShowOK,
+		kESDSDKEventGetGlobalSettings,
+		kESDSDKEventSetGlobalSettings,
+		kESDSDKEventSetSettings,
+		kESDSDKEventSetState,
+		kESDSDKEventSendToPropertyInspector,
+		kESDSDKEventSwitchToProfile,
+		kESDSDKEventLogMessage,
+		kESDSDKEventOpenURL,
+	};
+
+	constexpr std::array<std::string_view, static_cast<size_t>(PluginMetrics::HISTOGRAM::COUNT)> HISTOGRAM_NAMES = {
+		"timerCallback",
+		"updateUI",
+		"contextsMutexWait",
+		"contextsMutexHold",
+		"timerLateness",
+	};
+
+	// upper bound of a bucket in microseconds
+	double bucketLimit(const size_t bucket)
+	{
+		return static_cast<double>(uint64_t(1) << bucket);
+	}
+}
+
+PluginMetrics& PluginMetrics::get()
+{
+	static PluginMetrics metrics;
+	return metrics;
+}
+
+/**
+	@brief zeroes every counter and histogram, recording carries on if it is enabled
+**/
+void PluginMetrics::reset()
+{
+	for (std::atomic<uint64_t>& sent : mSent)
+		sent = 0;
+	for (std::atomic<uint64_t>& received : mReceived)
+		received = 0;
+	mBytesSent = 0;
+	mBytesReceived = 0;
+	for (histogram_t& histogram : mHistograms)
+	{
+		for (std::atomic<uint64_t>& bucket : histogram.buckets)
+			bucket = 0;
+		histogram.count = 0;
+		histogram.totalNanoseconds = 0;
+		histogram.maxNanoseconds = 0;
+	}
+}
+
+/**
+	@brief adds a duration to a histogram, if recording is enabled
+
+	@param[in] histogram the histogram to add to
+	@param[in] duration the duration
+**/
+void PluginMetrics::record(const HISTOGRAM histogram, const std::chrono::nanoseconds duration)
+{
+	if (!isEnabled())
+		return;
+
+	const uint64_t nanoseconds = static_cast<uint64_t>((std::max)(duration.count(), static_cast<std::chrono::nanoseconds::rep>(0)));
+	const size_t bucket = (std::min)(static_cast<size_t>(std::bit_width(nanoseconds / 1000)), HISTOGRAM_BUCKETS - 1);
+
+	histogram_t& h = mHistograms[static_cast<size_t>(histogram)];
+	h.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	h.count.fetch_add(1, std::memory_order_relaxed);
+	h.totalNanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+
+	uint64_t max = h.maxNanoseconds.load(std::memory_order_relaxed);
+	while (nanoseconds > max && !h.maxNanoseconds.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed))
+		;
+}
+
+/**
+	@brief reads a histogram. Percentiles are the upper bound of the power of two bucket they fall in, capped at the max.
+
+	@param[in] histogram the histogram to read
+
+	@return count, mean, median, 99th percentile and max, in microseconds
+**/
+PluginMetrics::histogramSnapshot_t PluginMetrics::getHistogram(const HISTOGRAM histogram) const
+{
+	const histogram_t& h = mHistograms[static_cast<size_t>(histogram)];
+
+	std::array<uint64_t, HISTOGRAM_BUCKETS> buckets{};
+	uint64_t count = 0;
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		buckets[i] = h.buckets[i].load(std::memory_order_relaxed);
+		count += buckets[i];
+	}
+
+	histogramSnapshot_t snapshot;
+	snapshot.count = count;
+	if (count == 0)
+		return snapshot;
+
+	snapshot.maxMicroseconds = h.maxNanoseconds.load(std::memory_order_relaxed) / 1000.0;
+	snapshot.meanMicroseconds = h.totalNanoseconds.load(std::memory_order_relaxed) / 1000.0 / count;
+
+	const auto percentile = [&](const double fraction)
+	{
+		const uint64_t rank = (std::max)(static_cast<uint64_t>(fraction * count + 0.5), static_cast<uint64_t>(1));
+		uint64_t seen = 0;
+		for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+		{
+			seen += buckets[i];
+			if (seen >= rank)
+				return (std::min)(bucketLimit(i), snapshot.maxMicroseconds);
+		}
+		return snapshot.maxMicroseconds;
+	};
+	snapshot.p50Microseconds = percentile(0.50);
+	snapshot.p99Microseconds = percentile(0.99);
+	return snapshot;
+}
+
+/**
+	@brief reads everything recorded so far
+
+	@return the messages sent and received by type, bytes, and each histogram in microseconds
+**/
+json PluginMetrics::snapshot() const
+{
+	json j;
+	j["enabled"] = isEnabled();
+
+	json sent = json::object();
+	for (size_t i = 0; i < SENT_NAMES.size(); i++)
+		if (const uint64_t count = getSent(static_cast<SENT>(i)))
+			sent[std::string(SENT_NAMES[i])] = count;
+	j["sent"] = sent;
+	j["bytesSent"] = getBytesSent();
+
+	json received = json::object();
+	for (size_t i = 0; i < InboundMessage::EVENT_COUNT; i++)
+		if (const uint64_t count = getReceived(static_cast<InboundMessage::EVENT>(i)))
+			received[std::string(InboundMessage::toName(static_cast<InboundMessage::EVENT>(i)))] = count;
+	j["received"] = received;
+	j["bytesReceived"] = getBytesReceived();
+
+	json histograms = json::object();
+	for (size_t i = 0; i < HISTOGRAM_NAMES.size(); i++)
+	{
+		const histogramSnapshot_t histogram = getHistogram(static_cast<HISTOGRAM>(i));
+		histograms[std::string(HISTOGRAM_NAMES[i])] = {
+			{ "count", histogram.count },
+			{ "meanUs", histogram.meanMicroseconds },
+			{ "p50Us", histogram.p50Microseconds },
+			{ "p99Us", histogram.p99Microseconds },
+			{ "maxUs", histogram.maxMicroseconds }
+		};
+	}
+	j["histograms"] = histograms;
+	return j;
+}
+
+std::string_view PluginMetrics::toName(const SENT type)
+{
+	return SENT_NAMES[static_cast<size_t>(type)];
+}
+
+std::string_view PluginMetrics::toName(const HISTOGRAM histogram)
+{
+	return HISTOGRAM_NAMES[static_cast<size_t>(histogram)];
+}
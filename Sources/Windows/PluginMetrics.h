@@ -0,0 +1,219 @@
+//==============================================================================
+/**
+@file       PluginMetrics.h
+@brief      Counters and latency histograms for the plugin's hot paths
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include "InboundMessage.h"
+#include "PluginTracer.h"
+
+#include "../Vendor/json/src/json.hpp"
+using json = nlohmann::json;
+
+/**
+	@brief Process wide counts of the messages the plugin sends and receives, and histograms of how long its hot paths take.
+	       Recording is off until setEnabled(true). While off, every record call is a single relaxed atomic load,
+	       and the timers below do not read the clock.
+	       Everything is lock free, so it can be recorded from any thread, including while holding the plugin's mutexes.
+**/
+class PluginMetrics
+{
+public:
+	// messages the plugin sends, by type
+	enum class SENT
+	{
+		SET_TITLE,
+		SET_IMAGE,
+		SHOW_ALERT,
+		SHOW_OK,
+		GET_GLOBAL_SETTINGS,
+		SET_GLOBAL_SETTINGS,
+		SET_SETTINGS,
+		SET_STATE,
+		SEND_TO_PROPERTY_INSPECTOR,
+		SWITCH_TO_PROFILE,
+		LOG_MESSAGE,
+		OPEN_URL,
+		COUNT,
+	};
+
+	// durations recorded
+	enum class HISTOGRAM
+	{
+		TIMER_CALLBACK, // the recompute timer's callback
+		UPDATE_UI, // one UpdateUI pass over every visible context
+		CONTEXTS_MUTEX_WAIT, // waiting to lock mVisibleContextsMutex
+		CONTEXTS_MUTEX_HOLD, // holding mVisibleContextsMutex
+		TIMER_LATENESS, // how much longer a timer's wait took than it asked for
+		COUNT,
+	};
+
+	// buckets are powers of two of microseconds, bucket 0 is under 1us and the last holds everything over 2^30us
+	static constexpr size_t HISTOGRAM_BUCKETS = 32;
+
+	// a histogram as read at a point in time
+	struct histogramSnapshot_t
+	{
+		uint64_t count = 0;
+		double meanMicroseconds = 0.0;
+		double p50Microseconds = 0.0; // upper bound of the bucket holding the median
+		double p99Microseconds = 0.0;
+		double maxMicroseconds = 0.0;
+	};
+
+	static PluginMetrics& get();
+
+	bool isEnabled() const { return mIsEnabled.load(std::memory_order_relaxed); }
+	void setEnabled(const bool isEnabled) { mIsEnabled.store(isEnabled, std::memory_order_relaxed); }
+	void reset();
+
+	void countSent(const SENT type, const size_t bytes)
+	{
+		if (!isEnabled())
+			return;
+		mSent[static_cast<size_t>(type)].fetch_add(1, std::memory_order_relaxed);
+		mBytesSent.fetch_add(bytes, std::memory_order_relaxed);
+	}
+
+	void countReceived(const InboundMessage::EVENT event, const size_t bytes)
+	{
+		if (!isEnabled())
+			return;
+		mReceived[static_cast<size_t>(event)].fetch_add(1, std::memory_order_relaxed);
+		mBytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+	}
+
+	void record(const HISTOGRAM histogram, const std::chrono::nanoseconds duration);
+
+	uint64_t getSent(const SENT type) const { return mSent[static_cast<size_t>(type)].load(std::memory_order_relaxed); }
+	uint64_t getReceived(const InboundMessage::EVENT event) const { return mReceived[static_cast<size_t>(event)].load(std::memory_order_relaxed); }
+	uint64_t getBytesSent() const { return mBytesSent.load(std::memory_order_relaxed); }
+	uint64_t getBytesReceived() const { return mBytesReceived.load(std::memory_order_relaxed); }
+	histogramSnapshot_t getHistogram(const HISTOGRAM histogram) const;
+
+	json snapshot() const;
+
+	static std::string_view toName(const SENT type);
+	static std::string_view toName(const HISTOGRAM histogram);
+
+private:
+	struct histogram_t
+	{
+		std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+		std::atomic<uint64_t> count = 0;
+		std::atomic<uint64_t> totalNanoseconds = 0;
+		std::atomic<uint64_t> maxNanoseconds = 0;
+	};
+
+	std::atomic_bool mIsEnabled = false;
+
+	std::array<std::atomic<uint64_t>, static_cast<size_t>(SENT::COUNT)> mSent{};
+	std::array<std::atomic<uint64_t>, InboundMessage::EVENT_COUNT> mReceived{};
+	std::atomic<uint64_t> mBytesSent = 0;
+	std::atomic<uint64_t> mBytesReceived = 0;
+
+	std::array<histogram_t, static_cast<size_t>(HISTOGRAM::COUNT)> mHistograms;
+};
+
+/**
+	@brief Records how long the scope it lives in took into a histogram, if metrics were on when it started
+**/
+class ScopedMetricsTimer
+{
+public:
+	explicit ScopedMetricsTimer(const PluginMetrics::HISTOGRAM histogram) :
+		mHistogram(histogram),
+		mIsTiming(PluginMetrics::get().isEnabled())
+	{
+		if (mIsTiming)
+			mStart = std::chrono::steady_clock::now();
+	}
+
+	~ScopedMetricsTimer()
+	{
+		if (mIsTiming)
+			PluginMetrics::get().record(mHistogram, std::chrono::steady_clock::now() - mStart);
+	}
+
+	ScopedMetricsTimer(const ScopedMetricsTimer&) = delete;
+	ScopedMetricsTimer& operator=(const ScopedMetricsTimer&) = delete;
+
+private:
+	const PluginMetrics::HISTOGRAM mHistogram;
+	const bool mIsTiming;
+	std::chrono::steady_clock::time_point mStart;
+};
+
+/**
+	@brief A mutex that records how long lockers wait for it and how long they hold it.
+	       A drop in replacement for std::mutex with std::unique_lock and std::lock_guard.
+**/
+class MeteredMutex
+{
+public:
+	MeteredMutex(const PluginMetrics::HISTOGRAM waitHistogram, const PluginMetrics::HISTOGRAM holdHistogram) :
+		mWaitHistogram(waitHistogram),
+		mHoldHistogram(holdHistogram),
+		mWaitSpanName(PluginMetrics::toName(waitHistogram).data())
+	{};
+
+	MeteredMutex(const MeteredMutex&) = delete;
+	MeteredMutex& operator=(const MeteredMutex&) = delete;
+
+	void lock()
+	{
+		// waits show up in traces too, so contention can be told apart from slow work under the lock
+		const ScopedTraceSpan waitSpan(mWaitSpanName, "lock");
+		PluginMetrics& metrics = PluginMetrics::get();
+		if (!metrics.isEnabled())
+		{
+			mMutex.lock();
+			mIsTiming = false;
+			return;
+		}
+		const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		mMutex.lock();
+		mLockedAt = std::chrono::steady_clock::now();
+		mIsTiming = true;
+		metrics.record(mWaitHistogram, mLockedAt - start);
+	}
+
+	bool try_lock()
+	{
+		if (!mMutex.try_lock())
+			return false;
+		mIsTiming = PluginMetrics::get().isEnabled();
+		if (mIsTiming)
+			mLockedAt = std::chrono::steady_clock::now();
+		return true;
+	}
+
+	void unlock()
+	{
+		// read before unlocking, another locker owns them after
+		const bool isTiming = mIsTiming;
+		const std::chrono::steady_clock::time_point lockedAt = mLockedAt;
+		mMutex.unlock();
+		if (isTiming)
+			PluginMetrics::get().record(mHoldHistogram, std::chrono::steady_clock::now() - lockedAt);
+	}
+
+private:
+	std::mutex mMutex;
+	const PluginMetrics::HISTOGRAM mWaitHistogram;
+	const PluginMetrics::HISTOGRAM mHoldHistogram;
+	const char* const mWaitSpanName;
+
+	// only used by the thread holding mMutex
+	bool mIsTiming = false;
+	std::chrono::steady_clock::time_point mLockedAt;
+};
@@ -0,0 +1,142 @@
+//==============================================================================
+/**
+@file       PluginSimulator.cpp
+@brief      Runs the whole plugin against virtual time, faster than real time
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "PluginSimulator.h"
+#include "../FFXIVOceanFishingTrackerPlugin.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <Psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fstream>
+#endif
+
+namespace
+{
+	const std::string PLUGIN_UUID = "PluginSimulator";
+
+	// long enough for the burst of appearing buttons to settle and every button to be shown
+	constexpr std::chrono::seconds APPEAR_TIME = std::chrono::seconds(1);
+}
+
+/**
+	@brief makes the plugin and shows the buttons on it, starting virtual time at startTime
+
+	@param[in] buttons the page of buttons to show
+	@param[in] startTime the virtual time to start from
+**/
+PluginSimulator::PluginSimulator(const std::vector<streamdecksession::button_t>& buttons, const time_t startTime) :
+	mClock(startTime)
+{
+	mPlugin = std::make_unique<FFXIVOceanFishingTrackerPlugin>(mClock);
+	mTransport = std::make_unique<InMemoryTransport>(mPlugin.get(), false, PLUGIN_UUID);
+
+	for (const std::string& message : streamdecksession::makeAppear(buttons, PLUGIN_UUID))
+		mTransport->inject(message);
+	mClock.advance(APPEAR_TIME);
+
+	const InMemoryTransport::transportStats_t stats = mTransport->getStats();
+	mStartTime = mClock.now();
+	mStartMessages = stats.messages;
+	mStartBytes = stats.bytes;
+	mStartWakeups = mClock.getWakeups();
+	mStartMemory = getMemoryBytes();
+}
+
+PluginSimulator::~PluginSimulator()
+{
+	mPlugin.reset();
+	mTransport.reset();
+}
+
+/**
+	@brief runs the plugin for a stretch of virtual time, every timer tick in it runs as soon as the last one is done
+
+	@param[in] duration how much virtual time to run for
+**/
+void PluginSimulator::run(const std::chrono::seconds duration)
+{
+	const double cpuStart = getCpuSeconds();
+	const std::chrono::steady_clock::time_point wallStart = std::chrono::steady_clock::now();
+
+	mClock.advance(duration);
+
+	mWallSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+	mCpuSeconds += getCpuSeconds() - cpuStart;
+}
+
+/**
+	@brief gets what the plugin did since the buttons were shown
+
+	@return the stats over all the runs so far
+**/
+PluginSimulator::simulationStats_t PluginSimulator::getStats()
+{
+	const InMemoryTransport::transportStats_t transportStats = mTransport->getStats();
+	const time_t now = mClock.now();
+
+	simulationStats_t stats;
+	stats.simulated = std::chrono::seconds(now - mStartTime);
+	stats.wallSeconds = mWallSeconds;
+	stats.cpuSeconds = mCpuSeconds;
+	stats.voyages = static_cast<uint64_t>(now / VOYAGE_INTERVAL - mStartTime / VOYAGE_INTERVAL);
+	stats.messages = transportStats.messages - mStartMessages;
+	stats.bytes = transportStats.bytes - mStartBytes;
+	stats.timerWakeups = mClock.getWakeups() - mStartWakeups;
+	stats.memoryGrowth = static_cast<int64_t>(getMemoryBytes()) - static_cast<int64_t>(mStartMemory);
+	return stats;
+}
+
+/**
+	@brief gets the cpu time used by the whole process
+
+	@return user and kernel seconds on every thread
+**/
+double PluginSimulator::getCpuSeconds()
+{
+#ifdef _WIN32
+	FILETIME creationTime{};
+	FILETIME exitTime{};
+	FILETIME kernelTime{};
+	FILETIME userTime{};
+	if (!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime))
+		return 0.0;
+	const auto toTicks = [](const FILETIME& time) { return (static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime; };
+	return (toTicks(kernelTime) + toTicks(userTime)) / 1e7;
+#else
+	rusage usage{};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0.0;
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+#endif
+}
+
+/**
+	@brief gets the memory the process has committed to itself, what a leak would grow
+
+	@return private bytes on windows, resident bytes elsewhere
+**/
+size_t PluginSimulator::getMemoryBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS_EX counters{};
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters)))
+		return 0;
+	return counters.PrivateUsage;
+#else
+	std::ifstream statm("/proc/self/statm");
+	size_t pages = 0;
+	size_t residentPages = 0;
+	if (!(statm >> pages >> residentPages))
+		return 0;
+	return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
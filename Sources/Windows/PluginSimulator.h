@@ -0,0 +1,74 @@
+//==============================================================================
+/**
+@file       PluginSimulator.h
+@brief      Runs the whole plugin against virtual time, faster than real time
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <vector>
+#include "VirtualClock.h"
+#include "InMemoryTransport.h"
+#include "StreamDeckSession.h"
+
+class FFXIVOceanFishingTrackerPlugin;
+
+/**
+	@brief Shows a page of buttons on a plugin running on a VirtualClock, then runs it for days of virtual time in seconds.
+	       Every timer tick the plugin would make in that time is made, in order, so its cost and output can be measured.
+	       Must be made from the plugin directory, like the plugin itself.
+**/
+class PluginSimulator
+{
+public:
+	// voyages leave every 2 hours
+	static constexpr time_t VOYAGE_INTERVAL = 2 * 60 * 60;
+
+	// what the plugin did over the simulated time, not counting showing the buttons
+	struct simulationStats_t
+	{
+		std::chrono::seconds simulated{ 0 };
+		double wallSeconds = 0.0; // real time taken
+		double cpuSeconds = 0.0; // process cpu time taken, on every thread
+		uint64_t voyages = 0; // voyages that left during the simulated time
+		uint64_t messages = 0;
+		uint64_t bytes = 0;
+		uint64_t timerWakeups = 0;
+		int64_t memoryGrowth = 0; // bytes the process grew by, from when the buttons were shown
+	};
+
+	PluginSimulator(const std::vector<streamdecksession::button_t>& buttons, const time_t startTime);
+	~PluginSimulator();
+
+	void run(const std::chrono::seconds duration);
+	simulationStats_t getStats();
+
+	InMemoryTransport& getTransport() { return *mTransport; }
+	time_t now() { return mClock.now(); }
+
+	static double getCpuSeconds();
+	static size_t getMemoryBytes();
+
+private:
+	VirtualClock mClock;
+
+	// the plugin's timers send through the transport, so the plugin is declared last to go first
+	std::unique_ptr<InMemoryTransport> mTransport;
+	std::unique_ptr<FFXIVOceanFishingTrackerPlugin> mPlugin;
+
+	// where the measurements start from, once the buttons are shown
+	time_t mStartTime = 0;
+	uint64_t mStartMessages = 0;
+	uint64_t mStartBytes = 0;
+	uint64_t mStartWakeups = 0;
+	size_t mStartMemory = 0;
+
+	double mWallSeconds = 0.0;
+	double mCpuSeconds = 0.0;
+};
@@ -0,0 +1,151 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../ButtonCanvas.h"
+#include "../IconCompositor.h"
+#include "../../Vendor/lodepng/lodepng.h"
+
+namespace ButtonCanvasTests
+{
+    const std::string iconDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/Icons/";
+
+    std::vector<uint8_t> decode(const std::vector<uint8_t>& png, const uint32_t size)
+    {
+        std::vector<uint8_t> rgba;
+        unsigned width = 0;
+        unsigned height = 0;
+        EXPECT_EQ(lodepng::decode(rgba, width, height, png), 0);
+        EXPECT_EQ(width, size);
+        EXPECT_EQ(height, size);
+        return rgba;
+    }
+
+    size_t countDifferentPixels(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+    {
+        size_t count = 0;
+        for (size_t i = 0; i + 4 <= (std::min)(a.size(), b.size()); i += 4)
+            if (!std::equal(a.begin() + i, a.begin() + i + 4, b.begin() + i))
+                count++;
+        return count;
+    }
+
+    class ButtonCanvasTestFixture : public ::testing::TestWithParam<uint32_t>
+    {
+    protected:
+        IconCompositor::icon_t mIcon;
+
+        void SetUp()
+        {
+            IconCompositor compositor(iconDirectory);
+            std::optional<IconCompositor::icon_t> icon = compositor.composePixels("Hafgufa");
+            ASSERT_TRUE(icon);
+            mIcon = std::move(*icon);
+        }
+    };
+
+    TEST_P(ButtonCanvasTestFixture, EveryModeDecodesToThePixels) {
+        const uint32_t size = GetParam();
+        ButtonCanvas canvas(size);
+        canvas.setBackground(mIcon.rgba.data(), mIcon.width, mIcon.height);
+        canvas.setProgress(0.3f);
+        canvas.setHighlight(true);
+
+        for (const ButtonCanvas::ENCODE_MODE mode : {
+            ButtonCanvas::ENCODE_MODE::STORED,
+            ButtonCanvas::ENCODE_MODE::FAST,
+            ButtonCanvas::ENCODE_MODE::DEFAULT })
+            EXPECT_EQ(decode(canvas.encodePng(mode), size), canvas.getPixels());
+    }
+
+    // the stored png is only patched with the changed rows, so it must still match after many redraws
+    TEST_P(ButtonCanvasTestFixture, StoredPngFollowsRedraws) {
+        const uint32_t size = GetParam();
+        ButtonCanvas canvas(size);
+        canvas.setBackground(mIcon.rgba.data(), mIcon.width, mIcon.height);
+        EXPECT_EQ(decode(canvas.encodePng(ButtonCanvas::ENCODE_MODE::STORED), size), canvas.getPixels());
+
+        for (const float progress : { 0.1f, 0.5f, 0.45f, 1.0f, 0.0f, 0.75f })
+        {
+            canvas.setProgress(progress);
+            canvas.setHighlight(progress > 0.5f);
+            EXPECT_EQ(decode(canvas.encodePng(ButtonCanvas::ENCODE_MODE::STORED), size), canvas.getPixels());
+        }
+    }
+
+    TEST_P(ButtonCanvasTestFixture, ProgressOnlyDrawsTheRing) {
+        const uint32_t size = GetParam();
+        ButtonCanvas canvas(size);
+        canvas.setBackground(mIcon.rgba.data(), mIcon.width, mIcon.height);
+        const std::vector<uint8_t> background = canvas.getPixels();
+
+        canvas.setProgress(0.25f);
+        const std::vector<uint8_t> quarter = canvas.getPixels();
+        const size_t quarterPixels = countDifferentPixels(background, quarter);
+        EXPECT_GT(quarterPixels, 0);
+
+        // the first quarter turn is the top right of the button
+        for (uint32_t y = 0; y < size; y++)
+            for (uint32_t x = 0; x < size; x++)
+                if (x < size / 2 || y >= size / 2)
+                    EXPECT_TRUE(std::equal(background.begin() + (y * size + x) * 4, background.begin() + (y * size + x + 1) * 4,
+                        quarter.begin() + (y * size + x) * 4)) << x << "," << y;
+
+        canvas.setProgress(1.0f);
+        EXPECT_NEAR(static_cast<double>(countDifferentPixels(background, canvas.getPixels())), quarterPixels * 4.0, quarterPixels * 0.1);
+
+        // emptying the ring puts the icon back
+        canvas.setProgress(0.0f);
+        EXPECT_EQ(canvas.getPixels(), background);
+    }
+
+    TEST_P(ButtonCanvasTestFixture, HighlightFramesTheEdge) {
+        const uint32_t size = GetParam();
+        ButtonCanvas canvas(size);
+        canvas.setBackground(mIcon.rgba.data(), mIcon.width, mIcon.height);
+        const std::vector<uint8_t> background = canvas.getPixels();
+
+        canvas.setHighlight(true);
+        const std::vector<uint8_t>& pixels = canvas.getPixels();
+        EXPECT_FALSE(std::equal(pixels.begin(), pixels.begin() + 4, background.begin()));
+        const size_t center = (size / 2 * size + size / 2) * 4;
+        EXPECT_TRUE(std::equal(pixels.begin() + center, pixels.begin() + center + 4, background.begin() + center));
+
+        canvas.setHighlight(false);
+        EXPECT_EQ(canvas.getPixels(), background);
+    }
+
+    TEST_P(ButtonCanvasTestFixture, TracksChanges) {
+        ButtonCanvas canvas(GetParam());
+        EXPECT_TRUE(canvas.hasChanged());
+        canvas.encodePng(ButtonCanvas::ENCODE_MODE::FAST);
+        EXPECT_FALSE(canvas.hasChanged());
+
+        // progress too small to fill a pixel, or the same highlight, is not a change
+        canvas.setProgress(0.0f);
+        canvas.setHighlight(false);
+        EXPECT_FALSE(canvas.hasChanged());
+
+        canvas.setProgress(0.5f);
+        EXPECT_TRUE(canvas.hasChanged());
+        canvas.encodePng(ButtonCanvas::ENCODE_MODE::STORED);
+        EXPECT_FALSE(canvas.hasChanged());
+        canvas.setProgress(0.5f);
+        EXPECT_FALSE(canvas.hasChanged());
+    }
+
+    TEST_P(ButtonCanvasTestFixture, StoredIsLargestDefaultIsSmallest) {
+        ButtonCanvas canvas(GetParam());
+        canvas.setBackground(mIcon.rgba.data(), mIcon.width, mIcon.height);
+        canvas.setProgress(0.6f);
+
+        const size_t stored = canvas.encodePng(ButtonCanvas::ENCODE_MODE::STORED).size();
+        const size_t fast = canvas.encodePng(ButtonCanvas::ENCODE_MODE::FAST).size();
+        const size_t smallest = canvas.encodePng(ButtonCanvas::ENCODE_MODE::DEFAULT).size();
+        EXPECT_GT(stored, fast);
+        EXPECT_GE(fast, smallest);
+    }
+
+    // the Stream Deck's standard and high dpi key sizes, plus a size whose stored png needs several deflate blocks
+    INSTANTIATE_TEST_CASE_P(ButtonCanvasTests, ButtonCanvasTestFixture, ::testing::Values(72, 144, 200));
+}
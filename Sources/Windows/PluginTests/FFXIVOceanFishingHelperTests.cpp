@@ -111,6 +111,19 @@ namespace FFXIVOceanFishingHelperTests
 		EXPECT_EQ(trackers, defaultTrackers);
 	}
 
+	TEST_F(FFXIVOceanFishingHelperTests, GetImageAliases) {
+		const std::unordered_map<std::string, std::string> imageAliases = mFFXIVOceanFishingHelper->getImageAliases();
+
+		// both routes are included
+		EXPECT_EQ(imageAliases.at("Hafg"), "Hafgufa");
+		EXPECT_EQ(imageAliases.at("Elas"), "Elasmosaurus");
+		EXPECT_EQ(imageAliases.at("Glass"), "Glass Dragon");
+		EXPECT_EQ(imageAliases.at("Jewel"), "Jewel of Plum Spring");
+
+		// fish without a short name are left out
+		EXPECT_FALSE(imageAliases.contains("Casket Oyster"));
+	}
+
 	class FFXIVOceanFishingHelperNoVoyageFixture :
 		public FFXIVOceanFishingHelperBase,
 		public ::testing::TestWithParam<
@@ -278,4 +278,54 @@ namespace FFXIVOceanFishingProcessorTests
         EXPECT_EQ(imageName, std::get<0>(GetParam()));
         EXPECT_EQ(buttonLabel, std::get<1>(GetParam()));
     }
+
+    class GetSecondsUntilNextStateChangeTestFixture :
+        public FFXIVOceanFishingProcessorBase,
+        public ::testing::TestWithParam<
+        ::testing::tuple<
+        uint32_t,
+        time_t,
+        std::unordered_set<uint32_t>,
+        uint32_t>>
+    {
+    protected:
+        void SetUp()
+        {
+            mFFXIVOceanFishingProcessor.reset(new FFXIVOceanFishingProcessor(j));
+        }
+    };
+
+    // 7200 * 3 is the start of a window for voyage 1, the next voyage 1 is at 7200 * 6
+    INSTANTIATE_TEST_CASE_P(
+        GetSecondsUntilNextStateChangeTest,
+        GetSecondsUntilNextStateChangeTestFixture,
+        ::testing::Values(
+            std::make_tuple(900, 7200 * 3, std::unordered_set<uint32_t>({ 1 }), 0), // window closes before the next voyage
+            std::make_tuple(840, 7200 * 3 + 60, std::unordered_set<uint32_t>({ 1 }), 0),
+            std::make_tuple(7200, 7200 * 3, std::unordered_set<uint32_t>({ 2 }), 0), // not in a window, next voyage starts
+            std::make_tuple(7200 * 2, 7200 * 3, std::unordered_set<uint32_t>({ 3 }), 0),
+            std::make_tuple(900, 7200 * 3, std::unordered_set<uint32_t>({ 1 }), 1), // skipped window closing changes the skip result
+            std::make_tuple(7200 + 900, 7200 * 3, std::unordered_set<uint32_t>({ 2 }), 1) // skipped window has not started yet
+        )
+    );
+
+    TEST_P(GetSecondsUntilNextStateChangeTestFixture, GetSecondsUntilNextStateChangeTest) {
+        uint32_t secondsTillStateChange = 0;
+        ASSERT_TRUE(mFFXIVOceanFishingProcessor->getSecondsUntilNextStateChange(
+            secondsTillStateChange,
+            std::get<1>(GetParam()),
+            std::get<2>(GetParam()),
+            std::get<3>(GetParam())));
+        EXPECT_EQ(secondsTillStateChange, std::get<0>(GetParam()));
+    }
+
+    TEST_P(GetSecondsUntilNextStateChangeTestFixture, NoVoyagesTest) {
+        uint32_t secondsTillStateChange = 0;
+        EXPECT_FALSE(mFFXIVOceanFishingProcessor->getSecondsUntilNextStateChange(
+            secondsTillStateChange,
+            std::get<1>(GetParam()),
+            {},
+            std::get<3>(GetParam())));
+        EXPECT_EQ(secondsTillStateChange, UINT32_MAX);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,127 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../IconCompositor.h"
+#include "../../Vendor/lodepng/lodepng.h"
+
+namespace IconCompositorTests
+{
+    const std::string iconDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/Icons/";
+
+    const IconCompositor::imageAliases_t imageAliases = {
+        { "Hafg", "Hafgufa" },
+        { "Elas", "Elasmosaurus" },
+        { "Soth", "Sothis" }
+    };
+
+    struct decoded_t
+    {
+        std::vector<uint8_t> rgba;
+        unsigned width = 0;
+        unsigned height = 0;
+    };
+
+    decoded_t decode(const std::vector<uint8_t>& png)
+    {
+        decoded_t decoded;
+        EXPECT_EQ(lodepng::decode(decoded.rgba, decoded.width, decoded.height, png), 0);
+        return decoded;
+    }
+
+    decoded_t decodeFile(const std::string& imageName)
+    {
+        decoded_t decoded;
+        EXPECT_EQ(lodepng::decode(decoded.rgba, decoded.width, decoded.height, iconDirectory + imageName + ".png"), 0);
+        return decoded;
+    }
+
+    // checks the columns [dstStart, dstStart + width) of image match the columns [srcStart, srcStart + width) of tile
+    bool isSliceOf(const decoded_t& image, const unsigned dstStart, const decoded_t& tile, const unsigned srcStart, const unsigned width)
+    {
+        for (unsigned y = 0; y < image.height; y++)
+            if (!std::equal(
+                image.rgba.begin() + (y * image.width + dstStart) * 4,
+                image.rgba.begin() + (y * image.width + dstStart + width) * 4,
+                tile.rgba.begin() + (y * tile.width + srcStart) * 4))
+                return false;
+        return true;
+    }
+
+    class GetTileNamesTestFixture :
+        public ::testing::TestWithParam<std::tuple<std::string, bool, std::vector<std::string>>>
+    {
+    };
+
+    INSTANTIATE_TEST_CASE_P(
+        GetTileNamesTest,
+        GetTileNamesTestFixture,
+        ::testing::Values(
+            std::make_tuple("Hafg-Elas-X", true, std::vector<std::string>{ "Hafgufa", "Elasmosaurus" }),
+            std::make_tuple("X-Soth-Elas", true, std::vector<std::string>{ "Sothis", "Elasmosaurus" }),
+            std::make_tuple("Balloon-Manta", true, std::vector<std::string>{ "Balloon", "Manta" }),
+            std::make_tuple("Hafgufa", true, std::vector<std::string>{ "Hafgufa" }),
+            // icon names containing the delimiter
+            std::make_tuple("Un-Namazu-X-Hafg", true, std::vector<std::string>{ "Un-Namazu", "Hafgufa" }),
+            std::make_tuple("Black-jawed Helicoprion-Balloon", true, std::vector<std::string>{ "Black-jawed Helicoprion", "Balloon" }),
+            std::make_tuple("X-X-X", false, std::vector<std::string>{}),
+            std::make_tuple("Hafg-Nope-X", false, std::vector<std::string>{ "Hafgufa" }),
+            std::make_tuple("", false, std::vector<std::string>{})
+        )
+    );
+
+    TEST_P(GetTileNamesTestFixture, GetTileNames) {
+        const auto& [imageName, expectedResult, expectedTileNames] = GetParam();
+        IconCompositor compositor(iconDirectory, imageAliases);
+
+        std::vector<std::string> tileNames;
+        EXPECT_EQ(compositor.getTileNames(tileNames, imageName), expectedResult);
+        if (expectedResult)
+            EXPECT_EQ(tileNames, expectedTileNames);
+    }
+
+    // two icons each keep their middle half, same as shaving 25px off both sides and appending
+    TEST(IconCompositorTests, ComposesPattern) {
+        IconCompositor compositor(iconDirectory, imageAliases);
+        const std::optional<std::vector<uint8_t>> png = compositor.compose("Hafg-Elas-X");
+        ASSERT_TRUE(png);
+
+        const decoded_t image = decode(*png);
+        ASSERT_EQ(image.width, 100);
+        ASSERT_EQ(image.height, 100);
+        EXPECT_TRUE(isSliceOf(image, 0, decodeFile("Hafgufa"), 25, 50));
+        EXPECT_TRUE(isSliceOf(image, 50, decodeFile("Elasmosaurus"), 25, 50));
+    }
+
+    TEST(IconCompositorTests, ComposesThreeIcons) {
+        IconCompositor compositor(iconDirectory, imageAliases);
+        const std::optional<std::vector<uint8_t>> png = compositor.compose("Hafg-Elas-Soth");
+        ASSERT_TRUE(png);
+
+        const decoded_t image = decode(*png);
+        ASSERT_EQ(image.width, 100);
+        EXPECT_TRUE(isSliceOf(image, 0, decodeFile("Hafgufa"), 33, 33));
+        EXPECT_TRUE(isSliceOf(image, 33, decodeFile("Elasmosaurus"), 33, 33));
+        EXPECT_TRUE(isSliceOf(image, 66, decodeFile("Sothis"), 33, 34));
+    }
+
+    TEST(IconCompositorTests, SingleIconIsUnchanged) {
+        IconCompositor compositor(iconDirectory, imageAliases);
+        const std::optional<std::vector<uint8_t>> png = compositor.compose("X-Hafg-X");
+        ASSERT_TRUE(png);
+
+        const decoded_t image = decode(*png);
+        const decoded_t tile = decodeFile("Hafgufa");
+        EXPECT_EQ(image.rgba, tile.rgba);
+    }
+
+    TEST(IconCompositorTests, MismatchedSizes) {
+        IconCompositor compositor(iconDirectory, imageAliases);
+        EXPECT_FALSE(compositor.compose("default-Hafg"));
+    }
+
+    TEST(IconCompositorTests, UnknownIcon) {
+        IconCompositor compositor(iconDirectory, imageAliases);
+        EXPECT_FALSE(compositor.compose("Hafg-Nope"));
+    }
+}
@@ -0,0 +1,77 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "../IconPack.h"
+#include "../ImageUtils.h"
+
+namespace IconPackTests
+{
+    const std::string pluginDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/";
+
+    std::string writeTempPack(const std::string& contents)
+    {
+        const std::string path = (std::filesystem::temp_directory_path() / "IconPackTests.pack").string();
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        ofs << contents;
+        return path;
+    }
+
+    // the shipped pack must hold exactly what encoding the shipped icons would give, if not rerun Devtools/createIconPack.sh
+    TEST(IconPackTests, MatchesIcons) {
+        const IconPack iconPack(pluginDirectory + "Icons.pack");
+        ASSERT_TRUE(iconPack.isInit()) << iconPack.getErrorMessage();
+
+        size_t iconCount = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(pluginDirectory + "Icons/"))
+        {
+            if (entry.path().extension() != ".png") continue;
+            std::ifstream ifs(entry.path(), std::ios::binary);
+            const std::vector<uint8_t> png((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+            std::string expected = "data:image/png;base64,";
+            imageutils::pngToBase64(expected, png);
+
+            const std::optional<std::string_view> dataUri = iconPack.find(entry.path().stem().string());
+            ASSERT_TRUE(dataUri) << entry.path();
+            EXPECT_EQ(*dataUri, expected) << entry.path();
+            iconCount++;
+        }
+        EXPECT_EQ(iconPack.size(), iconCount);
+    }
+
+    TEST(IconPackTests, SmallPack) {
+        const IconPack iconPack(writeTempPack("FFXIVICONPACK 1\n2\n0 3 a\n4 5 b c\nabc\ndefgh\n"));
+        ASSERT_TRUE(iconPack.isInit()) << iconPack.getErrorMessage();
+        EXPECT_EQ(iconPack.size(), 2);
+        EXPECT_EQ(iconPack.find("a"), "abc");
+        EXPECT_EQ(iconPack.find("b c"), "defgh");
+        EXPECT_EQ(iconPack.find("d"), std::nullopt);
+    }
+
+    TEST(IconPackTests, MissingFile) {
+        const IconPack iconPack(pluginDirectory + "Does not exist.pack");
+        EXPECT_FALSE(iconPack.isInit());
+        EXPECT_EQ(iconPack.find("default"), std::nullopt);
+    }
+
+    TEST(IconPackTests, BadMagic) {
+        const IconPack iconPack(writeTempPack("NOTAPACK 1\n0\n"));
+        EXPECT_FALSE(iconPack.isInit());
+    }
+
+    TEST(IconPackTests, TruncatedIndex) {
+        const IconPack iconPack(writeTempPack("FFXIVICONPACK 1\n2\n0 3 a\n"));
+        EXPECT_FALSE(iconPack.isInit());
+        EXPECT_EQ(iconPack.size(), 0);
+    }
+
+    TEST(IconPackTests, EntryOutOfBounds) {
+        const IconPack iconPack(writeTempPack("FFXIVICONPACK 1\n1\n0 30 a\nabc\n"));
+        EXPECT_FALSE(iconPack.isInit());
+        EXPECT_EQ(iconPack.find("a"), std::nullopt);
+    }
+}
@@ -0,0 +1,289 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <vector>
+#include "../ImageLoader.h"
+#include "../ImageUtils.h"
+#include "../../Vendor/lodepng/lodepng.h"
+
+namespace ImageLoaderTests
+{
+    const std::string iconDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/Icons/";
+
+    std::string expectedDataUri(const std::string& imageName)
+    {
+        std::ifstream ifs(iconDirectory + imageName + ".png", std::ios::binary);
+        const std::vector<uint8_t> png((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+        std::string dataUri = "data:image/png;base64,";
+        imageutils::pngToBase64(dataUri, png);
+        return dataUri;
+    }
+
+    // decodes a data URI back into the png it holds
+    std::vector<uint8_t> decodeDataUri(const std::string& dataUri)
+    {
+        const std::string prefix = "data:image/png;base64,";
+        EXPECT_TRUE(dataUri.starts_with(prefix));
+        std::vector<uint8_t> png;
+        uint32_t bits = 0;
+        int bitCount = 0;
+        for (size_t i = prefix.size(); i < dataUri.size() && dataUri[i] != '='; i++)
+        {
+            bits = (bits << 6) | static_cast<uint32_t>(imageutils::BASE64.find(dataUri[i]));
+            bitCount += 6;
+            if (bitCount >= 8)
+            {
+                bitCount -= 8;
+                png.push_back(static_cast<uint8_t>(bits >> bitCount));
+            }
+        }
+        return png;
+    }
+
+    class ImageLoaderTestFixture : public ::testing::Test
+    {
+    protected:
+        std::mutex mMutex;
+        std::condition_variable mCondition;
+        std::vector<std::pair<std::string, ImageLoader::image_t>> mLoaded;
+        std::unique_ptr<ImageLoader> mImageLoader;
+
+        void SetUp()
+        {
+            createLoader(ImageLoader::DEFAULT_BYTE_BUDGET);
+        }
+
+        void createLoader(const size_t byteBudget)
+        {
+            mImageLoader.reset();
+            mImageLoader.reset(new ImageLoader(iconDirectory,
+                [this](const std::string& imageName, const uint32_t /*size*/, const ImageLoader::image_t& dataUri)
+                {
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mLoaded.emplace_back(imageName, dataUri);
+                    mCondition.notify_all();
+                }, byteBudget));
+        }
+
+        // waits for the callback of the count-th image loaded since the loader was made
+        ImageLoader::image_t waitForLoad(const size_t count = 1)
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            if (!mCondition.wait_for(lock, std::chrono::seconds(5), [&]() { return mLoaded.size() >= count; }))
+                return std::make_shared<const std::string>("timed out");
+            return mLoaded[count - 1].second;
+        }
+
+        // loads an image and waits for it to be cached
+        void load(const std::string& imageName, const size_t count)
+        {
+            mImageLoader->prefetch(imageName);
+            waitForLoad(count);
+        }
+
+        // asks for decoded pixels until the loader has them, there is no callback for pixels
+        ImageLoader::pixels_t waitForPixels(const std::string& imageName, const uint32_t size)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            ImageLoader::pixels_t pixels = mImageLoader->getOrLoadPixels(imageName, size);
+            while (!pixels && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                pixels = mImageLoader->getOrLoadPixels(imageName, size);
+            }
+            return pixels;
+        }
+    };
+
+    TEST_F(ImageLoaderTestFixture, LoadsInBackgroundThenCaches) {
+        const std::string imageName = "Hafgufa";
+        ASSERT_FALSE(mImageLoader->getOrLoad(imageName));
+
+        const std::string expected = expectedDataUri(imageName);
+        const ImageLoader::image_t loaded = waitForLoad();
+        ASSERT_TRUE(loaded);
+        EXPECT_EQ(*loaded, expected);
+
+        // hits hand out the cached buffer itself, not a copy
+        const ImageLoader::image_t cached = mImageLoader->getOrLoad(imageName);
+        EXPECT_EQ(cached, loaded);
+
+        const ImageLoader::cacheStats_t stats = mImageLoader->getStats();
+        EXPECT_EQ(stats.hits, 1);
+        EXPECT_EQ(stats.misses, 1);
+        EXPECT_EQ(stats.evictions, 0);
+        EXPECT_EQ(stats.entries, 1);
+        EXPECT_EQ(stats.bytes, expected.size());
+    }
+
+    TEST_F(ImageLoaderTestFixture, MissingImage) {
+        ASSERT_FALSE(mImageLoader->getOrLoad("Does not exist"));
+        EXPECT_EQ(waitForLoad(), nullptr);
+        EXPECT_EQ(mImageLoader->getStats().entries, 0);
+    }
+
+    TEST_F(ImageLoaderTestFixture, EvictsLeastRecentlyUsed) {
+        const size_t a = expectedDataUri("Hafgufa").size();
+        const size_t b = expectedDataUri("Balloon").size();
+        const size_t c = expectedDataUri("Bareface").size();
+        createLoader(a + b + c - 1);
+
+        load("Hafgufa", 1);
+        load("Balloon", 2);
+
+        // touching Hafgufa makes Balloon the least recently used, so it goes when Bareface no longer fits
+        const ImageLoader::image_t held = mImageLoader->getOrLoad("Balloon");
+        ASSERT_TRUE(mImageLoader->getOrLoad("Hafgufa"));
+        load("Bareface", 3);
+
+        ImageLoader::cacheStats_t stats = mImageLoader->getStats();
+        EXPECT_EQ(stats.evictions, 1);
+        EXPECT_EQ(stats.entries, 2);
+        EXPECT_EQ(stats.bytes, a + c);
+        EXPECT_TRUE(mImageLoader->getOrLoad("Hafgufa"));
+        EXPECT_TRUE(mImageLoader->getOrLoad("Bareface"));
+        EXPECT_FALSE(mImageLoader->getOrLoad("Balloon"));
+
+        // an evicted image stays valid for whoever still holds it
+        ASSERT_TRUE(held);
+        EXPECT_EQ(*held, expectedDataUri("Balloon"));
+    }
+
+    TEST_F(ImageLoaderTestFixture, KeepsImageLargerThanBudget) {
+        createLoader(1);
+
+        load("Hafgufa", 1);
+        EXPECT_TRUE(mImageLoader->getOrLoad("Hafgufa"));
+
+        load("Balloon", 2);
+        const ImageLoader::cacheStats_t stats = mImageLoader->getStats();
+        EXPECT_EQ(stats.entries, 1);
+        EXPECT_EQ(stats.evictions, 1);
+        EXPECT_TRUE(mImageLoader->getOrLoad("Balloon"));
+    }
+
+    // combined icons without a file of their own are composed from the single icons
+    TEST_F(ImageLoaderTestFixture, ComposesMissingPattern) {
+        mImageLoader.reset();
+        mImageLoader.reset(new ImageLoader(iconDirectory,
+            [this](const std::string& imageName, const uint32_t /*size*/, const ImageLoader::image_t& dataUri)
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mLoaded.emplace_back(imageName, dataUri);
+                mCondition.notify_all();
+            }, ImageLoader::DEFAULT_BYTE_BUDGET, { { "Hafg", "Hafgufa" }, { "Elas", "Elasmosaurus" } }));
+
+        ASSERT_FALSE(mImageLoader->getOrLoad("Hafg-Elas-X"));
+        const ImageLoader::image_t loaded = waitForLoad();
+        ASSERT_TRUE(loaded);
+        EXPECT_TRUE(loaded->starts_with("data:image/png;base64,"));
+        EXPECT_EQ(mImageLoader->getOrLoad("Hafg-Elas-X"), loaded);
+    }
+
+    TEST_F(ImageLoaderTestFixture, ShrinksToKeySize) {
+        ASSERT_FALSE(mImageLoader->getOrLoad("Hafgufa", 72));
+        const ImageLoader::image_t loaded = waitForLoad();
+        ASSERT_TRUE(loaded);
+        EXPECT_LT(loaded->size(), expectedDataUri("Hafgufa").size());
+
+        std::vector<uint8_t> rgba;
+        unsigned width = 0;
+        unsigned height = 0;
+        ASSERT_EQ(lodepng::decode(rgba, width, height, decodeDataUri(*loaded)), 0);
+        EXPECT_EQ(width, 72);
+        EXPECT_EQ(height, 72);
+    }
+
+    // each size is its own cache entry, and the icon as shipped is still there for unknown devices
+    TEST_F(ImageLoaderTestFixture, CachesEachSize) {
+        load("Hafgufa", 1);
+        mImageLoader->prefetch("Hafgufa", 72);
+        waitForLoad(2);
+        mImageLoader->prefetch("Hafgufa", 144);
+        waitForLoad(3);
+
+        const ImageLoader::image_t original = mImageLoader->getOrLoad("Hafgufa");
+        const ImageLoader::image_t small = mImageLoader->getOrLoad("Hafgufa", 72);
+        ASSERT_TRUE(original);
+        ASSERT_TRUE(small);
+        EXPECT_EQ(*original, expectedDataUri("Hafgufa"));
+        EXPECT_NE(*small, *original);
+        EXPECT_EQ(mImageLoader->getStats().entries, 3);
+    }
+
+    // an icon that already fits the key is never enlarged, and never sent bigger than shipped
+    TEST_F(ImageLoaderTestFixture, KeepsIconThatFits) {
+        mImageLoader->prefetch("Hafgufa", 144);
+        const ImageLoader::image_t loaded = waitForLoad();
+        ASSERT_TRUE(loaded);
+        EXPECT_LE(loaded->size(), expectedDataUri("Hafgufa").size());
+
+        std::vector<uint8_t> rgba;
+        unsigned width = 0;
+        unsigned height = 0;
+        ASSERT_EQ(lodepng::decode(rgba, width, height, decodeDataUri(*loaded)), 0);
+        EXPECT_EQ(width, 100);
+        EXPECT_EQ(height, 100);
+
+        std::vector<uint8_t> original;
+        unsigned originalWidth = 0;
+        unsigned originalHeight = 0;
+        ASSERT_EQ(lodepng::decode(original, originalWidth, originalHeight, iconDirectory + "Hafgufa.png"), 0);
+        EXPECT_EQ(rgba, original);
+    }
+
+    // live images are drawn over pixels decoded on the loader thread, shrunk to the key
+    TEST_F(ImageLoaderTestFixture, DecodesPixelsInBackground) {
+        ASSERT_FALSE(mImageLoader->getOrLoadPixels("Hafgufa", 72));
+        const ImageLoader::pixels_t pixels = waitForPixels("Hafgufa", 72);
+        ASSERT_TRUE(pixels);
+        EXPECT_EQ(pixels->width, 72);
+        EXPECT_EQ(pixels->height, 72);
+        EXPECT_EQ(pixels->rgba.size(), 72 * 72 * 4);
+        EXPECT_EQ(mImageLoader->getOrLoadPixels("Hafgufa", 72), pixels);
+
+        // the data URI of the same icon is its own entry
+        ASSERT_FALSE(mImageLoader->getOrLoad("Hafgufa", 72));
+        EXPECT_EQ(mImageLoader->getStats().bytes, pixels->rgba.size() + waitForLoad()->size());
+    }
+
+    // a wide icon keeps its shape, shrunk to fit the key and centred between transparent bands, as the canvas fills the key with it
+    TEST_F(ImageLoaderTestFixture, CentresNonSquarePixels) {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "ImageLoaderTestsWide";
+        std::filesystem::create_directories(directory);
+        const std::vector<uint8_t> red = { 255, 0, 0, 255 };
+        std::vector<uint8_t> rgba;
+        for (size_t i = 0; i < 200 * 100; i++)
+            rgba.insert(rgba.end(), red.begin(), red.end());
+        ASSERT_EQ(lodepng::encode((directory / "Wide.png").string(), rgba, 200, 100), 0);
+        mImageLoader.reset(new ImageLoader(directory.string() + "/", [](const std::string&, const uint32_t, const ImageLoader::image_t&) {}));
+
+        const ImageLoader::pixels_t pixels = waitForPixels("Wide", 72);
+        ASSERT_TRUE(pixels);
+        ASSERT_EQ(pixels->width, 72);
+        ASSERT_EQ(pixels->height, 72);
+        const auto alphaAt = [&](const size_t x, const size_t y) { return pixels->rgba[(y * 72 + x) * 4 + 3]; };
+        EXPECT_EQ(alphaAt(36, 0), 0);
+        EXPECT_EQ(alphaAt(36, 17), 0);
+        EXPECT_EQ(alphaAt(0, 18), 255);
+        EXPECT_EQ(alphaAt(71, 53), 255);
+        EXPECT_EQ(alphaAt(36, 54), 0);
+        EXPECT_EQ(alphaAt(36, 71), 0);
+
+        mImageLoader.reset();
+        std::filesystem::remove_all(directory);
+    }
+
+    // a missing icon is remembered, so drawing does not try to load it on every frame
+    TEST_F(ImageLoaderTestFixture, RemembersMissingPixels) {
+        const ImageLoader::pixels_t pixels = waitForPixels("Does not exist", 72);
+        ASSERT_TRUE(pixels);
+        EXPECT_TRUE(pixels->rgba.empty());
+        EXPECT_EQ(mImageLoader->getOrLoadPixels("Does not exist", 72), pixels);
+    }
+}
@@ -0,0 +1,72 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../ImageSendFilter.h"
+
+namespace ImageSendFilterTests
+{
+    TEST(ImageSendFilterTests, FirstImageIsSent) {
+        ImageSendFilter filter;
+        EXPECT_TRUE(filter.shouldSend("data:image/png;base64,AAAA"));
+    }
+
+    TEST(ImageSendFilterTests, SameImageIsSkipped) {
+        ImageSendFilter filter;
+        const std::string image = "data:image/png;base64,AAAA";
+        ASSERT_TRUE(filter.shouldSend(image));
+        EXPECT_FALSE(filter.shouldSend(image));
+
+        // matched by content, not by buffer
+        EXPECT_FALSE(filter.shouldSend(std::string(image)));
+    }
+
+    TEST(ImageSendFilterTests, ChangedImageIsSent) {
+        ImageSendFilter filter;
+        ASSERT_TRUE(filter.shouldSend("data:image/png;base64,AAAA"));
+        EXPECT_TRUE(filter.shouldSend("data:image/png;base64,BBBB"));
+        EXPECT_TRUE(filter.shouldSend("data:image/png;base64,AAAA"));
+    }
+
+    TEST(ImageSendFilterTests, EmptyImageIsTracked) {
+        ImageSendFilter filter;
+        ASSERT_TRUE(filter.shouldSend("data:image/png;base64,AAAA"));
+        EXPECT_TRUE(filter.shouldSend(""));
+        EXPECT_FALSE(filter.shouldSend(""));
+    }
+
+    TEST(ImageSendFilterTests, ResetSendsAgain) {
+        ImageSendFilter filter;
+        ASSERT_TRUE(filter.shouldSend("data:image/png;base64,AAAA"));
+        filter.reset();
+        EXPECT_TRUE(filter.shouldSend("data:image/png;base64,AAAA"));
+    }
+
+    TEST(ImageSendFilterTests, HiddenFilterComesBackOnce) {
+        HiddenImageSendFilters hidden;
+        ImageSendFilter filter;
+        ASSERT_TRUE(filter.shouldSend("data:image/png;base64,AAAA"));
+        hidden.hide("ctx", filter);
+        EXPECT_EQ(hidden.size(), 1);
+
+        std::optional<ImageSendFilter> restored = hidden.reappear("ctx");
+        ASSERT_TRUE(restored.has_value());
+        EXPECT_FALSE(restored->shouldSend("data:image/png;base64,AAAA"));
+        EXPECT_FALSE(hidden.reappear("ctx").has_value());
+        EXPECT_EQ(hidden.size(), 0);
+    }
+
+    TEST(ImageSendFilterTests, LongestHiddenContextsAreDropped) {
+        HiddenImageSendFilters hidden(2);
+        ImageSendFilter filter;
+        hidden.hide("a", filter);
+        hidden.hide("b", filter);
+        // hiding a context again makes it the most recently hidden
+        hidden.hide("a", filter);
+        hidden.hide("c", filter);
+        EXPECT_EQ(hidden.size(), 2);
+        EXPECT_FALSE(hidden.reappear("b").has_value());
+        EXPECT_TRUE(hidden.reappear("a").has_value());
+        EXPECT_TRUE(hidden.reappear("c").has_value());
+    }
+}
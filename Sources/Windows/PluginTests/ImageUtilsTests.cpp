@@ -0,0 +1,149 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <vector>
+#include "../ImageUtils.h"
+#include "../../Vendor/lodepng/lodepng.h"
+
+namespace ImageUtilsTests
+{
+    const std::string iconDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/Icons/";
+
+    const std::vector<imageutils::BASE64_KERNEL> kernels = {
+        imageutils::BASE64_KERNEL::AUTO,
+        imageutils::BASE64_KERNEL::SCALAR,
+        imageutils::BASE64_KERNEL::SSSE3,
+        imageutils::BASE64_KERNEL::AVX2
+    };
+
+    // the original lodepng example encoder, the kernels must match it exactly
+    std::string referenceBase64(const std::vector<uint8_t>& in)
+    {
+        std::string out;
+        for (size_t i = 0; i < in.size(); i += 3) {
+            int v = 65536 * in[i];
+            if (i + 1 < in.size()) v += 256 * in[i + 1];
+            if (i + 2 < in.size()) v += in[i + 2];
+            out.push_back(imageutils::BASE64[(v >> 18) & 0x3f]);
+            out.push_back(imageutils::BASE64[(v >> 12) & 0x3f]);
+            if (i + 1 < in.size()) out.push_back(imageutils::BASE64[(v >> 6) & 0x3f]);
+            else out.push_back('=');
+            if (i + 2 < in.size()) out.push_back(imageutils::BASE64[(v >> 0) & 0x3f]);
+            else out.push_back('=');
+        }
+        return out;
+    }
+
+    std::string encode(const std::vector<uint8_t>& in, const imageutils::BASE64_KERNEL kernel)
+    {
+        std::string out(imageutils::getBase64EncodedSize(in.size()), '\0');
+        imageutils::encodeBase64(out.data(), in.data(), in.size(), kernel);
+        return out;
+    }
+
+    TEST(ImageUtilsTests, EncodedSize) {
+        EXPECT_EQ(imageutils::getBase64EncodedSize(0), 0);
+        EXPECT_EQ(imageutils::getBase64EncodedSize(1), 4);
+        EXPECT_EQ(imageutils::getBase64EncodedSize(3), 4);
+        EXPECT_EQ(imageutils::getBase64EncodedSize(4), 8);
+    }
+
+    TEST(ImageUtilsTests, KnownValues) {
+        const std::string text = "foobar";
+        const std::vector<uint8_t> in(text.begin(), text.end());
+        EXPECT_EQ(encode({ in.begin(), in.begin() + 1 }, imageutils::BASE64_KERNEL::SCALAR), "Zg==");
+        EXPECT_EQ(encode({ in.begin(), in.begin() + 2 }, imageutils::BASE64_KERNEL::SCALAR), "Zm8=");
+        EXPECT_EQ(encode(in, imageutils::BASE64_KERNEL::SCALAR), "Zm9vYmFy");
+    }
+
+    // covers every tail length around the 12 and 24 byte vector steps
+    TEST(ImageUtilsTests, KernelsMatchReferenceOnAllSizes) {
+        std::mt19937 rng(5);
+        for (size_t size = 0; size < 200; size++)
+        {
+            std::vector<uint8_t> in(size);
+            for (uint8_t& b : in) b = static_cast<uint8_t>(rng());
+            const std::string expected = referenceBase64(in);
+
+            for (const imageutils::BASE64_KERNEL kernel : kernels)
+            {
+                if (!imageutils::isBase64KernelSupported(kernel)) continue;
+                EXPECT_EQ(encode(in, kernel), expected) << "size " << size << " kernel " << static_cast<int>(kernel);
+            }
+        }
+    }
+
+    TEST(ImageUtilsTests, KernelsMatchReferenceOnIcons) {
+        size_t iconCount = 0;
+        for (const auto& entry : std::filesystem::directory_iterator(iconDirectory))
+        {
+            if (entry.path().extension() != ".png") continue;
+            std::ifstream ifs(entry.path(), std::ios::binary);
+            const std::vector<uint8_t> png((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+            const std::string expected = referenceBase64(png);
+
+            for (const imageutils::BASE64_KERNEL kernel : kernels)
+            {
+                if (!imageutils::isBase64KernelSupported(kernel)) continue;
+                EXPECT_EQ(encode(png, kernel), expected) << entry.path() << " kernel " << static_cast<int>(kernel);
+            }
+            iconCount++;
+        }
+        EXPECT_GT(iconCount, 0);
+    }
+
+    TEST(ImageUtilsTests, PngToBase64Appends) {
+        const std::vector<uint8_t> in = { 'f', 'o', 'o' };
+        std::string out = "data:image/png;base64,";
+        imageutils::pngToBase64(out, in);
+        EXPECT_EQ(out, "data:image/png;base64,Zm9v");
+    }
+
+    TEST(ImageUtilsTests, ResizeAveragesArea) {
+        // a 4x2 image of two 2x2 blocks shrinks to one pixel per block
+        const std::vector<uint8_t> in = {
+            0, 0, 0, 255,   0, 0, 0, 255,   200, 100, 0, 255,   100, 100, 0, 255,
+            0, 0, 0, 255,   0, 0, 0, 255,   200, 100, 0, 255,   100, 100, 0, 255,
+        };
+        std::vector<uint8_t> out;
+        ASSERT_TRUE(imageutils::resizeRgba(out, in, 4, 2, 2, 1));
+        EXPECT_EQ(out, std::vector<uint8_t>({ 0, 0, 0, 255, 150, 100, 0, 255 }));
+    }
+
+    TEST(ImageUtilsTests, ResizeIgnoresColorOfTransparentPixels) {
+        // the black of the transparent pixel must not bleed into the white one
+        const std::vector<uint8_t> in = { 255, 255, 255, 255,   0, 0, 0, 0 };
+        std::vector<uint8_t> out;
+        ASSERT_TRUE(imageutils::resizeRgba(out, in, 2, 1, 1, 1));
+        EXPECT_EQ(out, std::vector<uint8_t>({ 255, 255, 255, 128 }));
+    }
+
+    TEST(ImageUtilsTests, ResizeRejectsBadSizes) {
+        std::vector<uint8_t> out;
+        EXPECT_FALSE(imageutils::resizeRgba(out, std::vector<uint8_t>(16), 2, 2, 0, 1));
+        EXPECT_FALSE(imageutils::resizeRgba(out, std::vector<uint8_t>(15), 2, 2, 1, 1));
+    }
+
+    TEST(ImageUtilsTests, EncodePngSmallestRoundTrips) {
+        std::vector<uint8_t> rgba;
+        unsigned width = 0;
+        unsigned height = 0;
+        ASSERT_EQ(lodepng::decode(rgba, width, height, iconDirectory + "Hafgufa.png"), 0);
+
+        std::vector<uint8_t> png;
+        ASSERT_TRUE(imageutils::encodePngSmallest(png, rgba, width, height));
+
+        std::vector<uint8_t> decoded;
+        unsigned decodedWidth = 0;
+        unsigned decodedHeight = 0;
+        ASSERT_EQ(lodepng::decode(decoded, decodedWidth, decodedHeight, png), 0);
+        EXPECT_EQ(decodedWidth, width);
+        EXPECT_EQ(decodedHeight, height);
+        EXPECT_EQ(decoded, rgba);
+    }
+}
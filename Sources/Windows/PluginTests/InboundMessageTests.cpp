@@ -0,0 +1,103 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../InboundMessage.h"
+#include "../../Common/ESDSDKDefines.h"
+
+namespace InboundMessageTests
+{
+    TEST(InboundMessageTests, MapsEveryEventName) {
+        const std::vector<std::pair<std::string, InboundMessage::EVENT>> events = {
+            { kESDSDKEventKeyDown, InboundMessage::EVENT::KEY_DOWN },
+            { kESDSDKEventKeyUp, InboundMessage::EVENT::KEY_UP },
+            { kESDSDKEventWillAppear, InboundMessage::EVENT::WILL_APPEAR },
+            { kESDSDKEventWillDisappear, InboundMessage::EVENT::WILL_DISAPPEAR },
+            { kESDSDKEventDeviceDidConnect, InboundMessage::EVENT::DEVICE_DID_CONNECT },
+            { kESDSDKEventDeviceDidDisconnect, InboundMessage::EVENT::DEVICE_DID_DISCONNECT },
+            { kESDSDKEventApplicationDidLaunch, InboundMessage::EVENT::APPLICATION_DID_LAUNCH },
+            { kESDSDKEventApplicationDidTerminate, InboundMessage::EVENT::APPLICATION_DID_TERMINATE },
+            { kESDSDKEventSystemDidWakeUp, InboundMessage::EVENT::SYSTEM_DID_WAKE_UP },
+            { kESDSDKEventTitleParametersDidChange, InboundMessage::EVENT::TITLE_PARAMETERS_DID_CHANGE },
+            { kESDSDKEventDidReceiveSettings, InboundMessage::EVENT::DID_RECEIVE_SETTINGS },
+            { kESDSDKEventDidReceiveGlobalSettings, InboundMessage::EVENT::DID_RECEIVE_GLOBAL_SETTINGS },
+            { kESDSDKEventPropertyInspectorDidAppear, InboundMessage::EVENT::PROPERTY_INSPECTOR_DID_APPEAR },
+            { kESDSDKEventPropertyInspectorDidDisappear, InboundMessage::EVENT::PROPERTY_INSPECTOR_DID_DISAPPEAR },
+            { kESDSDKEventSendToPlugin, InboundMessage::EVENT::SEND_TO_PLUGIN },
+        };
+        for (const auto& [name, event] : events)
+            EXPECT_EQ(InboundMessage::toEvent(name), event) << name;
+
+        // names sharing a slot with a real event, or close to one
+        for (const std::string name : { "", "keyDowm", "KeyDown", "keyDown ", "setTitle", "k", "sendToPropertyInspector" })
+            EXPECT_EQ(InboundMessage::toEvent(name), InboundMessage::EVENT::UNKNOWN) << name;
+    }
+
+    TEST(InboundMessageTests, ReadsTopLevelFields) {
+        const std::string message = R"({"action":"com.elgato.ffxivoceanfishing.action","event":"willAppear","context":"ABC123",)"
+            R"("device":"DEV1","payload":{"settings":{"Route":"Indigo","Name":"a \"}\" b"},"coordinates":{"column":1,"row":[0]}}})";
+        InboundMessage inbound;
+        ASSERT_TRUE(inbound.parse(message));
+        EXPECT_EQ(inbound.getEvent(), InboundMessage::EVENT::WILL_APPEAR);
+        EXPECT_EQ(inbound.getAction(), "com.elgato.ffxivoceanfishing.action");
+        EXPECT_EQ(inbound.getContext(), "ABC123");
+        EXPECT_EQ(inbound.getDevice(), "DEV1");
+        EXPECT_EQ(inbound.getPayload(), json::parse(message)[kESDSDKCommonPayload]);
+        EXPECT_TRUE(inbound.getDeviceInfo().is_null());
+    }
+
+    TEST(InboundMessageTests, ReadsDeviceInfo) {
+        const std::string message = "{ \"event\" : \"deviceDidConnect\" ,\n \"device\" : \"DEV2\",\n"
+            " \"deviceInfo\" : { \"name\": \"Stream Deck\", \"type\": 0, \"size\": { \"columns\": 5, \"rows\": 3 } } }";
+        InboundMessage inbound;
+        ASSERT_TRUE(inbound.parse(message));
+        EXPECT_EQ(inbound.getEvent(), InboundMessage::EVENT::DEVICE_DID_CONNECT);
+        EXPECT_EQ(inbound.getDevice(), "DEV2");
+        EXPECT_EQ(inbound.getDeviceInfo(), json::parse(message)[kESDSDKCommonDeviceInfo]);
+        EXPECT_TRUE(inbound.getPayload().is_null());
+    }
+
+    TEST(InboundMessageTests, UnescapesStrings) {
+        const std::string message = R"({"event":"keyDown","context":"a\"b\\c\n","payload":{}})";
+        InboundMessage inbound;
+        ASSERT_TRUE(inbound.parse(message));
+        EXPECT_EQ(inbound.getEvent(), InboundMessage::EVENT::KEY_DOWN);
+        EXPECT_EQ(inbound.getContext(), "a\"b\\c\n");
+        EXPECT_EQ(inbound.getPayload(), json::object());
+    }
+
+    // every field is cleared by the next message, even if that message does not have it
+    TEST(InboundMessageTests, ReusesBetweenMessages) {
+        InboundMessage inbound;
+        ASSERT_TRUE(inbound.parse(R"({"event":"keyUp","context":"A","device":"D","payload":{"state":1}})"));
+        EXPECT_EQ(inbound.getPayload()["state"], 1);
+        ASSERT_TRUE(inbound.parse(R"({"event":"systemDidWakeUp"})"));
+        EXPECT_EQ(inbound.getEvent(), InboundMessage::EVENT::SYSTEM_DID_WAKE_UP);
+        EXPECT_TRUE(inbound.getContext().empty());
+        EXPECT_TRUE(inbound.getDevice().empty());
+        EXPECT_TRUE(inbound.getPayload().is_null());
+        ASSERT_TRUE(inbound.parse("{}"));
+        EXPECT_EQ(inbound.getEvent(), InboundMessage::EVENT::UNKNOWN);
+        EXPECT_TRUE(inbound.getEventName().empty());
+
+        // nor does a broken message keep the last message's event
+        ASSERT_TRUE(inbound.parse(R"({"event":"keyUp","context":"A"})"));
+        EXPECT_FALSE(inbound.parse("[]"));
+        EXPECT_EQ(inbound.getEvent(), InboundMessage::EVENT::UNKNOWN);
+        EXPECT_TRUE(inbound.getEventName().empty());
+        EXPECT_TRUE(inbound.getContext().empty());
+    }
+
+    TEST(InboundMessageTests, RejectsBrokenMessages) {
+        InboundMessage inbound;
+        for (const std::string message : { "", "[]", "\"event\"", "{\"event\":\"keyUp\"", "{\"event\" \"keyUp\"}",
+            "{\"event\":\"keyUp\" \"context\":\"A\"}", "{\"payload\":{\"a\":[1,2}", "{\"event\":\"keyUp}" })
+            EXPECT_FALSE(inbound.parse(message)) << message;
+
+        // a payload that is not an object is handed on as null
+        ASSERT_TRUE(inbound.parse(R"({"event":"keyUp","payload":[1,2]})"));
+        EXPECT_TRUE(inbound.getPayload().is_null());
+        ASSERT_TRUE(inbound.parse(R"({"event":"keyUp","payload":{"a":}})"));
+        EXPECT_TRUE(inbound.getPayload().is_null());
+    }
+}
@@ -0,0 +1,104 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../MessageQueue.h"
+
+#include <atomic>
+#include <thread>
+
+namespace MessageQueueTests
+{
+    std::vector<std::string> drainTexts(MessageQueue& queue)
+    {
+        std::vector<MessageQueue::message_t> batch;
+        queue.drain(batch);
+        std::vector<std::string> texts;
+        for (const MessageQueue::message_t& message : batch)
+            texts.push_back(message.text);
+        return texts;
+    }
+
+    TEST(MessageQueueTests, OnlyFirstPushSchedulesFlush) {
+        MessageQueue queue;
+        EXPECT_TRUE(queue.push("a"));
+        EXPECT_FALSE(queue.push("b"));
+        EXPECT_FALSE(queue.push("c", MessageQueue::COALESCE::TITLE, "ctx"));
+        EXPECT_EQ(drainTexts(queue), std::vector<std::string>({ "a", "b", "c" }));
+
+        EXPECT_TRUE(queue.push("d", MessageQueue::COALESCE::IMAGE, "ctx"));
+        EXPECT_EQ(drainTexts(queue), std::vector<std::string>({ "d" }));
+        EXPECT_TRUE(drainTexts(queue).empty());
+    }
+
+    TEST(MessageQueueTests, KeepsLatestTitleAndImagePerContext) {
+        MessageQueue queue;
+        queue.push("title1 a", MessageQueue::COALESCE::TITLE, "a");
+        queue.push("image1 a", MessageQueue::COALESCE::IMAGE, "a");
+        queue.push("title1 b", MessageQueue::COALESCE::TITLE, "b");
+        queue.push("log");
+        queue.push("title2 a", MessageQueue::COALESCE::TITLE, "a");
+        queue.push("image2 a", MessageQueue::COALESCE::IMAGE, "a");
+        queue.push("log");
+        queue.push("title3 a", MessageQueue::COALESCE::TITLE, "a");
+
+        // replaced messages keep their place, uncoalesced messages are all sent
+        EXPECT_EQ(drainTexts(queue), std::vector<std::string>({ "title3 a", "image2 a", "title1 b", "log", "log" }));
+
+        const MessageQueue::queueStats_t stats = queue.getStats();
+        EXPECT_EQ(stats.pushed, 8);
+        EXPECT_EQ(stats.sent, 5);
+        EXPECT_EQ(stats.flushes, 1);
+    }
+
+    TEST(MessageQueueTests, DoesNotCoalesceAcrossFlushes) {
+        MessageQueue queue;
+        queue.push("title1", MessageQueue::COALESCE::TITLE, "a");
+        EXPECT_EQ(drainTexts(queue), std::vector<std::string>({ "title1" }));
+        EXPECT_TRUE(queue.push("title2", MessageQueue::COALESCE::TITLE, "a"));
+        EXPECT_EQ(drainTexts(queue), std::vector<std::string>({ "title2" }));
+    }
+
+    // pushes from several threads while draining, every uncoalesced message arrives once and in order per thread
+    TEST(MessageQueueTests, PushesFromManyThreads) {
+        MessageQueue queue;
+        constexpr int THREADS = 4;
+        constexpr int MESSAGES = 2000;
+
+        std::atomic<int> running = THREADS;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; t++)
+        {
+            threads.emplace_back([&queue, &running, t]()
+                {
+                    for (int i = 0; i < MESSAGES; i++)
+                    {
+                        queue.push(std::to_string(t) + " " + std::to_string(i));
+                        queue.push("title", MessageQueue::COALESCE::TITLE, std::to_string(t));
+                    }
+                    running--;
+                });
+        }
+
+        std::vector<int> next(THREADS, 0);
+        std::vector<MessageQueue::message_t> batch;
+        bool isDone = false;
+        while (!isDone)
+        {
+            isDone = running == 0;
+            queue.drain(batch);
+            for (const MessageQueue::message_t& message : batch)
+            {
+                if (message.coalesce != MessageQueue::COALESCE::NONE)
+                    continue;
+                const int t = std::stoi(message.text);
+                EXPECT_EQ(message.text, std::to_string(t) + " " + std::to_string(next[t]));
+                next[t]++;
+            }
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+
+        EXPECT_EQ(next, std::vector<int>(THREADS, MESSAGES));
+    }
+}
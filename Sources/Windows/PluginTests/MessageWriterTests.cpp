@@ -0,0 +1,125 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../MessageWriter.h"
+#include "../../Common/ESDSDKDefines.h"
+
+namespace MessageWriterTests
+{
+    // every byte that json escapes, plus some that it does not
+    std::string getAwkwardString()
+    {
+        std::string value = "quote\" backslash\\ slash/ utf8 \xc3\xa9\xe2\x9c\x93 del\x7f";
+        for (char c = 1; c < 0x20; c++)
+            value.push_back(c);
+        return value;
+    }
+
+    class MessageWriterTestFixture : public ::testing::TestWithParam<std::string>
+    {
+    protected:
+        MessageWriter mWriter;
+    };
+
+    TEST_P(MessageWriterTestFixture, SetTitleMatchesDom) {
+        json expected;
+        expected[kESDSDKCommonEvent] = kESDSDKEventSetTitle;
+        expected[kESDSDKCommonContext] = "ctx" + GetParam();
+        expected[kESDSDKCommonPayload][kESDSDKPayloadTarget] = 2;
+        expected[kESDSDKCommonPayload][kESDSDKPayloadTitle] = GetParam();
+        EXPECT_EQ(mWriter.setTitle("ctx" + GetParam(), GetParam(), 2), expected.dump());
+    }
+
+    TEST_P(MessageWriterTestFixture, LogMessageMatchesDom) {
+        json expected;
+        expected[kESDSDKCommonEvent] = kESDSDKEventLogMessage;
+        expected[kESDSDKCommonPayload][kESDSDKPayloadMessage] = GetParam();
+        EXPECT_EQ(mWriter.logMessage(GetParam()), expected.dump());
+    }
+
+    TEST_P(MessageWriterTestFixture, OpenUrlMatchesDom) {
+        json expected;
+        expected[kESDSDKCommonEvent] = kESDSDKEventOpenURL;
+        expected[kESDSDKCommonPayload][kESDSDKPayloadURL] = GetParam();
+        EXPECT_EQ(mWriter.openUrl(GetParam()), expected.dump());
+    }
+
+    TEST_P(MessageWriterTestFixture, ContextMessagesMatchDom) {
+        json expected;
+        expected[kESDSDKCommonEvent] = kESDSDKEventShowAlert;
+        expected[kESDSDKCommonContext] = GetParam();
+        EXPECT_EQ(mWriter.contextEvent(kESDSDKEventShowAlert, GetParam()), expected.dump());
+
+        json settings;
+        settings["Name"] = GetParam();
+        settings["Skips"] = 3;
+        expected[kESDSDKCommonEvent] = kESDSDKEventSetSettings;
+        expected[kESDSDKCommonPayload] = settings;
+        EXPECT_EQ(mWriter.contextPayloadEvent(kESDSDKEventSetSettings, GetParam(), settings.dump()), expected.dump());
+
+        expected[kESDSDKCommonEvent] = kESDSDKEventSendToPropertyInspector;
+        expected[kESDSDKCommonAction] = "action" + GetParam();
+        EXPECT_EQ(mWriter.sendToPropertyInspector("action" + GetParam(), GetParam(), settings.dump()), expected.dump());
+    }
+
+    TEST_P(MessageWriterTestFixture, SwitchToProfileMatchesDom) {
+        json expected;
+        expected[kESDSDKCommonEvent] = kESDSDKEventSwitchToProfile;
+        expected[kESDSDKCommonContext] = "uuid";
+        expected[kESDSDKCommonDevice] = GetParam();
+        if (!GetParam().empty())
+            expected[kESDSDKCommonPayload][kESDSDKPayloadProfile] = GetParam();
+        EXPECT_EQ(mWriter.switchToProfile("uuid", GetParam(), GetParam()), expected.dump());
+    }
+
+    INSTANTIATE_TEST_CASE_P(MessageWriterTests, MessageWriterTestFixture, ::testing::Values(
+        "",
+        "Hafgufa\n\n\nWindow ends:\n00:14:59",
+        getAwkwardString()
+    ));
+
+    TEST(MessageWriterTests, SetImageMatchesDom) {
+        const std::string dataUri = "data:image/png;base64,iVBORw0KGgo+/==";
+        json expected;
+        expected[kESDSDKCommonEvent] = kESDSDKEventSetImage;
+        expected[kESDSDKCommonContext] = "ctx";
+        expected[kESDSDKCommonPayload][kESDSDKPayloadTarget] = 0;
+        expected[kESDSDKCommonPayload][kESDSDKPayloadImage] = dataUri;
+
+        MessageWriter writer;
+        EXPECT_EQ(writer.setImage("ctx", dataUri, 0), expected.dump());
+
+        // bare base64 gets the data URI prefix
+        EXPECT_EQ(writer.setImage("ctx", "iVBORw0KGgo+/==", 0), expected.dump());
+
+        // empty goes back to the default image
+        expected[kESDSDKCommonPayload][kESDSDKPayloadImage] = "";
+        EXPECT_EQ(writer.setImage("ctx", "", 0), expected.dump());
+    }
+
+    TEST(MessageWriterTests, SetStateAndRegisterMatchDom) {
+        MessageWriter writer;
+
+        json state;
+        state[kESDSDKCommonEvent] = kESDSDKEventSetState;
+        state[kESDSDKCommonContext] = "ctx";
+        state[kESDSDKCommonPayload][kESDSDKPayloadState] = -12;
+        EXPECT_EQ(writer.setState("ctx", -12), state.dump());
+
+        json registration;
+        registration["event"] = "registerPlugin";
+        registration["uuid"] = "com.elgato.ffxivoceanfishing";
+        EXPECT_EQ(writer.registerPlugin("registerPlugin", "com.elgato.ffxivoceanfishing"), registration.dump());
+    }
+
+    // each message reuses the buffer, the previous view is replaced
+    TEST(MessageWriterTests, ReusesBuffer) {
+        MessageWriter writer;
+        const std::string_view first = writer.logMessage(std::string(1000, 'a'));
+        const char* data = first.data();
+        const std::string_view second = writer.logMessage("short");
+        EXPECT_EQ(second.data(), data);
+        EXPECT_EQ(second, "{\"event\":\"logMessage\",\"payload\":{\"message\":\"short\"}}");
+    }
+}
@@ -0,0 +1,211 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include "../PluginLogger.h"
+
+namespace PluginLoggerTests
+{
+    // a clock that only moves when told, for rate limit windows. Each starts an hour after the last,
+    // so call sites' static rate limits start fresh when tests are repeated
+    class ManualClock : public Clock
+    {
+    public:
+        ManualClock()
+        {
+            static std::atomic<int> clocks = 0;
+            mElapsed = std::chrono::milliseconds(std::chrono::hours(++clocks));
+        }
+        time_t now() override { return 1700000000 + std::chrono::duration_cast<std::chrono::seconds>(mElapsed.load()).count(); }
+        std::chrono::steady_clock::time_point steadyNow() override { return std::chrono::steady_clock::time_point(mElapsed.load()); }
+        bool tryLockFor(std::timed_mutex& mutex, const std::chrono::milliseconds) override { return mutex.try_lock(); }
+        void advance(const std::chrono::milliseconds duration) { mElapsed = mElapsed.load() + duration; }
+    private:
+        std::atomic<std::chrono::milliseconds> mElapsed;
+    };
+
+    class PluginLoggerTestFixture : public ::testing::Test
+    {
+    protected:
+        ManualClock mClock;
+        std::mutex mMutex;
+        std::vector<std::string> mBatches;
+
+        PluginLogger::sink_t makeSink()
+        {
+            return [this](std::string_view lines)
+                {
+                    std::unique_lock<std::mutex> lock(mMutex);
+                    mBatches.emplace_back(lines);
+                };
+        }
+
+        std::vector<std::string> getLines()
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            std::vector<std::string> lines;
+            for (const std::string& batch : mBatches)
+            {
+                std::stringstream stream(batch);
+                std::string line;
+                while (std::getline(stream, line))
+                    lines.push_back(line);
+            }
+            return lines;
+        }
+    };
+
+    TEST_F(PluginLoggerTestFixture, FormatsArguments) {
+        PluginLogger logger(makeSink(), mClock);
+        const std::string context = "context";
+        PLUGIN_LOG_ERROR(logger, "could not find ", context, " with ", 3, " settings ", json({ { "Route", "Indigo Route" } }), ' ', true, ' ', 1.5);
+        logger.flush();
+
+        const std::vector<std::string> lines = getLines();
+        ASSERT_EQ(lines.size(), 1);
+        EXPECT_EQ(lines[0], "[ERROR] could not find context with 3 settings {\"Route\":\"Indigo Route\"} true 1.5");
+    }
+
+    TEST_F(PluginLoggerTestFixture, SkipsLevelsBelowTheSetOne) {
+        PluginLogger logger(makeSink(), mClock);
+        int evaluated = 0;
+        const auto expensive = [&evaluated]() { evaluated++; return std::string("expensive"); };
+
+        PLUGIN_LOG_DEBUG(logger, expensive());
+        PLUGIN_LOG_INFO(logger, "info");
+        logger.setLevel(LOG_LEVEL::WARNING);
+        PLUGIN_LOG_INFO(logger, expensive());
+        PLUGIN_LOG_WARNING(logger, "warning");
+        logger.flush();
+
+        EXPECT_EQ(evaluated, 0);
+        EXPECT_EQ(getLines(), std::vector<std::string>({ "[INFO] info", "[WARNING] warning" }));
+    }
+
+    TEST_F(PluginLoggerTestFixture, RateLimitsEachCallSite) {
+        PluginLogger logger(makeSink(), mClock);
+        for (int i = 0; i < 20; i++)
+        {
+            PLUGIN_LOG_INFO(logger, "busy ", i);
+            if (i % 10 == 0)
+                PLUGIN_LOG_INFO(logger, "quiet ", i);
+        }
+        mClock.advance(std::chrono::seconds(1));
+        PLUGIN_LOG_INFO(logger, "after");
+        logger.flush();
+
+        const std::vector<std::string> lines = getLines();
+        const size_t busy = std::count_if(lines.begin(), lines.end(), [](const std::string& line) { return line.starts_with("[INFO] busy "); });
+        const size_t quiet = std::count_if(lines.begin(), lines.end(), [](const std::string& line) { return line.starts_with("[INFO] quiet "); });
+        EXPECT_EQ(busy, PluginLogger::MAX_LINES_PER_SITE_PER_SECOND);
+        EXPECT_EQ(quiet, 2);
+        EXPECT_EQ(logger.getStats().suppressed, 20 - PluginLogger::MAX_LINES_PER_SITE_PER_SECOND);
+
+        // each macro is its own call site, so the line after the loop has its own limit
+        EXPECT_EQ(lines.back(), "[INFO] after");
+    }
+
+    TEST_F(PluginLoggerTestFixture, NotesSuppressedLines) {
+        PluginLogger logger(makeSink(), mClock);
+        for (int second = 0; second < 2; second++)
+        {
+            for (int i = 0; i < 8; i++)
+                PLUGIN_LOG_WARNING(logger, "line");
+            mClock.advance(std::chrono::seconds(1));
+        }
+        logger.flush();
+
+        const std::vector<std::string> lines = getLines();
+        ASSERT_EQ(lines.size(), 2 * PluginLogger::MAX_LINES_PER_SITE_PER_SECOND);
+        EXPECT_EQ(lines[PluginLogger::MAX_LINES_PER_SITE_PER_SECOND], "[WARNING] line (3 similar suppressed)");
+    }
+
+    TEST_F(PluginLoggerTestFixture, BatchesLines) {
+        PluginLogger logger(makeSink(), mClock);
+        for (int i = 0; i < 100; i++)
+            logger.log(LOG_LEVEL::INFO, 0, "line ", i);
+        logger.flush();
+
+        const std::vector<std::string> lines = getLines();
+        ASSERT_EQ(lines.size(), 100);
+        for (int i = 0; i < 100; i++)
+            EXPECT_EQ(lines[i], "[INFO] line " + std::to_string(i));
+        EXPECT_LT(logger.getStats().batches, 100);
+        EXPECT_EQ(logger.getStats().logged, 100);
+    }
+
+    // lines are dropped rather than waiting for a stuck sink
+    TEST_F(PluginLoggerTestFixture, DropsLinesWhenFull) {
+        std::mutex sinkMutex;
+        std::condition_variable sinkCondition;
+        bool isInSink = false;
+        bool isReleased = false;
+        PluginLogger logger([&](std::string_view)
+            {
+                std::unique_lock<std::mutex> lock(sinkMutex);
+                isInSink = true;
+                sinkCondition.notify_all();
+                sinkCondition.wait(lock, [&]() { return isReleased; });
+            }, mClock);
+
+        logger.log(LOG_LEVEL::INFO, 0, "first");
+        {
+            std::unique_lock<std::mutex> lock(sinkMutex);
+            sinkCondition.wait(lock, [&]() { return isInSink; });
+        }
+        for (size_t i = 0; i < PluginLogger::QUEUE_CAPACITY + 10; i++)
+            logger.log(LOG_LEVEL::INFO, 0, "line");
+        EXPECT_EQ(logger.getStats().dropped, 10);
+
+        {
+            std::unique_lock<std::mutex> lock(sinkMutex);
+            isReleased = true;
+        }
+        sinkCondition.notify_all();
+        logger.flush();
+        EXPECT_EQ(logger.getStats().logged, PluginLogger::QUEUE_CAPACITY + 1);
+    }
+
+    TEST_F(PluginLoggerTestFixture, RotatesFiles) {
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "PluginLoggerTests";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        const std::string path = (directory / "plugin.log").string();
+        {
+            PluginLogger logger(makeSink(), mClock);
+            logger.setFile(path, 200, 3);
+            for (int i = 0; i < 50; i++)
+            {
+                logger.log(LOG_LEVEL::INFO, 0, "line ", i);
+                logger.flush();
+            }
+        }
+
+        EXPECT_TRUE(getLines().empty());
+        EXPECT_TRUE(std::filesystem::exists(path));
+        EXPECT_TRUE(std::filesystem::exists(path + ".1"));
+        EXPECT_TRUE(std::filesystem::exists(path + ".2"));
+        EXPECT_FALSE(std::filesystem::exists(path + ".3"));
+        EXPECT_LE(std::filesystem::file_size(path), 200);
+        EXPECT_LE(std::filesystem::file_size(path + ".1"), 200);
+
+        std::ifstream input(path);
+        std::string line;
+        std::string last;
+        while (std::getline(input, line))
+            last = line;
+        EXPECT_TRUE(last.ends_with(" [INFO] line 49")) << last;
+        input.close();
+        std::filesystem::remove_all(directory);
+    }
+
+    TEST_F(PluginLoggerTestFixture, ReadsLevelNames) {
+        EXPECT_EQ(PluginLogger::toLevel("debug"), LOG_LEVEL::DBG);
+        EXPECT_EQ(PluginLogger::toLevel("Warning"), LOG_LEVEL::WARNING);
+        EXPECT_EQ(PluginLogger::toLevel("ERROR"), LOG_LEVEL::ERR);
+        EXPECT_EQ(PluginLogger::toLevel("verbose"), std::nullopt);
+        EXPECT_EQ(PluginLogger::toName(LOG_LEVEL::INFO), "INFO");
+    }
+}
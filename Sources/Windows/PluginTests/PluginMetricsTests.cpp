@@ -0,0 +1,163 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../PluginMetrics.h"
+#include "../InMemoryTransport.h"
+
+namespace PluginMetricsTests
+{
+    using HISTOGRAM = PluginMetrics::HISTOGRAM;
+    using SENT = PluginMetrics::SENT;
+
+    // the registry is shared by the whole process, so each test starts from zero and leaves it off
+    class PluginMetricsTestFixture : public ::testing::Test
+    {
+    protected:
+        PluginMetrics& mMetrics = PluginMetrics::get();
+
+        void SetUp()
+        {
+            mMetrics.reset();
+            mMetrics.setEnabled(true);
+        }
+
+        void TearDown()
+        {
+            mMetrics.setEnabled(false);
+            mMetrics.reset();
+        }
+    };
+
+    TEST_F(PluginMetricsTestFixture, RecordsNothingWhileDisabled) {
+        mMetrics.setEnabled(false);
+        mMetrics.countSent(SENT::SET_TITLE, 100);
+        mMetrics.countReceived(InboundMessage::EVENT::KEY_DOWN, 100);
+        mMetrics.record(HISTOGRAM::UPDATE_UI, std::chrono::microseconds(5));
+        {
+            ScopedMetricsTimer timer(HISTOGRAM::TIMER_CALLBACK);
+        }
+
+        EXPECT_EQ(mMetrics.getSent(SENT::SET_TITLE), 0);
+        EXPECT_EQ(mMetrics.getReceived(InboundMessage::EVENT::KEY_DOWN), 0);
+        EXPECT_EQ(mMetrics.getBytesSent(), 0);
+        EXPECT_EQ(mMetrics.getBytesReceived(), 0);
+        EXPECT_EQ(mMetrics.getHistogram(HISTOGRAM::UPDATE_UI).count, 0);
+        EXPECT_EQ(mMetrics.getHistogram(HISTOGRAM::TIMER_CALLBACK).count, 0);
+    }
+
+    TEST_F(PluginMetricsTestFixture, CountsMessagesAndBytes) {
+        mMetrics.countSent(SENT::SET_TITLE, 100);
+        mMetrics.countSent(SENT::SET_TITLE, 50);
+        mMetrics.countSent(SENT::SET_IMAGE, 1000);
+        mMetrics.countReceived(InboundMessage::EVENT::WILL_APPEAR, 200);
+
+        EXPECT_EQ(mMetrics.getSent(SENT::SET_TITLE), 2);
+        EXPECT_EQ(mMetrics.getSent(SENT::SET_IMAGE), 1);
+        EXPECT_EQ(mMetrics.getSent(SENT::LOG_MESSAGE), 0);
+        EXPECT_EQ(mMetrics.getBytesSent(), 1150);
+        EXPECT_EQ(mMetrics.getReceived(InboundMessage::EVENT::WILL_APPEAR), 1);
+        EXPECT_EQ(mMetrics.getBytesReceived(), 200);
+
+        mMetrics.reset();
+        EXPECT_EQ(mMetrics.getSent(SENT::SET_TITLE), 0);
+        EXPECT_EQ(mMetrics.getBytesSent(), 0);
+    }
+
+    // percentiles are reported as the upper bound of their power of two bucket, never above the max
+    TEST_F(PluginMetricsTestFixture, ReadsPercentilesFromBuckets) {
+        for (int i = 0; i < 98; i++)
+            mMetrics.record(HISTOGRAM::UPDATE_UI, std::chrono::microseconds(3));
+        mMetrics.record(HISTOGRAM::UPDATE_UI, std::chrono::microseconds(100));
+        mMetrics.record(HISTOGRAM::UPDATE_UI, std::chrono::microseconds(5000));
+
+        const PluginMetrics::histogramSnapshot_t histogram = mMetrics.getHistogram(HISTOGRAM::UPDATE_UI);
+        EXPECT_EQ(histogram.count, 100);
+        EXPECT_DOUBLE_EQ(histogram.p50Microseconds, 4.0);
+        EXPECT_DOUBLE_EQ(histogram.p99Microseconds, 128.0);
+        EXPECT_DOUBLE_EQ(histogram.maxMicroseconds, 5000.0);
+        EXPECT_NEAR(histogram.meanMicroseconds, (98 * 3 + 100 + 5000) / 100.0, 0.001);
+    }
+
+    TEST_F(PluginMetricsTestFixture, CapsPercentilesAtMax) {
+        mMetrics.record(HISTOGRAM::TIMER_LATENESS, std::chrono::microseconds(600));
+        mMetrics.record(HISTOGRAM::TIMER_LATENESS, std::chrono::nanoseconds(-5));
+
+        const PluginMetrics::histogramSnapshot_t histogram = mMetrics.getHistogram(HISTOGRAM::TIMER_LATENESS);
+        EXPECT_EQ(histogram.count, 2);
+        EXPECT_DOUBLE_EQ(histogram.p50Microseconds, 1.0);
+        EXPECT_DOUBLE_EQ(histogram.p99Microseconds, 600.0);
+        EXPECT_DOUBLE_EQ(histogram.maxMicroseconds, 600.0);
+    }
+
+    TEST_F(PluginMetricsTestFixture, TimesScopes) {
+        {
+            ScopedMetricsTimer timer(HISTOGRAM::TIMER_CALLBACK);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+        const PluginMetrics::histogramSnapshot_t histogram = mMetrics.getHistogram(HISTOGRAM::TIMER_CALLBACK);
+        EXPECT_EQ(histogram.count, 1);
+        EXPECT_GE(histogram.maxMicroseconds, 2000.0);
+    }
+
+    TEST_F(PluginMetricsTestFixture, TimesMutexWaitAndHold) {
+        MeteredMutex mutex(HISTOGRAM::CONTEXTS_MUTEX_WAIT, HISTOGRAM::CONTEXTS_MUTEX_HOLD);
+
+        std::unique_lock<MeteredMutex> lock(mutex);
+        std::thread waiter([&mutex]()
+            {
+                std::lock_guard<MeteredMutex> waiting(mutex);
+            });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        lock.unlock();
+        waiter.join();
+
+        const PluginMetrics::histogramSnapshot_t wait = mMetrics.getHistogram(HISTOGRAM::CONTEXTS_MUTEX_WAIT);
+        const PluginMetrics::histogramSnapshot_t hold = mMetrics.getHistogram(HISTOGRAM::CONTEXTS_MUTEX_HOLD);
+        EXPECT_EQ(wait.count, 2);
+        EXPECT_EQ(hold.count, 2);
+        EXPECT_GE(wait.maxMicroseconds, 10000.0);
+        EXPECT_GE(hold.maxMicroseconds, 10000.0);
+
+        // a lock taken while disabled is not timed even if metrics come on while it is held
+        mMetrics.setEnabled(false);
+        lock.lock();
+        mMetrics.setEnabled(true);
+        lock.unlock();
+        EXPECT_EQ(mMetrics.getHistogram(HISTOGRAM::CONTEXTS_MUTEX_HOLD).count, 2);
+        EXPECT_TRUE(lock.try_lock());
+        lock.unlock();
+        EXPECT_EQ(mMetrics.getHistogram(HISTOGRAM::CONTEXTS_MUTEX_HOLD).count, 3);
+    }
+
+    TEST_F(PluginMetricsTestFixture, CountsTransportMessages) {
+        InMemoryTransport transport(nullptr);
+        transport.SetTitle("title", "context", kESDSDKTarget_HardwareAndSoftware);
+        transport.SetTitle("title", "context", kESDSDKTarget_HardwareAndSoftware);
+        transport.LogMessage("message");
+        transport.LogMessage("");
+
+        EXPECT_EQ(mMetrics.getSent(SENT::SET_TITLE), 2);
+        EXPECT_EQ(mMetrics.getSent(SENT::LOG_MESSAGE), 1);
+        EXPECT_EQ(mMetrics.getBytesSent(), transport.getStats().bytes);
+    }
+
+    TEST_F(PluginMetricsTestFixture, SnapshotsEverything) {
+        mMetrics.countSent(SENT::SET_IMAGE, 10);
+        mMetrics.countReceived(InboundMessage::EVENT::SEND_TO_PLUGIN, 20);
+        mMetrics.record(HISTOGRAM::CONTEXTS_MUTEX_HOLD, std::chrono::microseconds(7));
+
+        const json snapshot = mMetrics.snapshot();
+        EXPECT_TRUE(snapshot["enabled"].get<bool>());
+        EXPECT_EQ(snapshot["sent"], json({ { "setImage", 1 } }));
+        EXPECT_EQ(snapshot["received"], json({ { "sendToPlugin", 1 } }));
+        EXPECT_EQ(snapshot["bytesSent"], 10);
+        EXPECT_EQ(snapshot["bytesReceived"], 20);
+
+        for (const std::string name : { "timerCallback", "updateUI", "contextsMutexWait", "contextsMutexHold", "timerLateness" })
+            ASSERT_TRUE(snapshot["histograms"].contains(name)) << name;
+        EXPECT_EQ(snapshot["histograms"]["contextsMutexHold"]["count"], 1);
+        EXPECT_DOUBLE_EQ(snapshot["histograms"]["contextsMutexHold"]["maxUs"].get<double>(), 7.0);
+        EXPECT_EQ(snapshot["histograms"]["updateUI"]["count"], 0);
+    }
+}
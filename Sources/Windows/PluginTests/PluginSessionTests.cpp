@@ -0,0 +1,268 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <filesystem>
+#include <fstream>
+#include "../../FFXIVOceanFishingTrackerPlugin.h"
+#include "../InMemoryTransport.h"
+#include "../VirtualClock.h"
+#include "../StreamDeckSession.h"
+
+namespace PluginSessionTests
+{
+    const std::string pluginDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/";
+    const std::chrono::milliseconds TIMEOUT = std::chrono::seconds(20);
+
+    // 2023-01-01 01:00:00 UTC, an hour before a voyage leaves
+    const time_t START_TIME = 1672534800;
+
+    // the UI timer's interval, virtual time moves on a tick at a time while buttons are being shown
+    const std::chrono::milliseconds TICK = std::chrono::milliseconds(500);
+
+    // the plugin loads its database and icons relative to the working directory
+    class PluginSessionTestFixture : public ::testing::Test
+    {
+    protected:
+        std::filesystem::path mPrevious;
+        json mRouteTargets;
+
+        // the plugin's timers only run when the test advances this, declared first so it outlives the plugin
+        VirtualClock mClock{ START_TIME };
+
+        void SetUp()
+        {
+            mPrevious = std::filesystem::current_path();
+            std::filesystem::current_path(pluginDirectory);
+
+            FFXIVOceanFishingHelper helper({ "oceanFishingDatabase - Indigo Route.json", "oceanFishingDatabase - Ruby Route.json" });
+            for (const std::string route : helper.getRouteNames())
+                mRouteTargets[route] = helper.getTargetsJson(route);
+        }
+
+        void TearDown()
+        {
+            std::filesystem::current_path(mPrevious);
+        }
+
+        // advances virtual time until every button has a title and an image. advance() only returns once every timer tick
+        // it ran has returned, so whatever a tick records is there when this does. Progress ring icons are decoded on the
+        // image loader's own thread, the only thing waited on in real time, with TIMEOUT guarding against a hang
+        bool showButtons(InMemoryTransport& transport, const size_t count)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + TIMEOUT;
+            while (true)
+            {
+                mClock.advance(TICK);
+                if (transport.waitForContexts(count, count, std::chrono::milliseconds(1)))
+                    return true;
+                if (std::chrono::steady_clock::now() >= deadline)
+                    return false;
+            }
+        }
+    };
+
+    TEST_F(PluginSessionTestFixture, MakesButtonsForEveryTarget) {
+        const std::vector<streamdecksession::button_t> buttons = streamdecksession::makeButtons(300, mRouteTargets, 7);
+        ASSERT_EQ(buttons.size(), 300);
+        EXPECT_EQ(buttons.front().context, "00000000000000000000000000000008");
+
+        std::set<std::string> contexts;
+        std::set<std::string> targets;
+        for (const streamdecksession::button_t& button : buttons)
+        {
+            contexts.insert(button.context);
+            targets.insert(button.settings["Route"].get<std::string>() + button.settings["Name"].get<std::string>());
+            EXPECT_EQ(mRouteTargets[button.settings["Route"].get<std::string>()][button.settings["Name"].get<std::string>()], button.settings["Tracker"]);
+        }
+        EXPECT_EQ(contexts.size(), buttons.size());
+        EXPECT_EQ(targets.size(), (std::min)(buttons.size(), mRouteTargets["Indigo Route"].size() + mRouteTargets["Ruby Route"].size()));
+    }
+
+    // a profile opens, every button gets a title and an image, a key press opens the button's url and the profile closes
+    TEST_F(PluginSessionTestFixture, RunsSessionInMemory) {
+        const std::vector<streamdecksession::button_t> buttons = streamdecksession::makeButtons(40, mRouteTargets);
+        // the plugin's timers send through the transport, so the plugin has to go first
+        auto plugin = std::make_unique<FFXIVOceanFishingTrackerPlugin>(mClock);
+        InMemoryTransport transport(plugin.get());
+
+        for (const std::string& message : streamdecksession::makeAppear(buttons, "InMemoryTransport"))
+            transport.inject(message);
+        ASSERT_TRUE(showButtons(transport, buttons.size()));
+
+        const InMemoryTransport::transportStats_t stats = transport.getStats();
+        EXPECT_EQ(stats.titledContexts, buttons.size());
+        EXPECT_EQ(stats.imagedContexts, buttons.size());
+        EXPECT_GE(stats.titles, buttons.size());
+
+        bool isGlobalSettingsRequested = false;
+        bool isPropertyInspectorInit = false;
+        for (const std::string& message : transport.takeMessages())
+        {
+            const json parsed = json::parse(message, nullptr, false);
+            ASSERT_TRUE(parsed.is_object()) << message;
+            isGlobalSettingsRequested |= parsed["event"] == "getGlobalSettings" && parsed["context"] == "InMemoryTransport";
+            isPropertyInspectorInit |= parsed["event"] == "sendToPropertyInspector" && parsed["context"] == buttons.front().context;
+        }
+        EXPECT_TRUE(isGlobalSettingsRequested);
+        EXPECT_TRUE(isPropertyInspectorInit);
+
+        for (const std::string& message : streamdecksession::makeKeyPresses(buttons, 1))
+            transport.inject(message);
+        // time stands still, so only the key press has sent anything since
+        std::vector<json> openUrls;
+        for (const std::string& message : transport.takeMessages())
+        {
+            json parsed = json::parse(message);
+            if (parsed["event"] == "openUrl")
+                openUrls.push_back(std::move(parsed));
+        }
+        ASSERT_EQ(openUrls.size(), 1);
+        EXPECT_EQ(openUrls.front()["payload"]["url"], "https://example.com");
+
+        for (const std::string& message : streamdecksession::makeDisappear(buttons))
+            transport.inject(message);
+        plugin.reset();
+    }
+
+    // nothing is kept when recording is off, only counted
+    TEST_F(PluginSessionTestFixture, CountsWithoutRecording) {
+        const std::vector<streamdecksession::button_t> buttons = streamdecksession::makeButtons(5, mRouteTargets);
+        auto plugin = std::make_unique<FFXIVOceanFishingTrackerPlugin>(mClock);
+        InMemoryTransport transport(plugin.get(), false);
+
+        for (const std::string& message : streamdecksession::makeAppear(buttons, "InMemoryTransport"))
+            transport.inject(message);
+        ASSERT_TRUE(showButtons(transport, buttons.size()));
+        EXPECT_TRUE(transport.takeMessages().empty());
+        EXPECT_GT(transport.getStats().bytes, 0);
+
+        plugin.reset();
+        transport.clear();
+        EXPECT_EQ(transport.getStats().messages, 0);
+        EXPECT_EQ(transport.getStats().titledContexts, 0);
+    }
+
+    // the property inspector turns metrics on and asks for a snapshot, logged or appended to a file
+    TEST_F(PluginSessionTestFixture, ReportsMetricsOnRequest) {
+        const std::vector<streamdecksession::button_t> buttons = streamdecksession::makeButtons(5, mRouteTargets);
+        auto plugin = std::make_unique<FFXIVOceanFishingTrackerPlugin>(mClock);
+        InMemoryTransport transport(plugin.get());
+
+        const auto sendMetricsCommand = [&](const json& command)
+            {
+                transport.inject(json({ { "event", "sendToPlugin" }, { "action", "action" }, { "context", buttons.front().context }, { "payload", { { "metrics", command } } } }).dump());
+            };
+        sendMetricsCommand({ { "enabled", true }, { "reset", true } });
+        for (const std::string& message : streamdecksession::makeAppear(buttons, "InMemoryTransport"))
+            transport.inject(message);
+        ASSERT_TRUE(showButtons(transport, buttons.size()));
+        transport.clear();
+
+        sendMetricsCommand({ { "output", "log" }, { "snapshot", true } });
+        json snapshot;
+        for (const std::string& message : transport.takeMessages())
+        {
+            const json parsed = json::parse(message);
+            // other log lines may come in around it
+            if (parsed["event"] != "logMessage")
+                continue;
+            const json logged = json::parse(parsed["payload"]["message"].get<std::string>(), nullptr, false);
+            if (logged.is_object())
+                snapshot = logged;
+        }
+        ASSERT_TRUE(snapshot.is_object());
+        EXPECT_EQ(snapshot["received"]["willAppear"], buttons.size());
+        EXPECT_GE(snapshot["sent"]["setTitle"].get<uint64_t>(), buttons.size());
+        EXPECT_GE(snapshot["sent"]["setImage"].get<uint64_t>(), buttons.size());
+        EXPECT_EQ(snapshot["contexts"]["visible"], buttons.size());
+        EXPECT_GE(snapshot["contexts"]["recomputed"].get<uint64_t>(), buttons.size());
+        EXPECT_GE(snapshot["histograms"]["timerCallback"]["count"].get<uint64_t>(), 1);
+        EXPECT_GE(snapshot["histograms"]["contextsMutexHold"]["count"].get<uint64_t>(), 1);
+        EXPECT_TRUE(snapshot.contains("imageCache"));
+
+        const std::filesystem::path file = std::filesystem::temp_directory_path() / "PluginSessionTestsMetrics.jsonl";
+        std::filesystem::remove(file);
+        sendMetricsCommand({ { "output", file.string() }, { "snapshot", true } });
+        sendMetricsCommand({ { "snapshot", true }, { "enabled", false } });
+        std::ifstream input(file);
+        std::string line;
+        size_t lines = 0;
+        while (std::getline(input, line))
+        {
+            EXPECT_TRUE(json::parse(line).contains("histograms"));
+            lines++;
+        }
+        EXPECT_EQ(lines, 2);
+        input.close();
+        std::filesystem::remove(file);
+
+        for (const std::string& message : streamdecksession::makeDisappear(buttons))
+            transport.inject(message);
+        plugin.reset();
+        PluginMetrics::get().reset();
+    }
+
+    // metrics can be turned on for the shipped plugin from the global settings, and are counted from then on
+    TEST_F(PluginSessionTestFixture, CountsMetricsWhenToggledInGlobalSettings) {
+        const std::vector<streamdecksession::button_t> buttons = streamdecksession::makeButtons(5, mRouteTargets);
+        auto plugin = std::make_unique<FFXIVOceanFishingTrackerPlugin>(mClock);
+        InMemoryTransport transport(plugin.get());
+
+        const auto sendMetrics = [&](const bool isMetrics)
+            {
+                transport.inject(json({ { "event", "didReceiveGlobalSettings" }, { "payload", { { "settings", { { "Metrics", isMetrics } } } } } }).dump());
+            };
+        PluginMetrics::get().reset();
+        sendMetrics(true);
+        EXPECT_TRUE(PluginMetrics::get().isEnabled());
+        for (const std::string& message : streamdecksession::makeAppear(buttons, "InMemoryTransport"))
+            transport.inject(message);
+        ASSERT_TRUE(showButtons(transport, buttons.size()));
+        sendMetrics(false);
+        EXPECT_FALSE(PluginMetrics::get().isEnabled());
+        EXPECT_EQ(PluginMetrics::get().getReceived(InboundMessage::EVENT::WILL_APPEAR), buttons.size());
+
+        for (const std::string& message : streamdecksession::makeDisappear(buttons))
+            transport.inject(message);
+        plugin.reset();
+        PluginMetrics::get().reset();
+    }
+
+    // turning tracing on and off in the global settings records the session and writes it as a Chrome trace
+    TEST_F(PluginSessionTestFixture, TracesWhenToggledInGlobalSettings) {
+        const std::vector<streamdecksession::button_t> buttons = streamdecksession::makeButtons(5, mRouteTargets);
+        auto plugin = std::make_unique<FFXIVOceanFishingTrackerPlugin>(mClock);
+        InMemoryTransport transport(plugin.get());
+
+        const std::filesystem::path file = std::filesystem::temp_directory_path() / "PluginSessionTestsTrace.json";
+        std::filesystem::remove(file);
+        const auto sendTracing = [&](const bool isTracing)
+            {
+                transport.inject(json({ { "event", "didReceiveGlobalSettings" }, { "payload", { { "settings", { { "Tracing", isTracing }, { "TraceFile", file.string() } } } } } }).dump());
+            };
+        sendTracing(true);
+        for (const std::string& message : streamdecksession::makeAppear(buttons, "InMemoryTransport"))
+            transport.inject(message);
+        ASSERT_TRUE(showButtons(transport, buttons.size()));
+        const std::vector<std::string> expectedSpans = { "dispatch", "recompute", "query", "updateImage", "setTitle", "setImage", "updateUI" };
+        sendTracing(false);
+        EXPECT_FALSE(PluginTracer::get().isEnabled());
+
+        std::ifstream input(file);
+        const json trace = json::parse(input, nullptr, false);
+        ASSERT_TRUE(trace.is_object());
+        std::set<std::string> spans;
+        for (const json& event : trace["traceEvents"])
+            if (event["ph"] == "X")
+                spans.insert(event["name"].get<std::string>());
+        for (const std::string& name : expectedSpans)
+            EXPECT_TRUE(spans.contains(name)) << name;
+        input.close();
+        std::filesystem::remove(file);
+
+        for (const std::string& message : streamdecksession::makeDisappear(buttons))
+            transport.inject(message);
+        plugin.reset();
+    }
+}
@@ -0,0 +1,132 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <sstream>
+#include "../PluginTracer.h"
+
+namespace PluginTracerTests
+{
+    // the tracer is shared by the whole process, so each test starts empty and leaves it off
+    class PluginTracerTestFixture : public ::testing::Test
+    {
+    protected:
+        PluginTracer& mTracer = PluginTracer::get();
+
+        void SetUp()
+        {
+            mTracer.clear();
+            mTracer.setEnabled(true);
+        }
+
+        void TearDown()
+        {
+            mTracer.setEnabled(false);
+            mTracer.clear();
+        }
+
+        size_t countEvents(const char* name)
+        {
+            const std::vector<PluginTracer::traceEvent_t> events = mTracer.getEvents();
+            return std::count_if(events.begin(), events.end(), [name](const PluginTracer::traceEvent_t& event) { return std::string(event.name) == name; });
+        }
+    };
+
+    TEST_F(PluginTracerTestFixture, RecordsNothingWhileDisabled) {
+        mTracer.setEnabled(false);
+        {
+            ScopedTraceSpan span("disabled", "test");
+        }
+        EXPECT_EQ(countEvents("disabled"), 0);
+    }
+
+    TEST_F(PluginTracerTestFixture, RecordsSpansPerThread) {
+        {
+            ScopedTraceSpan outer("outer", "test");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            ScopedTraceSpan inner("inner", "test");
+        }
+        std::thread other([]()
+            {
+                ScopedTraceSpan span("other", "test");
+            });
+        other.join();
+
+        const std::vector<PluginTracer::traceEvent_t> events = mTracer.getEvents();
+        ASSERT_EQ(events.size(), 3);
+        EXPECT_STREQ(events[0].name, "outer");
+        EXPECT_STREQ(events[0].category, "test");
+        EXPECT_GE(events[0].durationNanoseconds, 2000000);
+        EXPECT_STREQ(events[1].name, "inner");
+        EXPECT_LE(events[1].startNanoseconds + events[1].durationNanoseconds, events[0].startNanoseconds + events[0].durationNanoseconds);
+        EXPECT_STREQ(events[2].name, "other");
+        EXPECT_EQ(events[0].threadId, events[1].threadId);
+        EXPECT_NE(events[0].threadId, events[2].threadId);
+    }
+
+    TEST_F(PluginTracerTestFixture, KeepsLatestSpansOfEachThread) {
+        const uint64_t start = mTracer.now();
+        std::thread recorder([this, start]()
+            {
+                for (uint64_t i = 0; i < PluginTracer::EVENTS_PER_THREAD + 100; i++)
+                    mTracer.record(i < 100 ? "old" : "new", "test", start + i, start + i + 1);
+            });
+        recorder.join();
+
+        EXPECT_EQ(countEvents("old"), 0);
+        EXPECT_EQ(countEvents("new"), PluginTracer::EVENTS_PER_THREAD);
+    }
+
+    TEST_F(PluginTracerTestFixture, ReusesBuffersOfExitedThreads) {
+        for (size_t i = 0; i < PluginTracer::MAX_THREADS * 2; i++)
+        {
+            std::thread thread([]()
+                {
+                    ScopedTraceSpan span("thread", "test");
+                });
+            thread.join();
+        }
+        EXPECT_EQ(countEvents("thread"), PluginTracer::MAX_THREADS * 2);
+        EXPECT_EQ(mTracer.getDropped(), 0);
+    }
+
+    TEST_F(PluginTracerTestFixture, ClearForgetsSpans) {
+        {
+            ScopedTraceSpan span("cleared", "test");
+        }
+        mTracer.clear();
+        {
+            ScopedTraceSpan span("kept", "test");
+        }
+        EXPECT_EQ(countEvents("cleared"), 0);
+        EXPECT_EQ(countEvents("kept"), 1);
+    }
+
+    TEST_F(PluginTracerTestFixture, WritesChromeTrace) {
+        mTracer.nameThread("test thread");
+        const uint64_t start = mTracer.now();
+        mTracer.record("span", "test", start, start + 2000);
+
+        std::stringstream output;
+        mTracer.write(output);
+        const json trace = json::parse(output.str(), nullptr, false);
+        ASSERT_TRUE(trace.is_object()) << output.str();
+
+        bool isThreadNamed = false;
+        bool isSpanWritten = false;
+        for (const json& event : trace["traceEvents"])
+        {
+            if (event["ph"] == "M" && event["args"]["name"] == "test thread")
+                isThreadNamed = true;
+            if (event["ph"] == "X" && event["name"] == "span")
+            {
+                EXPECT_EQ(event["cat"], "test");
+                EXPECT_NEAR(event["ts"].get<double>(), start / 1000.0, 0.0005);
+                EXPECT_DOUBLE_EQ(event["dur"].get<double>(), 2.0);
+                isSpanWritten = true;
+            }
+        }
+        EXPECT_TRUE(isThreadNamed);
+        EXPECT_TRUE(isSpanWritten);
+    }
+}
@@ -0,0 +1,164 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <thread>
+#include "../SchedulePublisher.h"
+#include "../ScheduleReader.h"
+
+namespace SchedulePublisherTests
+{
+#ifdef _WIN32
+    const std::string segmentName = "Local\\FFXIVOceanFishingScheduleTests";
+#else
+    const std::string segmentName = "/FFXIVOceanFishingScheduleTests";
+#endif
+
+    sharedschedule::contextState_t makeState(const std::string& label, const int64_t voyageTime, const uint32_t nextVoyageId)
+    {
+        sharedschedule::contextState_t state{};
+        sharedschedule::copyText(state.routeName, "Indigo Route");
+        sharedschedule::copyText(state.tracker, "Blue Fish");
+        sharedschedule::copyText(state.targetName, "Sothis");
+        sharedschedule::copyText(state.buttonLabel, label);
+        sharedschedule::copyText(state.imageName, label);
+        state.voyageTime = voyageTime;
+        state.windowEnd = 0;
+        state.nextVoyageId = nextVoyageId;
+        return state;
+    }
+
+    TEST(SchedulePublisherTests, ReaderSeesPublishedContexts) {
+        SchedulePublisher publisher(segmentName);
+        ASSERT_TRUE(publisher.isInit()) << publisher.getErrorMessage();
+        ASSERT_TRUE(publisher.publish("context1", makeState("Sothis", 1700006400, 4)));
+        ASSERT_TRUE(publisher.publish("context2", makeState("Stonescale", 1700013600, 5)));
+
+        ScheduleReader reader(segmentName);
+        ASSERT_TRUE(reader.isInit()) << reader.getErrorMessage();
+        std::vector<sharedschedule::contextState_t> states;
+        ASSERT_EQ(reader.readAll(states), 2);
+        EXPECT_STREQ(states[0].context, "context1");
+        EXPECT_STREQ(states[0].buttonLabel, "Sothis");
+        EXPECT_STREQ(states[0].routeName, "Indigo Route");
+        EXPECT_EQ(states[0].voyageTime, 1700006400);
+        EXPECT_EQ(states[0].nextVoyageId, 4);
+        EXPECT_STREQ(states[1].context, "context2");
+        EXPECT_STREQ(states[1].imageName, "Stonescale");
+
+        // visiting reads in place, with no copy of the state
+        const char* label = nullptr;
+        EXPECT_TRUE(reader.visit(1, [&label](const sharedschedule::contextState_t& state) { label = state.buttonLabel; }));
+        EXPECT_STREQ(label, "Stonescale");
+    }
+
+    TEST(SchedulePublisherTests, WritesOnlyOnChange) {
+        SchedulePublisher publisher(segmentName);
+        ASSERT_TRUE(publisher.isInit());
+        publisher.publish("context1", makeState("Sothis", 1700006400, 4));
+        const uint64_t changeCount = publisher.getChangeCount();
+
+        ScheduleReader reader(segmentName);
+        ASSERT_TRUE(reader.isInit());
+        EXPECT_EQ(reader.getChangeCount(), changeCount);
+
+        publisher.publish("context1", makeState("Sothis", 1700006400, 4));
+        EXPECT_EQ(reader.getChangeCount(), changeCount);
+        publisher.publish("context1", makeState("Sothis", 1700013600, 4));
+        EXPECT_EQ(reader.getChangeCount(), changeCount + 1);
+
+        sharedschedule::contextState_t state{};
+        ASSERT_TRUE(reader.read(0, state));
+        EXPECT_EQ(state.voyageTime, 1700013600);
+    }
+
+    TEST(SchedulePublisherTests, RemovedContextsFreeTheirSlot) {
+        SchedulePublisher publisher(segmentName);
+        ASSERT_TRUE(publisher.isInit());
+        publisher.publish("context1", makeState("Sothis", 1700006400, 4));
+        publisher.publish("context2", makeState("Stonescale", 1700013600, 5));
+        EXPECT_TRUE(publisher.remove("context1"));
+        EXPECT_FALSE(publisher.remove("context1"));
+
+        ScheduleReader reader(segmentName);
+        ASSERT_TRUE(reader.isInit());
+        std::vector<sharedschedule::contextState_t> states;
+        ASSERT_EQ(reader.readAll(states), 1);
+        EXPECT_STREQ(states[0].context, "context2");
+        sharedschedule::contextState_t state{};
+        EXPECT_FALSE(reader.read(0, state));
+
+        // the next context reuses the freed slot
+        publisher.publish("context3", makeState("Coral Manta", 1700020800, 6));
+        EXPECT_EQ(reader.getSlotCount(), 2);
+        ASSERT_TRUE(reader.read(0, state));
+        EXPECT_STREQ(state.context, "context3");
+    }
+
+    TEST(SchedulePublisherTests, LimitsContextsAndCutsText) {
+        SchedulePublisher publisher(segmentName);
+        ASSERT_TRUE(publisher.isInit());
+        for (uint32_t i = 0; i < sharedschedule::MAX_CONTEXTS; i++)
+            ASSERT_TRUE(publisher.publish("context" + std::to_string(i), makeState("Sothis", 1700006400, 4)));
+        EXPECT_FALSE(publisher.publish("one too many", makeState("Sothis", 1700006400, 4)));
+
+        const std::string longLabel(sharedschedule::NAME_SIZE * 2, 'x');
+        publisher.publish("context0", makeState(longLabel, 1700006400, 4));
+        ScheduleReader reader(segmentName);
+        ASSERT_TRUE(reader.isInit());
+        sharedschedule::contextState_t state{};
+        ASSERT_TRUE(reader.read(0, state));
+        EXPECT_EQ(std::string(state.buttonLabel), longLabel.substr(0, sharedschedule::NAME_SIZE - 1));
+    }
+
+    TEST(SchedulePublisherTests, OnePublisherPerProcess) {
+        SchedulePublisher publisher(segmentName);
+        ASSERT_TRUE(publisher.isInit());
+        SchedulePublisher second(segmentName + "Second");
+        EXPECT_FALSE(second.isInit());
+        EXPECT_FALSE(second.publish("context1", makeState("Sothis", 1700006400, 4)));
+    }
+
+    TEST(SchedulePublisherTests, ReaderNeedsPublishedSegment) {
+        ScheduleReader reader(segmentName + "Missing");
+        EXPECT_FALSE(reader.isInit());
+        EXPECT_EQ(reader.getSlotCount(), 0);
+        sharedschedule::contextState_t state{};
+        EXPECT_FALSE(reader.read(0, state));
+    }
+
+    TEST(SchedulePublisherTests, ReadsAreNeverTorn) {
+        SchedulePublisher publisher(segmentName);
+        ASSERT_TRUE(publisher.isInit());
+        publisher.publish("context1", makeState("0", 0, 0));
+        ScheduleReader reader(segmentName);
+        ASSERT_TRUE(reader.isInit());
+
+        // every state the writer publishes has its label, time and voyage agreeing, a torn read would mix two of them
+        std::atomic<bool> isDone = false;
+        std::thread writer([&]()
+            {
+                for (uint32_t i = 1; i <= 200000; i++)
+                    publisher.publish("context1", makeState(std::to_string(i), i * 7200, i));
+                isDone = true;
+            });
+
+        uint64_t reads = 0;
+        uint64_t tornReads = 0;
+        sharedschedule::contextState_t state{};
+        while (!isDone || reads == 0)
+        {
+            if (!reader.read(0, state))
+                continue;
+            reads++;
+            if (state.voyageTime != static_cast<int64_t>(state.nextVoyageId) * 7200 ||
+                std::string(state.buttonLabel) != std::to_string(state.nextVoyageId) ||
+                std::string(state.imageName) != state.buttonLabel)
+                tornReads++;
+        }
+        writer.join();
+        EXPECT_GT(reads, 0);
+        EXPECT_EQ(tornReads, 0);
+        EXPECT_EQ(publisher.getChangeCount(), 200001);
+    }
+}
@@ -0,0 +1,252 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <sstream>
+#include "../ScheduleQueryRunner.h"
+#include "../VirtualClock.h"
+
+namespace ScheduleQueryRunnerTests
+{
+    const time_t startTime = 1700000000;
+    const time_t week = 7 * 24 * 60 * 60;
+
+    class ScheduleQueryRunnerTestFixture : public ::testing::Test
+    {
+    protected:
+        FFXIVOceanFishingHelper mHelper = FFXIVOceanFishingHelper({
+            "../../com.elgato.ffxivoceanfishing.sdPlugin/oceanFishingDatabase - Indigo Route.json",
+            "../../com.elgato.ffxivoceanfishing.sdPlugin/oceanFishingDatabase - Ruby Route.json"
+        });
+        const ScheduleQueryRunner::query_t mSothis = { "Indigo Route", "Blue Fish", "Sothis", 0 };
+    };
+
+    TEST_F(ScheduleQueryRunnerTestFixture, ListsWindowsInRange) {
+        ScheduleQueryRunner runner(mHelper, startTime, startTime + week);
+        std::vector<ScheduleQueryRunner::window_t> windows;
+        ASSERT_TRUE(runner.run(windows, mSothis));
+        ASSERT_GT(windows.size(), 1);
+
+        const std::unordered_set<uint32_t> voyageIds = mHelper.getVoyageIdByTracker(mSothis.routeName, mSothis.tracker, mSothis.name);
+        time_t previousEnd = startTime;
+        for (const ScheduleQueryRunner::window_t& window : windows)
+        {
+            EXPECT_GT(window.start, previousEnd);
+            EXPECT_LT(window.start, startTime + week);
+            EXPECT_EQ(window.end - window.start, ScheduleQueryRunner::WINDOW_SECONDS);
+            EXPECT_EQ(window.label, "Sothis");
+            EXPECT_TRUE(voyageIds.contains(window.voyageId));
+
+            // a button tracking the target a minute into the window is in it, and was not a second before it opened
+            uint32_t secondsTillNextVoyage = 0;
+            uint32_t secondsLeftInWindow = 0;
+            mHelper.getSecondsUntilNextVoyage(secondsTillNextVoyage, secondsLeftInWindow, window.start + 60, voyageIds, mSothis.routeName);
+            EXPECT_EQ(secondsLeftInWindow, ScheduleQueryRunner::WINDOW_SECONDS - 60);
+            mHelper.getSecondsUntilNextVoyage(secondsTillNextVoyage, secondsLeftInWindow, window.start - 1, voyageIds, mSothis.routeName);
+            EXPECT_EQ(secondsTillNextVoyage, 1);
+            previousEnd = window.end;
+        }
+
+        // no window was passed over between the last one and the end of the range
+        uint32_t secondsTillNextVoyage = 0;
+        uint32_t secondsLeftInWindow = 0;
+        mHelper.getSecondsUntilNextVoyage(secondsTillNextVoyage, secondsLeftInWindow, previousEnd + 1, voyageIds, mSothis.routeName);
+        EXPECT_GE(previousEnd + 1 + secondsTillNextVoyage, startTime + week);
+    }
+
+    TEST_F(ScheduleQueryRunnerTestFixture, IncludesWindowOpenAtStart) {
+        ScheduleQueryRunner weekRunner(mHelper, startTime, startTime + week);
+        std::vector<ScheduleQueryRunner::window_t> windows;
+        weekRunner.run(windows, mSothis);
+        ASSERT_FALSE(windows.empty());
+
+        const time_t from = windows[0].start + 5 * 60;
+        ScheduleQueryRunner runner(mHelper, from, from + week);
+        std::vector<ScheduleQueryRunner::window_t> openWindows;
+        runner.run(openWindows, mSothis);
+        ASSERT_FALSE(openWindows.empty());
+        EXPECT_EQ(openWindows[0].start, windows[0].start);
+    }
+
+    TEST_F(ScheduleQueryRunnerTestFixture, SkipsFirstWindows) {
+        ScheduleQueryRunner runner(mHelper, startTime, startTime + week);
+        std::vector<ScheduleQueryRunner::window_t> windows;
+        runner.run(windows, mSothis);
+        ScheduleQueryRunner::query_t skipped = mSothis;
+        skipped.skips = 2;
+        std::vector<ScheduleQueryRunner::window_t> skippedWindows;
+        runner.run(skippedWindows, skipped);
+
+        ASSERT_EQ(skippedWindows.size() + 2, windows.size());
+        for (size_t i = 0; i < skippedWindows.size(); i++)
+            EXPECT_EQ(skippedWindows[i].start, windows[i + 2].start);
+    }
+
+    TEST_F(ScheduleQueryRunnerTestFixture, LimitsWindowsPerQuery) {
+        ScheduleQueryRunner runner(mHelper, startTime, startTime + week, 2);
+        std::vector<ScheduleQueryRunner::window_t> windows;
+        runner.run(windows, mSothis);
+        EXPECT_EQ(windows.size(), 2);
+    }
+
+    TEST_F(ScheduleQueryRunnerTestFixture, ReportsUnknownTargets) {
+        ScheduleQueryRunner runner(mHelper, startTime, startTime + week);
+        std::vector<ScheduleQueryRunner::window_t> windows;
+        EXPECT_FALSE(runner.run(windows, { "Indigo Route", "Blue Fish", "Not A Fish", 0 }));
+        EXPECT_FALSE(runner.run(windows, { "Not A Route", "Blue Fish", "Sothis", 0 }));
+        EXPECT_TRUE(windows.empty());
+    }
+
+    TEST_F(ScheduleQueryRunnerTestFixture, WritesSameOutputOnAnyThreadCount) {
+        ScheduleQueryRunner runner(mHelper, startTime, startTime + week);
+        std::vector<ScheduleQueryRunner::query_t> queries;
+        for (uint32_t skips = 0; skips < 20; skips++)
+            for (ScheduleQueryRunner::query_t query : runner.getAllTargetQueries())
+            {
+                query.skips = skips;
+                queries.push_back(query);
+            }
+        queries.push_back({ "Indigo Route", "Blue Fish", "Not A Fish", 0 });
+        ASSERT_GT(queries.size(), ScheduleQueryRunner::MAX_PENDING_QUERIES);
+
+        std::ostringstream single;
+        const ScheduleQueryRunner::batchStats_t singleStats = runner.runBatch(single, queries, ScheduleQueryRunner::FORMAT::CSV, 1);
+        std::ostringstream multiple;
+        const ScheduleQueryRunner::batchStats_t multipleStats = runner.runBatch(multiple, queries, ScheduleQueryRunner::FORMAT::CSV, 8);
+
+        EXPECT_EQ(single.str(), multiple.str());
+        EXPECT_EQ(singleStats.queries, queries.size());
+        EXPECT_EQ(singleStats.unmatched, 1);
+        EXPECT_GT(singleStats.windows, queries.size());
+        EXPECT_EQ(multipleStats.unmatched, singleStats.unmatched);
+        EXPECT_EQ(multipleStats.windows, singleStats.windows);
+        EXPECT_EQ(multipleStats.bytes, singleStats.bytes);
+    }
+
+    TEST_F(ScheduleQueryRunnerTestFixture, WritesCsvAndJsonLines) {
+        const ScheduleQueryRunner::query_t query = { "Indigo Route", "Achievement", "Say \"Fish\", Again", 1 };
+        const std::vector<ScheduleQueryRunner::window_t> windows = { { 1700006400, 1700007300, 4, "Label", "Image" } };
+
+        std::string csv;
+        ScheduleQueryRunner::appendWindows(csv, query, windows, ScheduleQueryRunner::FORMAT::CSV);
+        EXPECT_EQ(csv, "Indigo Route,Achievement,\"Say \"\"Fish\"\", Again\",1,0,4,1700006400,1700007300,2023-11-15T00:00:00Z,Label,Image\n");
+
+        std::string lines;
+        ScheduleQueryRunner::appendWindows(lines, query, windows, ScheduleQueryRunner::FORMAT::JSON);
+        ASSERT_EQ(lines.back(), '\n');
+        const json line = json::parse(lines);
+        EXPECT_EQ(line["name"], query.name);
+        EXPECT_EQ(line["skips"], 1);
+        EXPECT_EQ(line["voyageId"], 4);
+        EXPECT_EQ(line["start"], 1700006400);
+        EXPECT_EQ(line["startUtc"], "2023-11-15T00:00:00Z");
+        EXPECT_EQ(line["image"], "Image");
+    }
+
+    TEST_F(ScheduleQueryRunnerTestFixture, WritesIcsEvents) {
+        const ScheduleQueryRunner::query_t query = { "Indigo Route", "Achievement", "Say \"Fish\", Again; Twice", 1 };
+        const std::vector<ScheduleQueryRunner::window_t> windows = { { 1700006400, 1700007300, 4, "Label", "Image" } };
+
+        std::string ics;
+        ScheduleQueryRunner::appendWindows(ics, query, windows, ScheduleQueryRunner::FORMAT::ICS, 1700000000);
+        EXPECT_EQ(ics,
+            "BEGIN:VEVENT\r\n"
+            "UID:1700006400-Indigo Route/Achievement/Say \"Fish\"\\, Again\\; Twice@ffxivoce\r\n"
+            " anfishing\r\n"
+            "DTSTAMP:20231114T221320Z\r\n"
+            "DTSTART:20231115T000000Z\r\n"
+            "DTEND:20231115T001500Z\r\n"
+            "SUMMARY:Say \"Fish\"\\, Again\\; Twice (Label)\r\n"
+            "DESCRIPTION:Indigo Route\\, Achievement: Say \"Fish\"\\, Again\\; Twice\\nVoyage \r\n"
+            " 4\r\n"
+            "CATEGORIES:Achievement\r\n"
+            "TRANSP:TRANSPARENT\r\n"
+            "END:VEVENT\r\n");
+    }
+
+    TEST_F(ScheduleQueryRunnerTestFixture, FoldsIcsLinesBetweenCharacters) {
+        // 3 octet characters, so a line of 75 octets would end inside one
+        std::string name;
+        for (int i = 0; i < 60; i++)
+            name += "\xE6\xB5\xB7";
+        const ScheduleQueryRunner::query_t query = { "Indigo Route", "Blue Fish", name, 0 };
+        const std::vector<ScheduleQueryRunner::window_t> windows = { { 1700006400, 1700007300, 4, name, "Image" } };
+
+        std::string ics;
+        ScheduleQueryRunner::appendWindows(ics, query, windows, ScheduleQueryRunner::FORMAT::ICS, 1700000000);
+        std::string unfolded;
+        for (size_t start = 0; start < ics.size();)
+        {
+            const size_t end = ics.find("\r\n", start);
+            ASSERT_NE(end, std::string::npos);
+            EXPECT_LE(end - start, 75);
+            EXPECT_NE(static_cast<unsigned char>(ics[start]) & 0xC0, 0x80);
+            const bool isFolded = ics[start] == ' ';
+            if (!isFolded && !unfolded.empty())
+                unfolded += '\n';
+            unfolded.append(ics, start + (isFolded ? 1 : 0), end - start - (isFolded ? 1 : 0));
+            start = end + 2;
+        }
+        EXPECT_NE(unfolded.find("\nSUMMARY:" + name + "\n"), std::string::npos);
+    }
+
+    // events are stamped with when the calendar was written, not with the start of its range
+    TEST_F(ScheduleQueryRunnerTestFixture, WritesIcsCalendar) {
+        VirtualClock clock(startTime - week); // 2023-11-07 22:13:20 UTC
+        ScheduleQueryRunner runner(mHelper, startTime, startTime + week, UINT32_MAX, PRIORITY::BLUE_FISH, clock);
+        const std::vector<ScheduleQueryRunner::query_t> queries = runner.getAllTargetQueries();
+
+        std::ostringstream single;
+        const ScheduleQueryRunner::batchStats_t stats = runner.runBatch(single, queries, ScheduleQueryRunner::FORMAT::ICS, 1);
+        std::ostringstream multiple;
+        runner.runBatch(multiple, queries, ScheduleQueryRunner::FORMAT::ICS, 8);
+        const std::string calendar = single.str();
+        EXPECT_EQ(calendar, multiple.str());
+
+        EXPECT_EQ(calendar.rfind("BEGIN:VCALENDAR\r\nVERSION:2.0\r\n", 0), 0);
+        EXPECT_TRUE(calendar.ends_with("\r\nEND:VEVENT\r\nEND:VCALENDAR\r\n"));
+        size_t events = 0;
+        for (size_t position = calendar.find("BEGIN:VEVENT\r\n"); position != std::string::npos; position = calendar.find("BEGIN:VEVENT\r\n", position + 1))
+            events++;
+        EXPECT_EQ(events, stats.windows);
+        size_t stamps = 0;
+        for (size_t position = calendar.find("\r\nDTSTAMP:"); position != std::string::npos; position = calendar.find("\r\nDTSTAMP:", position + 1))
+        {
+            EXPECT_EQ(calendar.compare(position, 28, "\r\nDTSTAMP:20231107T221320Z\r\n"), 0);
+            stamps++;
+        }
+        EXPECT_EQ(stamps, events);
+        EXPECT_EQ(std::count(calendar.begin(), calendar.end(), '\n'), std::count(calendar.begin(), calendar.end(), '\r'));
+    }
+
+    TEST(ScheduleQueryRunnerParseTests, ParsesQueries) {
+        const std::optional<ScheduleQueryRunner::query_t> query = ScheduleQueryRunner::parseQuery("Indigo Route,Blue Fish,Sothis");
+        ASSERT_TRUE(query.has_value());
+        EXPECT_EQ(query->routeName, "Indigo Route");
+        EXPECT_EQ(query->tracker, "Blue Fish");
+        EXPECT_EQ(query->name, "Sothis");
+        EXPECT_EQ(query->skips, 0);
+
+        const std::optional<ScheduleQueryRunner::query_t> quoted = ScheduleQueryRunner::parseQuery("Ruby Route,Achievement,\"Say \"\"Fish\"\", Again\",3\r");
+        ASSERT_TRUE(quoted.has_value());
+        EXPECT_EQ(quoted->name, "Say \"Fish\", Again");
+        EXPECT_EQ(quoted->skips, 3);
+
+        EXPECT_FALSE(ScheduleQueryRunner::parseQuery("Indigo Route,Blue Fish").has_value());
+        EXPECT_FALSE(ScheduleQueryRunner::parseQuery("Indigo Route,Blue Fish,Sothis,one").has_value());
+        EXPECT_FALSE(ScheduleQueryRunner::parseQuery("Indigo Route,Blue Fish,\"Sothis").has_value());
+        EXPECT_FALSE(ScheduleQueryRunner::parseQuery("Indigo Route,Blue Fish,Sothis,1,2").has_value());
+    }
+
+    TEST(ScheduleQueryRunnerParseTests, ParsesTimes) {
+        EXPECT_EQ(ScheduleQueryRunner::parseTime("1700000000"), 1700000000);
+        EXPECT_EQ(ScheduleQueryRunner::parseTime("2023-11-14"), 1699920000);
+        EXPECT_EQ(ScheduleQueryRunner::parseTime("2023-11-14T22:13:20Z"), 1700000000);
+        EXPECT_EQ(ScheduleQueryRunner::parseTime("2023-11-14T22:13"), 1699999980);
+        EXPECT_EQ(ScheduleQueryRunner::parseTime("2024-02-29T00:00Z"), 1709164800);
+        EXPECT_FALSE(ScheduleQueryRunner::parseTime("").has_value());
+        EXPECT_FALSE(ScheduleQueryRunner::parseTime("2023-13-01").has_value());
+        EXPECT_FALSE(ScheduleQueryRunner::parseTime("2023-11-14T25:00").has_value());
+        EXPECT_FALSE(ScheduleQueryRunner::parseTime("yesterday").has_value());
+    }
+}
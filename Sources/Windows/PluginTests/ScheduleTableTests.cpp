@@ -0,0 +1,119 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include "../FFXIVOceanFishingHelper.h"
+
+namespace ScheduleTableTests
+{
+    const time_t startTime = 1700000000;
+    const time_t week = 7 * 24 * 60 * 60;
+
+    class ScheduleTableTestFixture : public ::testing::Test
+    {
+    protected:
+        FFXIVOceanFishingHelper mHelper = FFXIVOceanFishingHelper({
+            "../../com.elgato.ffxivoceanfishing.sdPlugin/oceanFishingDatabase - Indigo Route.json",
+            "../../com.elgato.ffxivoceanfishing.sdPlugin/oceanFishingDatabase - Ruby Route.json"
+        });
+    };
+
+    TEST_F(ScheduleTableTestFixture, MatchesProcessorForEveryTarget) {
+        const std::unordered_map<std::string, ScheduleTable> tables = mHelper.buildScheduleTables(startTime, startTime + 8 * week);
+        ASSERT_EQ(tables.size(), 2);
+
+        std::vector<time_t> times;
+        for (const auto& [routeName, table] : tables)
+        {
+            ASSERT_GT(table.getTargetCount(), 0);
+            const json targets = mHelper.getTargetsJson(routeName);
+            for (const auto& [name, trackerJson] : targets.items())
+            {
+                const std::string tracker = trackerJson;
+                const std::unordered_set<uint32_t> voyageIds = mHelper.getVoyageIdByTracker(routeName, tracker, name);
+                EXPECT_GT(table.getOccurrenceCount(tracker, name), 0) << routeName << " " << tracker << " " << name;
+
+                // every 997 seconds over a week lands both in and out of windows
+                for (time_t t = startTime; t < startTime + week; t += 997)
+                {
+                    // the processor reports neither seconds left nor the window's departure on the second a window closes
+                    if ((t - ScheduleTable::WINDOW_SECONDS) % ScheduleTable::VOYAGE_INTERVAL == 0)
+                        continue;
+
+                    table.getNextOccurrences(times, tracker, name, t, 6);
+                    for (uint32_t skips = 0; skips < 5; skips++)
+                    {
+                        uint32_t secondsTillNextVoyage = 0;
+                        uint32_t secondsLeftInWindow = 0;
+                        if (!mHelper.getSecondsUntilNextVoyage(secondsTillNextVoyage, secondsLeftInWindow, t, voyageIds, routeName, skips))
+                            continue;
+
+                        ASSERT_GT(times.size(), skips) << routeName << " " << tracker << " " << name;
+                        if (secondsLeftInWindow > 0)
+                        {
+                            ASSERT_GT(times.size(), skips + 1);
+                            EXPECT_EQ(times[skips], t + secondsLeftInWindow - ScheduleTable::WINDOW_SECONDS);
+                            EXPECT_EQ(times[skips + 1], t + secondsTillNextVoyage);
+                        }
+                        else
+                            EXPECT_EQ(times[skips], t + secondsTillNextVoyage);
+                    }
+                }
+            }
+        }
+    }
+
+    TEST_F(ScheduleTableTestFixture, LooksUpFromBeforeAndAfterCheckpoints) {
+        const ScheduleTable table = mHelper.buildScheduleTables(startTime, startTime + 52 * week).at("Indigo Route");
+        const size_t count = table.getOccurrenceCount("Blue Fish", "Sothis");
+        ASSERT_GT(count, 4 * ScheduleTable::CHECKPOINT_INTERVAL);
+
+        std::vector<time_t> all;
+        ASSERT_EQ(table.getNextOccurrences(all, "Blue Fish", "Sothis", startTime, count), count);
+        for (size_t i = 1; i < all.size(); i++)
+            EXPECT_GT(all[i], all[i - 1]);
+
+        // looking up from any departure, or just after one, starts at that voyage or the one after
+        std::vector<time_t> times;
+        for (size_t i = 0; i + 1 < all.size(); i++)
+        {
+            ASSERT_EQ(table.getNextOccurrences(times, "Blue Fish", "Sothis", all[i], 2), 2);
+            EXPECT_EQ(times[0], all[i]);
+            EXPECT_EQ(times[1], all[i + 1]);
+            table.getNextOccurrences(times, "Blue Fish", "Sothis", all[i] + ScheduleTable::WINDOW_SECONDS + 1, 1);
+            EXPECT_EQ(times[0], all[i + 1]);
+        }
+    }
+
+    TEST_F(ScheduleTableTestFixture, StopsAtEndOfHorizon) {
+        const ScheduleTable table = mHelper.buildScheduleTables(startTime, startTime + week).at("Indigo Route");
+        EXPECT_EQ(table.getEnd(), startTime + week);
+        EXPECT_LE(table.getStart(), startTime);
+
+        std::vector<time_t> times;
+        const size_t count = table.getNextOccurrences(times, "Blue Fish", "Sothis", startTime, 1000);
+        EXPECT_EQ(count, table.getOccurrenceCount("Blue Fish", "Sothis"));
+        ASSERT_FALSE(times.empty());
+        EXPECT_LT(times.back(), startTime + week);
+        EXPECT_EQ(table.getNextOccurrences(times, "Blue Fish", "Sothis", startTime + 2 * week, 1), 0);
+        EXPECT_TRUE(times.empty());
+    }
+
+    TEST_F(ScheduleTableTestFixture, IgnoresUnknownTargets) {
+        const ScheduleTable table = mHelper.buildScheduleTables(startTime, startTime + week).at("Indigo Route");
+        std::vector<time_t> times = { startTime };
+        EXPECT_EQ(table.getNextOccurrences(times, "Blue Fish", "Not A Fish", startTime, 1), 0);
+        EXPECT_TRUE(times.empty());
+        EXPECT_EQ(table.getOccurrenceCount("Not A Tracker", "Sothis"), 0);
+        EXPECT_EQ(table.getMemoryBytes("Blue Fish", "Not A Fish"), 0);
+    }
+
+    TEST_F(ScheduleTableTestFixture, KeepsAbout1ByteAVoyage) {
+        const ScheduleTable table = mHelper.buildScheduleTables(startTime, startTime + 52 * week).at("Indigo Route");
+        const size_t count = table.getOccurrenceCount("Blue Fish", "Sothis");
+        const size_t bytes = table.getMemoryBytes("Blue Fish", "Sothis");
+        EXPECT_GE(bytes, count - 1);
+        EXPECT_LT(bytes, count * 2 + 256);
+        EXPECT_GE(table.getMemoryBytes(), bytes);
+    }
+}
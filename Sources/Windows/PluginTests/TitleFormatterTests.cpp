@@ -0,0 +1,93 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <tuple>
+#include "../TitleFormatter.h"
+#include "../TimeUtils.hpp"
+
+namespace TitleFormatterTests
+{
+    class ConvertSecondsToHMSStringTestFixture :
+        public ::testing::TestWithParam<::testing::tuple<int, std::string>> {
+    };
+
+    INSTANTIATE_TEST_CASE_P(
+        ConvertSecondsToHMSStringTests,
+        ConvertSecondsToHMSStringTestFixture,
+        ::testing::Values(
+            std::make_tuple(0, "0m0s"),
+            std::make_tuple(59, "0m59s"),
+            std::make_tuple(61, "1m1s"),
+            std::make_tuple(3600, "1h0m0s"),
+            std::make_tuple(7199, "1h59m59s"),
+            std::make_tuple(36000 + 61, "10h1m1s"),
+            std::make_tuple(-61, "1m1s")
+        )
+    );
+
+    TEST_P(ConvertSecondsToHMSStringTestFixture, ConvertSecondsToHMSString) {
+        const auto& [seconds, expectedResult] = GetParam();
+        EXPECT_EQ(timeutils::convertSecondsToHMSString(seconds), expectedResult);
+    }
+
+    TEST(TitleFormatterTests, DateStringMatchesLocalTime) {
+        const time_t t = 1700000000;
+        struct tm localTime {};
+        localtime_s(&localTime, &t);
+
+        timeutils::date_t date{};
+        ASSERT_TRUE(timeutils::convertTimeToDate(date, t));
+        EXPECT_EQ(date.day, static_cast<uint32_t>(localTime.tm_mday));
+        EXPECT_EQ(date.year, static_cast<uint32_t>(localTime.tm_year + 1900));
+        EXPECT_EQ(date.time24H.length(), 8);
+        EXPECT_EQ(date.time12H.length(), 7);
+        EXPECT_EQ(date.time24H.substr(3, 2), date.time12H.substr(3, 2));
+
+        char buffer[32];
+        char* end = timeutils::writeDateString(buffer, buffer + sizeof(buffer), t, true);
+        ASSERT_NE(end, nullptr);
+        EXPECT_EQ(std::string(buffer, end), date.weekday + " " + date.month + " " + std::to_string(date.day) + "\n" + date.time24H);
+
+        end = timeutils::writeDateString(buffer, buffer + sizeof(buffer), t, false);
+        ASSERT_NE(end, nullptr);
+        EXPECT_EQ(std::string(buffer, end), date.weekday + " " + date.month + " " + std::to_string(date.day) + "\n" + date.time12H);
+    }
+
+    TEST(TitleFormatterTests, CountdownTitle) {
+        TitleFormatter formatter;
+        const time_t now = 1000000;
+        EXPECT_EQ(formatter.format("Label", 0, 0, now + 3661, false, false, now), "Label\n\n\n\n\n1h1m1s");
+        EXPECT_EQ(formatter.format("Label", 2, 0, now + 61, false, false, now), "Label\n               2\n\n\n\n1m1s");
+    }
+
+    TEST(TitleFormatterTests, WindowTitle) {
+        TitleFormatter formatter;
+        const time_t now = 1000000;
+        EXPECT_EQ(formatter.format("Label", 0, now + 600, now + 7200, false, false, now), "Label\n\nWindow ends:\n10m0s\n\n2h0m0s");
+        // windows longer than 15 minutes are not displayed
+        EXPECT_EQ(formatter.format("Label", 0, now + 901, now + 7200, false, false, now), "Label\n\n\n\n\n2h0m0s");
+    }
+
+    TEST(TitleFormatterTests, DateTitle) {
+        TitleFormatter formatter;
+        const time_t now = 1700000000;
+        const time_t voyageTime = now + 7200;
+
+        char buffer[32];
+        for (bool is24H : { false, true, false })
+        {
+            char* end = timeutils::writeDateString(buffer, buffer + sizeof(buffer), voyageTime, is24H);
+            ASSERT_NE(end, nullptr);
+            EXPECT_EQ(formatter.format("Label", 0, 0, voyageTime, true, is24H, now), "Label\n\n\n\n" + std::string(buffer, end));
+        }
+    }
+
+    TEST(TitleFormatterTests, LongLabelIsTruncated) {
+        TitleFormatter formatter;
+        const std::string label(1000, 'A');
+        const std::string_view title = formatter.format(label, 0, 0, 0, false, false, 0);
+        EXPECT_LT(title.length(), label.length());
+        EXPECT_EQ(title, label.substr(0, title.length()));
+    }
+}
@@ -0,0 +1,117 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <atomic>
+#include <filesystem>
+#include "../CallBackTimer.h"
+#include "../VirtualClock.h"
+#include "../PluginSimulator.h"
+#include "../FFXIVOceanFishingHelper.h"
+
+namespace VirtualClockTests
+{
+    const std::string pluginDirectory = "../../com.elgato.ffxivoceanfishing.sdPlugin/";
+
+    // 2023-01-01 01:00:00 UTC, an hour before a voyage leaves
+    const time_t START_TIME = 1672534800;
+
+    TEST(VirtualClockTests, StandsStillUntilAdvanced) {
+        VirtualClock clock(START_TIME);
+        EXPECT_EQ(clock.now(), START_TIME);
+        const std::chrono::steady_clock::time_point start = clock.steadyNow();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_EQ(clock.now(), START_TIME);
+
+        clock.advance(std::chrono::milliseconds(2500));
+        EXPECT_EQ(clock.now(), START_TIME + 2);
+        EXPECT_EQ(clock.steadyNow() - start, std::chrono::milliseconds(2500));
+        EXPECT_EQ(clock.getWakeups(), 0);
+    }
+
+    TEST(VirtualClockTests, RunsIntervalTimerOnEveryTick) {
+        VirtualClock clock(START_TIME);
+        std::atomic<int> calls = 0;
+        std::vector<time_t> times;
+        CallBackTimer timer(clock);
+        timer.start(500, [&]() { times.push_back(clock.now()); calls++; });
+
+        // called straight away, then every 500ms, without waiting 5s
+        const auto wallStart = std::chrono::steady_clock::now();
+        clock.advance(std::chrono::seconds(5));
+        EXPECT_LT(std::chrono::steady_clock::now() - wallStart, std::chrono::seconds(2));
+        EXPECT_EQ(calls, 11);
+        EXPECT_EQ(times.back(), START_TIME + 5);
+
+        timer.stop();
+        clock.advance(std::chrono::seconds(5));
+        EXPECT_EQ(calls, 11);
+    }
+
+    TEST(VirtualClockTests, RunsTimerAtTheTimeItPicks) {
+        VirtualClock clock(START_TIME);
+        std::vector<time_t> times;
+        CallBackTimer timer(clock);
+        timer.start([&]() -> std::optional<time_t>
+            {
+                times.push_back(clock.now());
+                return clock.now() + 60;
+            });
+
+        clock.advance(std::chrono::minutes(10));
+        ASSERT_EQ(times.size(), 11);
+        for (size_t i = 0; i < times.size(); i++)
+            EXPECT_EQ(times[i], START_TIME + static_cast<time_t>(i) * 60);
+    }
+
+    // a wake with a settle time runs the function once the wakes have been quiet for that long in virtual time
+    TEST(VirtualClockTests, WakesAndSettles) {
+        VirtualClock clock(START_TIME);
+        std::vector<std::chrono::steady_clock::time_point> times;
+        CallBackTimer timer(clock);
+        const std::chrono::steady_clock::time_point start = clock.steadyNow();
+        timer.start([&]() -> std::optional<time_t>
+            {
+                times.push_back(clock.steadyNow());
+                return clock.now() + 3600;
+            });
+        clock.advance(std::chrono::seconds(1));
+        ASSERT_EQ(times.size(), 1);
+
+        timer.wake(std::chrono::milliseconds(50));
+        clock.advance(std::chrono::milliseconds(20));
+        timer.wake(std::chrono::milliseconds(50));
+        clock.advance(std::chrono::seconds(1));
+        ASSERT_EQ(times.size(), 2);
+        EXPECT_EQ(times[1] - start, std::chrono::milliseconds(1070));
+    }
+
+    // the plugin only reads the clock it was given, so hours of voyages take seconds
+    TEST(VirtualClockTests, SimulatesPluginHours) {
+        const std::filesystem::path previous = std::filesystem::current_path();
+        std::filesystem::current_path(pluginDirectory);
+        {
+            FFXIVOceanFishingHelper helper({ "oceanFishingDatabase - Indigo Route.json", "oceanFishingDatabase - Ruby Route.json" });
+            json routeTargets;
+            for (const std::string route : helper.getRouteNames())
+                routeTargets[route] = helper.getTargetsJson(route);
+            const std::vector<streamdecksession::button_t> buttons = streamdecksession::makeButtons(4, routeTargets);
+
+            PluginSimulator simulator(buttons, START_TIME);
+            EXPECT_EQ(simulator.getTransport().getStats().titledContexts, buttons.size());
+
+            simulator.run(std::chrono::hours(6));
+            const PluginSimulator::simulationStats_t stats = simulator.getStats();
+            EXPECT_EQ(simulator.now(), START_TIME + 1 + 6 * 60 * 60);
+            EXPECT_EQ(stats.simulated, std::chrono::hours(6));
+            EXPECT_EQ(stats.voyages, 3);
+
+            // every button's title is set on every half second tick
+            EXPECT_GE(stats.messages, buttons.size() * 2 * 6 * 60 * 60);
+            EXPECT_GT(stats.timerWakeups, 2 * 6 * 60 * 60);
+            EXPECT_LT(stats.wallSeconds, 6 * 60 * 60 / 100.0);
+        }
+        std::filesystem::current_path(previous);
+    }
+}
@@ -0,0 +1,224 @@
+//==============================================================================
+/**
+@file       PluginTracer.cpp
+@brief      Records spans of what each of the plugin's threads is doing, written as a Chrome trace
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "PluginTracer.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+	std::atomic<uint32_t> gNextThreadId = 1;
+
+	// small ids are easier to read in the trace viewer than the os thread ids
+	thread_local const uint32_t tThreadId = gNextThreadId.fetch_add(1, std::memory_order_relaxed);
+
+	// the name last given to this thread, so renaming it the same each tick does not lock
+	thread_local const char* tThreadName = nullptr;
+
+	// writes nanoseconds as the microseconds the trace format uses
+	void writeMicroseconds(std::ostream& output, const uint64_t nanoseconds)
+	{
+		output << nanoseconds / 1000 << '.' << std::setw(3) << std::setfill('0') << nanoseconds % 1000;
+	}
+}
+
+PluginTracer& PluginTracer::get()
+{
+	static PluginTracer tracer;
+	return tracer;
+}
+
+/**
+	@brief gets the buffer of the calling thread, handing it one on its first span and giving it back when the thread exits
+
+	@return the buffer, or nullptr if every buffer is taken
+**/
+PluginTracer::threadBuffer_t* PluginTracer::getThreadBuffer()
+{
+	struct threadHandle_t
+	{
+		threadBuffer_t* buffer = nullptr;
+		~threadHandle_t()
+		{
+			if (buffer != nullptr)
+				buffer->isInUse.store(false, std::memory_order_release);
+		}
+	};
+	thread_local threadHandle_t tHandle;
+
+	if (tHandle.buffer != nullptr)
+		return tHandle.buffer;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (const std::unique_ptr<threadBuffer_t>& buffer : mBuffers)
+	{
+		if (!buffer->isInUse.load(std::memory_order_acquire))
+		{
+			buffer->isInUse.store(true, std::memory_order_relaxed);
+			tHandle.buffer = buffer.get();
+			return tHandle.buffer;
+		}
+	}
+	if (mBuffers.size() >= MAX_THREADS)
+		return nullptr;
+
+	mBuffers.push_back(std::make_unique<threadBuffer_t>());
+	mBuffers.back()->isInUse.store(true, std::memory_order_relaxed);
+	tHandle.buffer = mBuffers.back().get();
+	return tHandle.buffer;
+}
+
+/**
+	@brief forgets every span recorded so far
+**/
+void PluginTracer::clear()
+{
+	mClearedAt.store(now(), std::memory_order_relaxed);
+	mDropped.store(0, std::memory_order_relaxed);
+}
+
+/**
+	@brief adds a span to the calling thread's buffer, overwriting its oldest span once full
+
+	@param[in] name what the span is, must be a string literal
+	@param[in] category which part of the plugin it belongs to, must be a string literal
+	@param[in] startNanoseconds when it started, from now()
+	@param[in] endNanoseconds when it ended, from now()
+**/
+void PluginTracer::record(const char* name, const char* category, const uint64_t startNanoseconds, const uint64_t endNanoseconds)
+{
+	threadBuffer_t* buffer = getThreadBuffer();
+	if (buffer == nullptr)
+	{
+		mDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	const uint64_t written = buffer->written.load(std::memory_order_relaxed);
+	slot_t& slot = buffer->slots[written % EVENTS_PER_THREAD];
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.category.store(category, std::memory_order_relaxed);
+	slot.startNanoseconds.store(startNanoseconds, std::memory_order_relaxed);
+	slot.durationNanoseconds.store(endNanoseconds - startNanoseconds, std::memory_order_relaxed);
+	slot.threadId.store(tThreadId, std::memory_order_relaxed);
+	buffer->written.store(written + 1, std::memory_order_release);
+}
+
+/**
+	@brief names the calling thread in the trace, cheap to call repeatedly with the same name
+
+	@param[in] name the thread's name, must be a string literal
+**/
+void PluginTracer::nameThread(const char* name)
+{
+	if (tThreadName == name)
+		return;
+	tThreadName = name;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mThreadNames[tThreadId] = name;
+}
+
+/**
+	@brief reads the spans kept since the last clear, while threads may still be recording
+
+	@return the spans, in order of when they started
+**/
+std::vector<PluginTracer::traceEvent_t> PluginTracer::getEvents() const
+{
+	const uint64_t clearedAt = mClearedAt.load(std::memory_order_relaxed);
+	std::vector<traceEvent_t> events;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	for (const std::unique_ptr<threadBuffer_t>& buffer : mBuffers)
+	{
+		const uint64_t written = buffer->written.load(std::memory_order_acquire);
+		const uint64_t first = (written > EVENTS_PER_THREAD) ? written - EVENTS_PER_THREAD : 0;
+		const size_t copied = events.size();
+		for (uint64_t i = first; i < written; i++)
+		{
+			const slot_t& slot = buffer->slots[i % EVENTS_PER_THREAD];
+			traceEvent_t event;
+			event.name = slot.name.load(std::memory_order_relaxed);
+			event.category = slot.category.load(std::memory_order_relaxed);
+			event.startNanoseconds = slot.startNanoseconds.load(std::memory_order_relaxed);
+			event.durationNanoseconds = slot.durationNanoseconds.load(std::memory_order_relaxed);
+			event.threadId = slot.threadId.load(std::memory_order_relaxed);
+			events.push_back(event);
+		}
+
+		// the owner may have kept recording while this was read, drop whatever it overwrote or may be part way through overwriting.
+		// No thread can take an unused buffer while the lock is held
+		const uint64_t writtenAfter = buffer->written.load(std::memory_order_acquire) + (buffer->isInUse.load(std::memory_order_acquire) ? 1 : 0);
+		const uint64_t firstIntact = (writtenAfter > EVENTS_PER_THREAD) ? writtenAfter - EVENTS_PER_THREAD : 0;
+		if (firstIntact > first)
+		{
+			const size_t overwritten = static_cast<size_t>((std::min)(firstIntact - first, written - first));
+			events.erase(events.begin() + copied, events.begin() + copied + overwritten);
+		}
+	}
+	lock.unlock();
+
+	events.erase(
+		std::remove_if(events.begin(), events.end(), [clearedAt](const traceEvent_t& event) { return event.startNanoseconds < clearedAt; }),
+		events.end()
+	);
+	std::sort(events.begin(), events.end(), [](const traceEvent_t& a, const traceEvent_t& b) { return a.startNanoseconds < b.startNanoseconds; });
+	return events;
+}
+
+/**
+	@brief writes the spans kept as a Chrome trace, one complete event per span and a name for each named thread
+
+	@param[in] output where to write the trace
+**/
+void PluginTracer::write(std::ostream& output) const
+{
+	const std::vector<traceEvent_t> events = getEvents();
+
+	output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool isFirst = true;
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		for (const auto& [threadId, name] : mThreadNames)
+		{
+			output << (isFirst ? "\n" : ",\n");
+			output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId << ",\"args\":{\"name\":\"" << name << "\"}}";
+			isFirst = false;
+		}
+	}
+	for (const traceEvent_t& event : events)
+	{
+		output << (isFirst ? "\n" : ",\n");
+		output << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadId << ",\"ts\":";
+		writeMicroseconds(output, event.startNanoseconds);
+		output << ",\"dur\":";
+		writeMicroseconds(output, event.durationNanoseconds);
+		output << '}';
+		isFirst = false;
+	}
+	output << "\n]}\n";
+}
+
+/**
+	@brief writes the spans kept as a Chrome trace file
+
+	@param[in] path the file to write, replaced if it exists
+
+	@return true if the file was written
+**/
+bool PluginTracer::write(const std::string& path) const
+{
+	std::ofstream output(path, std::ios::trunc);
+	if (!output)
+		return false;
+	write(output);
+	return static_cast<bool>(output);
+}
@@ -0,0 +1,125 @@
+//==============================================================================
+/**
+@file       PluginTracer.h
+@brief      Records spans of what each of the plugin's threads is doing, written as a Chrome trace
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+	@brief Records timed spans from every thread into a ring buffer per thread, to be written out in the Chrome trace event format
+	       and viewed in Perfetto or chrome://tracing. Recording is off until setEnabled(true), while off a span costs one relaxed atomic load.
+	       A thread records without locking, only its first span takes a lock to get a buffer. Memory is bounded: each buffer keeps
+	       the latest EVENTS_PER_THREAD spans, buffers of threads that exited are reused, and threads past MAX_THREADS are not recorded.
+**/
+class PluginTracer
+{
+public:
+	// a recorded span, names are string literals
+	struct traceEvent_t
+	{
+		const char* name = nullptr;
+		const char* category = nullptr;
+		uint64_t startNanoseconds = 0; // since the tracer was created
+		uint64_t durationNanoseconds = 0;
+		uint32_t threadId = 0;
+	};
+
+	static constexpr size_t EVENTS_PER_THREAD = 8192;
+	static constexpr size_t MAX_THREADS = 64;
+
+	static PluginTracer& get();
+
+	bool isEnabled() const { return mIsEnabled.load(std::memory_order_relaxed); }
+	void setEnabled(const bool isEnabled) { mIsEnabled.store(isEnabled, std::memory_order_relaxed); }
+	void clear();
+
+	uint64_t now() const { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - mEpoch).count(); }
+	void record(const char* name, const char* category, const uint64_t startNanoseconds, const uint64_t endNanoseconds);
+	void nameThread(const char* name);
+
+	std::vector<traceEvent_t> getEvents() const;
+	uint64_t getDropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+	void write(std::ostream& output) const;
+	bool write(const std::string& path) const;
+
+private:
+	// written only by the thread owning the buffer, the fields are atomic so a concurrent reader never sees a torn value
+	struct slot_t
+	{
+		std::atomic<const char*> name = nullptr;
+		std::atomic<const char*> category = nullptr;
+		std::atomic<uint64_t> startNanoseconds = 0;
+		std::atomic<uint64_t> durationNanoseconds = 0;
+		std::atomic<uint32_t> threadId = 0;
+	};
+
+	struct threadBuffer_t
+	{
+		std::array<slot_t, EVENTS_PER_THREAD> slots;
+		std::atomic<uint64_t> written = 0; // total spans recorded, the next slot is written % EVENTS_PER_THREAD
+		std::atomic_bool isInUse = false;
+	};
+
+	PluginTracer() : mEpoch(std::chrono::steady_clock::now()) {};
+
+	threadBuffer_t* getThreadBuffer();
+
+	const std::chrono::steady_clock::time_point mEpoch;
+	std::atomic_bool mIsEnabled = false;
+	std::atomic<uint64_t> mClearedAt = 0; // spans starting before this are no longer reported
+	std::atomic<uint64_t> mDropped = 0; // spans not recorded since every buffer was taken
+
+	// guards handing out buffers, naming threads and reading
+	mutable std::mutex mMutex;
+	std::vector<std::unique_ptr<threadBuffer_t>> mBuffers;
+	std::unordered_map<uint32_t, std::string> mThreadNames;
+};
+
+/**
+	@brief Records the scope it lives in as a span, if tracing was on when it started
+
+	@param[in] name what the span is, must be a string literal
+	@param[in] category which part of the plugin it belongs to, must be a string literal
+**/
+class ScopedTraceSpan
+{
+public:
+	ScopedTraceSpan(const char* name, const char* category) :
+		mName(name),
+		mCategory(category),
+		mIsTracing(PluginTracer::get().isEnabled())
+	{
+		if (mIsTracing)
+			mStart = PluginTracer::get().now();
+	}
+
+	~ScopedTraceSpan()
+	{
+		if (mIsTracing)
+			PluginTracer::get().record(mName, mCategory, mStart, PluginTracer::get().now());
+	}
+
+	ScopedTraceSpan(const ScopedTraceSpan&) = delete;
+	ScopedTraceSpan& operator=(const ScopedTraceSpan&) = delete;
+
+private:
+	const char* mName;
+	const char* mCategory;
+	const bool mIsTracing;
+	uint64_t mStart = 0;
+};
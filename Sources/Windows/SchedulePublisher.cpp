@@ -0,0 +1,159 @@
+//==============================================================================
+/**
+@file       SchedulePublisher.cpp
+@brief      Publishes every context's schedule to shared memory for overlays and other tools
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "SchedulePublisher.h"
+#include <atomic>
+#include <cstring>
+
+namespace
+{
+	// set while a publisher is open in this process
+	std::atomic<bool> isPublisherOpen = false;
+}
+
+/**
+	@brief creates the segment, or takes over one left by an earlier run, and clears it. Check isInit() afterwards
+
+	@param[in] segmentName the name readers open the segment by
+**/
+SchedulePublisher::SchedulePublisher(const std::string& segmentName)
+{
+	if (isPublisherOpen.exchange(true))
+	{
+		mErrorMessage = "A schedule publisher is already open in this process";
+		return;
+	}
+
+	mMemory = std::make_unique<SharedMemory>(segmentName, sizeof(sharedschedule::segment_t), SharedMemory::ACCESS::CREATE);
+	if (!mMemory->isInit())
+	{
+		mErrorMessage = mMemory->getErrorMessage();
+		mMemory.reset();
+		isPublisherOpen = false;
+		return;
+	}
+
+	// readers check the header when they open the segment, so it is filled in last
+	mSegment = static_cast<sharedschedule::segment_t*>(mMemory->data());
+	std::memset(static_cast<void*>(mSegment), 0, sizeof(sharedschedule::segment_t));
+	mSegment->maxContexts = sharedschedule::MAX_CONTEXTS;
+	mSegment->slotSize = sizeof(sharedschedule::slot_t);
+	mSegment->version = sharedschedule::VERSION;
+	std::atomic_thread_fence(std::memory_order_release);
+	mSegment->magic = sharedschedule::MAGIC;
+}
+
+SchedulePublisher::~SchedulePublisher()
+{
+	if (mSegment == nullptr)
+		return;
+
+	// readers that keep the segment mapped see every context gone
+	std::vector<std::string> contexts;
+	for (const auto& [context, _] : mContextSlots)
+		contexts.push_back(context);
+	for (const std::string& context : contexts)
+		remove(context);
+
+	mSegment = nullptr;
+	mMemory.reset();
+	isPublisherOpen = false;
+}
+
+/**
+	@brief writes a context's state to its slot if it changed, giving the context a slot the first time it is published
+
+	@param[in] context the Stream Deck context of the button
+	@param[in] state what the context is showing, with its text filled in by sharedschedule::copyText. Its context and isActive are set here
+
+	@return false if the publisher is not open, or every slot is taken
+**/
+bool SchedulePublisher::publish(const std::string& context, const sharedschedule::contextState_t& state)
+{
+	if (mSegment == nullptr)
+		return false;
+
+	uint32_t slot = 0;
+	if (const auto it = mContextSlots.find(context); it != mContextSlots.end())
+		slot = it->second;
+	else if (!mFreeSlots.empty())
+	{
+		slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+		mContextSlots.emplace(context, slot);
+	}
+	else
+	{
+		slot = mSegment->slotCount.load(std::memory_order_relaxed);
+		if (slot >= sharedschedule::MAX_CONTEXTS)
+			return false;
+		mContextSlots.emplace(context, slot);
+	}
+
+	sharedschedule::contextState_t published = state;
+	sharedschedule::copyText(published.context, context);
+	published.isActive = 1;
+
+	// only this process writes the slots, so comparing with what is there needs no seqlock
+	if (std::memcmp(&mSegment->slots[slot].state, &published, sizeof(published)) == 0)
+		return true;
+
+	write(slot, published);
+	if (slot >= mSegment->slotCount.load(std::memory_order_relaxed))
+		mSegment->slotCount.store(slot + 1, std::memory_order_release);
+	mSegment->changeCount.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+/**
+	@brief marks a context's slot inactive and frees it for the next context
+
+	@param[in] context the Stream Deck context of the button
+
+	@return false if the context was not published
+**/
+bool SchedulePublisher::remove(const std::string& context)
+{
+	const auto it = mContextSlots.find(context);
+	if (mSegment == nullptr || it == mContextSlots.end())
+		return false;
+
+	sharedschedule::contextState_t cleared{};
+	write(it->second, cleared);
+	mFreeSlots.push_back(it->second);
+	mContextSlots.erase(it);
+	mSegment->changeCount.fetch_add(1, std::memory_order_release);
+	return true;
+}
+
+/**
+	@brief gets how many times the segment has changed since it was opened
+
+	@return the change count, 0 if the publisher is not open
+**/
+uint64_t SchedulePublisher::getChangeCount() const
+{
+	return mSegment == nullptr ? 0 : mSegment->changeCount.load(std::memory_order_relaxed);
+}
+
+/**
+	@brief writes a slot under its seqlock: odd while the state is changing, even and one step further once it is done
+
+	@param[in] slot the slot to write
+	@param[in] state the state to write into it
+**/
+void SchedulePublisher::write(const uint32_t slot, const sharedschedule::contextState_t& state)
+{
+	sharedschedule::slot_t& target = mSegment->slots[slot];
+	const uint32_t sequence = target.sequence.load(std::memory_order_relaxed);
+	target.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(&target.state, &state, sizeof(state));
+	target.sequence.store(sequence + 2, std::memory_order_release);
+}
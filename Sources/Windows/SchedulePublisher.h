@@ -0,0 +1,51 @@
+//==============================================================================
+/**
+@file       SchedulePublisher.h
+@brief      Publishes every context's schedule to shared memory for overlays and other tools
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "SharedMemory.h"
+#include "SharedSchedule.h"
+
+/**
+	@brief Writes the state of each context into its own slot of the shared schedule segment, see SharedSchedule.h.
+	       A state is only written when it differs from what the slot already holds, so readers polling the change count
+	       wake only on real changes. Writing never waits on readers. Only one publisher per process can be open at a time,
+	       as a second one would write over the first. Not thread safe, the plugin publishes while holding its contexts lock.
+**/
+class SchedulePublisher
+{
+public:
+	SchedulePublisher(const std::string& segmentName = sharedschedule::SEGMENT_NAME);
+	~SchedulePublisher();
+
+	SchedulePublisher(const SchedulePublisher&) = delete;
+	SchedulePublisher& operator=(const SchedulePublisher&) = delete;
+
+	bool isInit() const { return mErrorMessage.empty(); };
+	std::string getErrorMessage() const { return mErrorMessage; };
+
+	bool publish(const std::string& context, const sharedschedule::contextState_t& state);
+	bool remove(const std::string& context);
+
+	uint64_t getChangeCount() const;
+
+private:
+	std::string mErrorMessage;
+	std::unique_ptr<SharedMemory> mMemory;
+	sharedschedule::segment_t* mSegment = nullptr;
+
+	// the slot of each published context, and the slots freed by contexts that disappeared
+	std::unordered_map<std::string, uint32_t> mContextSlots;
+	std::vector<uint32_t> mFreeSlots;
+
+	void write(const uint32_t slot, const sharedschedule::contextState_t& state);
+};
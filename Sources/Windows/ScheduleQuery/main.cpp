@@ -0,0 +1,203 @@
+//copyright  (c) 2023, Momoko Tomoko
+
+#include "pch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "../ScheduleQueryRunner.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+namespace
+{
+	const char* USAGE =
+		"Usage: ScheduleQuery [options] [route,tracker,name[,skips]...]\n"
+		"Lists the upcoming windows of each query's target, as a button tracking it would count them.\n"
+		"\n"
+		"  --data=<file>        a route database, repeatable. Defaults to both shipped routes in the current folder\n"
+		"  --queries=<file>     reads one query per line from a file, or from stdin if '-'\n"
+		"  --all                queries every target of every route\n"
+		"  --from=<time>        start of the range, seconds since the epoch or a UTC date like 2023-11-14T22:00Z. Defaults to now\n"
+		"  --to=<time>          end of the range. Defaults to --hours after --from\n"
+		"  --hours=<n>          length of the range when --to is not given. Defaults to 24\n"
+		"  --count=<n>          lists at most n windows per query\n"
+		"  --priority=<p>       achievement or bluefish, which of a voyage's targets labels and images show. Defaults to bluefish\n"
+		"  --format=<f>         csv, json, one object per line, or ics, an iCalendar file with an event per window. Defaults to csv\n"
+		"  --threads=<n>        threads to answer queries on. Defaults to one per core\n"
+		"  --stats              prints queries, windows and queries per second to stderr when done\n";
+
+	bool readNumber(const char* text, uint64_t& value)
+	{
+		const char* end = text + std::strlen(text);
+		const auto [last, ec] = std::from_chars(text, end, value);
+		return ec == std::errc() && last == end && last != text;
+	}
+
+	bool readQueries(std::istream& input, std::vector<ScheduleQueryRunner::query_t>& queries)
+	{
+		std::string line;
+		size_t lineNumber = 0;
+		while (std::getline(input, line))
+		{
+			lineNumber++;
+			if (line.empty() || line[0] == '#' || line == "\r")
+				continue;
+			const std::optional<ScheduleQueryRunner::query_t> query = ScheduleQueryRunner::parseQuery(line);
+			if (!query)
+			{
+				std::fprintf(stderr, "Line %zu is not a query of route,tracker,name[,skips]: %s\n", lineNumber, line.c_str());
+				return false;
+			}
+			queries.push_back(*query);
+		}
+		return true;
+	}
+}
+
+/**
+	@brief answers schedule queries from the command line, see USAGE
+**/
+int main(int argc, char* argv[])
+{
+	std::vector<std::string> dataFiles;
+	std::vector<ScheduleQueryRunner::query_t> queries;
+	bool isAllTargets = false;
+	bool isStatsShown = false;
+	time_t from = time(0);
+	std::optional<time_t> to;
+	uint64_t hours = 24;
+	uint64_t count = UINT32_MAX;
+	uint64_t threadCount = (std::max)(std::thread::hardware_concurrency(), 1u);
+	PRIORITY priority = PRIORITY::BLUE_FISH;
+	ScheduleQueryRunner::FORMAT format = ScheduleQueryRunner::FORMAT::CSV;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string_view argument = argv[i];
+		const auto value = [&argument](const char* option) -> const char*
+			{
+				const size_t length = std::strlen(option);
+				return argument.size() > length && argument.compare(0, length, option) == 0 ? argument.data() + length : nullptr;
+			};
+
+		bool isValid = true;
+		if (argument == "--help" || argument == "-h")
+		{
+			std::fputs(USAGE, stdout);
+			return 0;
+		}
+		else if (argument == "--all")
+			isAllTargets = true;
+		else if (argument == "--stats")
+			isStatsShown = true;
+		else if (const char* file = value("--data="))
+			dataFiles.push_back(file);
+		else if (const char* file = value("--queries="))
+		{
+			if (std::strcmp(file, "-") == 0)
+				isValid = readQueries(std::cin, queries);
+			else
+			{
+				std::ifstream input(file);
+				if (!input)
+				{
+					std::fprintf(stderr, "Unable to open %s\n", file);
+					return 1;
+				}
+				isValid = readQueries(input, queries);
+			}
+			if (!isValid)
+				return 1;
+		}
+		else if (const char* time = value("--from="))
+		{
+			const std::optional<time_t> parsed = ScheduleQueryRunner::parseTime(time);
+			isValid = parsed.has_value();
+			from = parsed.value_or(from);
+		}
+		else if (const char* time = value("--to="))
+		{
+			to = ScheduleQueryRunner::parseTime(time);
+			isValid = to.has_value();
+		}
+		else if (const char* number = value("--hours="))
+			isValid = readNumber(number, hours);
+		else if (const char* number = value("--count="))
+			isValid = readNumber(number, count);
+		else if (const char* number = value("--threads="))
+			isValid = readNumber(number, threadCount) && threadCount > 0;
+		else if (const char* name = value("--priority="))
+		{
+			isValid = std::strcmp(name, "achievement") == 0 || std::strcmp(name, "bluefish") == 0;
+			priority = std::strcmp(name, "achievement") == 0 ? PRIORITY::ACHIEVEMENTS : PRIORITY::BLUE_FISH;
+		}
+		else if (const char* name = value("--format="))
+		{
+			isValid = std::strcmp(name, "csv") == 0 || std::strcmp(name, "json") == 0 || std::strcmp(name, "ics") == 0;
+			format = std::strcmp(name, "json") == 0 ? ScheduleQueryRunner::FORMAT::JSON
+				: std::strcmp(name, "ics") == 0 ? ScheduleQueryRunner::FORMAT::ICS
+				: ScheduleQueryRunner::FORMAT::CSV;
+		}
+		else if (const std::optional<ScheduleQueryRunner::query_t> query = ScheduleQueryRunner::parseQuery(argument))
+			queries.push_back(*query);
+		else
+			isValid = false;
+
+		if (!isValid)
+		{
+			std::fprintf(stderr, "Invalid argument: %s\n\n%s", argv[i], USAGE);
+			return 1;
+		}
+	}
+
+	if (dataFiles.empty())
+		dataFiles = { "oceanFishingDatabase - Indigo Route.json", "oceanFishingDatabase - Ruby Route.json" };
+	FFXIVOceanFishingHelper helper(dataFiles);
+	if (!helper.isInit())
+	{
+		std::fprintf(stderr, "%s\n", helper.getErrorMessage().c_str());
+		return 1;
+	}
+
+	ScheduleQueryRunner runner(helper, from, to.value_or(from + static_cast<time_t>(hours) * 60 * 60), static_cast<uint32_t>((std::min)(count, static_cast<uint64_t>(UINT32_MAX))), priority);
+	if (isAllTargets)
+	{
+		const std::vector<ScheduleQueryRunner::query_t> allQueries = runner.getAllTargetQueries();
+		queries.insert(queries.end(), allQueries.begin(), allQueries.end());
+	}
+	if (queries.empty())
+	{
+		std::fprintf(stderr, "No queries given\n\n%s", USAGE);
+		return 1;
+	}
+
+#ifdef _WIN32
+	// iCalendar lines end in CRLF already, which text mode would write as CR CR LF
+	if (format == ScheduleQueryRunner::FORMAT::ICS)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+	std::ios::sync_with_stdio(false);
+	const auto start = std::chrono::steady_clock::now();
+	const ScheduleQueryRunner::batchStats_t stats = runner.runBatch(std::cout, queries, format, static_cast<size_t>(threadCount));
+	std::cout.flush();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if (stats.unmatched > 0)
+		std::fprintf(stderr, "%llu queries had an unknown route or target\n", static_cast<unsigned long long>(stats.unmatched));
+	if (isStatsShown)
+		std::fprintf(stderr, "%llu queries, %llu windows, %.1f MB in %.3fs on %llu threads, %.0f queries/s\n",
+			static_cast<unsigned long long>(stats.queries),
+			static_cast<unsigned long long>(stats.windows),
+			stats.bytes / 1e6,
+			seconds,
+			static_cast<unsigned long long>(threadCount),
+			seconds > 0.0 ? stats.queries / seconds : 0.0);
+	return std::cout ? 0 : 1;
+}
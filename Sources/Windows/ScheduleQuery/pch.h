@@ -0,0 +1,18 @@
+//
+// pch.h
+//
+
+#pragma once
+
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../../Vendor/json/src/json.hpp"
+
+using json = nlohmann::json;
@@ -0,0 +1,583 @@
+//==============================================================================
+/**
+@file       ScheduleQueryRunner.cpp
+@brief      Answers batches of schedule queries without a Stream Deck, as csv, json lines or iCalendar
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "ScheduleQueryRunner.h"
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "TimeUtils.hpp"
+
+namespace
+{
+	void appendNumber(std::string& output, const uint64_t value)
+	{
+		char digits[24];
+		const auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+		output.append(digits, end);
+	}
+
+	// writes a time as "2023-11-14T22:13:20Z", or as "20231114T221320Z" for iCalendar
+	void appendUtcTime(std::string& output, const time_t t, const bool isBasic = false)
+	{
+		struct tm utc {};
+		gmtime_s(&utc, &t);
+		const std::string_view dateSeparator = isBasic ? "" : "-";
+		const std::string_view timeSeparator = isBasic ? "" : ":";
+		char buffer[32];
+		char* const last = buffer + sizeof(buffer);
+		char* position = timeutils::appendNumber(buffer, last, utc.tm_year + 1900, 4);
+		position = timeutils::appendString(position, last, dateSeparator);
+		position = timeutils::appendNumber(position, last, utc.tm_mon + 1, 2);
+		position = timeutils::appendString(position, last, dateSeparator);
+		position = timeutils::appendNumber(position, last, utc.tm_mday, 2);
+		position = timeutils::appendString(position, last, "T");
+		position = timeutils::appendNumber(position, last, utc.tm_hour, 2);
+		position = timeutils::appendString(position, last, timeSeparator);
+		position = timeutils::appendNumber(position, last, utc.tm_min, 2);
+		position = timeutils::appendString(position, last, timeSeparator);
+		position = timeutils::appendNumber(position, last, utc.tm_sec, 2);
+		position = timeutils::appendString(position, last, "Z");
+		output.append(buffer, position);
+	}
+
+	// quotes a field if it holds a separator, quote or line break
+	void appendCsvField(std::string& output, std::string_view field)
+	{
+		if (field.find_first_of(",\"\r\n") == std::string_view::npos)
+		{
+			output += field;
+			return;
+		}
+		output += '"';
+		for (const char c : field)
+		{
+			if (c == '"')
+				output += '"';
+			output += c;
+		}
+		output += '"';
+	}
+
+	void appendJsonString(std::string& output, std::string_view text)
+	{
+		static constexpr char HEX[] = "0123456789abcdef";
+		output += '"';
+		for (const char c : text)
+		{
+			switch (c)
+			{
+			case '"': output += "\\\""; break;
+			case '\\': output += "\\\\"; break;
+			case '\n': output += "\\n"; break;
+			case '\r': output += "\\r"; break;
+			case '\t': output += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					output += "\\u00";
+					output += HEX[(c >> 4) & 0xF];
+					output += HEX[c & 0xF];
+				}
+				else
+					output += c;
+			}
+		}
+		output += '"';
+	}
+
+	// escapes iCalendar TEXT, where backslashes, semicolons, commas and line breaks are escaped
+	void appendIcsText(std::string& output, std::string_view text)
+	{
+		for (const char c : text)
+		{
+			switch (c)
+			{
+			case '\\': output += "\\\\"; break;
+			case ';': output += "\\;"; break;
+			case ',': output += "\\,"; break;
+			case '\n': output += "\\n"; break;
+			case '\r': break;
+			default: output += c;
+			}
+		}
+	}
+
+	// appends a content line ending in CRLF, folded so no line is longer than 75 octets, never inside a UTF-8 character
+	void appendIcsLine(std::string& output, std::string_view line)
+	{
+		static constexpr size_t MAX_LINE_OCTETS = 75;
+		size_t lineOctets = 0;
+		for (const char c : line)
+		{
+			// the octets of the character c starts, 0 for the rest of a character
+			const unsigned char byte = static_cast<unsigned char>(c);
+			const size_t characterOctets = (byte & 0xC0) == 0x80 ? 0 : byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : byte >= 0xC0 ? 2 : 1;
+			if (lineOctets + characterOctets > MAX_LINE_OCTETS)
+			{
+				// a folded line starts with a space, which counts towards its length
+				output += "\r\n ";
+				lineOctets = 1;
+			}
+			output += c;
+			lineOctets++;
+		}
+		output += "\r\n";
+	}
+
+	// days since 1970-01-01 of a date in the proleptic gregorian calendar
+	int64_t daysFromCivil(int64_t year, const int64_t month, const int64_t day)
+	{
+		year -= month <= 2;
+		const int64_t era = (year >= 0 ? year : year - 399) / 400;
+		const int64_t yearOfEra = year - era * 400;
+		const int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+		const int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+		return era * 146097 + dayOfEra - 719468;
+	}
+
+	// reads a fixed number of digits, advancing past them
+	bool readDigits(std::string_view& text, const size_t count, int& value)
+	{
+		if (text.size() < count)
+			return false;
+		const auto [end, ec] = std::from_chars(text.data(), text.data() + count, value);
+		if (ec != std::errc() || end != text.data() + count)
+			return false;
+		text.remove_prefix(count);
+		return true;
+	}
+
+	bool readSeparator(std::string_view& text, const char separator)
+	{
+		if (text.empty() || text.front() != separator)
+			return false;
+		text.remove_prefix(1);
+		return true;
+	}
+}
+
+/**
+	@param[in] helper the routes to answer queries from
+	@param[in] from the start of the time range, a window open at this time is included
+	@param[in] to the end of the time range, windows starting at or after it are left out
+	@param[in] maxWindows the most windows listed for each query
+	@param[in] priority whether labels and images show the achievement or the blue fish of a voyage
+	@param[in] clock what iCalendar events are stamped with the time from, the system clock unless testing
+**/
+ScheduleQueryRunner::ScheduleQueryRunner(FFXIVOceanFishingHelper& helper, const time_t from, const time_t to, const uint32_t maxWindows, const PRIORITY priority, Clock& clock) :
+	mHelper(helper),
+	mFrom(from),
+	mTo(to),
+	mMaxWindows(maxWindows),
+	mPriority(priority),
+	mClock(clock)
+{
+}
+
+/**
+	@brief lists the windows of a query's target in the time range, starting from its skips'th window
+
+	@param[out] windows the windows in order, replacing what was there
+	@param[in] query the target to list
+
+	@return false if the route or target is not known
+**/
+bool ScheduleQueryRunner::run(std::vector<window_t>& windows, const query_t& query)
+{
+	windows.clear();
+	const std::unordered_set<uint32_t> voyageIds = mHelper.getVoyageIdByTracker(query.routeName, query.tracker, query.name);
+	if (voyageIds.empty())
+		return false;
+
+	time_t t = mFrom;
+	uint32_t skips = query.skips;
+	while (windows.size() < mMaxWindows)
+	{
+		uint32_t secondsTillNextVoyage = 0;
+		uint32_t secondsLeftInWindow = 0;
+		window_t window;
+		if (!mHelper.getSecondsUntilNextVoyage(secondsTillNextVoyage, secondsLeftInWindow, window.voyageId, t, voyageIds, query.routeName, skips))
+			break;
+
+		window.start = secondsLeftInWindow > 0 ? t + secondsLeftInWindow - WINDOW_SECONDS : t + secondsTillNextVoyage;
+		if (window.start >= mTo)
+			break;
+		window.end = window.start + WINDOW_SECONDS;
+		mHelper.getImageNameAndLabel(window.imageName, window.label, query.routeName, query.tracker, query.name, window.start, mPriority, 0);
+		windows.push_back(std::move(window));
+
+		// a second past the window, as at its very end the closed window is still counted as the current one
+		t = windows.back().end + 1;
+		skips = 0;
+	}
+	return true;
+}
+
+/**
+	@brief answers every query, across threads, writing each query's windows in the order of the queries
+
+	@param[in] output where to write the windows, between the header and footer
+	@param[in] queries the targets to list
+	@param[in] format csv, json lines or iCalendar
+	@param[in] threadCount threads to answer queries on, 1 to answer them on the calling thread
+
+	@return what was written
+**/
+ScheduleQueryRunner::batchStats_t ScheduleQueryRunner::runBatch(std::ostream& output, const std::vector<query_t>& queries, const FORMAT format, const size_t threadCount)
+{
+	batchStats_t stats;
+	stats.queries = queries.size();
+	writeHeader(output, format);
+	// every event of a calendar is stamped with when it was written, not with the range it covers
+	const time_t stamp = mClock.now();
+
+	if (threadCount <= 1)
+	{
+		std::vector<window_t> windows;
+		std::string text;
+		for (const query_t& query : queries)
+		{
+			if (!run(windows, query))
+				stats.unmatched++;
+			stats.windows += windows.size();
+			text.clear();
+			appendWindows(text, query, windows, format, stamp);
+			stats.bytes += text.size();
+			output.write(text.data(), text.size());
+		}
+		writeFooter(output, format);
+		return stats;
+	}
+
+	// workers claim queries in order, the calling thread writes them out in the same order as they finish.
+	// A worker waits before answering a query more than MAX_PENDING_QUERIES ahead of the one being written,
+	// or while MAX_PENDING_BYTES are waiting to be written unless its query is the one being written
+	struct slot_t
+	{
+		std::string text;
+		bool isDone = false;
+	};
+	std::vector<slot_t> slots((std::min)(queries.size(), MAX_PENDING_QUERIES));
+	std::mutex mutex;
+	std::condition_variable doneCondition;
+	std::condition_variable writtenCondition;
+	size_t written = 0;
+	size_t pendingBytes = 0;
+	std::atomic<size_t> nextQuery = 0;
+	std::atomic<uint64_t> unmatched = 0;
+	std::atomic<uint64_t> windowCount = 0;
+
+	const auto work = [&]()
+		{
+			std::vector<window_t> windows;
+			std::string text;
+			for (size_t index = nextQuery.fetch_add(1); index < queries.size(); index = nextQuery.fetch_add(1))
+			{
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					writtenCondition.wait(lock, [&]()
+						{
+							return index < written + slots.size() && (pendingBytes < MAX_PENDING_BYTES || index == written);
+						});
+				}
+
+				if (!run(windows, queries[index]))
+					unmatched.fetch_add(1, std::memory_order_relaxed);
+				windowCount.fetch_add(windows.size(), std::memory_order_relaxed);
+				text.clear();
+				appendWindows(text, queries[index], windows, format, stamp);
+
+				std::unique_lock<std::mutex> lock(mutex);
+				slot_t& slot = slots[index % slots.size()];
+				pendingBytes += text.size();
+				slot.text.swap(text);
+				slot.isDone = true;
+				if (index == written)
+					doneCondition.notify_one();
+			}
+		};
+
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < (std::min)(threadCount, queries.size()); i++)
+		threads.emplace_back(work);
+
+	std::string text;
+	for (size_t index = 0; index < queries.size(); index++)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			slot_t& slot = slots[index % slots.size()];
+			doneCondition.wait(lock, [&slot]() { return slot.isDone; });
+			text.swap(slot.text);
+			slot.isDone = false;
+			pendingBytes -= text.size();
+			written = index + 1;
+		}
+		writtenCondition.notify_all();
+		stats.bytes += text.size();
+		output.write(text.data(), text.size());
+	}
+
+	for (std::thread& thread : threads)
+		thread.join();
+	writeFooter(output, format);
+	stats.unmatched = unmatched.load();
+	stats.windows = windowCount.load();
+	return stats;
+}
+
+/**
+	@brief makes a query for every target of every route
+
+	@return the queries, by route and then target
+**/
+std::vector<ScheduleQueryRunner::query_t> ScheduleQueryRunner::getAllTargetQueries()
+{
+	std::vector<query_t> queries;
+	for (const json& routeName : mHelper.getRouteNames())
+	{
+		const json targets = mHelper.getTargetsJson(routeName.get<std::string>());
+		if (!targets.is_object())
+			continue;
+		for (const auto& [name, tracker] : targets.items())
+			queries.push_back({ routeName.get<std::string>(), tracker.get<std::string>(), name, 0 });
+	}
+	return queries;
+}
+
+/**
+	@brief writes the csv column names or opens the calendar, json lines have no header
+
+	@param[in] output where to write the header
+	@param[in] format csv, json lines or iCalendar
+**/
+void ScheduleQueryRunner::writeHeader(std::ostream& output, const FORMAT format)
+{
+	if (format == FORMAT::CSV)
+		output << "route,tracker,name,skips,window,voyage_id,start,end,start_utc,label,image\n";
+	else if (format == FORMAT::ICS)
+		output <<
+			"BEGIN:VCALENDAR\r\n"
+			"VERSION:2.0\r\n"
+			"PRODID:-//Momoko Tomoko//FFXIV Ocean Fishing Tracker//EN\r\n"
+			"CALSCALE:GREGORIAN\r\n"
+			"METHOD:PUBLISH\r\n"
+			"X-WR-CALNAME:Ocean Fishing\r\n";
+}
+
+/**
+	@brief closes the calendar, csv and json lines have no footer
+
+	@param[in] output where to write the footer
+	@param[in] format csv, json lines or iCalendar
+**/
+void ScheduleQueryRunner::writeFooter(std::ostream& output, const FORMAT format)
+{
+	if (format == FORMAT::ICS)
+		output << "END:VCALENDAR\r\n";
+}
+
+/**
+	@brief appends a query's windows, one line or calendar event each
+
+	@param[out] output where the lines are appended
+	@param[in] query the query the windows answer
+	@param[in] windows the windows, from run
+	@param[in] format csv, json lines or iCalendar
+	@param[in] stamp when the calendar events were made, only used by iCalendar
+**/
+void ScheduleQueryRunner::appendWindows(std::string& output, const query_t& query, const std::vector<window_t>& windows, const FORMAT format, const time_t stamp)
+{
+	std::string line;
+	for (size_t i = 0; i < windows.size(); i++)
+	{
+		const window_t& window = windows[i];
+		if (format == FORMAT::ICS)
+		{
+			// the same window of the same target keeps its uid, so importing the calendar again updates it in place
+			output += "BEGIN:VEVENT\r\n";
+			line = "UID:";
+			appendNumber(line, window.start);
+			line += '-';
+			for (const std::string& part : { query.routeName, query.tracker, query.name })
+			{
+				appendIcsText(line, part);
+				line += '/';
+			}
+			line.back() = '@';
+			line += "ffxivoceanfishing";
+			appendIcsLine(output, line);
+			line = "DTSTAMP:";
+			appendUtcTime(line, stamp, true);
+			appendIcsLine(output, line);
+			line = "DTSTART:";
+			appendUtcTime(line, window.start, true);
+			appendIcsLine(output, line);
+			line = "DTEND:";
+			appendUtcTime(line, window.end, true);
+			appendIcsLine(output, line);
+			line = "SUMMARY:";
+			appendIcsText(line, query.name);
+			if (window.label != query.name)
+			{
+				line += " (";
+				appendIcsText(line, window.label);
+				line += ')';
+			}
+			appendIcsLine(output, line);
+			line = "DESCRIPTION:";
+			appendIcsText(line, query.routeName + ", " + query.tracker + ": " + query.name + "\nVoyage " + std::to_string(window.voyageId));
+			appendIcsLine(output, line);
+			line = "CATEGORIES:";
+			appendIcsText(line, query.tracker);
+			appendIcsLine(output, line);
+			output += "TRANSP:TRANSPARENT\r\n"
+				"END:VEVENT\r\n";
+		}
+		else if (format == FORMAT::CSV)
+		{
+			appendCsvField(output, query.routeName);
+			output += ',';
+			appendCsvField(output, query.tracker);
+			output += ',';
+			appendCsvField(output, query.name);
+			output += ',';
+			appendNumber(output, query.skips);
+			output += ',';
+			appendNumber(output, i);
+			output += ',';
+			appendNumber(output, window.voyageId);
+			output += ',';
+			appendNumber(output, window.start);
+			output += ',';
+			appendNumber(output, window.end);
+			output += ',';
+			appendUtcTime(output, window.start);
+			output += ',';
+			appendCsvField(output, window.label);
+			output += ',';
+			appendCsvField(output, window.imageName);
+			output += '\n';
+		}
+		else
+		{
+			output += "{\"route\":";
+			appendJsonString(output, query.routeName);
+			output += ",\"tracker\":";
+			appendJsonString(output, query.tracker);
+			output += ",\"name\":";
+			appendJsonString(output, query.name);
+			output += ",\"skips\":";
+			appendNumber(output, query.skips);
+			output += ",\"window\":";
+			appendNumber(output, i);
+			output += ",\"voyageId\":";
+			appendNumber(output, window.voyageId);
+			output += ",\"start\":";
+			appendNumber(output, window.start);
+			output += ",\"end\":";
+			appendNumber(output, window.end);
+			output += ",\"startUtc\":\"";
+			appendUtcTime(output, window.start);
+			output += "\",\"label\":";
+			appendJsonString(output, window.label);
+			output += ",\"image\":";
+			appendJsonString(output, window.imageName);
+			output += "}\n";
+		}
+	}
+}
+
+/**
+	@brief reads a query from a csv line of route,tracker,name and optionally skips. Fields may be quoted
+
+	@param[in] line the line, without its line break
+
+	@return the query, or nullopt if the line is not one
+**/
+std::optional<ScheduleQueryRunner::query_t> ScheduleQueryRunner::parseQuery(std::string_view line)
+{
+	std::vector<std::string> fields(1);
+	bool isQuoted = false;
+	for (size_t i = 0; i < line.size(); i++)
+	{
+		const char c = line[i];
+		if (isQuoted)
+		{
+			if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+			{
+				fields.back() += '"';
+				i++;
+			}
+			else if (c == '"')
+				isQuoted = false;
+			else
+				fields.back() += c;
+		}
+		else if (c == '"')
+			isQuoted = true;
+		else if (c == ',')
+			fields.emplace_back();
+		else if (c != '\r')
+			fields.back() += c;
+	}
+	if (isQuoted || fields.size() < 3 || fields.size() > 4 || fields[0].empty() || fields[1].empty() || fields[2].empty())
+		return std::nullopt;
+
+	query_t query{ fields[0], fields[1], fields[2], 0 };
+	if (fields.size() == 4 && !fields[3].empty())
+	{
+		const auto [end, ec] = std::from_chars(fields[3].data(), fields[3].data() + fields[3].size(), query.skips);
+		if (ec != std::errc() || end != fields[3].data() + fields[3].size())
+			return std::nullopt;
+	}
+	return query;
+}
+
+/**
+	@brief reads a time as seconds since the epoch, or as a UTC date of 2023-11-14, 2023-11-14T22:13 or 2023-11-14T22:13:20, optionally ending in Z
+
+	@param[in] text the time
+
+	@return the time, or nullopt if the text is not one
+**/
+std::optional<time_t> ScheduleQueryRunner::parseTime(std::string_view text)
+{
+	if (text.empty())
+		return std::nullopt;
+
+	if (text.find('-') == std::string_view::npos)
+	{
+		int64_t seconds = 0;
+		const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), seconds);
+		if (ec != std::errc() || end != text.data() + text.size())
+			return std::nullopt;
+		return static_cast<time_t>(seconds);
+	}
+
+	int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+	if (!readDigits(text, 4, year) || !readSeparator(text, '-') ||
+		!readDigits(text, 2, month) || !readSeparator(text, '-') ||
+		!readDigits(text, 2, day))
+		return std::nullopt;
+	if (readSeparator(text, 'T') || readSeparator(text, ' '))
+	{
+		if (!readDigits(text, 2, hour) || !readSeparator(text, ':') || !readDigits(text, 2, minute))
+			return std::nullopt;
+		if (readSeparator(text, ':') && !readDigits(text, 2, second))
+			return std::nullopt;
+	}
+	readSeparator(text, 'Z');
+	if (!text.empty() || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+		return std::nullopt;
+
+	return static_cast<time_t>(((daysFromCivil(year, month, day) * 24 + hour) * 60 + minute) * 60 + second);
+}
@@ -0,0 +1,93 @@
+//==============================================================================
+/**
+@file       ScheduleQueryRunner.h
+@brief      Answers batches of schedule queries without a Stream Deck, as csv, json lines or iCalendar
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Clock.h"
+#include "FFXIVOceanFishingHelper.h"
+
+/**
+	@brief Lists the windows of targets over a time range, the way a button tracking them would count through them.
+	       Batches are answered across threads and written out in query order as each query is done,
+	       so output streams while later queries are still being worked on.
+**/
+class ScheduleQueryRunner
+{
+public:
+	// a window lasts 15 minutes from when its voyage leaves
+	static constexpr time_t WINDOW_SECONDS = 15 * 60;
+
+	// queries answered ahead of the one being written, and the output they may hold, bounding the memory a batch takes.
+	// The query next to be written is always answered, however much is pending
+	static constexpr size_t MAX_PENDING_QUERIES = 1024;
+	static constexpr size_t MAX_PENDING_BYTES = 4 * 1024 * 1024;
+
+	enum class FORMAT
+	{
+		CSV,
+		JSON, // one object per line
+		ICS, // an RFC 5545 calendar with an event for each window
+	};
+
+	// a target as a button would track it, skips counting from the first window in the range
+	struct query_t
+	{
+		std::string routeName;
+		std::string tracker;
+		std::string name;
+		uint32_t skips = 0;
+	};
+
+	struct window_t
+	{
+		time_t start = 0;
+		time_t end = 0;
+		uint32_t voyageId = 0;
+		std::string label;
+		std::string imageName;
+	};
+
+	struct batchStats_t
+	{
+		uint64_t queries = 0;
+		uint64_t unmatched = 0; // queries with an unknown route or target
+		uint64_t windows = 0;
+		uint64_t bytes = 0;
+	};
+
+	ScheduleQueryRunner(FFXIVOceanFishingHelper& helper, const time_t from, const time_t to, const uint32_t maxWindows = UINT32_MAX, const PRIORITY priority = PRIORITY::BLUE_FISH, Clock& clock = Clock::system());
+
+	bool run(std::vector<window_t>& windows, const query_t& query);
+	batchStats_t runBatch(std::ostream& output, const std::vector<query_t>& queries, const FORMAT format, const size_t threadCount);
+
+	std::vector<query_t> getAllTargetQueries();
+
+	static void writeHeader(std::ostream& output, const FORMAT format);
+	static void writeFooter(std::ostream& output, const FORMAT format);
+	static void appendWindows(std::string& output, const query_t& query, const std::vector<window_t>& windows, const FORMAT format, const time_t stamp = 0);
+
+	static std::optional<query_t> parseQuery(std::string_view line);
+	static std::optional<time_t> parseTime(std::string_view text);
+
+private:
+	FFXIVOceanFishingHelper& mHelper;
+	const time_t mFrom;
+	const time_t mTo;
+	const uint32_t mMaxWindows;
+	const PRIORITY mPriority;
+
+	// stamps iCalendar events with when they were written
+	Clock& mClock;
+};
@@ -0,0 +1,95 @@
+//==============================================================================
+/**
+@file       ScheduleReader.cpp
+@brief      Reads the schedule the plugin publishes to shared memory, for overlays and other tools
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "ScheduleReader.h"
+#include <cstring>
+
+/**
+	@brief maps the segment read-only and checks it is one this reader understands. Check isInit() afterwards
+
+	@param[in] segmentName the name the plugin published the segment under
+**/
+ScheduleReader::ScheduleReader(const std::string& segmentName)
+{
+	mMemory = std::make_unique<SharedMemory>(segmentName, sizeof(sharedschedule::segment_t), SharedMemory::ACCESS::READ);
+	if (!mMemory->isInit())
+	{
+		mErrorMessage = mMemory->getErrorMessage() + ", is the plugin running?";
+		mMemory.reset();
+		return;
+	}
+
+	const sharedschedule::segment_t* segment = static_cast<const sharedschedule::segment_t*>(mMemory->data());
+	const uint32_t magic = segment->magic;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (magic != sharedschedule::MAGIC ||
+		segment->version != sharedschedule::VERSION ||
+		segment->maxContexts != sharedschedule::MAX_CONTEXTS ||
+		segment->slotSize != sizeof(sharedschedule::slot_t))
+	{
+		mErrorMessage = "Shared schedule " + segmentName + " is not version " + std::to_string(sharedschedule::VERSION) + " or is still being set up";
+		mMemory.reset();
+		return;
+	}
+	mSegment = segment;
+}
+
+/**
+	@brief gets how many times the published schedule has changed, read again only when this moves
+
+	@return the change count, 0 if the reader is not open
+**/
+uint64_t ScheduleReader::getChangeCount() const
+{
+	return mSegment == nullptr ? 0 : mSegment->changeCount.load(std::memory_order_acquire);
+}
+
+/**
+	@brief gets how many slots have ever been used, slots past this have never held a context
+
+	@return the slot count, 0 if the reader is not open
+**/
+uint32_t ScheduleReader::getSlotCount() const
+{
+	return mSegment == nullptr ? 0 : (std::min)(mSegment->slotCount.load(std::memory_order_acquire), sharedschedule::MAX_CONTEXTS);
+}
+
+/**
+	@brief copies a slot's state out of the segment
+
+	@param[in] slot the slot to read, below getSlotCount()
+	@param[out] state a consistent copy of the slot, only valid if true is returned
+
+	@return true if a consistent state of an active context was read
+**/
+bool ScheduleReader::read(const uint32_t slot, sharedschedule::contextState_t& state) const
+{
+	return visit(slot, [&state](const sharedschedule::contextState_t& source)
+		{
+			std::memcpy(&state, &source, sizeof(state));
+		}) && state.isActive != 0;
+}
+
+/**
+	@brief copies the state of every active context out of the segment
+
+	@param[out] states the states, replacing what was there
+
+	@return the number of states read
+**/
+size_t ScheduleReader::readAll(std::vector<sharedschedule::contextState_t>& states) const
+{
+	states.clear();
+	const uint32_t slotCount = getSlotCount();
+	sharedschedule::contextState_t state{};
+	for (uint32_t slot = 0; slot < slotCount; slot++)
+		if (read(slot, state))
+			states.push_back(state);
+	return states.size();
+}
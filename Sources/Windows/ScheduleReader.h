@@ -0,0 +1,78 @@
+//==============================================================================
+/**
+@file       ScheduleReader.h
+@brief      Reads the schedule the plugin publishes to shared memory, for overlays and other tools
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "SharedMemory.h"
+#include "SharedSchedule.h"
+
+/**
+	@brief Maps the plugin's shared schedule read-only and reads slots out of it without locking, see SharedSchedule.h.
+	       Reads never block the plugin: a read that overlaps a write is retried, up to MAX_READ_ATTEMPTS times.
+	       Poll getChangeCount() and read again only when it moves. Any number of threads may read at once.
+
+	       To use it from another program, build ScheduleReader.cpp and SharedMemory.cpp into it alongside the headers.
+**/
+class ScheduleReader
+{
+public:
+	// a write takes well under a microsecond, so a slot still being written after this many tries was left by a plugin that stopped mid-write
+	static constexpr uint32_t MAX_READ_ATTEMPTS = 64;
+
+	ScheduleReader(const std::string& segmentName = sharedschedule::SEGMENT_NAME);
+
+	ScheduleReader(const ScheduleReader&) = delete;
+	ScheduleReader& operator=(const ScheduleReader&) = delete;
+
+	bool isInit() const { return mErrorMessage.empty(); };
+	std::string getErrorMessage() const { return mErrorMessage; };
+
+	uint64_t getChangeCount() const;
+	uint32_t getSlotCount() const;
+
+	bool read(const uint32_t slot, sharedschedule::contextState_t& state) const;
+	size_t readAll(std::vector<sharedschedule::contextState_t>& states) const;
+
+	/**
+		@brief reads a slot in place, with no copy: calls visitor on the state inside the segment,
+		       then checks no write overlapped it. If one did, the visitor is called again, so it must only read
+		       and should keep what it needs in its own variables, which only hold a consistent state once this returns true
+
+		@param[in] slot the slot to read, below getSlotCount()
+		@param[in] visitor called with the const contextState_t& in the segment, possibly more than once
+
+		@return true if the visitor saw a consistent state, false if the slot is not valid or kept being written
+	**/
+	template <typename VISITOR>
+	bool visit(const uint32_t slot, VISITOR&& visitor) const
+	{
+		if (mSegment == nullptr || slot >= getSlotCount())
+			return false;
+
+		const sharedschedule::slot_t& source = mSegment->slots[slot];
+		for (uint32_t attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++)
+		{
+			const uint32_t sequence = source.sequence.load(std::memory_order_acquire);
+			if (sequence % 2 != 0)
+				continue;
+			visitor(source.state);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (source.sequence.load(std::memory_order_relaxed) == sequence)
+				return true;
+		}
+		return false;
+	}
+
+private:
+	std::string mErrorMessage;
+	std::unique_ptr<SharedMemory> mMemory;
+	const sharedschedule::segment_t* mSegment = nullptr;
+};
@@ -0,0 +1,238 @@
+//==============================================================================
+/**
+@file       ScheduleTable.cpp
+@brief      Every window of every target of a route over a horizon, looked up by binary search
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "ScheduleTable.h"
+#include <algorithm>
+#include <execution>
+
+namespace
+{
+	// rounds up, for times before the epoch too
+	int64_t divideRoundingUp(const int64_t numerator, const int64_t denominator)
+	{
+		const int64_t quotient = numerator / denominator;
+		return quotient + ((numerator % denominator != 0 && (numerator > 0) == (denominator > 0)) ? 1 : 0);
+	}
+}
+
+/**
+	@param[in] voyagePattern the voyage id of each block, repeating
+	@param[in] patternOffset the block the pattern starts from, as loaded from the route database
+	@param[in] targetToVoyageIdMap tracker -> target name -> the voyages of that target
+	@param[in] from the start of the horizon, a window open at this time is included
+	@param[in] to the end of the horizon, voyages leaving at or after it are left out
+**/
+ScheduleTable::ScheduleTable(
+	const std::vector<uint32_t>& voyagePattern,
+	const uint32_t patternOffset,
+	const std::unordered_map<std::string, std::map<std::string, targets_t>>& targetToVoyageIdMap,
+	const time_t from,
+	const time_t to
+)
+{
+	// blocks are numbered as FFXIVOceanFishingProcessor::convertBlockIndexToTime does, block b leaving at (b - (patternOffset - 1)) * 2h
+	const int64_t firstBlock = divideRoundingUp(static_cast<int64_t>(from) - WINDOW_SECONDS, VOYAGE_INTERVAL);
+	const int64_t endBlock = (std::max)(divideRoundingUp(static_cast<int64_t>(to), VOYAGE_INTERVAL), firstBlock);
+	mStart = static_cast<time_t>(firstBlock * VOYAGE_INTERVAL);
+	mEnd = to;
+	if (voyagePattern.empty())
+		return;
+
+	std::vector<uint32_t> blockVoyageIds(static_cast<size_t>(endBlock - firstBlock));
+	const int64_t patternSize = static_cast<int64_t>(voyagePattern.size());
+	const int64_t firstPatternIndex = ((firstBlock + patternOffset - 1) % patternSize + patternSize) % patternSize;
+	for (size_t i = 0; i < blockVoyageIds.size(); i++)
+		blockVoyageIds[i] = voyagePattern[(firstPatternIndex + i) % patternSize];
+
+	// the maps are filled in first, so every target can then be encoded at once without touching them
+	std::vector<std::pair<occurrences_t*, const std::unordered_set<uint32_t>*>> work;
+	for (const auto& [tracker, targets] : targetToVoyageIdMap)
+		for (const auto& [name, target] : targets)
+			work.emplace_back(&mOccurrences[tracker][name], &target.ids);
+
+	std::for_each(std::execution::par, work.begin(), work.end(), [&blockVoyageIds](const auto& item)
+		{
+			encode(*item.first, blockVoyageIds, *item.second);
+		});
+}
+
+/**
+	@brief records the blocks a target has a voyage in, as the gaps between them
+
+	@param[out] occurrences where to record them
+	@param[in] blockVoyageIds the voyage of each block of the table
+	@param[in] voyageIds the voyages of the target
+**/
+void ScheduleTable::encode(occurrences_t& occurrences, const std::vector<uint32_t>& blockVoyageIds, const std::unordered_set<uint32_t>& voyageIds)
+{
+	uint32_t previous = 0;
+	for (uint32_t block = 0; block < blockVoyageIds.size(); block++)
+	{
+		if (!voyageIds.contains(blockVoyageIds[block]))
+			continue;
+
+		if (occurrences.count > 0)
+		{
+			for (uint32_t delta = block - previous; ; delta >>= 7)
+			{
+				if (delta < 0x80)
+				{
+					occurrences.deltas.push_back(static_cast<uint8_t>(delta));
+					break;
+				}
+				occurrences.deltas.push_back(static_cast<uint8_t>((delta & 0x7F) | 0x80));
+			}
+		}
+		if (occurrences.count % CHECKPOINT_INTERVAL == 0)
+			occurrences.checkpoints.push_back({ block, static_cast<uint32_t>(occurrences.deltas.size()) });
+
+		previous = block;
+		occurrences.count++;
+	}
+	occurrences.deltas.shrink_to_fit();
+	occurrences.checkpoints.shrink_to_fit();
+}
+
+/**
+	@brief reads the gap to the next voyage
+
+	@param[in] deltas the gaps
+	@param[in,out] offset where the gap starts, moved past it
+
+	@return the gap in blocks
+**/
+uint32_t ScheduleTable::decode(const std::vector<uint8_t>& deltas, uint32_t& offset)
+{
+	uint32_t delta = 0;
+	for (uint32_t shift = 0; ; shift += 7)
+	{
+		const uint8_t byte = deltas[offset++];
+		delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+		if (byte < 0x80)
+			return delta;
+	}
+}
+
+const ScheduleTable::occurrences_t* ScheduleTable::find(const std::string& tracker, const std::string& name) const
+{
+	const auto targets = mOccurrences.find(tracker);
+	if (targets == mOccurrences.end())
+		return nullptr;
+	const auto occurrences = targets->second.find(name);
+	return occurrences == targets->second.end() ? nullptr : &occurrences->second;
+}
+
+/**
+	@brief gets the departures of a target's next voyages, counting a window that is still open at t like getSecondsUntilNextVoyage does
+
+	@param[out] times the departures in order, replacing what was there
+	@param[in] tracker the name of the tracker type (ie: Blue Fish, Achievement)
+	@param[in] name the name of the target
+	@param[in] t the time to look from
+	@param[in] count the most departures to get
+
+	@return the number of departures found, fewer than count if the table ends first or the target is not known
+**/
+size_t ScheduleTable::getNextOccurrences(std::vector<time_t>& times, const std::string& tracker, const std::string& name, const time_t t, const size_t count) const
+{
+	times.clear();
+	const occurrences_t* occurrences = find(tracker, name);
+	if (occurrences == nullptr || occurrences->count == 0 || count == 0)
+		return 0;
+
+	// the first block whose window has not closed by t
+	const int64_t firstBlock = divideRoundingUp(static_cast<int64_t>(t) - WINDOW_SECONDS - mStart, VOYAGE_INTERVAL);
+	if (firstBlock > UINT32_MAX)
+		return 0;
+	const uint32_t threshold = static_cast<uint32_t>((std::max)(firstBlock, static_cast<int64_t>(0)));
+
+	// start from the last checkpoint at or before the threshold, then step through the gaps after it
+	const auto checkpoint = std::upper_bound(
+		occurrences->checkpoints.begin(),
+		occurrences->checkpoints.end(),
+		threshold,
+		[](const uint32_t block, const checkpoint_t& checkpoint) { return block < checkpoint.block; }
+	);
+	const size_t checkpointIndex = checkpoint == occurrences->checkpoints.begin() ? 0 : checkpoint - occurrences->checkpoints.begin() - 1;
+	uint32_t index = static_cast<uint32_t>(checkpointIndex) * CHECKPOINT_INTERVAL;
+	uint32_t block = occurrences->checkpoints[checkpointIndex].block;
+	uint32_t offset = occurrences->checkpoints[checkpointIndex].offset;
+	while (block < threshold)
+	{
+		if (index + 1 >= occurrences->count)
+			return 0;
+		block += decode(occurrences->deltas, offset);
+		index++;
+	}
+
+	while (true)
+	{
+		times.push_back(mStart + static_cast<time_t>(block) * VOYAGE_INTERVAL);
+		if (times.size() >= count || index + 1 >= occurrences->count)
+			break;
+		block += decode(occurrences->deltas, offset);
+		index++;
+	}
+	return times.size();
+}
+
+/**
+	@brief gets how many voyages a target has in the table
+
+	@param[in] tracker the name of the tracker type
+	@param[in] name the name of the target
+
+	@return the number of voyages, 0 if the target is not known
+**/
+size_t ScheduleTable::getOccurrenceCount(const std::string& tracker, const std::string& name) const
+{
+	const occurrences_t* occurrences = find(tracker, name);
+	return occurrences == nullptr ? 0 : occurrences->count;
+}
+
+size_t ScheduleTable::occurrences_t::getMemoryBytes() const
+{
+	return sizeof(occurrences_t) + deltas.capacity() + checkpoints.capacity() * sizeof(checkpoint_t);
+}
+
+/**
+	@brief gets the memory a target's voyages take, not counting the maps holding them
+
+	@param[in] tracker the name of the tracker type
+	@param[in] name the name of the target
+
+	@return the size in bytes, 0 if the target is not known
+**/
+size_t ScheduleTable::getMemoryBytes(const std::string& tracker, const std::string& name) const
+{
+	const occurrences_t* occurrences = find(tracker, name);
+	return occurrences == nullptr ? 0 : occurrences->getMemoryBytes();
+}
+
+/**
+	@brief gets the memory every target's voyages take, not counting the maps holding them
+
+	@return the size in bytes
+**/
+size_t ScheduleTable::getMemoryBytes() const
+{
+	size_t bytes = 0;
+	for (const auto& [_, targets] : mOccurrences)
+		for (const auto& [_, occurrences] : targets)
+			bytes += occurrences.getMemoryBytes();
+	return bytes;
+}
+
+size_t ScheduleTable::getTargetCount() const
+{
+	size_t targetCount = 0;
+	for (const auto& [_, targets] : mOccurrences)
+		targetCount += targets.size();
+	return targetCount;
+}
@@ -0,0 +1,81 @@
+//==============================================================================
+/**
+@file       ScheduleTable.h
+@brief      Every window of every target of a route over a horizon, looked up by binary search
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Common.h"
+
+/**
+	@brief Lists when every target of a route has a voyage, for each 2 hour block from the start of a horizon to its end,
+	       built across cores once so planning views can look up many windows far ahead without walking the voyage pattern.
+	       Each target keeps its voyages as the number of blocks between one and the next, a byte each for all but very rare targets,
+	       with the block of every CHECKPOINT_INTERVAL'th voyage kept alongside to binary search from.
+	       Read only once built, so any number of threads can look up from it.
+**/
+class ScheduleTable
+{
+public:
+	// voyages leave every 2 hours, and their windows stay open for 15 minutes
+	static constexpr time_t VOYAGE_INTERVAL = 2 * 60 * 60;
+	static constexpr time_t WINDOW_SECONDS = 15 * 60;
+
+	// voyages between the blocks kept for the binary search, so a look up decodes at most this many gaps before its first result
+	static constexpr uint32_t CHECKPOINT_INTERVAL = 32;
+
+	ScheduleTable() {};
+	ScheduleTable(
+		const std::vector<uint32_t>& voyagePattern,
+		const uint32_t patternOffset,
+		const std::unordered_map<std::string, std::map<std::string, targets_t>>& targetToVoyageIdMap,
+		const time_t from,
+		const time_t to
+	);
+
+	size_t getNextOccurrences(std::vector<time_t>& times, const std::string& tracker, const std::string& name, const time_t t, const size_t count) const;
+	size_t getOccurrenceCount(const std::string& tracker, const std::string& name) const;
+
+	size_t getMemoryBytes(const std::string& tracker, const std::string& name) const;
+	size_t getMemoryBytes() const;
+	size_t getTargetCount() const;
+
+	// the departure of the first block in the table, and the end of the horizon it was built for
+	time_t getStart() const { return mStart; };
+	time_t getEnd() const { return mEnd; };
+
+private:
+	struct checkpoint_t
+	{
+		uint32_t block = 0; // blocks from the start of the table
+		uint32_t offset = 0; // where the gap to the next voyage starts in deltas
+	};
+
+	struct occurrences_t
+	{
+		uint32_t count = 0;
+		std::vector<uint8_t> deltas; // blocks between each voyage and the one before it, as LEB128
+		std::vector<checkpoint_t> checkpoints;
+
+		size_t getMemoryBytes() const;
+	};
+
+	const occurrences_t* find(const std::string& tracker, const std::string& name) const;
+	static void encode(occurrences_t& occurrences, const std::vector<uint32_t>& blockVoyageIds, const std::unordered_set<uint32_t>& voyageIds);
+	static uint32_t decode(const std::vector<uint8_t>& deltas, uint32_t& offset);
+
+	time_t mStart = 0;
+	time_t mEnd = 0;
+
+	// tracker -> target name -> when it has a voyage, like FFXIVOceanFishingProcessor's mTargetToVoyageIdMap
+	std::unordered_map<std::string, std::map<std::string, occurrences_t>> mOccurrences;
+};
@@ -0,0 +1,118 @@
+//==============================================================================
+/**
+@file       SharedMemory.cpp
+@brief      Maps a named block of memory shared between processes
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "SharedMemory.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+	@brief maps the segment, check isInit() afterwards
+
+	@param[in] name the segment's name, starting with "Local\" on Windows or "/" on POSIX
+	@param[in] size the size of the segment in bytes. A segment being read must be at least this big
+	@param[in] access whether to create the segment for writing or open it read-only
+**/
+SharedMemory::SharedMemory(const std::string& name, const size_t size, const ACCESS access) :
+	mName(name),
+	mAccess(access)
+{
+	map(size);
+}
+
+SharedMemory::~SharedMemory()
+{
+	unmap();
+}
+
+/**
+	@brief creates or opens the segment and maps it
+
+	@param[in] size the size of the segment in bytes
+
+	@return true on success, otherwise the error message is set
+**/
+bool SharedMemory::map(const size_t size)
+{
+#ifdef _WIN32
+	HANDLE mapping = mAccess == ACCESS::CREATE
+		? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size), mName.c_str())
+		: OpenFileMappingA(FILE_MAP_READ, FALSE, mName.c_str());
+	if (mapping == nullptr)
+	{
+		mErrorMessage = "Unable to open shared memory: " + mName;
+		return false;
+	}
+	mMappingHandle = mapping;
+
+	mData = MapViewOfFile(mapping, mAccess == ACCESS::CREATE ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, size);
+	mSize = size;
+#else
+	const int file = mAccess == ACCESS::CREATE
+		? shm_open(mName.c_str(), O_CREAT | O_RDWR, S_IRUSR | S_IWUSR)
+		: shm_open(mName.c_str(), O_RDONLY, 0);
+	if (file < 0)
+	{
+		mErrorMessage = "Unable to open shared memory: " + mName;
+		return false;
+	}
+
+	struct stat fileStat{};
+	const bool isSized = mAccess == ACCESS::CREATE
+		? ftruncate(file, static_cast<off_t>(size)) == 0
+		: fstat(file, &fileStat) == 0 && static_cast<size_t>(fileStat.st_size) >= size;
+	if (!isSized)
+	{
+		mErrorMessage = "Shared memory is smaller than expected: " + mName;
+		close(file);
+		unmap();
+		return false;
+	}
+
+	void* data = mmap(nullptr, size, mAccess == ACCESS::CREATE ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+	close(file); // the mapping keeps the segment alive
+	mData = data == MAP_FAILED ? nullptr : data;
+	mSize = size;
+#endif
+
+	if (mData == nullptr)
+	{
+		mErrorMessage = "Unable to map shared memory: " + mName;
+		unmap();
+		return false;
+	}
+	return true;
+}
+
+/**
+	@brief releases the mapping, and removes the segment's name if this created it. Safe to call more than once
+**/
+void SharedMemory::unmap()
+{
+#ifdef _WIN32
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+	if (mMappingHandle != nullptr)
+		CloseHandle(mMappingHandle);
+	mMappingHandle = nullptr;
+#else
+	if (mData != nullptr)
+		munmap(mData, mSize);
+	if (mAccess == ACCESS::CREATE)
+		shm_unlink(mName.c_str());
+#endif
+	mData = nullptr;
+	mSize = 0;
+}
@@ -0,0 +1,53 @@
+//==============================================================================
+/**
+@file       SharedMemory.h
+@brief      Maps a named block of memory shared between processes
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+/**
+	@brief A named shared memory segment, created for writing by one process or opened read-only by any number of others.
+	       On Windows the segment lives until the last process unmaps it, on POSIX the writer removes its name when it unmaps,
+	       so readers keep what they mapped but cannot open it again.
+**/
+class SharedMemory
+{
+public:
+	enum class ACCESS
+	{
+		CREATE, // creates the segment if missing, read and write
+		READ, // opens an existing segment read-only
+	};
+
+	SharedMemory(const std::string& name, const size_t size, const ACCESS access);
+	~SharedMemory();
+
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	bool isInit() const { return mErrorMessage.empty(); };
+	std::string getErrorMessage() const { return mErrorMessage; };
+
+	void* data() const { return mData; };
+	size_t size() const { return mSize; };
+
+private:
+	std::string mErrorMessage;
+	std::string mName;
+	ACCESS mAccess;
+
+	void* mData = nullptr;
+	size_t mSize = 0;
+#ifdef _WIN32
+	void* mMappingHandle = nullptr;
+#endif
+
+	bool map(const size_t size);
+	void unmap();
+};
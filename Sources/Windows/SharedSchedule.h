@@ -0,0 +1,89 @@
+//==============================================================================
+/**
+@file       SharedSchedule.h
+@brief      Layout of the shared memory the plugin publishes every context's schedule into
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+/**
+	@brief The segment is a header followed by a fixed array of slots, one per context, each guarded by its own seqlock.
+	       Only the plugin writes, bumping a slot's sequence to odd before changing it and to even after. Readers copy
+	       a slot and keep the copy only if the sequence was the same even number before and after, so they never
+	       block the plugin and the plugin never waits for them.
+	       Everything in it is fixed size and native endian, so any process on the machine can map it and read it in place.
+**/
+namespace sharedschedule
+{
+	// "Local\" keeps the segment to the user's session on Windows, POSIX names start with a slash
+#ifdef _WIN32
+	constexpr const char* SEGMENT_NAME = "Local\\FFXIVOceanFishingSchedule";
+#else
+	constexpr const char* SEGMENT_NAME = "/FFXIVOceanFishingSchedule";
+#endif
+
+	constexpr uint32_t MAGIC = 0x4F464653; // "SFFO" in memory on little endian
+	constexpr uint32_t VERSION = 1;
+	constexpr uint32_t MAX_CONTEXTS = 256;
+
+	// text is nul terminated and cut to fit, Stream Deck contexts are 32 hex characters
+	constexpr size_t CONTEXT_SIZE = 64;
+	constexpr size_t NAME_SIZE = 64;
+
+	// what a context is showing, as the plugin last computed it
+	struct contextState_t
+	{
+		char context[CONTEXT_SIZE]; // the Stream Deck context of the button
+		char routeName[NAME_SIZE];
+		char tracker[NAME_SIZE]; // the tracker type, ie: Blue Fish, Achievement
+		char targetName[NAME_SIZE];
+		char buttonLabel[NAME_SIZE]; // the label under the button
+		char imageName[NAME_SIZE]; // the icon the button shows, the file name without .png
+		int64_t voyageTime; // when the next voyage leaves, seconds since the epoch
+		int64_t windowEnd; // when the window open now closes, 0 if none is open
+		uint32_t nextVoyageId; // the voyage whose window is open, or otherwise the next one
+		uint32_t isActive; // 0 once the context has disappeared, its slot may be reused
+	};
+
+	// padded to a cache line, so writing one slot does not slow readers of its neighbours
+	struct alignas(64) slot_t
+	{
+		std::atomic<uint32_t> sequence; // odd while the plugin is writing the state
+		contextState_t state;
+	};
+
+	struct segment_t
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t maxContexts;
+		uint32_t slotSize;
+		std::atomic<uint32_t> slotCount; // slots that have ever been used, readers need only look at these
+		uint32_t reserved;
+		std::atomic<uint64_t> changeCount; // bumped after every change, readers can poll it to know when to read again
+		slot_t slots[MAX_CONTEXTS];
+	};
+
+	// the segment is shared between processes, so its atomics must not hide a lock
+	static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free);
+	static_assert(std::is_trivially_copyable_v<contextState_t>);
+	static_assert(std::is_standard_layout_v<segment_t>);
+
+	// copies text into a fixed field, cut to fit and always nul terminated
+	template <size_t SIZE>
+	void copyText(char(&field)[SIZE], std::string_view text)
+	{
+		const size_t length = (std::min)(text.size(), SIZE - 1);
+		std::memcpy(field, text.data(), length);
+		std::memset(field + length, 0, SIZE - length);
+	}
+}
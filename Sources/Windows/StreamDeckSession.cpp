@@ -0,0 +1,190 @@
+//==============================================================================
+/**
+@file       StreamDeckSession.cpp
+@brief      Scripts the events the Stream Deck application sends a plugin
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "StreamDeckSession.h"
+#include "../Common/ESDSDKDefines.h"
+#include <cstdio>
+
+namespace
+{
+	const std::string ACTION = "com.elgato.ffxivoceanfishing.action";
+
+	/**
+		@brief builds an event for one button, as the Stream Deck application sends them
+	**/
+	std::string buttonEvent(std::string_view event, const streamdecksession::button_t& button, std::string_view device, json payload)
+	{
+		json message;
+		message[kESDSDKCommonAction] = ACTION;
+		message[kESDSDKCommonEvent] = event;
+		message[kESDSDKCommonContext] = button.context;
+		message[kESDSDKCommonDevice] = device;
+		message[kESDSDKCommonPayload] = std::move(payload);
+		return message.dump();
+	}
+
+	json keyPayload(const streamdecksession::button_t& button)
+	{
+		json payload;
+		payload["settings"] = button.settings;
+		payload["coordinates"] = { { "column", 0 }, { "row", 0 } };
+		payload["isInMultiAction"] = false;
+		return payload;
+	}
+}
+
+namespace streamdecksession
+{
+	/**
+		@brief makes buttons that cycle through every target of every route, with a mix of the other settings
+
+		@param[in] routeTargets the targets of each route, as route name -> FFXIVOceanFishingHelper::getTargetsJson()
+		@param[in] firstId the id the contexts start from, so each batch of buttons can be new to the plugin
+
+		@return the buttons, each with its own context
+	**/
+	std::vector<button_t> makeButtons(const size_t count, const json& routeTargets, const size_t firstId)
+	{
+		std::vector<json> targets;
+		for (const auto& [route, names] : routeTargets.items())
+		{
+			for (const auto& [name, tracker] : names.items())
+			{
+				json settings;
+				settings["Route"] = route;
+				settings["Name"] = name;
+				settings["Tracker"] = tracker;
+				targets.push_back(std::move(settings));
+			}
+		}
+		if (targets.empty())
+			return {};
+
+		std::vector<button_t> buttons;
+		buttons.reserve(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			char context[33] = {};
+			std::snprintf(context, sizeof(context), "%032zX", firstId + i + 1);
+
+			json settings = targets[i % targets.size()];
+			settings["Skips"] = std::to_string(i / targets.size() % 3);
+			settings["DateOrTime"] = i % 2 == 1;
+			settings["Priority"] = i % 3 == 2;
+			settings["ProgressRing"] = i % 4 == 3;
+			settings["url"] = "example.com";
+			buttons.push_back({ context, std::move(settings) });
+		}
+		return buttons;
+	}
+
+	std::string deviceDidConnect(std::string_view device, const int deviceType)
+	{
+		json message;
+		message[kESDSDKCommonEvent] = kESDSDKEventDeviceDidConnect;
+		message[kESDSDKCommonDevice] = device;
+		message[kESDSDKCommonDeviceInfo] = {
+			{ "name", "Stream Deck" },
+			{ "type", deviceType },
+			{ "size", { { "columns", 5 }, { "rows", 3 } } },
+		};
+		return message.dump();
+	}
+
+	std::string didReceiveGlobalSettings(std::string_view pluginUUID, const bool is24HMode)
+	{
+		json message;
+		message[kESDSDKCommonEvent] = kESDSDKEventDidReceiveGlobalSettings;
+		message[kESDSDKCommonContext] = pluginUUID;
+		message[kESDSDKCommonPayload]["settings"]["Timekeeping24HMode"] = is24HMode;
+		return message.dump();
+	}
+
+	std::string willAppear(const button_t& button, std::string_view device)
+	{
+		return buttonEvent(kESDSDKEventWillAppear, button, device, keyPayload(button));
+	}
+
+	std::string willDisappear(const button_t& button, std::string_view device)
+	{
+		return buttonEvent(kESDSDKEventWillDisappear, button, device, keyPayload(button));
+	}
+
+	std::string keyDown(const button_t& button, std::string_view device)
+	{
+		return buttonEvent(kESDSDKEventKeyDown, button, device, keyPayload(button));
+	}
+
+	std::string keyUp(const button_t& button, std::string_view device)
+	{
+		return buttonEvent(kESDSDKEventKeyUp, button, device, keyPayload(button));
+	}
+
+	// the property inspector sends a button's settings when they are edited
+	std::string sendToPlugin(const button_t& button, std::string_view device)
+	{
+		return buttonEvent(kESDSDKEventSendToPlugin, button, device, button.settings);
+	}
+
+	/**
+		@brief scripts a profile being opened: the device connects, every button appears, the global settings
+		       arrive and the property inspector of the first button is opened
+
+		@param[in] pluginUUID the uuid the plugin registered with
+
+		@return the events in the order the Stream Deck application sends them
+	**/
+	std::vector<std::string> makeAppear(const std::vector<button_t>& buttons, std::string_view pluginUUID)
+	{
+		std::vector<std::string> messages;
+		messages.reserve(buttons.size() + 3);
+		messages.push_back(deviceDidConnect(DEVICE_ID, kESDSDKDeviceType_StreamDeck));
+		for (const button_t& button : buttons)
+			messages.push_back(willAppear(button, DEVICE_ID));
+		messages.push_back(didReceiveGlobalSettings(pluginUUID, true));
+		if (!buttons.empty())
+			messages.push_back(sendToPlugin(buttons.front(), DEVICE_ID));
+		return messages;
+	}
+
+	/**
+		@brief scripts key presses going round the buttons
+
+		@param[in] count how many keys are pressed
+
+		@return a key down and key up per press
+	**/
+	std::vector<std::string> makeKeyPresses(const std::vector<button_t>& buttons, const size_t count)
+	{
+		std::vector<std::string> messages;
+		if (buttons.empty())
+			return messages;
+		messages.reserve(count * 2);
+		for (size_t i = 0; i < count; i++)
+		{
+			messages.push_back(keyDown(buttons[i % buttons.size()], DEVICE_ID));
+			messages.push_back(keyUp(buttons[i % buttons.size()], DEVICE_ID));
+		}
+		return messages;
+	}
+
+	/**
+		@brief scripts the profile being closed
+
+		@return a will disappear per button
+	**/
+	std::vector<std::string> makeDisappear(const std::vector<button_t>& buttons)
+	{
+		std::vector<std::string> messages;
+		messages.reserve(buttons.size());
+		for (const button_t& button : buttons)
+			messages.push_back(willDisappear(button, DEVICE_ID));
+		return messages;
+	}
+}
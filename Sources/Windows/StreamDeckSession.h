@@ -0,0 +1,44 @@
+//==============================================================================
+/**
+@file       StreamDeckSession.h
+@brief      Scripts the events the Stream Deck application sends a plugin
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../Vendor/json/src/json.hpp"
+using json = nlohmann::json;
+
+namespace streamdecksession
+{
+	// the device every scripted button is on
+	constexpr std::string_view DEVICE_ID = "5A6F1B7C9D2E4F3A8B0C1D2E3F4A5B6C";
+
+	// a scripted button and the settings it was saved with
+	struct button_t
+	{
+		std::string context;
+		json settings;
+	};
+
+	std::vector<button_t> makeButtons(const size_t count, const json& routeTargets, const size_t firstId = 0);
+
+	std::string deviceDidConnect(std::string_view device, const int deviceType);
+	std::string didReceiveGlobalSettings(std::string_view pluginUUID, const bool is24HMode);
+	std::string willAppear(const button_t& button, std::string_view device);
+	std::string willDisappear(const button_t& button, std::string_view device);
+	std::string keyDown(const button_t& button, std::string_view device);
+	std::string keyUp(const button_t& button, std::string_view device);
+	std::string sendToPlugin(const button_t& button, std::string_view device);
+
+	std::vector<std::string> makeAppear(const std::vector<button_t>& buttons, std::string_view pluginUUID);
+	std::vector<std::string> makeKeyPresses(const std::vector<button_t>& buttons, const size_t count);
+	std::vector<std::string> makeDisappear(const std::vector<button_t>& buttons);
+}
@@ -0,0 +1,202 @@
+//==============================================================================
+/**
+@file       StreamDeckStandIn.cpp
+@brief      A local websocket server that stands in for the Stream Deck application
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "StreamDeckStandIn.h"
+#include "../Common/ESDSDKDefines.h"
+
+/**
+	@brief starts listening on a free local port, check isInit() before connecting a plugin to getPort()
+
+	@param[in] session the events to send once the plugin registers
+**/
+StreamDeckStandIn::StreamDeckStandIn(std::vector<std::string> session) :
+	mSession(std::move(session))
+{
+	mServer.clear_access_channels(websocketpp::log::alevel::all);
+	mServer.clear_error_channels(websocketpp::log::elevel::all);
+
+	// connections copy the handlers when they are made, and start_accept makes the first one
+	mServer.set_open_handler([this](websocketpp::connection_hdl connection)
+		{
+			// one plugin per stand in, like one plugin per Stream Deck port
+			mConnection = connection;
+			websocketpp::lib::error_code ec;
+			mServer.stop_listening(ec);
+		});
+	mServer.set_message_handler([this](websocketpp::connection_hdl connection, server_t::message_ptr message)
+		{
+			onMessage(connection, message);
+		});
+
+	websocketpp::lib::error_code ec;
+	mServer.init_asio(ec);
+	if (!ec)
+	{
+		mServer.set_reuse_addr(true);
+		mServer.listen(websocketpp::lib::asio::ip::tcp::endpoint(websocketpp::lib::asio::ip::address_v4::loopback(), 0), ec);
+	}
+	if (!ec)
+		mServer.start_accept(ec);
+	websocketpp::lib::asio::error_code asioEc;
+	if (!ec)
+		mPort = mServer.get_local_endpoint(asioEc).port();
+	if (ec || asioEc)
+	{
+		mErrorMessage = "StreamDeckStandIn: could not listen, " + (ec ? ec.message() : asioEc.message());
+		return;
+	}
+
+	mThread = std::thread([this]()
+		{
+			mServer.run();
+		});
+	mIsInit = true;
+}
+
+StreamDeckStandIn::~StreamDeckStandIn()
+{
+	if (!mIsInit)
+		return;
+
+	mServer.get_io_service().post([this]()
+		{
+			websocketpp::lib::error_code ec;
+			mServer.stop_listening(ec);
+			if (!mConnection.expired())
+				mServer.close(mConnection, websocketpp::close::status::going_away, "", ec);
+		});
+	// give the plugin the chance to see the close, then stop regardless
+	const std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+	while (!mServer.stopped() && std::chrono::steady_clock::now() < deadline)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	mServer.stop();
+	if (mThread.joinable())
+		mThread.join();
+}
+
+/**
+	@brief sends more scripted events to the plugin, ie: key presses once the buttons have appeared.
+	       Events replayed before the plugin registers are held back and sent after the session.
+
+	@param[in] messages the events to send, in order
+**/
+void StreamDeckStandIn::replay(std::vector<std::string> messages)
+{
+	mServer.get_io_service().post([this, messages = std::move(messages)]()
+		{
+			bool isRegistered = false;
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				isRegistered = mStats.isRegistered;
+			}
+			if (isRegistered)
+				sendAll(messages);
+			else
+				mSession.insert(mSession.end(), messages.begin(), messages.end());
+		});
+}
+
+/**
+	@brief waits until enough buttons have been given a title and an image
+
+	@param[in] titledContexts how many contexts need a title
+	@param[in] imagedContexts how many contexts need an image
+	@param[in] timeout the longest to wait
+
+	@return true if they were all sent before the timeout
+**/
+bool StreamDeckStandIn::waitForContexts(const size_t titledContexts, const size_t imagedContexts, const std::chrono::milliseconds timeout)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	return mCondition.wait_for(lock, timeout, [&]()
+		{
+			return mTitledContexts.size() >= titledContexts && mImagedContexts.size() >= imagedContexts;
+		});
+}
+
+/**
+	@brief gets what the plugin has sent so far
+
+	@return the counts and title latencies since construction
+**/
+StreamDeckStandIn::standInStats_t StreamDeckStandIn::getStats()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	standInStats_t stats = mStats;
+	stats.titledContexts = mTitledContexts.size();
+	stats.imagedContexts = mImagedContexts.size();
+	if (!mTitledContexts.empty())
+		stats.meanTitleLatency = mTotalTitleLatency / static_cast<int64_t>(mTitledContexts.size());
+	return stats;
+}
+
+/**
+	@brief counts a message from the plugin, replaying the session once it registers. Runs on the server thread.
+**/
+void StreamDeckStandIn::onMessage(websocketpp::connection_hdl /*connection*/, server_t::message_ptr message)
+{
+	const std::string& text = message->get_payload();
+	// a frame that is not a json object is dropped rather than counted as any event
+	if (!mInbound.parse(text))
+		return;
+	const std::string& event = mInbound.getEventName();
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	bool isRegistration = false;
+	bool isNewContext = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStats.messages++;
+		mStats.bytes += text.size();
+		if (event == "registerPlugin")
+		{
+			isRegistration = !mStats.isRegistered;
+			mStats.isRegistered = true;
+		}
+		else if (event == kESDSDKEventSetTitle)
+		{
+			mStats.titles++;
+			isNewContext = mTitledContexts.insert(mInbound.getContext()).second;
+			if (const auto appeared = mAppearTimes.find(mInbound.getContext()); isNewContext && appeared != mAppearTimes.end())
+			{
+				const std::chrono::microseconds latency = std::chrono::duration_cast<std::chrono::microseconds>(now - appeared->second);
+				mTotalTitleLatency += latency;
+				mStats.maxTitleLatency = (std::max)(mStats.maxTitleLatency, latency);
+			}
+		}
+		else if (event == kESDSDKEventSetImage)
+		{
+			mStats.images++;
+			isNewContext = mImagedContexts.insert(mInbound.getContext()).second;
+		}
+	}
+
+	if (isNewContext)
+		mCondition.notify_all();
+	if (isRegistration)
+		sendAll(mSession);
+}
+
+/**
+	@brief sends events to the plugin, noting when each button appeared. Runs on the server thread.
+**/
+void StreamDeckStandIn::sendAll(const std::vector<std::string>& messages)
+{
+	for (const std::string& message : messages)
+	{
+		if (mInbound.parse(message) && mInbound.getEvent() == InboundMessage::EVENT::WILL_APPEAR)
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mAppearTimes.insert_or_assign(mInbound.getContext(), std::chrono::steady_clock::now());
+		}
+
+		websocketpp::lib::error_code ec;
+		mServer.send(mConnection, message, websocketpp::frame::opcode::text, ec);
+	}
+}
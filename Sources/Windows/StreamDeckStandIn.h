@@ -0,0 +1,83 @@
+//==============================================================================
+/**
+@file       StreamDeckStandIn.h
+@brief      A local websocket server that stands in for the Stream Deck application
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "InboundMessage.h"
+
+#include <websocketpp/config/asio_no_tls.hpp>
+#include <websocketpp/server.hpp>
+
+/**
+	@brief Listens on a local port for a plugin started with it, like the Stream Deck application does.
+	       Once the plugin registers, the scripted session is replayed to it, and everything the plugin sends
+	       back is counted, with how long each button took to get its first title after it appeared.
+	       Only one plugin connection is served.
+**/
+class StreamDeckStandIn
+{
+public:
+	// what the plugin has sent, and how quickly buttons were given a title
+	struct standInStats_t
+	{
+		bool isRegistered = false;
+		uint64_t messages = 0;
+		uint64_t bytes = 0;
+		uint64_t titles = 0;
+		uint64_t images = 0;
+		size_t titledContexts = 0;
+		size_t imagedContexts = 0;
+		std::chrono::microseconds meanTitleLatency{ 0 };
+		std::chrono::microseconds maxTitleLatency{ 0 };
+	};
+
+	explicit StreamDeckStandIn(std::vector<std::string> session);
+	~StreamDeckStandIn();
+
+	bool isInit() const { return mIsInit; }
+	const std::string& getErrorMessage() const { return mErrorMessage; }
+	uint16_t getPort() const { return mPort; }
+
+	void replay(std::vector<std::string> messages);
+	bool waitForContexts(const size_t titledContexts, const size_t imagedContexts, const std::chrono::milliseconds timeout);
+	standInStats_t getStats();
+
+private:
+	using server_t = websocketpp::server<websocketpp::config::asio>;
+
+	server_t mServer;
+	std::thread mThread;
+	bool mIsInit = false;
+	std::string mErrorMessage;
+	uint16_t mPort = 0;
+
+	// only used on the server thread
+	websocketpp::connection_hdl mConnection;
+	std::vector<std::string> mSession;
+	InboundMessage mInbound;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	standInStats_t mStats;
+	std::unordered_map<std::string, std::chrono::steady_clock::time_point> mAppearTimes;
+	std::unordered_set<std::string> mTitledContexts;
+	std::unordered_set<std::string> mImagedContexts;
+	std::chrono::microseconds mTotalTitleLatency{ 0 };
+
+	void onMessage(websocketpp::connection_hdl connection, server_t::message_ptr message);
+	void sendAll(const std::vector<std::string>& messages);
+};
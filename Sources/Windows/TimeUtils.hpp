@@ -9,8 +9,12 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <time.h>
-#include <sstream>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
 
 namespace timeutils
 {
@@ -24,6 +28,129 @@ namespace timeutils
 		uint32_t year;
 	};
 
+	static constexpr std::string_view WEEKDAYS[7] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+	static constexpr std::string_view MONTHS[12] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+	/**
+		@brief appends a string to a fixed buffer, truncating if there is no room left
+
+		@param[in] first start of the free space in the buffer
+		@param[in] last end of the buffer
+		@param[in] str the string to append
+
+		@return pointer past the last written character
+	**/
+	inline char* appendString(char* first, char* last, std::string_view str)
+	{
+		const size_t length = (std::min)(str.length(), static_cast<size_t>(last - first));
+		std::memcpy(first, str.data(), length);
+		return first + length;
+	}
+
+	/**
+		@brief appends an integer to a fixed buffer, optionally zero padded
+
+		@param[in] first start of the free space in the buffer
+		@param[in] last end of the buffer
+		@param[in] value the number to append
+		@param[in] minDigits pad with leading zeros up to this many digits
+
+		@return pointer past the last written character, or first if there was no room
+	**/
+	inline char* appendNumber(char* first, char* last, int value, int minDigits = 1)
+	{
+		char digits[16];
+		auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+		if (ec != std::errc()) return first;
+
+		for (int pad = minDigits - static_cast<int>(end - digits); pad > 0 && first < last; pad--)
+			*first++ = '0';
+		return appendString(first, last, std::string_view(digits, end - digits));
+	}
+
+	/**
+		@brief writes the time of day as "hh:mm:ss" (24h) or "hh:mmAM" (12h) into a fixed buffer
+
+		@param[in] first start of the free space in the buffer
+		@param[in] last end of the buffer
+		@param[in] localTime the local time to write
+		@param[in] is24H true for 24h time, false for 12h time
+
+		@return pointer past the last written character
+	**/
+	inline char* writeTimeOfDayString(char* first, char* last, const struct tm& localTime, const bool is24H)
+	{
+		char* it = first;
+		if (is24H)
+		{
+			it = appendNumber(it, last, localTime.tm_hour, 2);
+			it = appendString(it, last, ":");
+			it = appendNumber(it, last, localTime.tm_min, 2);
+			it = appendString(it, last, ":");
+			return appendNumber(it, last, localTime.tm_sec, 2);
+		}
+
+		int hour = localTime.tm_hour % 12;
+		if (hour == 0)
+			hour = 12;
+		it = appendNumber(it, last, hour, 2);
+		it = appendString(it, last, ":");
+		it = appendNumber(it, last, localTime.tm_min, 2);
+		return appendString(it, last, localTime.tm_hour >= 12 ? "PM" : "AM");
+	}
+
+	/**
+		@brief writes a date as "Www Mmm d\nhh:mm:ss" (24h) or "Www Mmm d\nhh:mmAM" (12h) into a fixed buffer
+
+		@param[in] first start of the free space in the buffer
+		@param[in] last end of the buffer
+		@param[in] t the time to write
+		@param[in] is24H true for 24h time, false for 12h time
+
+		@return pointer past the last written character, or nullptr if the time could not be converted
+	**/
+	inline char* writeDateString(char* first, char* last, const time_t& t, const bool is24H)
+	{
+		struct tm localTime {};
+		if (localtime_s(&localTime, &t) != 0) return nullptr;
+		if (localTime.tm_wday < 0 || localTime.tm_wday > 6 || localTime.tm_mon < 0 || localTime.tm_mon > 11) return nullptr;
+
+		char* it = appendString(first, last, WEEKDAYS[localTime.tm_wday]);
+		it = appendString(it, last, " ");
+		it = appendString(it, last, MONTHS[localTime.tm_mon]);
+		it = appendString(it, last, " ");
+		it = appendNumber(it, last, localTime.tm_mday);
+		it = appendString(it, last, "\n");
+		return writeTimeOfDayString(it, last, localTime, is24H);
+	}
+
+	/**
+		@brief writes seconds as a XhXmXs string into a fixed buffer
+
+		@param[in] first start of the free space in the buffer
+		@param[in] last end of the buffer
+		@param[in] seconds number of seconds
+
+		@return pointer past the last written character
+	**/
+	inline char* writeSecondsToHMSString(char* first, char* last, int seconds)
+	{
+		const int S = std::abs(seconds) % 60;
+		const int M = (std::abs(seconds) / 60) % 60;
+		const int H = seconds / 3600;
+
+		char* it = first;
+		if (H > 0)
+		{
+			it = appendNumber(it, last, H);
+			it = appendString(it, last, "h");
+		}
+		it = appendNumber(it, last, M);
+		it = appendString(it, last, "m");
+		it = appendNumber(it, last, S);
+		return appendString(it, last, "s");
+	}
+
 	/**
 		@brief convert a time_t to a date_t struct
 
@@ -32,68 +159,21 @@ namespace timeutils
 
 		@return true if successful
 	**/
-	bool convertTimeToDate(date_t& date, const time_t& t)
+	inline bool convertTimeToDate(date_t& date, const time_t& t)
 	{
-		// TODO refactor this
-		// convert to asctime string
-		struct tm localTime;
-		localtime_s(&localTime, &t);
-		char buffer[256];
-		if (!asctime_s(buffer, 256, &localTime))
-		{
-			// parse asctime string
-			std::stringstream ss(buffer);
-
-			if (ss)
-				ss >> date.weekday;
-			else
-				return false;
-
-			if (ss)
-				ss >> date.month;
-			else
-				return false;
-
-			if (ss)
-				ss >> date.day;
-			else
-				return false;
-
-			if (ss)
-				ss >> date.time24H;
-			else
-				return false;
-
-			// parse the 24h time string into 12h time without seconds
-			size_t firstColonLoc = date.time24H.find(":");
-			if (firstColonLoc != std::string::npos)
-			{
-				uint32_t hour = stoi(date.time24H.substr(0, firstColonLoc));
-				std::string amPm = "AM";
-				if (hour >= 12)
-				{
-					amPm = "PM";
-					hour -= 12;
-				}
-				if (hour == 0)
-					hour = 12;
-
-				std::string hourString = std::to_string(hour);
-				hourString.insert(hourString.begin(), 2 - hourString.length(), '0');
-
-				date.time12H = hourString + date.time24H.substr(firstColonLoc, 3) + amPm;
-			}
-			else
-				return false;
-
-			if (ss)
-				ss >> date.year;
-			else
-				return false;
-
-			return true;
-		}
-		return false;
+		struct tm localTime {};
+		if (localtime_s(&localTime, &t) != 0) return false;
+		if (localTime.tm_wday < 0 || localTime.tm_wday > 6 || localTime.tm_mon < 0 || localTime.tm_mon > 11) return false;
+
+		date.weekday = WEEKDAYS[localTime.tm_wday];
+		date.month = MONTHS[localTime.tm_mon];
+		date.day = static_cast<uint32_t>(localTime.tm_mday);
+		date.year = static_cast<uint32_t>(localTime.tm_year + 1900);
+
+		char buffer[16];
+		date.time24H.assign(buffer, writeTimeOfDayString(buffer, buffer + sizeof(buffer), localTime, true));
+		date.time12H.assign(buffer, writeTimeOfDayString(buffer, buffer + sizeof(buffer), localTime, false));
+		return true;
 	}
 
 	/**
@@ -103,16 +183,9 @@ namespace timeutils
 
 		@return the parsed string
 	**/
-	std::string convertSecondsToHMSString(int seconds)
+	inline std::string convertSecondsToHMSString(int seconds)
 	{
-		int S = std::abs(seconds) % 60;
-		int M = static_cast<int>(std::floor(std::abs(seconds) / 60)) % 60;
-		int H = static_cast<int>(std::floor(seconds / 3600));
-		
-		std::string output;
-		if (H > 0)
-			output += std::to_string(H) + "h";
-		output += std::to_string(M) + "m" + std::to_string(S) + "s";
-		return output;
+		char buffer[32];
+		return std::string(buffer, writeSecondsToHMSString(buffer, buffer + sizeof(buffer), seconds));
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,95 @@
+//==============================================================================
+/**
+@file       TitleFormatter.cpp
+@brief      Formats button titles into a reusable fixed buffer
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "TitleFormatter.h"
+#include "TimeUtils.hpp"
+
+/**
+	@brief creates the title string displayed on a steamdeck button
+
+	@param[in] buttonLabel the text on the top of the button
+	@param[in] skips number of skips, displayed on the top right if non-zero
+	@param[in] windowTime time the current fishing window ends
+	@param[in] voyageTime time of next voyage
+	@param[in] dateOrTime true to display the date of the voyage, false for a countdown
+	@param[in] is24H true for 24h time, false for 12h time
+	@param[in] currentTime the current time
+
+	@return view of the title string, valid until the next call to format
+**/
+std::string_view TitleFormatter::format(
+	const std::string& buttonLabel,
+	const uint32_t skips,
+	const time_t& windowTime,
+	const time_t& voyageTime,
+	const bool dateOrTime,
+	const bool is24H,
+	const time_t& currentTime
+)
+{
+	char* const first = mTitleBuffer.data();
+	char* const last = first + mTitleBuffer.size();
+
+	char* it = timeutils::appendString(first, last, buttonLabel);
+	it = timeutils::appendString(it, last, "\n");
+	// if we have skips, add a number to the top right
+	if (skips != 0)
+	{
+		it = timeutils::appendString(it, last, "               ");
+		it = timeutils::appendNumber(it, last, static_cast<int>(skips));
+	}
+	it = timeutils::appendString(it, last, "\n");
+
+	// check to see if we are in a window, and display a timer for that
+	const int windowTimeLeft = static_cast<int>(difftime(windowTime, currentTime));
+	if (windowTimeLeft <= 15 * 60 && windowTimeLeft > 0)
+	{
+		it = timeutils::appendString(it, last, "Window ends:\n");
+		it = timeutils::writeSecondsToHMSString(it, last, windowTimeLeft);
+		it = timeutils::appendString(it, last, "\n");
+	}
+	else
+		it = timeutils::appendString(it, last, "\n\n");
+
+	// display either the date or time
+	if (dateOrTime)
+	{
+		const std::string_view date = getDateString(voyageTime, is24H);
+		it = timeutils::appendString(it, last, date.empty() ? "Error" : date);
+	}
+	else
+	{
+		it = timeutils::appendString(it, last, "\n");
+		it = timeutils::writeSecondsToHMSString(it, last, static_cast<int>(difftime(voyageTime, currentTime)));
+	}
+
+	return std::string_view(first, it - first);
+}
+
+/**
+	@brief gets the date string of a voyage, only reformatting it if the voyage time or mode changed
+
+	@param[in] voyageTime time of the voyage
+	@param[in] is24H true for 24h time, false for 12h time
+
+	@return view of the date string, or empty if the time could not be converted
+**/
+std::string_view TitleFormatter::getDateString(const time_t& voyageTime, const bool is24H)
+{
+	if (!mIsDateCached || mDateVoyageTime != voyageTime || mDateIs24H != is24H)
+	{
+		char* const first = mDateBuffer.data();
+		char* const end = timeutils::writeDateString(first, first + mDateBuffer.size(), voyageTime, is24H);
+		mDateLength = end ? static_cast<size_t>(end - first) : 0;
+		mDateVoyageTime = voyageTime;
+		mDateIs24H = is24H;
+		mIsDateCached = true;
+	}
+	return std::string_view(mDateBuffer.data(), mDateLength);
+}
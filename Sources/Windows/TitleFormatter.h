@@ -0,0 +1,50 @@
+//==============================================================================
+/**
+@file       TitleFormatter.h
+@brief      Formats button titles into a reusable fixed buffer
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <time.h>
+
+/**
+	@brief Formats the title of a single button. Each context owns one of these so
+	       the title can be rebuilt every UI tick without any heap allocations.
+**/
+class TitleFormatter
+{
+public:
+	TitleFormatter() {};
+	~TitleFormatter() {};
+
+	std::string_view format(
+		const std::string& buttonLabel,
+		const uint32_t skips,
+		const time_t& windowTime,
+		const time_t& voyageTime,
+		const bool dateOrTime,
+		const bool is24H,
+		const time_t& currentTime
+	);
+
+private:
+	static constexpr size_t TITLE_BUFFER_SIZE = 256;
+	static constexpr size_t DATE_BUFFER_SIZE = 32;
+
+	std::array<char, TITLE_BUFFER_SIZE> mTitleBuffer{};
+
+	// the date string only changes when the voyage time or timekeeping mode does, so cache it
+	std::array<char, DATE_BUFFER_SIZE> mDateBuffer{};
+	size_t mDateLength = 0;
+	time_t mDateVoyageTime = 0;
+	bool mDateIs24H = false;
+	bool mIsDateCached = false;
+
+	std::string_view getDateString(const time_t& voyageTime, const bool is24H);
+};
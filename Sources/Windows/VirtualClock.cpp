@@ -0,0 +1,114 @@
+//==============================================================================
+/**
+@file       VirtualClock.cpp
+@brief      A clock that only moves when told to, for running the plugin faster than real time
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#include "pch.h"
+#include "VirtualClock.h"
+
+time_t VirtualClock::now()
+{
+	return mStartTime + static_cast<time_t>(mElapsedMilliseconds / 1000);
+}
+
+std::chrono::steady_clock::time_point VirtualClock::steadyNow()
+{
+	return std::chrono::steady_clock::time_point(std::chrono::milliseconds(mElapsedMilliseconds));
+}
+
+/**
+	@brief waits until the mutex is unlocked or advance() reaches the deadline, without any real time passing
+
+	@param[in] mutex the timer's mutex
+	@param[in] duration how long to wait in virtual time
+
+	@return true if the mutex was locked, false if the deadline was reached
+**/
+bool VirtualClock::tryLockFor(std::timed_mutex& mutex, const std::chrono::milliseconds duration)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	const int64_t deadline = mElapsedMilliseconds + (std::max)(duration.count(), static_cast<int64_t>(0));
+	const auto deadlineIt = mDeadlines.insert(deadline);
+
+	bool isLocked = false;
+	while (true)
+	{
+		if (mutex.try_lock())
+		{
+			isLocked = true;
+			break;
+		}
+		if (mElapsedMilliseconds >= deadline)
+			break;
+
+		// nothing to do until time moves or the mutex is unlocked
+		mBlocked++;
+		mIdle.notify_all();
+		const uint64_t generation = mGeneration;
+		mAdvanced.wait(lock, [&]() { return mGeneration != generation; });
+	}
+	mDeadlines.erase(deadlineIt);
+	return isLocked;
+}
+
+/**
+	@brief a timer was woken or stopped, so its thread has to check its mutex again
+**/
+void VirtualClock::notify()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	wakeAll();
+}
+
+void VirtualClock::attach()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mThreads++;
+}
+
+void VirtualClock::detach()
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	mThreads--;
+	mIdle.notify_all();
+}
+
+/**
+	@brief moves time forward, running every timer that falls due in order. Returns once they are all waiting again.
+
+	@param[in] duration how far to move
+**/
+void VirtualClock::advance(const std::chrono::milliseconds duration)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	const int64_t target = mElapsedMilliseconds + duration.count();
+	while (true)
+	{
+		mIdle.wait(lock, [this]() { return mBlocked >= mThreads; });
+		if (mElapsedMilliseconds >= target)
+			break;
+
+		// waiting timers all have deadlines in the future, so jump to the earliest one
+		if (!mDeadlines.empty() && *mDeadlines.begin() <= target)
+		{
+			mElapsedMilliseconds = *mDeadlines.begin();
+			mWakeups++;
+		}
+		else
+			mElapsedMilliseconds = target;
+		wakeAll();
+	}
+}
+
+/**
+	@brief makes every waiting timer check its mutex and deadline again. Call while holding mMutex.
+**/
+void VirtualClock::wakeAll()
+{
+	mGeneration++;
+	mBlocked = 0;
+	mAdvanced.notify_all();
+}
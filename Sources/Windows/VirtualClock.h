@@ -0,0 +1,60 @@
+//==============================================================================
+/**
+@file       VirtualClock.h
+@brief      A clock that only moves when told to, for running the plugin faster than real time
+@copyright  (c) 2023, Momoko Tomoko
+**/
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <set>
+#include "Clock.h"
+
+/**
+	@brief Virtual time for the plugin's timers. Time stands still until advance() is called, which jumps straight to
+	       the next timer due, lets it run and waits for every timer to be waiting again before moving on.
+	       So timers run in the same order and at the same virtual times as they would in real time, only without the waits.
+**/
+class VirtualClock : public Clock
+{
+public:
+	explicit VirtualClock(const time_t startTime) : mStartTime(startTime) {};
+	~VirtualClock() {};
+
+	time_t now() override;
+	std::chrono::steady_clock::time_point steadyNow() override;
+	bool tryLockFor(std::timed_mutex& mutex, const std::chrono::milliseconds duration) override;
+	void notify() override;
+	void attach() override;
+	void detach() override;
+
+	void advance(const std::chrono::milliseconds duration);
+
+	// times advance() woke a timer that was due
+	uint64_t getWakeups() const { return mWakeups; }
+
+private:
+	const time_t mStartTime;
+	std::atomic<int64_t> mElapsedMilliseconds = 0;
+	std::atomic<uint64_t> mWakeups = 0;
+
+	std::mutex mMutex;
+	std::condition_variable mAdvanced;
+	std::condition_variable mIdle;
+
+	// bumped whenever time moves or a mutex is unlocked, so every waiting timer checks again
+	uint64_t mGeneration = 0;
+
+	// timer threads attached, and how many of them are waiting on a deadline in the future
+	size_t mThreads = 0;
+	size_t mBlocked = 0;
+
+	// the deadline of every timer waiting on this clock, in elapsed milliseconds
+	std::multiset<int64_t> mDeadlines;
+
+	void wakeAll();
+};
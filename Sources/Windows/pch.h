@@ -17,12 +17,21 @@
 // C++ headers
 //-------------------------------------------------------------------
 
+#ifdef _WIN32
 #include <winsock2.h>
 #include <Windows.h>
+#include <strsafe.h>
+#else
+// the schedule engine is also built on Linux for the ScheduleQuery tool, which has the POSIX forms of these
+#include <ctime>
+#include <cerrno>
+#define __cdecl
+inline int localtime_s(struct tm* result, const time_t* t) { return localtime_r(t, result) ? 0 : errno; }
+inline int gmtime_s(struct tm* result, const time_t* t) { return gmtime_r(t, result) ? 0 : errno; }
+#endif
 #include <string>
 #include <set>
 #include <thread>
-#include <strsafe.h>
 
 
 //-------------------------------------------------------------------
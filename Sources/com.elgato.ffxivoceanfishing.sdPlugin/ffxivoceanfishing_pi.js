@@ -6,6 +6,7 @@ actionInfo = {};
 
 // stored menu info
 routesJson = {};
+globalSettingsJson = {};
 menuheadersJson = {};
 targetsJson = {};
 
@@ -87,10 +88,13 @@ function connectElgatoStreamDeckSocket(inPort, inUUID, inRegisterEvent, inInfo,
             if( payload.hasOwnProperty('url') && payload.url != null)
                 document.getElementById('set_url').value = payload.url;
 
+            document.getElementById('set_progress_ring').checked = payload.ProgressRing != null && payload.ProgressRing;
+
             settingsInitialized = true;
         }
         if (jsonObj.event === 'didReceiveGlobalSettings') {
             const payload = jsonObj.payload.settings;
+            globalSettingsJson = payload;
 
             // create route dropdown list
             if (payload.hasOwnProperty('Routes')) {
@@ -107,6 +111,10 @@ function connectElgatoStreamDeckSocket(inPort, inUUID, inRegisterEvent, inInfo,
             else
                 document.getElementById('select_12h').checked = true;
 
+            document.getElementById('set_tracing').checked = payload.Tracing != null && payload.Tracing;
+            document.getElementById('set_metrics').checked = payload.Metrics != null && payload.Metrics;
+            document.getElementById('set_log_level').value = payload.LogLevel != null ? payload.LogLevel : 'info';
+
             globalSettingsInitialized = true;
         }
         if (jsonObj.event === 'sendToPropertyInspector') {
@@ -157,7 +165,8 @@ function sendSettingsToPlugin() {
         'DateOrTime': document.getElementById('select_date').checked,
         'Priority': document.getElementById('select_achievement').checked,
         'Skips': document.getElementById('set_skips').value,
-        'url': document.getElementById('set_url').value
+        'url': document.getElementById('set_url').value,
+        'ProgressRing': document.getElementById('set_progress_ring').checked
     };
 
     if (websocket) {
@@ -176,13 +185,30 @@ function sendSettingsToPlugin() {
     saveValues(payload);
 }
 
+// asks the plugin to write a snapshot of its metrics to the Stream Deck log
+function sendMetricsSnapshot() {
+    if (websocket) {
+        const json = {
+            "action": actionInfo['action'],
+            "event": "sendToPlugin",
+            "context": uuid,
+            "payload": { 'metrics': { 'snapshot': true } }
+        };
+        websocket.send(JSON.stringify(json));
+    }
+}
+
 // updates global settings
 function updateGlobalSettings()
 {
-    globalPayload = {
+    // keeps settings without a control here, such as LogFile and TraceFile
+    globalPayload = Object.assign({}, globalSettingsJson, {
         'Routes': routesJson,
-        'Timekeeping24HMode': document.getElementById('select_24h').checked
-    };
+        'Timekeeping24HMode': document.getElementById('select_24h').checked,
+        'Tracing': document.getElementById('set_tracing').checked,
+        'Metrics': document.getElementById('set_metrics').checked,
+        'LogLevel': document.getElementById('set_log_level').value
+    });
     saveGlobalValues(globalPayload);
 }
          